@@ -1,184 +1,623 @@
 #include "MillisTaskManager.h"
+#include <string.h>
+#include "Arduino.h"
 
 #ifndef NULL
 #define NULL 0
 #endif
 
-#define TASK_NEW(task)     \
-	do                     \
-	{                      \
-		task = new Task_t; \
-	} while (0)
-#define TASK_DEL(task) \
-	do                 \
-	{                  \
-		delete task;   \
-	} while (0)
-
 /**
- * @brief initialization task list
+ * @brief initialization task list, the pool for MTM_MAX_TASKS tasks is allocated and doubled when it is full
  * @param priorityEnable: Set whether to enable priority
  * @retval None
  */
 MillisTaskManager::MillisTaskManager(bool priorityEnable)
 {
-	PriorityEnable = priorityEnable;
-	Head = NULL;
-	Tail = NULL;
+	Init(NULL, NULL, NULL, priorityEnable);
+	OwnPool = true;
+	Grow();
+}
+
+/**
+ * @brief initialization task list with a task pool provided by the caller, the pool does not grow
+ * @param pool: task pool
+ * @param slots: task of each pool slot, same size as the pool
+ * @param table: task table, same size as the pool
+ * @param ready: ready heap, same size as the pool
+ * @param capacity: number of tasks in the pool
+ * @param priorityEnable: Set whether to enable priority
+ * @retval None
+ */
+MillisTaskManager::MillisTaskManager(Task_t *pool, Task_t **slots, Task_t **table, Task_t **ready, uint16_t capacity, bool priorityEnable)
+{
+	Init(slots, table, ready, priorityEnable);
+	AddSlots(pool, capacity);
+	OwnPool = false;
 }
 
 /**
- * @brief scheduler destructor, release task list memory
+ * @brief scheduler destructor, release task pool memory
  * @param none
  * @retval None
  */
 MillisTaskManager::~MillisTaskManager()
 {
-	Task_t *now = Head; // Move to the head of the list.
-	while (true)
+	if (OwnPool && (Capacity != 0))
 	{
-		if (now == NULL)
-			break;
-		Task_t *now_del = now;
-		now = now->Next;
-		TASK_DEL(now_del);
+		// The pool blocks start at slot 0, MTM_MAX_TASKS, 2 * MTM_MAX_TASKS, 4 * MTM_MAX_TASKS ...
+		delete[] Slots[0];
+		for (uint32_t start = MTM_MAX_TASKS; start < Capacity; start *= 2)
+		{
+			delete[] Slots[start];
+		}
+		delete[] Slots;
+		delete[] Tasks;
+		delete[] ReadyTasks;
 	}
 }
 
 /**
- * @brief Add a task to the task list and set the interval execution time
- * @param func: task function pointer
- * @param timeMs: cycle time setting (milliseconds)
- * @param state: task switch
- * @retval task node address
+ * @brief initialization of the scheduler without tasks
+ * @param slots: task of each pool slot
+ * @param table: task table
+ * @param ready: ready heap
+ * @param priorityEnable: Set whether to enable priority
+ * @retval None
  */
-MillisTaskManager::Task_t *MillisTaskManager::Register(TaskFunction_t func, uint32_t timeMs, bool state)
+void MillisTaskManager::Init(Task_t **slots, Task_t **table, Task_t **ready, bool priorityEnable)
 {
-	Task_t *task = Find(func);
+	PriorityEnable = priorityEnable;
+	Slots = slots;
+	Tasks = table;
+	ReadyTasks = ready;
+	Capacity = 0;
+	Count = 0;
+	HeapSize = 0;
+	ReadySize = 0;
+	Budget = 0;
+	LastTick = 0;
+	Pass = 0;
+	NotifyPending = false;
+}
 
-	if (task != NULL)
+/**
+ * @brief add free tasks to the end of the pool, the tables must have room for them
+ * @param tasks: free tasks
+ * @param count: number of tasks
+ * @retval None
+ */
+void MillisTaskManager::AddSlots(Task_t *tasks, uint16_t count)
+{
+	for (uint16_t i = 0; i < count; i++)
 	{
-		task->Time = timeMs;
-		task->State = state;
-		task->FirstExecut = true;
-		return task;
+		Task_t *task = &tasks[i];
+		task->Function = NULL;
+		task->Notified = false;
+		task->Ready = false;
+		task->Index = Capacity;
+		task->Slot = Capacity;
+		task->Generation = 0;
+		Slots[Capacity] = task;
+		Tasks[Capacity] = task;
+		Capacity++;
 	}
+}
 
-	TASK_NEW(task);
+/**
+ * @brief double the heap allocated pool, the tasks keep their address.
+ *        Not interrupt safe, Notify must not run while a task is added to a full pool.
+ * @param none
+ * @retval true: success; false: static pool, pool limit reached or out of memory
+ */
+bool MillisTaskManager::Grow()
+{
+	uint32_t capacity = (Capacity == 0) ? MTM_MAX_TASKS : (uint32_t)Capacity * 2;
+	if (capacity > MTM_POOL_LIMIT)
+		capacity = MTM_POOL_LIMIT;
+	if (!OwnPool || (capacity <= Capacity))
+		return false;
 
-	if (task == NULL)
+	Task_t *block = new Task_t[capacity - Capacity];
+	Task_t **slots = new Task_t *[capacity];
+	Task_t **table = new Task_t *[capacity];
+	Task_t **ready = new Task_t *[capacity];
+	if ((block == NULL) || (slots == NULL) || (table == NULL) || (ready == NULL))
+	{
+		delete[] block;
+		delete[] slots;
+		delete[] table;
+		delete[] ready;
+		return false;
+	}
+
+	if (Capacity != 0)
+	{
+		memcpy(slots, Slots, Capacity * sizeof(Task_t *));
+		memcpy(table, Tasks, Capacity * sizeof(Task_t *));
+		memcpy(ready, ReadyTasks, ReadySize * sizeof(Task_t *));
+		delete[] Slots;
+		delete[] Tasks;
+		delete[] ReadyTasks;
+	}
+	Slots = slots;
+	Tasks = table;
+	ReadyTasks = ready;
+	AddSlots(block, capacity - Capacity);
+	return true;
+}
+
+/**
+ * @brief take a free task from the pool, the free tasks follow the registered tasks in the task table
+ * @param func: task function pointer
+ * @param timeMs: cycle time setting (milliseconds)
+ * @param state: task switch
+ * @retval task node address, NULL if the static pool is full
+ */
+MillisTaskManager::Task_t *MillisTaskManager::Alloc(TaskFunction_t func, uint32_t timeMs, bool state)
+{
+	if ((Count >= Capacity) && !Grow())
 	{
 		return NULL;
 	}
 
+	Task_t *task = Tasks[Count];
+	Count++;
+
 	task->Function = func;
 	task->Time = timeMs;
-	task->State = state;
+	task->State = false;
 	task->FirstExecut = true;
+	task->Triggered = false;
+	task->Notified = false;
+	task->Priority = 0;
+	task->Ready = false;
+	task->OneShot = false;
 	task->TimePrev = 0;
 	task->TimeCost = 0;
 	task->TimeError = 0;
-	task->Next = NULL;
+	task->Deadline = LastTick;
+	task->Pass = Pass - 1;
+#if (MTM_USE_STATS == 1)
+	ResetStats(task);
+#endif
+
+	Enable(task, state);
+	return task;
+}
+
+/**
+ * @brief return a task to the pool, its handle becomes invalid
+ * @param task: task node address
+ * @retval None
+ */
+void MillisTaskManager::Free(Task_t *task)
+{
+	Enable(task, false);
+	Count--;
+	Swap(task->Index, Count);
+	task->Function = NULL;
+	task->Generation++;
+}
 
-	if (Head == NULL)
+/**
+ * @brief heap order, earlier deadline first, on equal deadline the task that ran less recently
+ * @param a: task node address
+ * @param b: task node address
+ * @retval true: a is before b
+ */
+bool MillisTaskManager::Before(Task_t *a, Task_t *b)
+{
+	bool aUrgent = a->FirstExecut || a->Triggered;
+	bool bUrgent = b->FirstExecut || b->Triggered;
+	if (aUrgent != bUrgent)
 	{
-		Head = task;
+		return aUrgent;
 	}
-	else
+	int32_t diff = (int32_t)(a->Deadline - b->Deadline);
+	if (diff != 0)
 	{
-		Tail->Next = task;
+		return diff < 0;
 	}
+	return (int32_t)(a->Pass - b->Pass) < 0;
+}
 
-	Tail = task;
-	return task;
+/**
+ * @brief swap two entries of the task table
+ * @param a: table index
+ * @param b: table index
+ * @retval None
+ */
+void MillisTaskManager::Swap(uint16_t a, uint16_t b)
+{
+	Task_t *task = Tasks[a];
+	Tasks[a] = Tasks[b];
+	Tasks[b] = task;
+	Tasks[a]->Index = a;
+	Tasks[b]->Index = b;
 }
 
 /**
- * @brief find the task, return the task node
- * @param func: task function pointer
- * @retval task node address
+ * @brief move a heap entry up until its parent is earlier
+ * @param index: table index
+ * @retval None
  */
-MillisTaskManager::Task_t *MillisTaskManager::Find(TaskFunction_t func)
+void MillisTaskManager::SiftUp(uint16_t index)
 {
-	Task_t *now = Head;
-	Task_t *task = NULL;
-	while (true)
+	while (index > 0)
 	{
-		if (now == NULL)
+		uint16_t parent = (index - 1) / 2;
+		if (!Before(Tasks[index], Tasks[parent]))
+		{
 			break;
+		}
+		Swap(index, parent);
+		index = parent;
+	}
+}
 
-		if (now->Function == func)
+/**
+ * @brief move a heap entry down until its children are later
+ * @param index: table index
+ * @retval None
+ */
+void MillisTaskManager::SiftDown(uint16_t index)
+{
+	while (true)
+	{
+		uint16_t first = index;
+		uint32_t left = 2 * (uint32_t)index + 1;
+		uint32_t right = left + 1;
+		if ((left < HeapSize) && Before(Tasks[left], Tasks[first]))
+		{
+			first = left;
+		}
+		if ((right < HeapSize) && Before(Tasks[right], Tasks[first]))
+		{
+			first = right;
+		}
+		if (first == index)
 		{
-			task = now;
 			break;
 		}
+		Swap(index, first);
+		index = first;
+	}
+}
 
-		now = now->Next;
+/**
+ * @brief restore the heap order after the deadline of a task changed
+ * @param task: task node address
+ * @retval None
+ */
+void MillisTaskManager::Update(Task_t *task)
+{
+	if (!task->Ready && (task->Index < HeapSize))
+	{
+		SiftUp(task->Index);
+		SiftDown(task->Index);
 	}
-	return task;
 }
 
 /**
- * @brief Get the previous node of the current node
- * @param task: current task node address
- * @retval previous task node address
+ * @brief move a task into the heap of waiting tasks or out of the waiting or ready tasks
+ * @param task: task node address
+ * @param state: task state
+ * @retval None
  */
-MillisTaskManager::Task_t *MillisTaskManager::GetPrev(Task_t *task)
+void MillisTaskManager::Enable(Task_t *task, bool state)
+{
+	uint16_t disabled = HeapSize + ReadySize;
+	if (state && (task->Index >= disabled))
+	{
+		// First disabled position, then swap with the first ready task to the end of the heap
+		Swap(task->Index, disabled);
+		Swap(disabled, HeapSize);
+		HeapSize++;
+		SiftUp(task->Index);
+	}
+	else if (!state && task->Ready)
+	{
+		RemoveReady(task);
+		Swap(task->Index, HeapSize + ReadySize);
+	}
+	else if (!state && (task->Index < HeapSize))
+	{
+		uint16_t index = task->Index;
+		HeapSize--;
+		Swap(index, HeapSize);
+		if (index < HeapSize)
+		{
+			Task_t *moved = Tasks[index];
+			SiftUp(index);
+			SiftDown(moved->Index);
+		}
+		// Swap with the last ready task to the first disabled position
+		Swap(HeapSize, HeapSize + ReadySize);
+	}
+	task->State = state;
+}
+
+/**
+ * @brief ready heap order, earlier ready key first, on equal key the task that ran less recently
+ * @param a: task node address
+ * @param b: task node address
+ * @retval true: a is before b
+ */
+bool MillisTaskManager::ReadyBefore(Task_t *a, Task_t *b)
+{
+	int32_t diff = (int32_t)(a->ReadyKey - b->ReadyKey);
+	if (diff != 0)
+	{
+		return diff < 0;
+	}
+	return (int32_t)(a->Pass - b->Pass) < 0;
+}
+
+/**
+ * @brief swap two entries of the ready heap
+ * @param a: ready heap index
+ * @param b: ready heap index
+ * @retval None
+ */
+void MillisTaskManager::ReadySwap(uint16_t a, uint16_t b)
 {
-	Task_t *now = Head;
-	Task_t *prev = NULL;
-	Task_t *retval = NULL;
+	Task_t *task = ReadyTasks[a];
+	ReadyTasks[a] = ReadyTasks[b];
+	ReadyTasks[b] = task;
+	ReadyTasks[a]->ReadyIndex = a;
+	ReadyTasks[b]->ReadyIndex = b;
+}
 
-	while (true)
+/**
+ * @brief move a ready heap entry up until its parent is earlier
+ * @param index: ready heap index
+ * @retval None
+ */
+void MillisTaskManager::ReadySiftUp(uint16_t index)
+{
+	while (index > 0)
 	{
-		if (now == NULL)
+		uint16_t parent = (index - 1) / 2;
+		if (!ReadyBefore(ReadyTasks[index], ReadyTasks[parent]))
 		{
 			break;
 		}
+		ReadySwap(index, parent);
+		index = parent;
+	}
+}
 
-		if (now == task)
+/**
+ * @brief move a ready heap entry down until its children are later
+ * @param index: ready heap index
+ * @retval None
+ */
+void MillisTaskManager::ReadySiftDown(uint16_t index)
+{
+	while (true)
+	{
+		uint16_t first = index;
+		uint32_t left = 2 * (uint32_t)index + 1;
+		uint32_t right = left + 1;
+		if ((left < ReadySize) && ReadyBefore(ReadyTasks[left], ReadyTasks[first]))
+		{
+			first = left;
+		}
+		if ((right < ReadySize) && ReadyBefore(ReadyTasks[right], ReadyTasks[first]))
+		{
+			first = right;
+		}
+		if (first == index)
 		{
-			retval = prev;
 			break;
 		}
+		ReadySwap(index, first);
+		index = first;
+	}
+}
 
-		prev = now;
+/**
+ * @brief move the top of the waiting heap, a due task, into the ready heap.
+ *        The ready key is the due time plus MTM_PRIORITY_AGING per priority class,
+ *        inside a class the earliest deadline runs first, a task of a lower class
+ *        overtakes after it waited MTM_PRIORITY_AGING longer per class.
+ * @param tick: current time
+ * @retval None
+ */
+void MillisTaskManager::MakeReady(uint32_t tick)
+{
+	Task_t *task = Tasks[0];
+	HeapSize--;
+	// The last heap position becomes the first ready position
+	Swap(0, HeapSize);
+	SiftDown(0);
 
-		now = now->Next;
+	uint32_t due = (task->FirstExecut || task->Triggered) ? tick : task->Deadline;
+	task->ReadyKey = due + task->Priority * MTM_PRIORITY_AGING;
+	task->Ready = true;
+	task->ReadyIndex = ReadySize;
+	ReadyTasks[ReadySize] = task;
+	ReadySize++;
+	ReadySiftUp(task->ReadyIndex);
+}
+
+/**
+ * @brief take a task out of the ready heap, the caller moves it out of the ready part of the task table
+ * @param task: task node address
+ * @retval None
+ */
+void MillisTaskManager::RemoveReady(Task_t *task)
+{
+	uint16_t index = task->ReadyIndex;
+	ReadySize--;
+	ReadySwap(index, ReadySize);
+	if (index < ReadySize)
+	{
+		Task_t *moved = ReadyTasks[index];
+		ReadySiftUp(index);
+		ReadySiftDown(moved->ReadyIndex);
 	}
-	return retval;
+	task->Ready = false;
 }
 
 /**
- * @brief logout task (use with caution, thread-unsafe)
+ * @brief move a ready task back into the heap of waiting tasks
+ * @param task: task node address
+ * @retval None
+ */
+void MillisTaskManager::Reschedule(Task_t *task)
+{
+	RemoveReady(task);
+	// The first ready position becomes the last heap position
+	Swap(task->Index, HeapSize);
+	HeapSize++;
+	SiftUp(task->Index);
+}
+
+/**
+ * @brief Add a task to the task list and set the interval execution time
  * @param func: task function pointer
- * @retval true: success; false: failure
+ * @param timeMs: cycle time setting (milliseconds)
+ * @param state: task switch
+ * @param oneShot: disable the task after each execution, see Start
+ * @retval task node address
  */
-bool MillisTaskManager::Logout(TaskFunction_t func)
+MillisTaskManager::Task_t *MillisTaskManager::Register(TaskFunction_t func, uint32_t timeMs, bool state, bool oneShot)
 {
+	if (func == NULL)
+	{
+		return NULL;
+	}
+
 	Task_t *task = Find(func);
-	if (task == NULL)
-		return false;
 
-	Task_t *prev = GetPrev(task);
-	Task_t *next = task->Next;
+	if (task != NULL)
+	{
+		task->Time = timeMs;
+		task->FirstExecut = true;
+		task->Deadline = LastTick;
+		task->OneShot = oneShot;
+		Enable(task, state);
+		Update(task);
+		return task;
+	}
 
-	if (prev == NULL && next != NULL)
+	task = Alloc(func, timeMs, false);
+	if (task != NULL)
 	{
-		Head = next;
+		task->OneShot = oneShot;
+		Enable(task, state);
 	}
-	else if (prev != NULL && next == NULL)
+	return task;
+}
+
+/**
+ * @brief find the task, return the task node
+ * @param func: task function pointer
+ * @retval task node address
+ */
+MillisTaskManager::Task_t *MillisTaskManager::Find(TaskFunction_t func)
+{
+	for (uint16_t i = 0; i < Count; i++)
 	{
-		prev->Next = NULL;
+		if (Tasks[i]->Function == func)
+		{
+			return Tasks[i];
+		}
 	}
-	else if (prev != NULL && next != NULL)
+	return NULL;
+}
+
+/**
+ * @brief Get the previous node of the current node
+ * @param task: current task node address
+ * @retval previous task node address in the task table
+ */
+MillisTaskManager::Task_t *MillisTaskManager::GetPrev(Task_t *task)
+{
+	if ((task == NULL) || (task->Index == 0) || (task->Index >= Count) || (Tasks[task->Index] != task))
 	{
-		prev->Next = next;
+		return NULL;
 	}
-	TASK_DEL(task);
+	return Tasks[task->Index - 1];
+}
+
+/**
+ * @brief logout task (use with caution, thread-unsafe)
+ * @param func: task function pointer
+ * @retval true: success; false: failure
+ */
+bool MillisTaskManager::Logout(TaskFunction_t func)
+{
+	Task_t *task = Find(func);
+	if (task == NULL)
+		return false;
+
+	Free(task);
+	return true;
+}
+
+/**
+ * @brief Add a task without checking for an already registered function, O(1) besides the heap order
+ * @param func: task function pointer
+ * @param timeMs: cycle time setting (milliseconds)
+ * @param state: task switch
+ * @retval task handle, MTM_INVALID_HANDLE if the static pool is full
+ */
+MillisTaskManager::TaskHandle_t MillisTaskManager::Add(TaskFunction_t func, uint32_t timeMs, bool state)
+{
+	if (func == NULL)
+		return MTM_INVALID_HANDLE;
+
+	return GetHandle(Alloc(func, timeMs, state));
+}
+
+/**
+ * @brief remove a task by its handle (use with caution, thread-unsafe)
+ * @param handle: task handle
+ * @retval true: success; false: invalid handle
+ */
+bool MillisTaskManager::Remove(TaskHandle_t handle)
+{
+	Task_t *task = Get(handle);
+	if (task == NULL)
+		return false;
+
+	Free(task);
 	return true;
 }
 
+/**
+ * @brief get the task node of a handle
+ * @param handle: task handle
+ * @retval task node address, NULL if the task was removed
+ */
+MillisTaskManager::Task_t *MillisTaskManager::Get(TaskHandle_t handle)
+{
+	uint16_t slot = handle & 0xFFFF;
+	if (slot >= Capacity)
+		return NULL;
+
+	Task_t *task = Slots[slot];
+	if ((task->Function == NULL) || (task->Generation != (handle >> 16)))
+		return NULL;
+
+	return task;
+}
+
+/**
+ * @brief get the handle of a task node
+ * @param task: task node address
+ * @retval task handle, MTM_INVALID_HANDLE if task is NULL
+ */
+MillisTaskManager::TaskHandle_t MillisTaskManager::GetHandle(Task_t *task)
+{
+	if (task == NULL)
+		return MTM_INVALID_HANDLE;
+
+	return ((TaskHandle_t)task->Generation << 16) | task->Slot;
+}
+
 /**
  * @brief task state control
  * @param func: task function pointer
@@ -191,10 +630,68 @@ bool MillisTaskManager::SetState(TaskFunction_t func, bool state)
 	if (task == NULL)
 		return false;
 
-	task->State = state;
+	Enable(task, state);
+	return true;
+}
+
+/**
+ * @brief task state control by handle
+ * @param handle: task handle
+ * @param state: task state
+ * @retval true: success; false: invalid handle
+ */
+bool MillisTaskManager::SetState(TaskHandle_t handle, bool state)
+{
+	Task_t *task = Get(handle);
+	if (task == NULL)
+		return false;
+
+	Enable(task, state);
+	return true;
+}
+
+/**
+ * @brief task priority class setting, takes effect when the task is due the next time
+ * @param func: task function pointer
+ * @param priority: priority class, 0 (highest) to MTM_PRIORITY_CLASSES - 1
+ * @retval true: success; false: failure
+ */
+bool MillisTaskManager::SetPriority(TaskFunction_t func, uint8_t priority)
+{
+	Task_t *task = Find(func);
+	if ((task == NULL) || (priority >= MTM_PRIORITY_CLASSES))
+		return false;
+
+	task->Priority = priority;
+	return true;
+}
+
+/**
+ * @brief task priority class setting by handle, takes effect when the task is due the next time
+ * @param handle: task handle
+ * @param priority: priority class, 0 (highest) to MTM_PRIORITY_CLASSES - 1
+ * @retval true: success; false: invalid handle or priority
+ */
+bool MillisTaskManager::SetPriority(TaskHandle_t handle, uint8_t priority)
+{
+	Task_t *task = Get(handle);
+	if ((task == NULL) || (priority >= MTM_PRIORITY_CLASSES))
+		return false;
+
+	task->Priority = priority;
 	return true;
 }
 
+/**
+ * @brief CPU time limit of a Running call, due tasks that did not fit run first on the next call
+ * @param budgetUs: CPU time (us), 0 for no limit
+ * @retval None
+ */
+void MillisTaskManager::SetBudget(uint32_t budgetUs)
+{
+	Budget = budgetUs;
+}
+
 /**
  * @brief task execution cycle setting
  * @param func: task function pointer
@@ -208,6 +705,32 @@ bool MillisTaskManager::SetIntervalTime(TaskFunction_t func, uint32_t timeMs)
 		return false;
 
 	task->Time = timeMs;
+	task->Deadline = task->TimePrev + timeMs;
+	Update(task);
+	return true;
+}
+
+/**
+ * @brief (re)start a task, it runs the first time timeMs after tick, like starting a hardware timer
+ * @param func: task function pointer
+ * @param timeMs: task execution cycle, delay of a one-shot task
+ * @param tick: current time (milliseconds)
+ * @retval true: success; false: failure
+ */
+bool MillisTaskManager::Start(TaskFunction_t func, uint32_t timeMs, uint32_t tick)
+{
+	Task_t *task = Find(func);
+	if (task == NULL)
+		return false;
+
+	// Out of the heaps first, a due task must not run with the old schedule
+	Enable(task, false);
+	task->Time = timeMs;
+	task->TimePrev = tick;
+	task->Deadline = tick + timeMs;
+	task->FirstExecut = false;
+	task->Triggered = false;
+	Enable(task, true);
 	return true;
 }
 
@@ -224,11 +747,12 @@ bool MillisTaskManager::ReSetTaskTime(TaskFunction_t func, uint32_t timeMs)
 		return false;
 
 	task->TimePrev = timeMs;
+	task->Deadline = timeMs + task->Time;
+	Update(task);
 	return true;
 }
 
 #if (MTM_USE_CPU_USAGE == 1)
-#include "Arduino.h"
 static uint32_t UserFuncLoopUs = 0;
 /**
  * @brief Get CPU usage
@@ -287,51 +811,310 @@ uint32_t MillisTaskManager::GetTimeCost(TaskFunction_t func)
 }
 
 /**
- * @brief scheduler (kernel)
+ * @brief Get the next trigger time of the enabled tasks
+ * @param deadline: next trigger time (milliseconds)
+ * @retval true: success; false: no enabled task
+ */
+bool MillisTaskManager::GetNextDeadline(uint32_t *deadline)
+{
+	if (ReadySize != 0)
+	{
+		*deadline = LastTick;
+		return true;
+	}
+
+	if (HeapSize == 0)
+		return false;
+
+	Task_t *task = Tasks[0];
+	*deadline = (task->FirstExecut || task->Triggered || NotifyPending) ? LastTick : task->Deadline;
+	return true;
+}
+
+/**
+ * @brief Get the number of registered tasks
+ * @param none
+ * @retval number of registered tasks
+ */
+uint16_t MillisTaskManager::GetCount()
+{
+	return Count;
+}
+
+/**
+ * @brief Get a registered task by its position in the task table, the position changes with the deadlines
+ * @param index: 0 to GetCount() - 1
+ * @retval task node address, NULL if index is out of range
+ */
+MillisTaskManager::Task_t *MillisTaskManager::GetTask(uint16_t index)
+{
+	if (index >= Count)
+		return NULL;
+
+	return Tasks[index];
+}
+
+#if (MTM_USE_STATS == 1)
+/**
+ * @brief Get the log2 histogram bucket of a value
+ * @param value: run time or start jitter
+ * @retval bucket, 0 for 0, n for 2^(n-1) to 2^n - 1, limited to MTM_HIST_BUCKETS - 1
+ */
+uint8_t MillisTaskManager::HistBucket(uint32_t value)
+{
+	uint8_t bucket = value == 0 ? 0 : 32 - __builtin_clz(value);
+	return bucket < MTM_HIST_BUCKETS ? bucket : MTM_HIST_BUCKETS - 1;
+}
+
+/**
+ * @brief Clear the statistics of a task
+ * @param task: task node address
+ * @retval None
+ */
+void MillisTaskManager::ResetStats(Task_t *task)
+{
+	memset(&task->Stats, 0, sizeof(task->Stats));
+	task->Stats.CostMin = 0xFFFFFFFF;
+	task->Stats.ErrorMin = 0xFFFFFFFF;
+}
+
+/**
+ * @brief Clear the statistics of all tasks
+ * @param none
+ * @retval None
+ */
+void MillisTaskManager::ResetStats()
+{
+	for (uint16_t i = 0; i < Count; i++)
+	{
+		ResetStats(Tasks[i]);
+	}
+}
+
+/**
+ * @brief Add an execution to the task statistics
+ * @param task: task node address
+ * @param timeCost: run time (us)
+ * @param first: first execution, it has no start jitter
+ * @retval None
+ */
+void MillisTaskManager::Record(Task_t *task, uint32_t timeCost, bool first)
+{
+	struct TaskStats *stats = &task->Stats;
+
+	stats->Runs++;
+	if (timeCost < stats->CostMin)
+		stats->CostMin = timeCost;
+	if (timeCost > stats->CostMax)
+		stats->CostMax = timeCost;
+	stats->CostSum += timeCost;
+	uint8_t bucket = HistBucket(timeCost);
+	if (stats->CostHist[bucket] != 0xFFFF)
+		stats->CostHist[bucket]++;
+
+	if ((task->Time != 0) && (timeCost > (uint64_t)task->Time * 1000))
+		stats->Overruns++;
+
+	if (first)
+		return;
+
+	stats->Starts++;
+	if (task->TimeError < stats->ErrorMin)
+		stats->ErrorMin = task->TimeError;
+	if (task->TimeError > stats->ErrorMax)
+		stats->ErrorMax = task->TimeError;
+	stats->ErrorSum += task->TimeError;
+	bucket = HistBucket(task->TimeError);
+	if (stats->ErrorHist[bucket] != 0xFFFF)
+		stats->ErrorHist[bucket]++;
+}
+#endif
+
+/**
+ * @brief Mark a task to run on the next Running call, regardless of its period, a disabled task is enabled.
+ *        Lock-free, can be called from an interrupt handler.
+ * @param handle: task handle
+ * @retval true: success; false: invalid handle
+ */
+bool MillisTaskManager::Notify(TaskHandle_t handle)
+{
+	return Notify(Get(handle));
+}
+
+/**
+ * @brief Mark a task to run on the next Running call, regardless of its period, a disabled task is enabled.
+ *        Lock-free, can be called from an interrupt handler.
+ * @param task: task node address
+ * @retval true: success; false: task is NULL
+ */
+bool MillisTaskManager::Notify(Task_t *task)
+{
+	if (task == NULL)
+		return false;
+
+	task->Notified = true;
+	// Flag the task before the scheduler can see the pending notification
+	__sync_synchronize();
+	NotifyPending = true;
+	return true;
+}
+
+/**
+ * @brief Check for notifications that were not taken by Running yet
+ * @param none
+ * @retval true: a notified task waits for Running
+ */
+bool MillisTaskManager::IsNotified()
+{
+	return NotifyPending;
+}
+
+/**
+ * @brief move the notified tasks to the top of the heap, a disabled task is enabled
+ * @param none
+ * @retval None
+ */
+void MillisTaskManager::TakeNotifications()
+{
+	NotifyPending = false;
+	// Clear the pending flag before the task flags, a Notify during the scan is kept for the next call
+	__sync_synchronize();
+	// Scan in pool order, Update changes the task table order
+	for (uint16_t i = 0; i < Capacity; i++)
+	{
+		Task_t *task = Slots[i];
+		if (!task->Notified)
+			continue;
+
+		task->Notified = false;
+		if (task->Function != NULL)
+		{
+			task->Triggered = true;
+			if (task->State)
+			{
+				Update(task);
+			}
+			else
+			{
+				Enable(task, true);
+			}
+		}
+	}
+}
+
+/**
+ * @brief Get the time until the next task is due
+ * @param tick: current time (milliseconds)
+ * @retval time until the next task is due (milliseconds), 0 if a task is due, MTM_SLEEP_FOREVER if no task is enabled
+ */
+uint32_t MillisTaskManager::GetSleepTime(uint32_t tick)
+{
+	if (NotifyPending || (ReadySize != 0))
+		return 0;
+
+	if (HeapSize == 0)
+		return MTM_SLEEP_FOREVER;
+
+	Task_t *task = Tasks[0];
+	if (task->FirstExecut || task->Triggered)
+		return 0;
+
+	uint32_t elapsTime = GetTickElaps(tick, task->TimePrev);
+	if (elapsTime >= task->Time)
+		return 0;
+
+	return task->Time - elapsTime;
+}
+
+/**
+ * @brief scheduler (kernel), moves the due tasks into the ready heap and runs them
+ *        by priority class and deadline, each at most once per call
  * @param tick: provide a system clock variable accurate to milliseconds
  * @retval None
  */
 void MillisTaskManager::Running(uint32_t tick)
 {
-	Task_t *now = Head;
-	while (true)
+	LastTick = tick;
+	Pass++;
+
+	if (NotifyPending)
 	{
-		if (now == NULL)
+		TakeNotifications();
+	}
+
+	while (HeapSize > 0)
+	{
+		Task_t *now = Tasks[0];
+		if ((GetTickElaps(tick, now->TimePrev) < now->Time) && (now->FirstExecut == false) && (now->Triggered == false))
 		{
 			break;
 		}
+		MakeReady(tick);
+	}
 
-		if (now->Function != NULL && now->State)
-		{
-			uint32_t elapsTime = GetTickElaps(tick, now->TimePrev);
-			if ((elapsTime >= now->Time) || (now->FirstExecut == true))
-			{
-				now->FirstExecut = false;
+	uint32_t runStart = micros();
+
+	while (ReadySize > 0)
+	{
+		Task_t *now = ReadyTasks[0];
+
+		uint32_t elapsTime = GetTickElaps(tick, now->TimePrev);
+		// A notified task runs on the notification, not on its period, also if it was disabled for longer
+		bool early = now->Triggered || (elapsTime < now->Time);
 
-				now->TimeError = elapsTime - now->Time;
+#if (MTM_USE_STATS == 1)
+		// A notified task has no start jitter
+		bool first = now->FirstExecut || early;
+#endif
 
-				now->TimePrev = tick;
+		now->FirstExecut = false;
+		now->Triggered = false;
 
-#if (MTM_USE_CPU_USAGE == 1)
-				uint32_t start = micros();
+		now->TimeError = early ? 0 : elapsTime - now->Time;
 
-				now->Function();
+		now->TimePrev = tick;
+
+		// Reschedule before the call, the task may change the task list
+		now->Deadline = tick + now->Time;
+		now->Pass = Pass;
+		Reschedule(now);
+		if (now->OneShot)
+		{
+			// Before the call, the task may start itself again
+			Enable(now, false);
+		}
 
-				uint32_t timeCost = micros() - start;
+#if (MTM_USE_CPU_USAGE == 1) || (MTM_USE_STATS == 1)
+		uint16_t generation = now->Generation;
 
-				now->TimeCost = timeCost;
+		uint32_t start = micros();
 
-				UserFuncLoopUs += timeCost;
+		now->Function();
+
+		uint32_t timeCost = micros() - start;
+
+		// The task may have removed itself
+		if ((now->Function != NULL) && (now->Generation == generation))
+		{
+			now->TimeCost = timeCost;
+#if (MTM_USE_STATS == 1)
+			Record(now, timeCost, first);
+#endif
+		}
+#if (MTM_USE_CPU_USAGE == 1)
+		UserFuncLoopUs += timeCost;
+#endif
 #else
-				now->Function();
+		now->Function();
 #endif
-				if (PriorityEnable)
-				{
-					break;
-				}
-			}
+		if (PriorityEnable)
+		{
+			break;
 		}
 
-		now = now->Next;
+		if ((Budget != 0) && ((micros() - runStart) >= Budget))
+		{
+			break;
+		}
 	}
 }
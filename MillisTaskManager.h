@@ -15,6 +15,15 @@
 			Add anti-collision judgment to TaskRegister
 			Add TimeCost task time cost calculation
 			Use singly linked list to manage tasks, add GetTickElaps to handle uint32 overflow, add time error records
+  * @Upgrade 2026.10.16 Replace the linked list with a min-heap ordered by the next deadline of the enabled tasks,
+			Running only touches due tasks, add GetNextDeadline
+			Add GetSleepTime for a tickless main loop
+			Tasks live in a fixed pool, MillisTaskPool<N> without heap allocation, add task handles with Add/Remove
+			Add per task run time and start jitter statistics with log2 histograms and overrun counter (MTM_USE_STATS)
+			Add Notify, ISR safe wakeup that runs a task on the next Running call
+			Due tasks wait in a ready heap ordered by priority class and deadline with aging, add a CPU budget per Running call
+			Add one-shot tasks and Start, Notify enables a disabled task
+			The heap allocated pool grows as tasks are added, handles are 32 bit with a 16 bit slot
   **************************************************** ****************************
   * @attention
   * You need to provide a system clock accurate to the millisecond level, and then call the Running function periodically
@@ -26,12 +35,50 @@
 
 #define MTM_USE_CPU_USAGE 1
 
+#ifndef MTM_USE_STATS
+#define MTM_USE_STATS 1 // Per task statistics, set to 0 to remove them.
+#endif
+
+#define MTM_HIST_BUCKETS 16 // Number of log2 histogram buckets, bucket n counts values below 2^n.
+
+#ifndef MTM_MAX_TASKS
+#define MTM_MAX_TASKS 16 // Initial size of the heap allocated pool, it doubles when it is full.
+#endif
+
+#define MTM_POOL_LIMIT 0x8000 // Maximum number of tasks of the heap allocated pool.
+
+#define MTM_INVALID_HANDLE 0xFFFFFFFF // Add result if the pool is full.
+
+#define MTM_PRIORITY_CLASSES 4 // Number of priority classes, 0 is the highest.
+
+#ifndef MTM_PRIORITY_AGING
+#define MTM_PRIORITY_AGING 1000 // A due task overtakes the next higher class after waiting this long (ms).
+#endif
+
+#define MTM_SLEEP_FOREVER 0xFFFFFFFF // GetSleepTime result if no task is enabled.
+
 #include "stdint.h"
 
 class MillisTaskManager
 {
 public:
 	typedef void (*TaskFunction_t)(void); // Task callback function.
+#if (MTM_USE_STATS == 1)
+	struct TaskStats
+	{
+		uint32_t Runs;						  // Number of executions.
+		uint32_t Overruns;					  // Executions that took longer than the task period.
+		uint32_t CostMin;					  // Shortest run time (us).
+		uint32_t CostMax;					  // Longest run time (us).
+		uint64_t CostSum;					  // Sum of run times (us).
+		uint32_t Starts;					  // Number of executions with a start jitter (all but the first).
+		uint32_t ErrorMin;					  // Smallest start jitter (ms).
+		uint32_t ErrorMax;					  // Largest start jitter (ms).
+		uint64_t ErrorSum;					  // Sum of start jitter (ms).
+		uint16_t CostHist[MTM_HIST_BUCKETS];  // Run time histogram.
+		uint16_t ErrorHist[MTM_HIST_BUCKETS]; // Start jitter histogram.
+	};
+#endif
 	struct Task
 	{
 		bool State;				 // Task state.
@@ -41,31 +88,120 @@ public:
 		uint32_t TimePrev;		 // The last trigger time of the task.
 		uint32_t TimeCost;		 // Task cost (us) time.
 		uint32_t TimeError;		 // Error time.
-		struct Task *Next;		 // next node.
+		uint32_t Deadline;		 // Next trigger time of the task.
+		uint32_t Pass;			 // Running call of the last execution.
+		uint16_t Index;			 // Position in the task table.
+		uint16_t Slot;			 // Pool slot, part of the task handle.
+		uint16_t Generation;	 // Slot reuse counter, part of the task handle.
+		volatile bool Notified;	 // Set by Notify, taken over by Running.
+		bool Triggered;			 // Run on the next Running call because of a Notify.
+		uint8_t Priority;		 // Priority class, 0 is the highest.
+		bool Ready;				 // Task is due and waits in the ready heap.
+		uint16_t ReadyIndex;	 // Position in the ready heap.
+		uint32_t ReadyKey;		 // Ready heap order, due time plus aging offset of the priority class.
+		bool OneShot;			 // Disable the task after each execution.
+#if (MTM_USE_STATS == 1)
+		struct TaskStats Stats; // Run time and start jitter statistics.
+#endif
 	};
 	typedef struct Task Task_t;
+	typedef uint32_t TaskHandle_t; // Task handle, generation and pool slot.
 
 	MillisTaskManager(bool priorityEnable = false);
 	~MillisTaskManager();
 
-	Task_t *Register(TaskFunction_t func, uint32_t timeMs, bool state = true);
+	TaskHandle_t Add(TaskFunction_t func, uint32_t timeMs, bool state = true);
+	bool Remove(TaskHandle_t handle);
+	Task_t *Get(TaskHandle_t handle);
+	TaskHandle_t GetHandle(Task_t *task);
+	bool SetState(TaskHandle_t handle, bool state);
+	bool Notify(TaskHandle_t handle);
+	bool Notify(Task_t *task);
+	bool IsNotified();
+	bool SetPriority(TaskFunction_t func, uint8_t priority);
+	bool SetPriority(TaskHandle_t handle, uint8_t priority);
+	void SetBudget(uint32_t budgetUs);
+
+	Task_t *Register(TaskFunction_t func, uint32_t timeMs, bool state = true, bool oneShot = false);
 	Task_t *Find(TaskFunction_t func);
 	Task_t *GetPrev(Task_t *task);
 	bool Logout(TaskFunction_t func);
 	bool SetState(TaskFunction_t func, bool state);
 	bool SetIntervalTime(TaskFunction_t func, uint32_t timeMs);
+	bool Start(TaskFunction_t func, uint32_t timeMs, uint32_t tick);
 	bool ReSetTaskTime(TaskFunction_t func, uint32_t timeMs);
 	uint32_t GetTimeCost(TaskFunction_t func);
 	uint32_t GetTickElaps(uint32_t nowTick, uint32_t prevTick);
+	bool GetNextDeadline(uint32_t *deadline);
+	uint32_t GetSleepTime(uint32_t tick);
 #if (MTM_USE_CPU_USAGE == 1)
 	float GetCPU_Usage();
+#endif
+	uint16_t GetCount();
+	Task_t *GetTask(uint16_t index);
+#if (MTM_USE_STATS == 1)
+	void ResetStats(Task_t *task);
+	void ResetStats();
+	static uint8_t HistBucket(uint32_t value);
 #endif
 	void Running(uint32_t tick);
 
+protected:
+	MillisTaskManager(Task_t *pool, Task_t **slots, Task_t **table, Task_t **ready, uint16_t capacity, bool priorityEnable);
+
 private:
-	Task_t *Head;		 // Task list header.
-	Task_t *Tail;		 // Tail of the task list.
+	void Init(Task_t **slots, Task_t **table, Task_t **ready, bool priorityEnable);
+	void AddSlots(Task_t *tasks, uint16_t count);
+	bool Grow();
+	Task_t *Alloc(TaskFunction_t func, uint32_t timeMs, bool state);
+	void Free(Task_t *task);
+#if (MTM_USE_STATS == 1)
+	void Record(Task_t *task, uint32_t timeCost, bool first);
+#endif
+	bool Before(Task_t *a, Task_t *b);
+	void Swap(uint16_t a, uint16_t b);
+	void SiftUp(uint16_t index);
+	void SiftDown(uint16_t index);
+	void Update(Task_t *task);
+	void Enable(Task_t *task, bool state);
+	void TakeNotifications();
+	bool ReadyBefore(Task_t *a, Task_t *b);
+	void ReadySwap(uint16_t a, uint16_t b);
+	void ReadySiftUp(uint16_t index);
+	void ReadySiftDown(uint16_t index);
+	void MakeReady(uint32_t tick);
+	void RemoveReady(Task_t *task);
+	void Reschedule(Task_t *task);
+
+	Task_t **Slots;		 // Task of each pool slot, tasks never move.
+	Task_t **Tasks;		 // Task table, waiting tasks as min-heap by deadline, then ready, disabled and free tasks.
+	Task_t **ReadyTasks; // Ready heap, due tasks by priority class and deadline.
+	uint16_t Capacity;	 // Number of tasks in the pool.
+	uint16_t Count;		 // Number of registered tasks.
+	uint16_t HeapSize;	 // Number of enabled tasks that are not due yet.
+	uint16_t ReadySize;	 // Number of due tasks.
+	uint32_t Budget;	 // CPU time per Running call (us), 0 for no limit.
+	uint32_t LastTick;	 // Tick of the last Running call.
+	uint32_t Pass;		 // Running call counter.
 	bool PriorityEnable; // Priority enable.
+	bool OwnPool;		 // Pool is allocated from the heap and grows when it is full.
+	volatile bool NotifyPending; // A task was notified since the last Running call.
+};
+
+/**
+ * @brief Scheduler with a static task pool for N tasks, never allocates from the heap
+ */
+template <uint16_t N>
+class MillisTaskPool : public MillisTaskManager
+{
+public:
+	MillisTaskPool(bool priorityEnable = false) : MillisTaskManager(PoolTasks, PoolSlots, PoolTable, PoolReady, N, priorityEnable) {}
+
+private:
+	Task_t PoolTasks[N];  // Task pool.
+	Task_t *PoolSlots[N]; // Task of each pool slot.
+	Task_t *PoolTable[N]; // Task table.
+	Task_t *PoolReady[N]; // Ready heap.
 };
 
 #endif
@@ -10,24 +10,10 @@
  */
 #include "app.h"
 
-/** Last RX SNR level*/
-volatile int8_t last_snr = 0;
-/** Last RX RSSI level*/
-volatile int16_t last_rssi = 0;
-/** Link check result */
-volatile uint8_t link_check_state;
-/** Demodulation margin */
-volatile uint8_t link_check_demod_margin;
-/** Number of gateways */
-volatile uint8_t link_check_gateways;
 /** Sent packet counter */
 volatile int32_t packet_num = 0;
 /** Lost packet counter (only LPW mode)*/
 volatile int32_t packet_lost = 0;
-/** Last RX data rate */
-volatile uint8_t last_dr = 0;
-/** TX fail reason (only LPW mode)*/
-volatile int32_t tx_fail_status;
 /** Packet Loss Rate (only FieldTester V2 mode) */
 volatile float plr;
 
@@ -45,18 +31,13 @@ bool lorawan_mode = true;
 bool has_oled = false;
 /** Buffer for OLED output */
 char line_str[256];
-/** Flag for display handler */
-uint8_t display_reason;
 
 /** Task Manager for button press */
-MillisTaskManager mtmMain;
+MillisTaskPool<MTM_MAX_TASKS> mtmMain;
 
 /** LoRaWAN packet (used for FieldTester Mode only) */
 WisCayenne g_solution_data(255);
 
-/** Buffer for FieldTester downlink */
-uint8_t field_tester_pckg[32];
-
 /** Flag for GNSS readings active */
 bool gnss_active = false;
 
@@ -70,7 +51,7 @@ bool has_file = false;
 bool has_gnss = false;
 
 /** Name of current log file */
-char volatile file_name[] = "0000-log.csv";
+char volatile file_name[] = "0000-log.bin";
 
 /** Structure for result data */
 volatile result_s result;
@@ -85,9 +66,26 @@ uint8_t sync_time_status = 0;
  */
 void send_packet(void *data)
 {
+	// Skip the uplink if the device did not move since the last one
+	if (motion_skip_send())
+	{
+		MYLOG("APP", "No motion, uplink skipped");
+		if (has_oled && !g_settings_ui)
+		{
+			oled_add_line((char *)"No motion, skipped");
+		}
+		return;
+	}
+
 	tx_active = true;
 	ready_to_dump = false;
 
+	if (has_sd)
+	{
+		// Sample the battery for the SD flush policy once per send cycle
+		check_sd_battery();
+	}
+
 	if ((g_custom_parameters.test_mode == MODE_FIELDTESTER) || (g_custom_parameters.test_mode == MODE_FIELDTESTER_V2))
 	{
 		// Clear payload
@@ -114,6 +112,8 @@ void send_packet(void *data)
 				// Check if we already have a sufficient location fix
 				if (poll_gnss())
 				{
+					// A forced uplink is sent with this fix, the next ones are gated again
+					forced_tx = false;
 					// if (has_oled && !g_settings_ui)
 					// {
 					// oled_clear();
@@ -199,13 +199,13 @@ void send_packet(void *data)
 						gnss_active = true;
 						g_solution_data.reset();
 						check_gnss_counter = 0;
-						// Max location aquisition time is half of send frequency
-						check_gnss_max_try = g_custom_parameters.send_interval / 2 / 2500;
+						gnss_start_time = millis();
+						// Max location aquisition time is half of send frequency, in steps of 2.5 seconds
+						check_gnss_max_try = g_custom_parameters.send_interval / 2 / GNSS_POLL_INTERVAL;
 						// Reset satellites check values
-						max_sat = 0;
-						max_sat_unchanged = 0;
-						// Start the timer
-						api.system.timer.start(RAK_TIMER_3, 2500, NULL);
+						gnss_reset_policy();
+						// Check often for solutions sent by the module, a polled solution is only requested every step
+						job_start(JOB_GNSS, g_custom_parameters.location_on ? GNSS_CHECK_INTERVAL : GNSS_POLL_INTERVAL);
 					}
 				}
 			}
@@ -326,6 +326,8 @@ void send_packet(void *data)
 					{
 						g_last_long = 0.0;
 						g_last_lat = 0.0;
+						g_last_longitude = 0;
+						g_last_latitude = 0;
 					}
 
 					// Check if packet size fits DR
@@ -384,7 +386,8 @@ void send_packet(void *data)
 /**
  * @brief Display handler
  *
- * @param reason 1 = RX packet display (only P2P mode)
+ * @param event radio event, the reason is
+ *               1 = RX packet display (only P2P mode)
  *               2 = TX failed display (only LPW LinkCheck mode)
  *               3 = Join failed (only LPW mode)
  *               4 = Linkcheck result display (only LPW LinkCheck mode)
@@ -392,8 +395,10 @@ void send_packet(void *data)
  *               6 = FieldTester downlink packet (only FieldTester mode )
  *               7 = FieldTester no downlink packet (only FieldTester mode )
  *               8 = P2P TX finished (only P2P mode)
+ *               The RSSI, SNR, status and downlink payload are taken
+ *               from the event, not from the last callback.
  */
-void handle_display(void *reason)
+void handle_display(radio_event_s *event)
 {
 	digitalWrite(LED_BLUE, LOW);
 	digitalWrite(LED_GREEN, LOW);
@@ -415,17 +420,14 @@ void handle_display(void *reason)
 		}
 		oled_write_header(line_str);
 	}
-	// Get the wakeup reason
-	uint8_t *disp_reason = (uint8_t *)reason;
-
 	// Check if we have a reason
-	if (disp_reason == NULL)
+	if (event == NULL)
 	{
 		MYLOG("APP", "Bug in code!");
 	}
-	else if (disp_reason[0] == 1) // RX packet display (only P2P mode)
+	else if (event->reason == RADIO_P2P_RX) // RX packet display (only P2P mode)
 	{
-		// MYLOG("APP", "RX_EVENT %d, disp_reason[0]);
+		// MYLOG("APP", "RX_EVENT %d, event->reason);
 		// RX event display
 		if (has_sd)
 		{
@@ -445,16 +447,16 @@ void handle_display(void *reason)
 			result.sec = g_date_time.second;
 			result.mode = MODE_P2P;
 			result.gw = 0;
-			result.lat = g_last_lat;
-			result.lng = g_last_long;
+			result.lat = g_last_latitude;
+			result.lng = g_last_longitude;
 			result.min_rssi = 0;
 			result.max_rssi = 0;
-			result.rx_rssi = last_rssi;
-			result.rx_snr = last_snr;
+			result.rx_rssi = event->rssi;
+			result.rx_snr = event->snr;
 			result.min_dst = 0;
 			result.max_dst = 0;
 			result.demod = 0;
-			result.lost = packet_lost;
+			result.lost = event->lost;
 			write_sd_entry();
 		}
 		if (has_oled && !g_settings_ui)
@@ -509,20 +511,20 @@ void handle_display(void *reason)
 			oled_write_line(3, 64, line_str);
 			sprintf(line_str, "CR 4/%d", api.lora.pcr.get() + 5);
 			oled_write_line(2, 64, line_str);
-			sprintf(line_str, "RSSI %d", last_rssi);
+			sprintf(line_str, "RSSI %d", event->rssi);
 			oled_write_line(4, 0, line_str);
-			sprintf(line_str, "SNR %d", last_snr);
+			sprintf(line_str, "SNR %d", event->snr);
 			oled_write_line(4, 64, line_str);
 			oled_display();
 		}
 		MYLOG("APP", "LPW P2P mode");
-		MYLOG("APP", "Packet # %d RSSI %d SNR %d", packet_num, last_rssi, last_snr);
+		MYLOG("APP", "Packet # %d RSSI %d SNR %d", packet_num, event->rssi, event->snr);
 		MYLOG("APP", "F %.3f SF %d BW %d",
 			  (float)api.lora.pfreq.get() / 1000000.0,
 			  api.lora.psf.get(),
 			  (api.lora.pbw.get() + 1) * 125);
 	}
-	else if (display_reason == 2) // TX failed display (only LPW LinkCheck mode)
+	else if (event->reason == RADIO_TX_FAILED) // TX failed display (only LPW LinkCheck mode)
 	{
 		tx_active = false;
 
@@ -544,8 +546,8 @@ void handle_display(void *reason)
 			result.sec = g_date_time.second;
 			result.mode = MODE_LINKCHECK;
 			result.gw = 0;
-			result.lat = g_last_lat;
-			result.lng = g_last_long;
+			result.lat = g_last_latitude;
+			result.lng = g_last_longitude;
 			result.min_rssi = 0;
 			result.max_rssi = 0;
 			result.rx_rssi = 0;
@@ -553,7 +555,7 @@ void handle_display(void *reason)
 			result.min_dst = 0;
 			result.max_dst = 0;
 			result.demod = 0;
-			result.lost = packet_lost;
+			result.lost = event->lost;
 			result.tx_dr = api.lorawan.dr.get();
 			write_sd_entry();
 		}
@@ -561,9 +563,9 @@ void handle_display(void *reason)
 		{
 			sprintf(line_str, "LinkCheck Mode");
 			oled_write_line(0, 0, line_str);
-			sprintf(line_str, "TX Error ", tx_fail_status);
+			sprintf(line_str, "TX Error ", event->status);
 			oled_write_line(2, 0, line_str);
-			switch (tx_fail_status)
+			switch (event->status)
 			{
 			case RAK_LORAMAC_STATUS_ERROR:
 				sprintf(line_str, "Service error");
@@ -621,9 +623,9 @@ void handle_display(void *reason)
 			oled_display();
 		}
 	}
-	else if (disp_reason[0] == 3) // Join failed (only LPW mode)
+	else if (event->reason == RADIO_JOIN_FAILED) // Join failed (only LPW mode)
 	{
-		// MYLOG("APP", "JOIN_ERROR %d\n", disp_reason[0]);
+		// MYLOG("APP", "JOIN_ERROR %d\n", event->reason);
 		if (has_oled && !g_settings_ui)
 		{
 			switch (g_custom_parameters.test_mode)
@@ -647,9 +649,9 @@ void handle_display(void *reason)
 			oled_display();
 		}
 	}
-	else if (disp_reason[0] == 4) // Linkcheck result display (only LPW LinkCheck mode)
+	else if (event->reason == RADIO_LINKCHECK) // Linkcheck result display (only LPW LinkCheck mode)
 	{
-		// MYLOG("APP", "LINK_CHECK %d\n", disp_reason[0]);
+		// MYLOG("APP", "LINK_CHECK %d\n", event->reason);
 		// LinkCheck result event display
 		if (has_sd)
 		{
@@ -668,40 +670,40 @@ void handle_display(void *reason)
 			result.min = g_date_time.minute;
 			result.sec = g_date_time.second;
 			result.mode = MODE_LINKCHECK;
-			result.gw = link_check_gateways;
-			result.lat = g_last_lat;
-			result.lng = g_last_long;
-			result.min_rssi = last_rssi;
-			result.max_rssi = last_rssi;
-			result.rx_rssi = last_rssi;
-			result.rx_snr = last_snr;
+			result.gw = event->gateways;
+			result.lat = g_last_latitude;
+			result.lng = g_last_longitude;
+			result.min_rssi = event->rssi;
+			result.max_rssi = event->rssi;
+			result.rx_rssi = event->rssi;
+			result.rx_snr = event->snr;
 			result.min_dst = 0;
 			result.max_dst = 0;
-			result.demod = link_check_demod_margin;
-			result.lost = packet_lost;
+			result.demod = event->demod_margin;
+			result.lost = event->lost;
 			result.tx_dr = api.lorawan.dr.get();
 			write_sd_entry();
 		}
 		if (has_oled && !g_settings_ui)
 		{
-			sprintf(line_str, "LPW LinkCheck %s", link_check_state == 0 ? "OK" : "NOK");
+			sprintf(line_str, "LPW LinkCheck %s", event->link_check_state == 0 ? "OK" : "NOK");
 			oled_write_line(0, 0, line_str);
 
-			if (link_check_state == 0)
+			if (event->link_check_state == 0)
 			{
-				sprintf(line_str, "UL Demod Margin  %d", link_check_demod_margin);
+				sprintf(line_str, "UL Demod Margin  %d", event->demod_margin);
 				oled_write_line(1, 0, line_str);
 				sprintf(line_str, "UL DR %d", api.lorawan.dr.get());
 				oled_write_line(2, 0, line_str);
-				sprintf(line_str, "%d GW(s)", link_check_gateways);
+				sprintf(line_str, "%d GW(s)", event->gateways);
 				oled_write_line(2, 64, line_str);
 				sprintf(line_str, "Sent %d", packet_num);
 				oled_write_line(3, 0, line_str);
 				sprintf(line_str, "Lost %d", packet_lost);
 				oled_write_line(3, 64, line_str);
-				sprintf(line_str, "DL RSSI %d", last_rssi);
+				sprintf(line_str, "DL RSSI %d", event->rssi);
 				oled_write_line(4, 0, line_str);
-				sprintf(line_str, "DL SNR %d", last_snr);
+				sprintf(line_str, "DL SNR %d", event->snr);
 				oled_write_line(4, 64, line_str);
 			}
 			else
@@ -710,9 +712,9 @@ void handle_display(void *reason)
 				oled_write_line(1, 0, line_str);
 				sprintf(line_str, "Lost %d", packet_lost);
 				oled_write_line(1, 64, line_str);
-				sprintf(line_str, "LinkCheck result %d ", link_check_state);
+				sprintf(line_str, "LinkCheck result %d ", event->link_check_state);
 				oled_write_line(2, 0, line_str);
-				switch (link_check_state)
+				switch (event->link_check_state)
 				{
 				case RAK_LORAMAC_STATUS_ERROR:
 					sprintf(line_str, "Service error");
@@ -774,13 +776,13 @@ void handle_display(void *reason)
 			}
 			oled_display();
 		}
-		MYLOG("APP", "LinkCheck %s", link_check_state == 0 ? "OK" : "NOK");
-		MYLOG("APP", "Packet # %d RSSI %d SNR %d", packet_num, last_rssi, last_snr);
-		MYLOG("APP", "GW # %d Demod Margin %d", link_check_gateways, link_check_demod_margin);
+		MYLOG("APP", "LinkCheck %s", event->link_check_state == 0 ? "OK" : "NOK");
+		MYLOG("APP", "Packet # %d RSSI %d SNR %d", packet_num, event->rssi, event->snr);
+		MYLOG("APP", "GW # %d Demod Margin %d", event->gateways, event->demod_margin);
 	}
-	else if (disp_reason[0] == 5) // Join success (only LPW mode)
+	else if (event->reason == RADIO_JOIN_OK) // Join success (only LPW mode)
 	{
-		// MYLOG("APP", "JOIN_SUCCESS %d\n", disp_reason[0]);
+		// MYLOG("APP", "JOIN_SUCCESS %d\n", event->reason);
 		if (has_oled && !g_settings_ui)
 		{
 			switch (g_custom_parameters.test_mode)
@@ -804,26 +806,17 @@ void handle_display(void *reason)
 			oled_display();
 		}
 	}
-	else if (display_reason == 6) // FieldTester downlink packet (only FieldTester mode )
+	else if (event->reason == RADIO_FT_DOWNLINK) // FieldTester downlink packet (only FieldTester mode )
 	{
 		// 01 01 a7 00 00 02 01 d5 09 20 ca
-		if (g_custom_parameters.test_mode == MODE_FIELDTESTER_V2)
+		// Downlink was parsed by the receive callback
+		field_tester_dl_s *dl = &event->dl;
+		if (dl->version == 2)
 		{
-			uint16_t plr_i = ((uint16_t)field_tester_pckg[0] << 8) + (uint16_t)field_tester_pckg[1];
-			plr = plr_i / 10;
-			int8_t max_rssi = field_tester_pckg[2] - 200;
-			int16_t min_distance = (int16_t)field_tester_pckg[3] * 250;
-			int16_t max_distance = (int16_t)field_tester_pckg[4] * 250;
-			int8_t num_gateways = field_tester_pckg[5] >> 4;
-			int16_t seq_id = (int16_t)field_tester_pckg[5] & 0x0F + (int16_t)field_tester_pckg[6];
-			int8_t max_snr = field_tester_pckg[7] - 200;
-			uint8_t gw_eui[8] = {0xac, 0x1f, 0x09, 0xff, 0xfe, 0x00, 0x00, 0x00};
-			gw_eui[5] = field_tester_pckg[8];
-			gw_eui[6] = field_tester_pckg[9];
-			gw_eui[7] = field_tester_pckg[10];
-			MYLOG("APP", "+EVT:FieldTester V2 %d gateways", num_gateways);
-			MYLOG("APP", "+EVT:RSSI max %d, SNR max %d", max_rssi, max_snr);
-			MYLOG("APP", "+EVT:Distance min %d max %d", min_distance, max_distance);
+			plr = dl->plr / 10.0;
+			MYLOG("APP", "+EVT:FieldTester V2 %d gateways", dl->gateways);
+			MYLOG("APP", "+EVT:RSSI max %d, SNR max %d", dl->max_rssi, dl->max_snr);
+			MYLOG("APP", "+EVT:Distance min %d max %d", dl->min_distance, dl->max_distance);
 			if (has_sd)
 			{
 				if (has_rtc)
@@ -841,18 +834,18 @@ void handle_display(void *reason)
 				result.min = g_date_time.minute;
 				result.sec = g_date_time.second;
 				result.mode = MODE_FIELDTESTER_V2;
-				result.gw = num_gateways;
-				result.lat = g_last_lat;
-				result.lng = g_last_long;
+				result.gw = dl->gateways;
+				result.lat = g_last_latitude;
+				result.lng = g_last_longitude;
 				result.min_rssi = 0;
-				result.max_rssi = max_rssi;
-				result.max_snr = max_snr;
-				result.rx_rssi = last_rssi;
-				result.rx_snr = last_snr;
-				result.min_dst = min_distance;
-				result.max_dst = max_distance;
+				result.max_rssi = dl->max_rssi;
+				result.max_snr = dl->max_snr;
+				result.rx_rssi = event->rssi;
+				result.rx_snr = event->snr;
+				result.min_dst = dl->min_distance;
+				result.max_dst = dl->max_distance;
 				result.demod = 0;
-				result.lost = plr_i;
+				result.lost = dl->plr;
 				result.tx_dr = api.lorawan.dr.get();
 				write_sd_entry();
 			}
@@ -861,11 +854,11 @@ void handle_display(void *reason)
 				oled_clear();
 				oled_write_header((char *)"RAK FieldTest V2");
 
-				sprintf(line_str, "DL RX SNR: %d RSSI: %d", last_snr, last_rssi);
+				sprintf(line_str, "DL RX SNR: %d RSSI: %d", event->snr, event->rssi);
 				oled_write_line(0, 0, line_str);
-				sprintf(line_str, "UL TX SNR: %d RSSI: %d", max_snr, max_rssi);
+				sprintf(line_str, "UL TX SNR: %d RSSI: %d", dl->max_snr, dl->max_rssi);
 				oled_write_line(1, 0, line_str);
-				sprintf(line_str, "GW(s): %d\n", num_gateways);
+				sprintf(line_str, "GW(s): %d\n", dl->gateways);
 				oled_write_line(2, 0, line_str);
 				oled_write_line(2, 50, "Min");
 				oled_write_line(2, 80, "Max");
@@ -873,9 +866,9 @@ void handle_display(void *reason)
 
 				if (g_custom_parameters.location_on)
 				{
-					sprintf(line_str, "%d", min_distance);
+					sprintf(line_str, "%d", dl->min_distance);
 					oled_write_line(3, 50, line_str);
-					sprintf(line_str, "%d", max_distance);
+					sprintf(line_str, "%d", dl->max_distance);
 					oled_write_line(3, 80, line_str);
 					sprintf(line_str, "PLR: %.1f   Sent: %d", plr, packet_num);
 					// sprintf(line_str, "L %.6f:%.6f", g_last_lat, g_last_long);
@@ -895,14 +888,9 @@ void handle_display(void *reason)
 		}
 		else
 		{
-			int16_t min_rssi = field_tester_pckg[1] - 200;
-			int16_t max_rssi = field_tester_pckg[2] - 200;
-			int16_t min_distance = field_tester_pckg[3] * 250;
-			int16_t max_distance = field_tester_pckg[4] * 250;
-			int8_t num_gateways = field_tester_pckg[5];
-			MYLOG("APP", "+EVT:FieldTester %d gateways", num_gateways);
-			MYLOG("APP", "+EVT:RSSI min %d max %d", min_rssi, max_rssi);
-			MYLOG("APP", "+EVT:Distance min %d max %d", min_distance, max_distance);
+			MYLOG("APP", "+EVT:FieldTester %d gateways", dl->gateways);
+			MYLOG("APP", "+EVT:RSSI min %d max %d", dl->min_rssi, dl->max_rssi);
+			MYLOG("APP", "+EVT:Distance min %d max %d", dl->min_distance, dl->max_distance);
 
 			if (has_sd)
 			{
@@ -921,17 +909,17 @@ void handle_display(void *reason)
 				result.min = g_date_time.minute;
 				result.sec = g_date_time.second;
 				result.mode = MODE_FIELDTESTER;
-				result.gw = num_gateways;
-				result.lat = g_last_lat;
-				result.lng = g_last_long;
-				result.min_rssi = min_rssi;
-				result.max_rssi = max_rssi;
-				result.rx_rssi = last_rssi;
-				result.rx_snr = last_snr;
-				result.min_dst = min_distance;
-				result.max_dst = max_distance;
+				result.gw = dl->gateways;
+				result.lat = g_last_latitude;
+				result.lng = g_last_longitude;
+				result.min_rssi = dl->min_rssi;
+				result.max_rssi = dl->max_rssi;
+				result.rx_rssi = event->rssi;
+				result.rx_snr = event->snr;
+				result.min_dst = dl->min_distance;
+				result.max_dst = dl->max_distance;
 				result.demod = 0;
-				result.lost = packet_lost;
+				result.lost = event->lost;
 				result.tx_dr = api.lorawan.dr.get();
 				write_sd_entry();
 			}
@@ -940,25 +928,25 @@ void handle_display(void *reason)
 				oled_clear();
 				oled_write_header((char *)"RAK FieldTester");
 
-				sprintf(line_str, "DL RX SNR: %d RSSI: %d", last_snr, last_rssi);
+				sprintf(line_str, "DL RX SNR: %d RSSI: %d", event->snr, event->rssi);
 				oled_write_line(0, 0, line_str);
-				sprintf(line_str, "GW(s): %d\n", num_gateways);
+				sprintf(line_str, "GW(s): %d\n", dl->gateways);
 				oled_write_line(1, 0, line_str);
 				oled_write_line(1, 50, "RSSI");
 				oled_write_line(1, 80, "Distance");
 				oled_write_line(2, 0, "Min");
 				oled_write_line(3, 0, "Max");
 
-				sprintf(line_str, "%d", min_rssi);
+				sprintf(line_str, "%d", dl->min_rssi);
 				oled_write_line(2, 50, line_str);
-				sprintf(line_str, "%d", max_rssi);
+				sprintf(line_str, "%d", dl->max_rssi);
 				oled_write_line(3, 50, line_str);
 
 				if (g_custom_parameters.location_on)
 				{
-					sprintf(line_str, "%d", min_distance);
+					sprintf(line_str, "%d", dl->min_distance);
 					oled_write_line(2, 80, line_str);
-					sprintf(line_str, "%d", max_distance);
+					sprintf(line_str, "%d", dl->max_distance);
 					oled_write_line(3, 80, line_str);
 					sprintf(line_str, "Lost: %d   Sent: %d", packet_lost, packet_num);
 					// sprintf(line_str, "L %.6f:%.6f", g_last_lat, g_last_long);
@@ -977,7 +965,7 @@ void handle_display(void *reason)
 			}
 		}
 	}
-	else if (display_reason == 7) // FieldTester no downlink packet (only FieldTester mode )
+	else if (event->reason == RADIO_FT_NO_DOWNLINK) // FieldTester no downlink packet (only FieldTester mode )
 	{
 		MYLOG("APP", "+EVT:FieldTester no downlink");
 
@@ -999,8 +987,8 @@ void handle_display(void *reason)
 			result.sec = g_date_time.second;
 			result.mode = MODE_FIELDTESTER;
 			result.gw = 0;
-			result.lat = g_last_lat;
-			result.lng = g_last_long;
+			result.lat = g_last_latitude;
+			result.lng = g_last_longitude;
 			result.min_rssi = 0;
 			result.max_rssi = 0;
 			result.rx_rssi = 0;
@@ -1008,7 +996,7 @@ void handle_display(void *reason)
 			result.min_dst = 0;
 			result.max_dst = 0;
 			result.demod = 0;
-			result.lost = packet_lost;
+			result.lost = event->lost;
 			result.tx_dr = api.lorawan.dr.get();
 			write_sd_entry();
 		}
@@ -1038,7 +1026,7 @@ void handle_display(void *reason)
 			oled_display();
 		}
 	}
-	else if (display_reason == 8) // P2P TX finished (only P2P mode)
+	else if (event->reason == RADIO_TX_DONE) // P2P TX finished (only P2P mode)
 	{
 		switch (g_custom_parameters.test_mode)
 		{
@@ -1075,16 +1063,17 @@ void handle_display(void *reason)
  */
 void join_cb_lpw(int32_t status)
 {
+	radio_event_s event = {0};
+	event.status = status;
 	if (status != 0)
 	{
-		display_reason = 3;
-		api.system.timer.start(RAK_TIMER_1, 250, &display_reason);
+		event.reason = RADIO_JOIN_FAILED;
 	}
 	else
 	{
-		display_reason = 5;
-		api.system.timer.start(RAK_TIMER_1, 250, &display_reason);
+		event.reason = RADIO_JOIN_OK;
 	}
+	post_radio_event(&event);
 	tx_active = false;
 }
 
@@ -1097,8 +1086,9 @@ void send_cb_p2p(void)
 {
 	tx_active = false;
 
-	display_reason = 8;
-	api.system.timer.start(RAK_TIMER_1, 250, &display_reason);
+	radio_event_s event = {0};
+	event.reason = RADIO_TX_DONE;
+	post_radio_event(&event);
 }
 
 /**
@@ -1108,13 +1098,15 @@ void send_cb_p2p(void)
  */
 void recv_cb_p2p(rui_lora_p2p_recv_t data)
 {
-	last_rssi = data.Rssi;
-	last_snr = data.Snr;
+	radio_event_s event = {0};
+	event.reason = RADIO_P2P_RX;
+	event.rssi = data.Rssi;
+	event.snr = data.Snr;
+	event.lost = packet_lost;
 	// packet_num++;
 	tx_active = false;
 
-	display_reason = 1;
-	api.system.timer.start(RAK_TIMER_1, 250, &display_reason);
+	post_radio_event(&event);
 }
 
 /**
@@ -1124,9 +1116,10 @@ void recv_cb_p2p(rui_lora_p2p_recv_t data)
  */
 void recv_cb_lpw(SERVICE_LORA_RECEIVE_T *data)
 {
-	last_rssi = data->Rssi;
-	last_snr = data->Snr;
-	last_dr = data->RxDatarate;
+	radio_event_s event = {0};
+	event.rssi = data->Rssi;
+	event.snr = data->Snr;
+	event.dr = data->RxDatarate;
 
 	// packet_num++;
 	tx_active = false;
@@ -1140,9 +1133,20 @@ void recv_cb_lpw(SERVICE_LORA_RECEIVE_T *data)
 	{
 		if (data->Port == 2)
 		{
-			display_reason = 6;
-			memcpy(field_tester_pckg, data->Buffer, data->BufferSize);
-			api.system.timer.start(RAK_TIMER_1, 250, &display_reason);
+			// Parse straight from the receive buffer, only the parsed values are queued
+			if (parse_field_tester_dl(data->Buffer, data->BufferSize, g_custom_parameters.test_mode == MODE_FIELDTESTER_V2, &event.dl))
+			{
+				event.reason = RADIO_FT_DOWNLINK;
+			}
+			else
+			{
+				// Invalid downlink, the uplink is logged and counted as lost
+				MYLOG("RX-CB", "Invalid downlink size %d", data->BufferSize);
+				packet_lost++;
+				event.reason = RADIO_FT_NO_DOWNLINK;
+			}
+			event.lost = packet_lost;
+			post_radio_event(&event);
 		}
 		else
 		{
@@ -1162,25 +1166,27 @@ void send_cb_lpw(int32_t status)
 	{
 		tx_active = false;
 		MYLOG("APP", "LMC status %d\n", status);
-		tx_fail_status = status;
+		radio_event_s event = {0};
+		event.status = status;
 
 		if ((g_custom_parameters.test_mode == MODE_FIELDTESTER) || (g_custom_parameters.test_mode == MODE_FIELDTESTER_V2))
 		{
 			packet_lost++;
-			display_reason = 7;
-			api.system.timer.start(RAK_TIMER_1, 250, &display_reason);
+			event.reason = RADIO_FT_NO_DOWNLINK;
 		}
 		else
 		{
 			packet_lost++;
-			display_reason = 2;
-			api.system.timer.start(RAK_TIMER_1, 250, &display_reason);
+			event.reason = RADIO_TX_FAILED;
 		}
+		event.lost = packet_lost;
+		post_radio_event(&event);
 	}
 	else if (tx_active)
 	{
-		display_reason = 8;
-		api.system.timer.start(RAK_TIMER_1, 250, &display_reason);
+		radio_event_s event = {0};
+		event.reason = RADIO_TX_DONE;
+		post_radio_event(&event);
 	}
 }
 
@@ -1197,17 +1203,19 @@ void linkcheck_cb_lpw(SERVICE_LORA_LINKCHECK_T *data)
 		return;
 	}
 	// MYLOG("APP", "linkcheck_cb_lpw\n");
-	last_snr = data->Snr;
-	last_rssi = data->Rssi;
-	link_check_state = data->State;
-	link_check_demod_margin = data->DemodMargin;
-	link_check_gateways = data->NbGateways;
+	radio_event_s event = {0};
+	event.reason = RADIO_LINKCHECK;
+	event.snr = data->Snr;
+	event.rssi = data->Rssi;
+	event.link_check_state = data->State;
+	event.demod_margin = data->DemodMargin;
+	event.gateways = data->NbGateways;
 	if (data->State != 0)
 	{
 		packet_lost++;
 	}
-	display_reason = 4;
-	api.system.timer.start(RAK_TIMER_1, 250, &display_reason);
+	event.lost = packet_lost;
+	post_radio_event(&event);
 }
 
 /**
@@ -1369,6 +1377,20 @@ void setup(void)
 	{
 		MYLOG("APP", "Failed to initialize Product Info AT command");
 	}
+	if (!init_gnss_policy_at())
+	{
+		MYLOG("APP", "Failed to initialize GNSS Fix Policy AT command");
+	}
+	if (!init_motion_at())
+	{
+		MYLOG("APP", "Failed to initialize Motion Gate AT command");
+	}
+#if (MTM_USE_STATS == 1)
+	if (!init_task_stats_at())
+	{
+		MYLOG("APP", "Failed to initialize Task Statistics AT command");
+	}
+#endif
 
 	// Get saved custom settings
 	if (!get_at_setting())
@@ -1382,8 +1404,11 @@ void setup(void)
 		MYLOG("APP", "Failed to initialize button");
 	}
 
-	// Initialize ACC (set to sleep as default)
-	init_acc(false);
+	// Register the send, display, display saver and GNSS jobs in mtmMain
+	init_jobs();
+
+	// Initialize ACC (set to sleep as default, active with the motion gate)
+	has_acc = init_acc(g_custom_parameters.motion_gate) && g_custom_parameters.motion_gate;
 
 	// Initialize GNSS (set to sleep as default)
 	if ((g_custom_parameters.test_mode == MODE_FIELDTESTER) || (g_custom_parameters.test_mode == MODE_FIELDTESTER_V2))
@@ -1439,14 +1464,19 @@ void setup(void)
 	}
 	else
 	{
-		// New file creation
-		has_sd = create_sd_file();
+		// Continue the last log file or create a new one
+		has_sd = resume_sd_file() || create_sd_file();
 		if (!has_sd)
 		{
 			MYLOG("APP", "Failed to create file");
 		}
 		MYLOG("APP", "New file created has_sd = %s", has_sd ? "true" : "false");
 		init_dump_logs_at();
+		init_log_rotation_at();
+		// Log records are written to the card by the writer task
+		mtmMain.Register(sd_writer_task, SD_WRITER_RETRY);
+		// SD card writes yield to the button handler
+		mtmMain.SetPriority(sd_writer_task, 2);
 	}
 
 	if (has_sd)
@@ -1454,6 +1484,13 @@ void setup(void)
 		oled_add_line((char *)"SD Card OK");
 	}
 
+	// Give the GNSS module the last position, the time and the navigation database after the reboot, the time needs the RTC, the database the SD card
+	// If the module is not powered yet, poll_gnss() does it on the first use
+	if (has_gnss && gnss_warm_pending && gnss_power_on())
+	{
+		gnss_warm_start();
+	}
+
 	// Setup callbacks and timers depending on test mode
 	switch (g_custom_parameters.test_mode)
 	{
@@ -1509,29 +1546,21 @@ void setup(void)
 	sprintf(line_str, "Test interval  %lds", g_custom_parameters.send_interval / 1000);
 	oled_add_line(line_str);
 
-	// Create timer for periodic sending
-	api.system.timer.create(RAK_TIMER_0, send_packet, RAK_TIMER_PERIODIC);
+	// Start periodic sending
 	// if (lorawan_mode)
 	{
 		if (g_custom_parameters.send_interval != 0)
 		{
-			api.system.timer.start(RAK_TIMER_0, g_custom_parameters.send_interval, NULL);
+			job_start(JOB_SEND, g_custom_parameters.send_interval);
 		}
 	}
 
-	//  Create timer for display handler
-	api.system.timer.create(RAK_TIMER_1, handle_display, RAK_TIMER_ONESHOT);
-
-	// Create timer for display saver
-	api.system.timer.create(RAK_TIMER_2, oled_saver, RAK_TIMER_ONESHOT);
+	// Start display saver
 	if (g_custom_parameters.display_saver)
 	{
-		api.system.timer.start(RAK_TIMER_2, 60000, NULL);
+		job_start(JOB_OLED_SAVER, 60000);
 	}
 
-	// Create timer for GNSS location acquisition
-	api.system.timer.create(RAK_TIMER_3, gnss_handler, RAK_TIMER_PERIODIC);
-
 	// If LoRaWAN, start join if required
 	if (lorawan_mode)
 	{
@@ -1546,16 +1575,23 @@ void setup(void)
 }
 
 /**
- * @brief Loop (unused)
+ * @brief Loop
  *
  */
 void loop(void)
 {
-	// api.system.sleep.all(100);
-	if (pressCount != 0)
+	// Start and stop jobs as requested by callbacks and the UI, then run the due jobs and tasks
+	dispatch_events();
+	mtmMain.Running(millis());
+#if TICKLESS_LOOP > 0
+	// Sleep until the next job is due, button and radio interrupts wake up earlier.
+	// Only the CPU sleeps, the radio has to stay in P2P RX and keep the LoRaWAN RX windows
+	uint32_t sleep_time = events_pending() ? 0 : mtmMain.GetSleepTime(millis());
+	if (sleep_time != 0)
 	{
-		mtmMain.Running(millis());
+		api.system.sleep.cpu(sleep_time < TICKLESS_MAX_SLEEP ? sleep_time : TICKLESS_MAX_SLEEP);
 	}
+#endif
 }
 
 /**
@@ -1590,9 +1626,9 @@ void set_linkcheck(void)
 		// Enable GNSS module
 		digitalWrite(WB_IO2, HIGH);
 	}
-	else
+	else if (!has_sd)
 	{
-		// Disable GNSS module
+		// Disable GNSS module (shares the power rail with the SD card, keep it on while logging)
 		digitalWrite(WB_IO2, LOW);
 	}
 }
@@ -1623,9 +1659,9 @@ void set_p2p(void)
 		// Enable GNSS module
 		digitalWrite(WB_IO2, HIGH);
 	}
-	else
+	else if (!has_sd)
 	{
-		// Disable GNSS module
+		// Disable GNSS module (shares the power rail with the SD card, keep it on while logging)
 		digitalWrite(WB_IO2, LOW);
 	}
 }
@@ -16,6 +16,13 @@ void acc_int_callback(void);
 /** The LIS3DH sensor */
 LIS3DH acc_sensor(I2C_MODE, 0x18);
 
+/** Flag if the ACC sensor is active */
+bool has_acc = false;
+/** Flag for motion since the last uplink, set by the ACC interrupt */
+volatile bool motion_since_send = true;
+/** Flag if an uplink was skipped because the device did not move */
+bool send_skipped = false;
+
 /**
  * @brief Initialize LIS3DH 3-axis
  *
@@ -146,12 +153,63 @@ void read_acc(void)
 }
 
 /**
- * @brief ACC interrupt handler (unused)
+ * @brief ACC interrupt handler
+ * 		Flags the motion and starts the motion job, the interrupt
+ * 		is latched until the motion job clears it.
  *
  */
 void acc_int_callback(void)
 {
+	motion_since_send = true;
+	job_start(JOB_MOTION, 0);
+}
+
+/**
+ * @brief Motion job, one-shot after an ACC interrupt
+ * 		Clears the latched interrupt. If uplinks were skipped because
+ * 		the device did not move, the next uplink is sent now and the
+ * 		send interval starts again.
+ *
+ */
+void handle_motion(void)
+{
+	clear_acc_int();
+	if (send_skipped)
+	{
+		send_skipped = false;
+		MYLOG("ACC", "Motion, send now");
+		if (g_custom_parameters.send_interval != 0)
+		{
+			job_start(JOB_SEND, g_custom_parameters.send_interval);
+		}
+		send_packet(NULL);
+	}
+}
 
+/**
+ * @brief Check if an uplink can be skipped.
+ * 		With the motion gate on, FieldTester uplinks with location are
+ * 		skipped while the device did not move since the last uplink and
+ * 		the last location is still valid. Forced uplinks and DR sweeps
+ * 		are never skipped.
+ *
+ * @return true skip the uplink
+ * @return false send the uplink, the motion flag is cleared
+ */
+bool motion_skip_send(void)
+{
+	if (!g_custom_parameters.motion_gate || !has_acc || !g_custom_parameters.location_on || forced_tx || dr_sweep_active || gnss_active ||
+		((g_custom_parameters.test_mode != MODE_FIELDTESTER) && (g_custom_parameters.test_mode != MODE_FIELDTESTER_V2)))
+	{
+		return false;
+	}
+	if (!motion_since_send && ((g_last_lat != 0) || (g_last_long != 0)))
+	{
+		send_skipped = true;
+		return true;
+	}
+	motion_since_send = false;
+	return false;
 }
 
 /**
@@ -70,7 +70,19 @@ struct custom_param_s
 	uint8_t custom_packet[129] = {0x01, 0x02, 0x03, 0x04};
 	uint16_t custom_packet_len = 4;
 	bool dr_sweep_on = false;
+	uint16_t log_max_rows = 300;  // Rows per log file, 0 = no limit
+	uint16_t log_max_kb = 0;	  // Size of a log file in kB, 0 = no limit
+	uint16_t log_max_minutes = 0; // Time span of a log file, 0 = no limit
+	uint8_t log_rotate = 0;		  // Rotation flags, see LOG_ROTATE_DAY and LOG_ROTATE_BOOT
+	uint8_t gnss_policy = 0;	  // Fix acceptance policy, see gnss_policy_t
+	uint16_t gnss_hacc_max = 50;  // Max horizontal accuracy estimate of the hacc policy (m)
+	uint8_t gnss_deadline = 75;	  // Accept any 3D fix after this part of the acquisition time (%), 0 = never
+	bool motion_gate = false;	  // Skip FieldTester uplinks while the device does not move
 };
+/** Start a new log file when the date changes */
+#define LOG_ROTATE_DAY 0x01
+/** Start a new log file on every restart */
+#define LOG_ROTATE_BOOT 0x02
 // Structure size without CRC
 #define custom_params_len sizeof(custom_param_s)
 
@@ -92,9 +104,13 @@ bool init_interval_at(void);
 bool init_test_mode_at(void);
 bool init_custom_pckg_at(void);
 bool init_dump_logs_at(void);
+bool init_log_rotation_at(void);
+bool init_gnss_policy_at(void);
+bool init_motion_at(void);
 bool init_rtc_at(void);
 bool init_app_ver_at(void);
 bool init_product_info_at(void);
+bool init_task_stats_at(void);
 bool get_at_setting(void);
 bool save_at_setting(void);
 void set_linkcheck(void);
@@ -183,8 +199,89 @@ bool buttonInit(void);
 uint8_t getButtonStatus(void);
 void handle_button(void);
 void buttonIntHandle(void);
-extern MillisTaskManager mtmMain;
+extern MillisTaskPool<MTM_MAX_TASKS> mtmMain;
 extern volatile uint8_t pressCount;
+/** Sleep in loop() until the next task is due, set to 0 to poll */
+#ifndef TICKLESS_LOOP
+#define TICKLESS_LOOP 1
+#endif
+/** Longest sleep of loop() (ms), in case an event does not end the sleep */
+#ifndef TICKLESS_MAX_SLEEP
+#define TICKLESS_MAX_SLEEP 1000
+#endif
+
+// Jobs
+/** Jobs run by mtmMain */
+enum app_jobs_t
+{
+	JOB_SEND = 0,	// Send a packet, periodic
+	JOB_DISPLAY,	// Show a radio event, one-shot
+	JOB_OLED_SAVER, // Switch the display off, one-shot
+	JOB_GNSS,		// Location acquisition, periodic
+	JOB_MOTION,		// Handle an ACC interrupt, one-shot
+	JOB_GNSS_CACHE, // Save the GNSS warm start data, one-shot
+	JOB_NUM
+};
+/** Event types of the event queue */
+enum app_event_type_t
+{
+	EVENT_JOB_START = 0,
+	EVENT_JOB_STOP
+};
+/** Event queue entry */
+struct app_event_s
+{
+	uint8_t type;  // See app_event_type_t
+	uint8_t job;   // See app_jobs_t
+	uint32_t time; // Period or delay of the job (ms)
+};
+/** Number of events the event queue can hold, must be a power of 2 */
+#ifndef EVENT_QUEUE_SIZE
+#define EVENT_QUEUE_SIZE 16
+#endif
+void init_jobs(void);
+bool job_start(uint8_t job, uint32_t time_ms);
+bool job_stop(uint8_t job);
+bool events_pending(void);
+void dispatch_events(void);
+const char *job_name(MillisTaskManager::TaskFunction_t func);
+extern volatile uint32_t event_queue_dropped;
+/** Radio event reasons, see handle_display() */
+enum radio_event_reason_t
+{
+	RADIO_P2P_RX = 1,	 // RX packet (only P2P mode)
+	RADIO_TX_FAILED,	 // TX failed (only LPW LinkCheck mode)
+	RADIO_JOIN_FAILED,	 // Join failed (only LPW mode)
+	RADIO_LINKCHECK,	 // Linkcheck result (only LPW LinkCheck mode)
+	RADIO_JOIN_OK,		 // Join success (only LPW mode)
+	RADIO_FT_DOWNLINK,	 // FieldTester downlink packet (only FieldTester mode)
+	RADIO_FT_NO_DOWNLINK, // FieldTester no downlink packet (only FieldTester mode)
+	RADIO_TX_DONE		 // TX finished
+};
+#include "field_tester.h"
+/** Radio event queue entry, written by the radio callbacks */
+struct radio_event_s
+{
+	uint8_t reason;					   // See radio_event_reason_t
+	int16_t rssi;					   // RX RSSI
+	int8_t snr;						   // RX SNR
+	uint8_t dr;						   // RX data rate
+	int32_t status;					   // TX status
+	uint8_t link_check_state;		   // Link check result
+	uint8_t demod_margin;			   // Link check demodulation margin
+	uint8_t gateways;				   // Link check number of gateways
+	int32_t lost;					   // Lost packet counter when the event happened
+	field_tester_dl_s dl;			   // Parsed FieldTester downlink
+};
+/** Number of events the radio event queue can hold, must be a power of 2 */
+#ifndef RADIO_EVENT_QUEUE_SIZE
+#define RADIO_EVENT_QUEUE_SIZE 8
+#endif
+bool post_radio_event(radio_event_s *event);
+radio_event_s *peek_radio_event(void);
+void release_radio_event(void);
+extern volatile uint32_t radio_event_dropped;
+void handle_display(radio_event_s *event);
 extern volatile bool display_power;
 
 // ACC
@@ -193,23 +290,132 @@ extern volatile bool display_power;
 bool init_acc(bool active = false);
 void clear_acc_int(void);
 void read_acc(void);
+void handle_motion(void);
+bool motion_skip_send(void);
+extern bool has_acc;
 
 // GNSS
 #include <SparkFun_u-blox_GNSS_Arduino_Library.h>
+/** One GNSS solution, read from a single NAV-PVT (+ NAV-DOP) message */
+struct gnss_snapshot_s
+{
+	uint32_t itow;		  // GPS time of week of the solution (ms)
+	int32_t latitude;	  // Latitude (deg * 1e7)
+	int32_t longitude;	  // Longitude (deg * 1e7)
+	int32_t altitude;	  // Height above ellipsoid (mm)
+	uint16_t hdop;		  // Horizontal DOP (0.01)
+	uint8_t satellites;	  // Satellites used in the solution
+	uint8_t fix_type;	  // 0 no fix, 1 dead reckoning, 2 2D, 3 3D, 4 GNSS + dead reckoning, 5 time only
+	bool fix_ok;		  // Fix within DOP and accuracy masks
+	uint32_t h_acc;		  // Horizontal accuracy estimate (mm)
+	uint16_t pdop;		  // Position DOP (0.01)
+	uint32_t utc;		  // UTC of the solution (seconds since 1970-01-01), 0 if not valid
+	uint8_t transactions; // I2C transactions of the last poll
+};
+/** Fix acceptance policies */
+enum gnss_policy_t
+{
+	GNSS_POLICY_LEGACY = 0, // HDOP and satellites (location on) or satellites not growing
+	GNSS_POLICY_HACC,		// Horizontal accuracy estimate below gnss_hacc_max
+	GNSS_POLICY_SETTLED,	// Horizontal accuracy estimate stopped improving
+	GNSS_POLICY_NUM
+};
+/** Fix acceptance policy entry */
+struct gnss_policy_s
+{
+	bool (*accept)(gnss_snapshot_s *snapshot);
+	const char *name;
+	bool hdop; // Policy needs the horizontal DOP, one more poll per solution
+};
+/** Time and quality of the last accepted fix, reported by ATC+GNSSFIX=? */
+struct gnss_fix_info_s
+{
+	uint32_t fixes;		// Accepted fixes since boot
+	uint32_t ttf;		// Time to fix of the acquisition (ms), 0 if the fix was taken without acquisition
+	uint32_t h_acc;		// Horizontal accuracy estimate (mm)
+	uint16_t pdop;		// Position DOP (0.01)
+	uint8_t satellites; // Satellites used in the solution
+	uint8_t fix_type;	// Fix type, see gnss_snapshot_s
+	bool warm;			// Module got warm start data after its power up
+	const char *reason; // Name of the accepting policy or "deadline"
+};
+/** Time window of the settled policy (ms) */
+#ifndef GNSS_SETTLE_TIME
+#define GNSS_SETTLE_TIME 2500
+#endif
+/** Improvement of the horizontal accuracy estimate within the window below which a fix is settled (%) */
+#ifndef GNSS_SETTLE_PERCENT
+#define GNSS_SETTLE_PERCENT 10
+#endif
+/** GNSS warm start data, kept in flash behind the settings */
+struct gnss_cache_s
+{
+	uint32_t magic;	   // GNSS_CACHE_MAGIC
+	int32_t latitude;  // Latitude of the last fix (deg * 1e7)
+	int32_t longitude; // Longitude of the last fix (deg * 1e7)
+	int32_t altitude;  // Altitude of the last fix (mm)
+	uint32_t utc;	   // UTC of the last fix (seconds since 1970-01-01), 0 if not known
+	uint32_t rtc;	   // RTC time of the last fix (seconds since 1970-01-01), 0 without RTC
+	uint32_t crc;	   // Crc32 of the fields above
+};
+/** Flash offset of the warm start data */
+#define GNSS_CACHE_FLASH_OFFSET 256
+/** Warm start data magic "RSMG" */
+#define GNSS_CACHE_MAGIC 0x474D5352
+/** Minimum time between two saves of the warm start data (ms) */
+#ifndef GNSS_CACHE_INTERVAL
+#define GNSS_CACHE_INTERVAL 3600000
+#endif
+/** Size of the navigation database buffer, 0 = do not keep the database */
+#ifndef GNSS_DBD_SIZE
+#define GNSS_DBD_SIZE 8192
+#endif
+/** Name of the navigation database file on the SD card */
+#define GNSS_DBD_NAME "GNSS.DBD"
+/** Accuracy of the position given to the module (cm) */
+#define GNSS_WARM_POS_ACC 10000000
+/** Accuracy of the time given to the module (s) */
+#define GNSS_WARM_TIME_ACC 2
+/** Interval of the GNSS job to check for new solutions sent by the module, location_on (ms) */
+#ifndef GNSS_CHECK_INTERVAL
+#define GNSS_CHECK_INTERVAL 250
+#endif
+/** Interval of the GNSS job to poll a solution, also the step of the acquisition timeout (ms) */
+#define GNSS_POLL_INTERVAL 2500
 bool init_gnss(bool active = false);
+void gnss_pvt_callback(UBX_NAV_PVT_data_t *pvt);
+bool gnss_power_on(void);
+void gnss_warm_start(void);
+void gnss_cache_fix(gnss_snapshot_s *snapshot, uint32_t ttf);
+void save_gnss_warm_data(void);
+bool gnss_read_pvt(gnss_snapshot_s *snapshot);
+bool gnss_fix_accepted(gnss_snapshot_s *snapshot);
+void gnss_reset_policy(void);
+uint8_t gnss_selected_policy(void);
+extern gnss_policy_s gnss_policies[GNSS_POLICY_NUM];
+bool gnss_read_dop(gnss_snapshot_s *snapshot);
 bool poll_gnss(void);
 void gnss_handler(void *);
 extern bool gnss_active;
 extern uint16_t check_gnss_counter;
 extern uint16_t check_gnss_max_try;
+extern uint32_t gnss_start_time;
 extern uint8_t max_sat;
 extern uint8_t max_sat_unchanged;
 extern volatile float g_last_lat;
 extern volatile float g_last_long;
+extern volatile int32_t g_last_latitude;
+extern volatile int32_t g_last_longitude;
 extern volatile float g_last_accuracy;
 extern volatile uint32_t g_last_altitude;
 extern volatile uint8_t g_last_satellites;
 extern volatile bool has_gnss_location;
+extern gnss_snapshot_s g_gnss_snapshot;
+extern uint32_t gnss_transactions;
+extern bool gnss_warm_pending;
+extern bool gnss_warm;
+extern gnss_fix_info_s gnss_last_fix;
+extern uint32_t gnss_power_time;
 
 // SD Card
 /** Log file info structure */
@@ -223,24 +429,156 @@ struct result_s
 	uint8_t sec = 0;
 	uint8_t mode = 0;
 	uint8_t gw = 0;
-	float lat = 14.421536;
-	float lng = 121.006819;
+	int32_t lat = 144215360;  // Latitude (deg * 1e7), as delivered by the GNSS
+	int32_t lng = 1210068190; // Longitude (deg * 1e7)
 	int8_t min_rssi = 0;
 	int8_t max_rssi = 0;
 	int8_t max_snr = 0;
 	int8_t rx_rssi = 0;
 	int8_t rx_snr = 0;
-	int16_t min_dst = 0;
-	int16_t max_dst = 0;
+	uint16_t min_dst = 0;
+	uint16_t max_dst = 0;
 	int16_t demod = 0;
 	int16_t lost = 0;
 	int8_t tx_dr = 0;
 };
+/** Size of a SD card sector, log data is committed in multiples of it */
+#define SD_SECTOR_SIZE 512
+/** Size of the RAM staging buffer for log rows */
+#define SD_BUFFER_SIZE (4 * SD_SECTOR_SIZE)
+/** Flush staging buffer after this number of rows */
+#ifndef SD_FLUSH_ROWS
+#define SD_FLUSH_ROWS 16
+#endif
+/** Flush staging buffer when the oldest buffered row is older than this (ms) */
+#ifndef SD_FLUSH_AGE
+#define SD_FLUSH_AGE 300000
+#endif
+/** Retry time of the writer task while the radio is busy (ms) */
+#ifndef SD_WRITER_RETRY
+#define SD_WRITER_RETRY 100
+#endif
+/** Flush every row when the battery voltage is below this level (V) */
+#ifndef SD_FLUSH_LOW_BAT
+#define SD_FLUSH_LOW_BAT 3.5
+#endif
+/** Number of records the log queue can hold, must be a power of 2 */
+#ifndef LOG_QUEUE_SIZE
+#define LOG_QUEUE_SIZE 32
+#endif
+/** Pre-allocated rows of a log file if the rotation policy has no size limit */
+#ifndef LOG_PREALLOC_ROWS
+#define LOG_PREALLOC_ROWS 300
+#endif
+/** Open a file for in place updates, FILE_WRITE would append every write */
+#define FILE_UPDATE (O_READ | O_WRITE | O_CREAT)
+/** Frame size of the bulk log dump */
+#define SD_DUMP_CHUNK SD_SECTOR_SIZE
+/** Binary log file identifier "RSML" */
+#define LOG_MAGIC 0x4C4D5352
+/** Binary log format version */
+#define LOG_VERSION 3
+/** Commit marker of a completely written log record */
+#define LOG_RECORD_COMMIT 0xA5
+/** Column sets of the log files, selected by test mode and location setting */
+typedef enum log_columns_num
+{
+	LOG_COL_LINKCHECK_LOC = 0,
+	LOG_COL_LINKCHECK = 1,
+	LOG_COL_FIELDTESTER = 2,
+	LOG_COL_FIELDTESTER_V2 = 3,
+	LOG_COL_P2P_LOC = 4,
+	LOG_COL_P2P = 5,
+	LOG_COL_INVALID = 6
+} log_columns_t;
+/** Header at the start of every binary log file */
+struct __attribute__((packed)) log_header_s
+{
+	uint32_t magic;		 // LOG_MAGIC
+	uint8_t version;	 // LOG_VERSION
+	uint8_t test_mode;	 // Test mode when the file was created
+	uint8_t columns;	 // Column set, see log_columns_t
+	uint8_t record_size; // Size of one log_record_s
+	uint32_t rows;		 // Number of valid records, the file is pre-allocated
+	uint8_t reserved[20]; // Pads the header to one record, records stay sector aligned
+};
+/** Binary log record, packed copy of result_s */
+struct __attribute__((packed)) log_record_s
+{
+	uint32_t time;	 // Seconds since 1970-01-01
+	int32_t lat;	 // Latitude in 1/10000000 degree
+	int32_t lng;	 // Longitude in 1/10000000 degree
+	int16_t lost;	 // Lost packets (PLR * 10 in FieldTester V2 mode)
+	uint8_t mode;	 // Test mode
+	uint8_t gw;		 // Number of gateways
+	int8_t min_rssi; // Min RSSI seen by gateways
+	int8_t max_rssi; // Max RSSI seen by gateways
+	int8_t max_snr;	 // Max SNR seen by gateways
+	int8_t rx_rssi;	 // RSSI of downlink
+	int8_t rx_snr;	 // SNR of downlink
+	int8_t tx_dr;	 // TX datarate
+	uint8_t demod;	 // Demodulation margin
+	uint8_t min_dst; // Min distance in 250m steps
+	uint8_t max_dst; // Max distance in 250m steps
+	uint8_t commit;	 // LOG_RECORD_COMMIT, zero in unused pre-allocated space
+	uint8_t reserved[2];
+	uint32_t crc; // Crc32 of the fields above
+};
+struct date_time_s;
+uint8_t log_columns(uint8_t test_mode, bool location_on);
+void log_encode_record(volatile result_s *res, log_record_s *record);
+bool log_record_valid(log_record_s *record);
+uint32_t log_make_time(uint16_t year, uint8_t month, uint8_t day, uint8_t hour, uint8_t minute, uint8_t second);
+void log_split_time(uint32_t time, date_time_s *date_time);
+const char *log_csv_header(uint8_t columns);
+size_t log_record_to_csv(uint8_t columns, log_record_s *record, char *line, size_t line_size);
+/** Name of the log file index */
+#define LOG_INDEX_NAME "LOGINDEX.DAT"
+/** Index magic "RSMI" */
+#define LOG_INDEX_MAGIC 0x494D5352
+/** Offset of the first file entry, behind the two header slots */
+#define LOG_INDEX_ENTRIES (2 * SD_SECTOR_SIZE)
+/** Index header, written alternating to two sector aligned slots */
+struct __attribute__((packed)) log_index_head_s
+{
+	uint32_t magic;		 // LOG_INDEX_MAGIC
+	uint32_t generation; // Incremented on every header write
+	uint16_t next_file;	 // Next free log file number
+	uint16_t reserved;
+	uint32_t crc; // Crc32 of the fields above
+};
+/** Index entry of one log file, at LOG_INDEX_ENTRIES + file number * size */
+struct __attribute__((packed)) log_index_entry_s
+{
+	uint32_t rows;		 // Number of records in the file
+	uint32_t first_time; // Time of the first record
+	uint32_t last_time;	 // Time of the last record
+	uint32_t crc;		 // Crc32 of the fields above
+};
+bool open_log_index(void);
+void close_log_index(void);
+bool read_log_index(void);
+uint16_t alloc_log_file(void);
+bool write_log_index_entry(uint16_t file_num, log_index_entry_s *entry);
+bool read_log_index_entry(uint16_t file_num, log_index_entry_s *entry);
+extern uint16_t log_next_file;
 bool init_sd(void);
+bool mount_sd(void);
 bool create_sd_file(void);
+bool resume_sd_file(void);
 void write_sd_entry(void);
+bool flush_sd_file(bool force);
+void close_sd_file(void);
+bool log_writer_pending(void);
+void sd_writer_task(void);
+void check_sd_battery(void);
 void dump_all_sd_files(void);
 void dump_sd_file(const char *path);
+void list_sd_files(void);
+bool dump_sd_file_num(uint16_t file_num);
+void dump_sd_time_range(uint32_t from_time, uint32_t to_time);
+void dump_sd_tail(uint32_t rows);
+void stream_sd_files(int32_t file_num, uint32_t offset, uint32_t length);
 void clear_sd_file(void);
 extern volatile result_s result;
 extern volatile char file_name[];
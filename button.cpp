@@ -20,6 +20,9 @@ volatile uint8_t pressCount = 0;
 /** Timestamp for first button press event */
 static time_t firstPressTime = 0;
 
+/** Button task in mtmMain, notified by the interrupt handler */
+static MillisTaskManager::Task_t *button_task = NULL;
+
 /** Flag if UI is active or not */
 bool g_settings_ui = false;
 /** Current selected menu */
@@ -101,7 +104,7 @@ bool buttonInit(void)
 	pinMode(BUTTON_INT_PIN, INPUT_PULLUP);
 	attachInterrupt(BUTTON_INT_PIN, buttonIntHandle, FALLING);
 
-	mtmMain.Register(handle_button, 100); // Process button data every 100ms.
+	button_task = mtmMain.Register(handle_button, 100); // Process button data every 100ms and after each press.
 
 	return true;
 }
@@ -118,6 +121,8 @@ void buttonIntHandle(void)
 		firstPressTime = millis();
 		pressCount += 1;
 	}
+	// Run the button handler on the next loop() instead of waiting for its period
+	mtmMain.Notify(button_task);
 	MYLOG("BTN", "pressCount = %d", pressCount);
 }
 
@@ -274,6 +279,7 @@ void save_n_reboot(void)
 			api.lorawan.nwm.set();
 		}
 		// settings changed, reboot
+		close_sd_file();
 		api.system.reboot();
 	}
 
@@ -373,12 +379,12 @@ void save_n_reboot(void)
 
 	if (g_custom_parameters.send_interval != 0)
 	{
-		api.system.timer.start(RAK_TIMER_0, g_custom_parameters.send_interval, NULL);
+		job_start(JOB_SEND, g_custom_parameters.send_interval);
 	}
 
 	if (g_custom_parameters.display_saver)
 	{
-		api.system.timer.start(RAK_TIMER_2, 60000, NULL);
+		job_start(JOB_OLED_SAVER, 60000);
 	}
 }
 
@@ -426,6 +432,7 @@ void handle_button(void)
 		{
 			oled_clear();
 			oled_write_header((char *)"BOOTLOADER", false);
+			close_sd_file();
 			udrv_enter_dfu();
 		}
 	}
@@ -450,6 +457,7 @@ void handle_button(void)
 		{
 			oled_clear();
 			oled_write_header((char *)"RESET", false);
+			close_sd_file();
 			api.system.reboot();
 		}
 		break;
@@ -586,7 +594,7 @@ void handle_button(void)
 							oled_power(true);
 						}
 						MYLOG("BTN", "DR sweep triggered");
-						api.system.timer.stop(RAK_TIMER_0);
+						job_stop(JOB_SEND);
 
 						uint16_t *region_ps = region_map[api.lorawan.band.get()];
 						uint16_t origin_dr = api.lorawan.dr.get();
@@ -621,7 +629,7 @@ void handle_button(void)
 
 						if (g_custom_parameters.send_interval != 0)
 						{
-							api.system.timer.start(RAK_TIMER_0, g_custom_parameters.send_interval, NULL);
+							job_start(JOB_SEND, g_custom_parameters.send_interval);
 						}
 						dr_sweep_active = false;
 					}
@@ -823,12 +831,12 @@ void handle_button(void)
 						oled_power(true);
 					}
 					MYLOG("BTN", "Manual send triggered");
-					api.system.timer.stop(RAK_TIMER_0);
+					job_stop(JOB_SEND);
 					forced_tx = true;
 					send_packet(NULL);
 					if (g_custom_parameters.send_interval != 0)
 					{
-						api.system.timer.start(RAK_TIMER_0, g_custom_parameters.send_interval, NULL);
+						job_start(JOB_SEND, g_custom_parameters.send_interval);
 					}
 				}
 			}
@@ -842,9 +850,9 @@ void handle_button(void)
 		// MYLOG("BTN", "Double Click");
 		if (!g_settings_ui)
 		{
-			api.system.timer.stop(RAK_TIMER_0);
-			api.system.timer.stop(RAK_TIMER_1);
-			api.system.timer.stop(RAK_TIMER_2);
+			job_stop(JOB_SEND);
+			job_stop(JOB_DISPLAY);
+			job_stop(JOB_OLED_SAVER);
 
 			if (!display_power)
 			{
@@ -1079,4 +1087,10 @@ void handle_button(void)
 	default:
 		break;
 	}
+
+	// All presses handled, sleep until the interrupt handler notifies the task again
+	if (pressCount == 0)
+	{
+		mtmMain.SetState(handle_button, false);
+	}
 }
\ No newline at end of file
@@ -51,9 +51,15 @@ int status_handler(SERIAL_PORT port, char *cmd, stParam *param);
 int test_mode_handler(SERIAL_PORT port, char *cmd, stParam *param);
 int custom_pckg_handler(SERIAL_PORT port, char *cmd, stParam *param);
 int dump_logs_handler(SERIAL_PORT port, char *cmd, stParam *param);
+int log_rotation_handler(SERIAL_PORT port, char *cmd, stParam *param);
+int gnss_policy_handler(SERIAL_PORT port, char *cmd, stParam *param);
+int motion_handler(SERIAL_PORT port, char *cmd, stParam *param);
 int rtc_command_handler(SERIAL_PORT port, char *cmd, stParam *param);
 int app_ver_handler(SERIAL_PORT port, char *cmd, stParam *param);
 int product_info_handler(SERIAL_PORT port, char *cmd, stParam *param);
+#if (MTM_USE_STATS == 1)
+int task_stats_handler(SERIAL_PORT port, char *cmd, stParam *param);
+#endif
 /**
  * @brief Add send interval AT command
  *
@@ -109,11 +115,11 @@ int interval_send_handler(SERIAL_PORT port, char *cmd, stParam *param)
 
 		MYLOG("AT_CMD", "New interval %ld", g_custom_parameters.send_interval);
 		// Stop the timer
-		api.system.timer.stop(RAK_TIMER_0);
+		job_stop(JOB_SEND);
 		if (g_custom_parameters.send_interval != 0)
 		{
 			// Restart the timer
-			api.system.timer.start(RAK_TIMER_0, g_custom_parameters.send_interval, NULL);
+			job_start(JOB_SEND, g_custom_parameters.send_interval);
 		}
 		MYLOG("AT_CMD", "Timer restarted with %ld", g_custom_parameters.send_interval);
 		// Save custom settings
@@ -204,6 +210,7 @@ int test_mode_handler(SERIAL_PORT port, char *cmd, stParam *param)
 
 			// On mode change, always restart to refresh log file appearance
 			AT_PRINTF("+EVT:RESTART_FOR_MODE_CHANGE");
+			close_sd_file();
 			delay(5000);
 			api.system.reboot();
 		}
@@ -282,6 +289,58 @@ int custom_pckg_handler(SERIAL_PORT port, char *cmd, stParam *param)
 	return AT_OK;
 }
 
+/**
+ * @brief Check if a parameter is a decimal number
+ *
+ * @param value parameter string
+ * @return true only digits
+ * @return false empty or other characters
+ */
+bool is_number(char *value)
+{
+	if (strlen(value) == 0)
+	{
+		return false;
+	}
+	for (int i = 0; i < strlen(value); i++)
+	{
+		if (!isdigit(value[i]))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * @brief Parse a log time parameter YYYYMMDD[hhmm[ss]]
+ *
+ * @param value parameter string
+ * @param time parsed time, seconds since 1970
+ * @return true valid time
+ * @return false invalid format
+ */
+bool parse_log_time(char *value, uint32_t *time)
+{
+	size_t len = strlen(value);
+	if (!is_number(value) || ((len != 8) && (len != 12) && (len != 14)))
+	{
+		return false;
+	}
+	uint16_t part[6] = {0, 0, 0, 0, 0, 0};
+	part[0] = (value[0] - '0') * 1000 + (value[1] - '0') * 100 + (value[2] - '0') * 10 + (value[3] - '0');
+	for (int idx = 1; idx < (len / 2 - 1); idx++)
+	{
+		part[idx] = (value[idx * 2 + 2] - '0') * 10 + (value[idx * 2 + 3] - '0');
+	}
+	if ((part[1] < 1) || (part[1] > 12) || (part[2] < 1) || (part[2] > 31) || (part[3] > 23) || (part[4] > 59) || (part[5] > 59))
+	{
+		return false;
+	}
+	*time = log_make_time(part[0], part[1], part[2], part[3], part[4], part[5]);
+	return true;
+}
+
 /**
  * @brief Add send interval AT command
  *
@@ -322,9 +381,9 @@ int dump_logs_handler(SERIAL_PORT port, char *cmd, stParam *param)
 	{
 		g_settings_ui = true;
 		AT_PRINTF("\r\n");
-		api.system.timer.stop(RAK_TIMER_0);
-		api.system.timer.stop(RAK_TIMER_1);
-		api.system.timer.stop(RAK_TIMER_2);
+		job_stop(JOB_SEND);
+		job_stop(JOB_DISPLAY);
+		job_stop(JOB_OLED_SAVER);
 		oled_clear();
 		oled_write_header("REBOOT", false);
 		oled_add_line((char *)"Dumping SD card");
@@ -346,12 +405,98 @@ int dump_logs_handler(SERIAL_PORT port, char *cmd, stParam *param)
 		// reboot
 		api.system.reboot();
 	}
+	else if ((param->argc == 1 || param->argc == 3 || param->argc == 4) && !strcmp(param->argv[0], "b"))
+	{
+		// Bulk dump in raw frames: b = all files, b,<file>,<offset>[,<length>] = resume or repeat a chunk
+		int32_t file_num = -1;
+		uint32_t offset = 0;
+		uint32_t length = 0;
+		for (int arg = 1; arg < param->argc; arg++)
+		{
+			if (!is_number(param->argv[arg]))
+			{
+				return AT_PARAM_ERROR;
+			}
+		}
+		if (param->argc >= 3)
+		{
+			file_num = strtoul(param->argv[1], NULL, 10);
+			offset = strtoul(param->argv[2], NULL, 10);
+			if (file_num >= log_next_file)
+			{
+				return AT_PARAM_ERROR;
+			}
+		}
+		if (param->argc == 4)
+		{
+			length = strtoul(param->argv[3], NULL, 10);
+		}
+		// Pause the send cycle during the transfer, like the full dump
+		job_stop(JOB_SEND);
+		time_t start_wait = millis();
+		while (!ready_to_dump)
+		{
+			delay(1000);
+			if ((millis() - start_wait) > 10000)
+			{
+				MYLOG("ATC", "Timeout waiting for TX finished");
+				if (g_custom_parameters.send_interval != 0)
+				{
+					job_start(JOB_SEND, g_custom_parameters.send_interval);
+				}
+				return AT_BUSY_ERROR;
+			}
+		}
+		AT_PRINTF("");
+		stream_sd_files(file_num, offset, length);
+		// Logging continues after the transfer
+		if (g_custom_parameters.send_interval != 0)
+		{
+			job_start(JOB_SEND, g_custom_parameters.send_interval);
+		}
+	}
+	else if (param->argc == 1 && !strcmp(param->argv[0], "l"))
+	{
+		// List files with size, rows and time span
+		AT_PRINTF("");
+		list_sd_files();
+	}
+	else if (param->argc == 2 && !strcmp(param->argv[0], "f"))
+	{
+		// Dump a single file
+		if (!is_number(param->argv[1]) || !dump_sd_file_num(strtoul(param->argv[1], NULL, 10)))
+		{
+			return AT_PARAM_ERROR;
+		}
+	}
+	else if (param->argc == 3 && !strcmp(param->argv[0], "t"))
+	{
+		// Dump rows between two times
+		uint32_t from_time;
+		uint32_t to_time;
+		if (!parse_log_time(param->argv[1], &from_time) || !parse_log_time(param->argv[2], &to_time) || (from_time > to_time))
+		{
+			return AT_PARAM_ERROR;
+		}
+		AT_PRINTF("");
+		dump_sd_time_range(from_time, to_time);
+	}
+	else if (param->argc == 2 && !strcmp(param->argv[0], "n"))
+	{
+		// Dump the last rows
+		if (!is_number(param->argv[1]))
+		{
+			return AT_PARAM_ERROR;
+		}
+		AT_PRINTF("");
+		dump_sd_tail(strtoul(param->argv[1], NULL, 10));
+	}
 	else if (param->argc == 1 && !strcmp(param->argv[0], "e"))
 	{
 		g_settings_ui = true;
-		api.system.timer.stop(RAK_TIMER_0);
-		api.system.timer.stop(RAK_TIMER_1);
-		api.system.timer.stop(RAK_TIMER_2);
+		job_stop(JOB_SEND);
+		job_stop(JOB_DISPLAY);
+		job_stop(JOB_OLED_SAVER);
 		oled_clear();
 		oled_write_header("REBOOT", false);
 		oled_add_line((char *)"Erasing SD card");
@@ -387,6 +532,203 @@ int dump_logs_handler(SERIAL_PORT port, char *cmd, stParam *param)
 	return AT_OK;
 }
 
+/**
+ * @brief Add log rotation AT command
+ *
+ * @return true if success
+ * @return false if failed
+ */
+bool init_log_rotation_at(void)
+{
+	return api.system.atMode.add((char *)"LOGROT",
+								 (char *)"Set/Get log file rotation. <max rows>,<max kB>,<max minutes>,<flags> 0 = no limit, flags 1 = new file each day, 2 = new file on restart",
+								 (char *)"LOGROT", log_rotation_handler,
+								 RAK_ATCMD_PERM_WRITE | RAK_ATCMD_PERM_READ);
+}
+
+/**
+ * @brief Handler for log rotation AT command
+ *
+ * @param port Serial port used
+ * @param cmd char array with the received AT command
+ * @param param char array with the received AT command parameters
+ * @return int result of command parsing
+ * 			AT_OK AT command & parameters valid
+ * 			AT_PARAM_ERROR command or parameters invalid
+ */
+int log_rotation_handler(SERIAL_PORT port, char *cmd, stParam *param)
+{
+	if (param->argc == 1 && !strcmp(param->argv[0], "?"))
+	{
+		AT_PRINTF("%s=%d,%d,%d,%d", cmd, g_custom_parameters.log_max_rows, g_custom_parameters.log_max_kb,
+				  g_custom_parameters.log_max_minutes, g_custom_parameters.log_rotate);
+	}
+	else if (param->argc == 4)
+	{
+		for (int arg = 0; arg < param->argc; arg++)
+		{
+			if (!is_number(param->argv[arg]))
+			{
+				return AT_PARAM_ERROR;
+			}
+		}
+		uint32_t max_rows = strtoul(param->argv[0], NULL, 10);
+		uint32_t max_kb = strtoul(param->argv[1], NULL, 10);
+		uint32_t max_minutes = strtoul(param->argv[2], NULL, 10);
+		uint32_t rotate = strtoul(param->argv[3], NULL, 10);
+		if ((max_rows > 65535) || (max_kb > 65535) || (max_minutes > 65535) || (rotate > (LOG_ROTATE_DAY | LOG_ROTATE_BOOT)))
+		{
+			return AT_PARAM_ERROR;
+		}
+		g_custom_parameters.log_max_rows = max_rows;
+		g_custom_parameters.log_max_kb = max_kb;
+		g_custom_parameters.log_max_minutes = max_minutes;
+		g_custom_parameters.log_rotate = rotate;
+		MYLOG("AT_CMD", "Log rotation %ld rows, %ld kB, %ld min, flags %ld", max_rows, max_kb, max_minutes, rotate);
+		// Save custom settings
+		save_at_setting();
+	}
+	else
+	{
+		return AT_PARAM_ERROR;
+	}
+
+	return AT_OK;
+}
+
+/**
+ * @brief Add GNSS fix acceptance AT command
+ *
+ * @return true if success
+ * @return false if failed
+ */
+bool init_gnss_policy_at(void)
+{
+	return api.system.atMode.add((char *)"GNSSFIX",
+								 (char *)"Set/Get GNSS fix acceptance. <policy>,<max hAcc m>,<deadline %> policy 0 = legacy, 1 = hAcc below max, 2 = hAcc settled",
+								 (char *)"GNSSFIX", gnss_policy_handler,
+								 RAK_ATCMD_PERM_WRITE | RAK_ATCMD_PERM_READ);
+}
+
+/**
+ * @brief Handler for GNSS fix acceptance AT command
+ *
+ * @param port Serial port used
+ * @param cmd char array with the received AT command
+ * @param param char array with the received AT command parameters
+ * @return int result of command parsing
+ * 			AT_OK AT command & parameters valid
+ * 			AT_PARAM_ERROR command or parameters invalid
+ */
+int gnss_policy_handler(SERIAL_PORT port, char *cmd, stParam *param)
+{
+	if (param->argc == 1 && !strcmp(param->argv[0], "?"))
+	{
+		AT_PRINTF("%s=%d,%d,%d", cmd, g_custom_parameters.gnss_policy, g_custom_parameters.gnss_hacc_max,
+				  g_custom_parameters.gnss_deadline);
+		AT_PRINTF("Policy %s", gnss_policies[g_custom_parameters.gnss_policy].name);
+		if (gnss_last_fix.fixes != 0)
+		{
+			AT_PRINTF("Last fix (%s): TTF %ld ms, hAcc %ld mm, pDOP %d.%02d, Sat %d, Fix %d, %s start", gnss_last_fix.reason, gnss_last_fix.ttf,
+					  gnss_last_fix.h_acc, gnss_last_fix.pdop / 100, gnss_last_fix.pdop % 100, gnss_last_fix.satellites, gnss_last_fix.fix_type,
+					  gnss_last_fix.warm ? "warm" : "cold");
+			AT_PRINTF("Fixes since boot %ld", gnss_last_fix.fixes);
+		}
+		else
+		{
+			AT_PRINTF("No fix since boot");
+		}
+	}
+	else if (param->argc == 3)
+	{
+		for (int arg = 0; arg < param->argc; arg++)
+		{
+			if (!is_number(param->argv[arg]))
+			{
+				return AT_PARAM_ERROR;
+			}
+		}
+		uint32_t policy = strtoul(param->argv[0], NULL, 10);
+		uint32_t hacc_max = strtoul(param->argv[1], NULL, 10);
+		uint32_t deadline = strtoul(param->argv[2], NULL, 10);
+		if ((policy >= GNSS_POLICY_NUM) || (hacc_max == 0) || (hacc_max > 65535) || (deadline > 100))
+		{
+			return AT_PARAM_ERROR;
+		}
+		g_custom_parameters.gnss_policy = policy;
+		g_custom_parameters.gnss_hacc_max = hacc_max;
+		g_custom_parameters.gnss_deadline = deadline;
+		MYLOG("AT_CMD", "GNSS fix policy %s, hAcc %ld m, deadline %ld %%", gnss_policies[policy].name, hacc_max, deadline);
+		// Save custom settings
+		save_at_setting();
+	}
+	else
+	{
+		return AT_PARAM_ERROR;
+	}
+
+	return AT_OK;
+}
+
+/**
+ * @brief Add motion gate AT command
+ *
+ * @return true if success
+ * @return false if failed
+ */
+bool init_motion_at(void)
+{
+	return api.system.atMode.add((char *)"MOTION",
+								 (char *)"Set/Get motion gate. 0 = off, 1 = skip FieldTester uplinks while the device does not move",
+								 (char *)"MOTION", motion_handler,
+								 RAK_ATCMD_PERM_WRITE | RAK_ATCMD_PERM_READ);
+}
+
+/**
+ * @brief Handler for motion gate AT command
+ *
+ * @param port Serial port used
+ * @param cmd char array with the received AT command
+ * @param param char array with the received AT command parameters
+ * @return int result of command parsing
+ * 			AT_OK AT command & parameters valid
+ * 			AT_PARAM_ERROR command or parameters invalid
+ */
+int motion_handler(SERIAL_PORT port, char *cmd, stParam *param)
+{
+	if (param->argc == 1 && !strcmp(param->argv[0], "?"))
+	{
+		AT_PRINTF("%s=%d", cmd, g_custom_parameters.motion_gate ? 1 : 0);
+	}
+	else if (param->argc == 1)
+	{
+		if (!is_number(param->argv[0]))
+		{
+			return AT_PARAM_ERROR;
+		}
+		uint32_t new_gate = strtoul(param->argv[0], NULL, 10);
+		if (new_gate > 1)
+		{
+			return AT_PARAM_ERROR;
+		}
+		g_custom_parameters.motion_gate = (new_gate == 1);
+		if (!g_custom_parameters.motion_gate)
+		{
+			detachInterrupt(ACC_INT_PIN);
+		}
+		has_acc = init_acc(g_custom_parameters.motion_gate) && g_custom_parameters.motion_gate;
+		MYLOG("AT_CMD", "Motion gate %s, ACC %s", g_custom_parameters.motion_gate ? "on" : "off", has_acc ? "active" : "off");
+		// Save custom settings
+		save_at_setting();
+	}
+	else
+	{
+		return AT_PARAM_ERROR;
+	}
+
+	return AT_OK;
+}
+
 /**
  * @brief Add custom RTC AT commands
  *
@@ -702,6 +1044,108 @@ int product_info_handler(SERIAL_PORT port, char *cmd, stParam *param)
 	}
 	return AT_ERROR;
 }
+#if (MTM_USE_STATS == 1)
+/**
+ * @brief Add task statistics AT command
+ *
+ * @return true if success
+ * @return false if failed
+ */
+bool init_task_stats_at(void)
+{
+	return api.system.atMode.add((char *)"TASKS",
+								 (char *)"Get/Reset scheduler task statistics. ATC+TASKS=? shows the table, ATC+TASKS=0 resets it",
+								 (char *)"TASKS", task_stats_handler,
+								 RAK_ATCMD_PERM_WRITE | RAK_ATCMD_PERM_READ);
+}
+
+/**
+ * @brief Get the name of a scheduler task
+ *
+ * @param func task function
+ * @return const char* name, "?" for unknown functions
+ */
+const char *task_name(MillisTaskManager::TaskFunction_t func)
+{
+	if (func == handle_button)
+	{
+		return "button";
+	}
+	if (func == sd_writer_task)
+	{
+		return "sd_writer";
+	}
+	const char *name = job_name(func);
+	if (name != NULL)
+	{
+		return name;
+	}
+	return "?";
+}
+
+/**
+ * @brief Print a log2 histogram
+ *
+ * @param name histogram name
+ * @param hist bucket counters
+ */
+void print_task_hist(const char *name, uint16_t *hist)
+{
+	atcmd_printf("  %s <2^n:", name);
+	for (uint8_t bucket = 0; bucket < MTM_HIST_BUCKETS; bucket++)
+	{
+		atcmd_printf(" %d", hist[bucket]);
+	}
+	atcmd_printf("\r\n");
+}
+
+/**
+ * @brief Handler for task statistics AT command
+ *
+ * @param port Serial port used
+ * @param cmd char array with the received AT command
+ * @param param char array with the received AT command parameters
+ * @return int result of command parsing
+ * 			AT_OK AT command & parameters valid
+ * 			AT_PARAM_ERROR command or parameters invalid
+ */
+int task_stats_handler(SERIAL_PORT port, char *cmd, stParam *param)
+{
+	if (param->argc == 1 && !strcmp(param->argv[0], "?"))
+	{
+		AT_PRINTF("%s: task;period ms;on;runs;overruns;cost min/mean/max us;jitter min/mean/max ms", cmd);
+		for (uint16_t idx = 0; idx < mtmMain.GetCount(); idx++)
+		{
+			MillisTaskManager::Task_t *task = mtmMain.GetTask(idx);
+			MillisTaskManager::TaskStats *stats = &task->Stats;
+			if (stats->Runs == 0)
+			{
+				AT_PRINTF("%s;%ld;%d;0;0;-;-", task_name(task->Function), task->Time, task->State);
+				continue;
+			}
+			uint32_t cost_mean = stats->CostSum / stats->Runs;
+			uint32_t error_min = stats->Starts == 0 ? 0 : stats->ErrorMin;
+			uint32_t error_mean = stats->Starts == 0 ? 0 : stats->ErrorSum / stats->Starts;
+			AT_PRINTF("%s;%ld;%d;%ld;%ld;%ld/%ld/%ld;%ld/%ld/%ld", task_name(task->Function), task->Time, task->State,
+					  stats->Runs, stats->Overruns,
+					  stats->CostMin, cost_mean, stats->CostMax,
+					  error_min, error_mean, stats->ErrorMax);
+			print_task_hist("cost us", stats->CostHist);
+			print_task_hist("jitter ms", stats->ErrorHist);
+		}
+	}
+	else if (param->argc == 1 && !strcmp(param->argv[0], "0"))
+	{
+		mtmMain.ResetStats();
+	}
+	else
+	{
+		return AT_PARAM_ERROR;
+	}
+	return AT_OK;
+}
+#endif
+
 /**
  * @brief Get setting from flash
  *
@@ -763,6 +1207,14 @@ bool get_at_setting(void)
 		g_custom_parameters.custom_packet[2] = 0x03;
 		g_custom_parameters.custom_packet[3] = 0x04;
 		g_custom_parameters.custom_packet_len = 4;
+		g_custom_parameters.log_max_rows = 300;
+		g_custom_parameters.log_max_kb = 0;
+		g_custom_parameters.log_max_minutes = 0;
+		g_custom_parameters.log_rotate = 0;
+		g_custom_parameters.gnss_policy = GNSS_POLICY_LEGACY;
+		g_custom_parameters.gnss_hacc_max = 50;
+		g_custom_parameters.gnss_deadline = 75;
+		g_custom_parameters.motion_gate = false;
 		save_at_setting();
 		return false;
 	}
@@ -814,6 +1266,46 @@ bool get_at_setting(void)
 		memcpy(g_custom_parameters.custom_packet, temp_params.custom_packet, g_custom_parameters.custom_packet_len);
 	}
 
+	g_custom_parameters.log_max_rows = temp_params.log_max_rows;
+	g_custom_parameters.log_max_kb = temp_params.log_max_kb;
+	g_custom_parameters.log_max_minutes = temp_params.log_max_minutes;
+	if (temp_params.log_rotate > (LOG_ROTATE_DAY | LOG_ROTATE_BOOT))
+	{
+		MYLOG("AT_CMD", "Invalid log rotation found %d", temp_params.log_rotate);
+		g_custom_parameters.log_rotate = 0;
+		found_problem = true;
+	}
+	else
+	{
+		g_custom_parameters.log_rotate = temp_params.log_rotate;
+	}
+
+	if ((temp_params.gnss_policy >= GNSS_POLICY_NUM) || (temp_params.gnss_hacc_max == 0) || (temp_params.gnss_deadline > 100))
+	{
+		MYLOG("AT_CMD", "Invalid GNSS fix policy found %d", temp_params.gnss_policy);
+		g_custom_parameters.gnss_policy = GNSS_POLICY_LEGACY;
+		g_custom_parameters.gnss_hacc_max = 50;
+		g_custom_parameters.gnss_deadline = 75;
+		found_problem = true;
+	}
+	else
+	{
+		g_custom_parameters.gnss_policy = temp_params.gnss_policy;
+		g_custom_parameters.gnss_hacc_max = temp_params.gnss_hacc_max;
+		g_custom_parameters.gnss_deadline = temp_params.gnss_deadline;
+	}
+
+	if (temp_params.motion_gate > 1)
+	{
+		MYLOG("AT_CMD", "Invalid motion gate found %d", temp_params.motion_gate);
+		g_custom_parameters.motion_gate = false;
+		found_problem = true;
+	}
+	else
+	{
+		g_custom_parameters.motion_gate = temp_params.motion_gate;
+	}
+
 	if (found_problem)
 	{
 		save_at_setting();
@@ -0,0 +1,69 @@
+/**
+ * @file field_tester.cpp
+ * @author Bernd Giesecke (bernd@giesecke.tk)
+ * @brief Parser for the FieldTester and FieldTester V2 downlinks
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include "field_tester.h"
+#include <string.h>
+
+/** Number of downlinks rejected by the parser */
+volatile uint32_t field_tester_dl_invalid = 0;
+
+/**
+ * @brief Parse a FieldTester downlink.
+ * 		Called once from the receive callback with the RUI3 receive
+ * 		buffer, the display job, the OLED and the SD card log only use
+ * 		the parsed values.
+ *
+ * 		FieldTester (6 bytes)
+ * 		0 sequence, 1 min RSSI + 200, 2 max RSSI + 200,
+ * 		3 min distance / 250m, 4 max distance / 250m, 5 gateways
+ *
+ * 		FieldTester V2 (11 bytes), see "FieldTester V2 Packet format.txt"
+ * 		0..1 PLR in 0.1%, 2 max RSSI + 200, 3 min distance / 250m,
+ * 		4 max distance / 250m, 5 gateways (upper 4 bits) + sequence MSB,
+ * 		6 sequence LSB, 7 max SNR + 200, 8..10 last 3 bytes of the gateway EUI
+ *
+ * @param buffer downlink payload
+ * @param size downlink payload size
+ * @param v2 true for FieldTester V2 format
+ * @param dl parsed downlink
+ * @return true downlink is valid
+ * @return false downlink is too short, dl is not changed
+ */
+bool parse_field_tester_dl(const uint8_t *buffer, uint16_t size, bool v2, field_tester_dl_s *dl)
+{
+	if ((buffer == NULL) || (size < (v2 ? FT_V2_DL_SIZE : FT_V1_DL_SIZE)))
+	{
+		field_tester_dl_invalid++;
+		return false;
+	}
+
+	memset(dl, 0, sizeof(field_tester_dl_s));
+	dl->version = v2 ? 2 : 1;
+	dl->max_rssi = (int16_t)buffer[2] - 200;
+	dl->min_distance = (uint16_t)buffer[3] * 250;
+	dl->max_distance = (uint16_t)buffer[4] * 250;
+	if (v2)
+	{
+		dl->plr = ((uint16_t)buffer[0] << 8) + (uint16_t)buffer[1];
+		dl->gateways = buffer[5] >> 4;
+		dl->seq_id = (((uint16_t)buffer[5] & 0x0F) << 8) + (uint16_t)buffer[6];
+		dl->max_snr = (int16_t)buffer[7] - 200;
+		dl->gw_eui[0] = buffer[8];
+		dl->gw_eui[1] = buffer[9];
+		dl->gw_eui[2] = buffer[10];
+	}
+	else
+	{
+		dl->seq_id = buffer[0];
+		dl->min_rssi = (int16_t)buffer[1] - 200;
+		dl->gateways = buffer[5];
+	}
+	return true;
+}
@@ -0,0 +1,39 @@
+/**
+ * @file field_tester.h
+ * @author Bernd Giesecke (bernd@giesecke.tk)
+ * @brief FieldTester downlink format.
+ * 		Only depends on the C library, field_tester.cpp builds
+ * 		without the RUI3 and Arduino headers.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#ifndef FIELD_TESTER_H
+#define FIELD_TESTER_H
+
+#include <stdint.h>
+
+/** Minimum size of a FieldTester downlink */
+#define FT_V1_DL_SIZE 6
+/** Minimum size of a FieldTester V2 downlink */
+#define FT_V2_DL_SIZE 11
+/** FieldTester downlink, parsed once by the receive callback */
+struct field_tester_dl_s
+{
+	uint8_t version;	   // 1 = FieldTester, 2 = FieldTester V2
+	uint16_t plr;		   // Packet loss rate in 0.1% (only V2)
+	int16_t min_rssi;	   // Min uplink RSSI (only V1)
+	int16_t max_rssi;	   // Max uplink RSSI
+	int16_t max_snr;	   // Max uplink SNR (only V2)
+	uint16_t min_distance; // Min gateway distance (m)
+	uint16_t max_distance; // Max gateway distance (m)
+	uint8_t gateways;	   // Number of gateways
+	uint16_t seq_id;	   // Downlink sequence
+	uint8_t gw_eui[3];	   // Last 3 bytes of the gateway EUI (only V2)
+};
+bool parse_field_tester_dl(const uint8_t *buffer, uint16_t size, bool v2, field_tester_dl_s *dl);
+extern volatile uint32_t field_tester_dl_invalid;
+
+#endif
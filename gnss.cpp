@@ -42,6 +42,10 @@ uint8_t satellites = 0;
 volatile float g_last_lat = 0.0;
 /** Last longitude for global use */
 volatile float g_last_long = 0.0;
+/** Last latitude as delivered by the module (deg * 1e7), for the log */
+volatile int32_t g_last_latitude = 0;
+/** Last longitude as delivered by the module (deg * 1e7), for the log */
+volatile int32_t g_last_longitude = 0;
 /** Last accuracy for global use */
 volatile float g_last_accuracy = 0.0;
 /** Last altitude for global use */
@@ -54,10 +58,61 @@ uint16_t check_gnss_counter = 0;
 /** Max number of GNSS readings before giving up */
 uint16_t check_gnss_max_try = 0;
 
+/** Last GNSS solution */
+gnss_snapshot_s g_gnss_snapshot;
+/** Number of I2C transactions with the GNSS module since boot */
+uint32_t gnss_transactions = 0;
+
+/** Flag for a new solution from the module, set by gnss_pvt_callback() */
+volatile bool gnss_pvt_ready = false;
+/** Time the last solution arrived (ms) */
+uint32_t gnss_pvt_time = 0;
+/** Start of the location acquisition (ms) */
+uint32_t gnss_start_time = 0;
+
+/** Horizontal accuracy estimate at the start of the settle window (mm) */
+uint32_t gnss_settle_hacc = 0xFFFFFFFF;
+/** Start of the settle window (ms) */
+uint32_t gnss_settle_time = 0;
+
+/** Time and quality of the last accepted fix */
+gnss_fix_info_s gnss_last_fix = {0, 0, 0, 0, 0, 0, false, "none"};
+
+/** Flag if the module was powered up and did not get the warm start data yet */
+bool gnss_warm_pending = false;
+
 /** Max number of satellites seen */
 uint8_t max_sat = 0;
 /** Number of checks with unchanged number of satellites seen */
 uint8_t max_sat_unchanged = 0;
+/** Acquisition step of the last satellite check, counted once per GNSS_POLL_INTERVAL */
+uint16_t max_sat_step = 0xFFFF;
+
+/**
+ * @brief Auto PVT callback, called by checkCallbacks() for each
+ * 		solution the module sent. The solution stays in the library
+ * 		buffer and is read by gnss_read_pvt().
+ *
+ * @param pvt new solution (unused)
+ */
+void gnss_pvt_callback(UBX_NAV_PVT_data_t *pvt)
+{
+	gnss_pvt_ready = true;
+	gnss_pvt_time = millis();
+}
+
+/**
+ * @brief Check if the power rail of the module (WB_IO2) is switched on.
+ * 		WB_IO2 is an output, digitalRead() does not return its level.
+ *
+ * @return true module is powered
+ * @return false module is off
+ */
+bool gnss_power_on(void)
+{
+	NRF_GPIO_Type *port = (WB_IO2 < 32) ? NRF_P0 : NRF_P1;
+	return ((port->OUT >> (WB_IO2 & 0x1F)) & 0x01) != 0;
+}
 
 /**
  * @brief Initialize GNSS module
@@ -68,6 +123,13 @@ uint8_t max_sat_unchanged = 0;
  */
 bool init_gnss(bool active)
 {
+	// After a reboot or with the power rail off the module starts without warm start data
+	if ((g_gnss_option == NO_GNSS_INIT) || !gnss_power_on())
+	{
+		gnss_warm_pending = true;
+		gnss_power_time = millis();
+	}
+
 	// Power on the GNSS module
 	digitalWrite(WB_IO2, HIGH);
 
@@ -100,6 +162,7 @@ bool init_gnss(bool active)
 			{
 				my_gnss.setNavigationFrequency(5); // Produce two solutions per second
 				my_gnss.setAutoPVT(true, false);   // Tell the GNSS to "send" each solution and the lib not to update stale data implicitly
+				my_gnss.setAutoPVTcallbackPtr(gnss_pvt_callback); // Flag each solution as it arrives
 			}
 			else
 			{
@@ -151,17 +214,225 @@ bool init_gnss(bool active)
 		{
 			my_gnss.setNavigationFrequency(5); // Produce two solutions per second
 			my_gnss.setAutoPVT(true, false);   // Tell the GNSS to "send" each solution and the lib not to update stale data implicitly
+			my_gnss.setAutoPVTcallbackPtr(gnss_pvt_callback); // Flag each solution as it arrives
 		}
 		else
 		{
 			my_gnss.setMeasurementRate(500);
 		}
 		my_gnss.saveConfiguration(); // Save the current settings to flash and BBR
+
+		// Give the module the last position, the time and the navigation database, only needed after a power up
+		if (gnss_warm_pending)
+		{
+			gnss_warm_start();
+		}
 	}
 
 	return true;
 }
 
+/**
+ * @brief Read one NAV-PVT solution into a snapshot.
+ * 		All position fields come from the same message, the getters of
+ * 		the library are not used because each of them can poll the
+ * 		module again.
+ * 		With location_on the module sends each solution (auto PVT), a
+ * 		single read of the I2C buffer takes it. Otherwise the solution
+ * 		is polled.
+ *
+ * @param snapshot snapshot to fill, transactions is incremented
+ * @return true solution read
+ * @return false no solution from the module, only fix_ok is cleared
+ */
+bool gnss_read_pvt(gnss_snapshot_s *snapshot)
+{
+	snapshot->transactions++;
+	gnss_transactions++;
+	if (g_custom_parameters.location_on)
+	{
+		my_gnss.checkUblox();
+		my_gnss.checkCallbacks();
+		gnss_pvt_ready = false;
+	}
+	else if (!my_gnss.getPVT())
+	{
+		snapshot->fix_ok = false;
+		return false;
+	}
+	if (my_gnss.packetUBXNAVPVT == NULL)
+	{
+		snapshot->fix_ok = false;
+		return false;
+	}
+
+	UBX_NAV_PVT_data_t *pvt = &my_gnss.packetUBXNAVPVT->data;
+	snapshot->itow = pvt->iTOW;
+	snapshot->latitude = pvt->lat;
+	snapshot->longitude = pvt->lon;
+	snapshot->altitude = pvt->height;
+	snapshot->satellites = pvt->numSV;
+	snapshot->fix_type = pvt->fixType;
+	snapshot->fix_ok = pvt->flags.bits.gnssFixOK;
+	snapshot->h_acc = pvt->hAcc;
+	snapshot->pdop = pvt->pDOP;
+	snapshot->utc = 0;
+	if (pvt->valid.bits.validDate && pvt->valid.bits.validTime)
+	{
+		snapshot->utc = log_make_time(pvt->year, pvt->month, pvt->day, pvt->hour, pvt->min, pvt->sec);
+	}
+	return true;
+}
+
+/**
+ * @brief Add the horizontal DOP to a snapshot, one NAV-DOP poll
+ *
+ * @param snapshot snapshot to update, transactions is incremented
+ * @return true DOP read
+ * @return false no answer from the module, hdop is not changed
+ */
+bool gnss_read_dop(gnss_snapshot_s *snapshot)
+{
+	snapshot->transactions++;
+	gnss_transactions++;
+	if (!my_gnss.getDOP() || (my_gnss.packetUBXNAVDOP == NULL))
+	{
+		return false;
+	}
+	snapshot->hdop = my_gnss.packetUBXNAVDOP->data.hDOP;
+	return true;
+}
+
+/**
+ * @brief Fix acceptance as before the policies.
+ * 		With location_on HDOP below 3 and more than 5 satellites,
+ * 		otherwise a 3D fix with the number of satellites not growing
+ * 		for two 2.5 second steps.
+ *
+ * @param snapshot solution, hdop is needed with location_on
+ * @return true fix is good enough
+ */
+bool gnss_accept_legacy(gnss_snapshot_s *snapshot)
+{
+	if (g_custom_parameters.location_on)
+	{
+		return (snapshot->hdop < 300) && (snapshot->satellites > 5);
+	}
+	return (snapshot->fix_type >= 3) && (max_sat_unchanged >= 2);
+}
+
+/**
+ * @brief Accept a 3D fix with the horizontal accuracy estimate below
+ * 		gnss_hacc_max
+ *
+ * @param snapshot solution
+ * @return true fix is good enough
+ */
+bool gnss_accept_hacc(gnss_snapshot_s *snapshot)
+{
+	return snapshot->fix_ok && (snapshot->fix_type >= 3) && (snapshot->h_acc <= (uint32_t)g_custom_parameters.gnss_hacc_max * 1000);
+}
+
+/**
+ * @brief Accept a 3D fix when the horizontal accuracy estimate
+ * 		improved less than GNSS_SETTLE_PERCENT within GNSS_SETTLE_TIME
+ *
+ * @param snapshot solution
+ * @return true fix is good enough
+ */
+bool gnss_accept_settled(gnss_snapshot_s *snapshot)
+{
+	if (!snapshot->fix_ok || (snapshot->fix_type < 3))
+	{
+		gnss_settle_hacc = 0xFFFFFFFF;
+		gnss_settle_time = millis();
+		return false;
+	}
+	if ((millis() - gnss_settle_time) < GNSS_SETTLE_TIME)
+	{
+		return false;
+	}
+	bool settled = (gnss_settle_hacc != 0xFFFFFFFF) &&
+				   ((uint64_t)(gnss_settle_hacc > snapshot->h_acc ? gnss_settle_hacc - snapshot->h_acc : 0) * 100 < (uint64_t)gnss_settle_hacc * GNSS_SETTLE_PERCENT);
+	gnss_settle_hacc = snapshot->h_acc;
+	gnss_settle_time = millis();
+	return settled;
+}
+
+/** Fix acceptance policies, in the order of gnss_policy_t */
+gnss_policy_s gnss_policies[GNSS_POLICY_NUM] = {
+	{gnss_accept_legacy, "legacy", true},
+	{gnss_accept_hacc, "hacc", false},
+	{gnss_accept_settled, "settled", false},
+};
+
+/**
+ * @brief Reset the state of the fix acceptance policies, called when
+ * 		a location acquisition starts
+ *
+ */
+void gnss_reset_policy(void)
+{
+	max_sat = 0;
+	max_sat_unchanged = 0;
+	max_sat_step = 0xFFFF;
+	gnss_settle_hacc = 0xFFFFFFFF;
+	gnss_settle_time = millis();
+}
+
+/**
+ * @brief Get the selected fix acceptance policy
+ *
+ * @return uint8_t policy, see gnss_policy_t
+ */
+uint8_t gnss_selected_policy(void)
+{
+	return g_custom_parameters.gnss_policy < GNSS_POLICY_NUM ? g_custom_parameters.gnss_policy : GNSS_POLICY_LEGACY;
+}
+
+/**
+ * @brief Check a solution with the selected fix acceptance policy.
+ * 		During a location acquisition any 3D fix is accepted after
+ * 		gnss_deadline percent of the acquisition time (half of the
+ * 		send interval), the legacy policy has no deadline.
+ * 		The time and quality of an accepted fix are kept in
+ * 		gnss_last_fix for ATC+GNSSFIX=? and logged.
+ *
+ * @param snapshot solution
+ * @return true fix is good enough
+ */
+bool gnss_fix_accepted(gnss_snapshot_s *snapshot)
+{
+	uint8_t policy = gnss_selected_policy();
+	uint32_t elapsed = millis() - gnss_start_time;
+	const char *reason = gnss_policies[policy].name;
+
+	bool accepted = gnss_policies[policy].accept(snapshot);
+	if (!accepted && gnss_active && (policy != GNSS_POLICY_LEGACY) && (g_custom_parameters.gnss_deadline != 0))
+	{
+		uint32_t deadline = (uint32_t)check_gnss_max_try * GNSS_POLL_INTERVAL / 100 * g_custom_parameters.gnss_deadline;
+		if ((elapsed >= deadline) && snapshot->fix_ok && (snapshot->fix_type >= 3))
+		{
+			accepted = true;
+			reason = "deadline";
+		}
+	}
+	if (accepted)
+	{
+		gnss_last_fix.fixes++;
+		gnss_last_fix.ttf = gnss_active ? elapsed : 0;
+		gnss_last_fix.h_acc = snapshot->h_acc;
+		gnss_last_fix.pdop = snapshot->pdop;
+		gnss_last_fix.satellites = snapshot->satellites;
+		gnss_last_fix.fix_type = snapshot->fix_type;
+		gnss_last_fix.warm = gnss_warm;
+		gnss_last_fix.reason = reason;
+		MYLOG("GNSS", "Fix accepted (%s) after %ld ms: fix %d sat %d hAcc %ld mm pDOP %.2f", reason, gnss_active ? elapsed : 0,
+			  snapshot->fix_type, snapshot->satellites, snapshot->h_acc, snapshot->pdop / 100.0);
+	}
+	return accepted;
+}
+
 /**
  * @brief Check GNSS module for position
  *
@@ -185,15 +456,32 @@ bool poll_gnss(void)
 	sprintf(fix_type_str, "No Fix");
 	byte fix_type;
 
+	// First use of the module after it was powered up
+	if (gnss_warm_pending && gnss_power_on())
+	{
+		gnss_warm_start();
+	}
+
+	// All values of this poll come from one solution
+	gnss_snapshot_s *snapshot = &g_gnss_snapshot;
+	snapshot->transactions = 0;
+	gnss_read_pvt(snapshot);
+
 	if (g_custom_parameters.location_on)
 	{
-		// GNSS is active all time, just check HDOP and number of satellites
-		latitude = my_gnss.getLatitude();
-		longitude = my_gnss.getLongitude();
-		altitude = my_gnss.getAltitude();
-		accuracy = my_gnss.getHorizontalDOP();
-		satellites = my_gnss.getSIV();
-		fix_type = my_gnss.getFixType(); // Get the fix type
+		// GNSS is active all time, just check HDOP and number of satellites.
+		// HDOP is one more poll, it is read before the check only if the policy uses it
+		bool policy_hdop = gnss_policies[gnss_selected_policy()].hdop;
+		if (policy_hdop)
+		{
+			gnss_read_dop(snapshot);
+		}
+		latitude = snapshot->latitude;
+		longitude = snapshot->longitude;
+		altitude = snapshot->altitude;
+		accuracy = snapshot->hdop;
+		satellites = snapshot->satellites;
+		fix_type = snapshot->fix_type; // Get the fix type
 		if (fix_type == 1)
 			sprintf(fix_type_str, "Dead reckoning");
 		else if (fix_type == 2)
@@ -214,18 +502,25 @@ bool poll_gnss(void)
 		MYLOG("GNSS", "Lat: %.4f Lon: %.4f", latitude / 10000000.0, longitude / 10000000.0);
 		MYLOG("GNSS", "Alt: %.2f", altitude / 1000.0);
 		MYLOG("GNSS", "HDOP: %.2f ", accuracy / 100.0);
+		MYLOG("GNSS", "I2C transactions: %d", snapshot->transactions);
 
-		if ((accuracy < 300) && (satellites > 5))
+		if (gnss_fix_accepted(snapshot))
 		{
 			has_gnss_location = true;
+			// The payload needs the HDOP of the accepted fix
+			if (!policy_hdop)
+			{
+				gnss_read_dop(snapshot);
+				accuracy = snapshot->hdop;
+			}
 		}
 	}
 	else
 	{
-		if (my_gnss.getGnssFixOk())
+		if (snapshot->fix_ok)
 		{
 			digitalWrite(LED_BLUE, HIGH);
-			fix_type = my_gnss.getFixType(); // Get the fix type
+			fix_type = snapshot->fix_type; // Get the fix type
 			if (fix_type == 0)
 				sprintf(fix_type_str, "No Fix");
 			else if (fix_type == 1)
@@ -239,20 +534,26 @@ bool poll_gnss(void)
 			else if (fix_type == 5)
 				sprintf(fix_type_str, "Time fix");
 
-			satellites = my_gnss.getSIV();
+			satellites = snapshot->satellites;
 
 			bool satisfied = false;
 
-			// When in cold start, wait for max satellites
-			if (satellites == max_sat)
-			{
-				max_sat_unchanged++;
-			}
-			if (satellites > max_sat)
+			// When in cold start, wait for max satellites.
+			// Checked once per 2.5 second step as with the old timer, independent of the poll rate
+			uint16_t step = (millis() - gnss_start_time) / GNSS_POLL_INTERVAL;
+			if (step != max_sat_step)
 			{
-				max_sat = satellites;
+				max_sat_step = step;
+				if (satellites == max_sat)
+				{
+					max_sat_unchanged++;
+				}
+				if (satellites > max_sat)
+				{
+					max_sat = satellites;
+				}
 			}
-			if ((fix_type >= 3) && (max_sat_unchanged >= 2)) /** Fix type 3D and number of satellites not growing */
+			if (gnss_fix_accepted(snapshot))
 			{
 				satisfied = true;
 			}
@@ -263,10 +564,12 @@ bool poll_gnss(void)
 			// if (fix_type >= 3) /** Fix type 3D */
 			{
 				has_gnss_location = true;
-				latitude = my_gnss.getLatitude();
-				longitude = my_gnss.getLongitude();
-				altitude = my_gnss.getAltitude();
-				accuracy = my_gnss.getHorizontalDOP();
+				// HDOP is only needed for an accepted fix
+				gnss_read_dop(snapshot);
+				latitude = snapshot->latitude;
+				longitude = snapshot->longitude;
+				altitude = snapshot->altitude;
+				accuracy = snapshot->hdop;
 
 				// MYLOG("GNSS", "Fixtype: %d %s", my_gnss.getFixType(), fix_type_str);
 				// MYLOG("GNSS", "Lat: %.4f Lon: %.4f", latitude / 10000000.0, longitude / 10000000.0);
@@ -295,6 +598,8 @@ bool poll_gnss(void)
 
 		g_last_lat = latitude / 10000000.0;
 		g_last_long = longitude / 10000000.0;
+		g_last_latitude = latitude;
+		g_last_longitude = longitude;
 		g_last_accuracy = accuracy;
 		g_last_altitude = altitude / 1000;
 		g_last_satellites = satellites;
@@ -326,6 +631,8 @@ bool poll_gnss(void)
 
 		g_last_lat = latitude / 10000000.0;
 		g_last_long = longitude / 10000000.0;
+		g_last_latitude = latitude;
+		g_last_longitude = longitude;
 		g_last_accuracy = accuracy;
 		g_last_altitude = altitude / 1000;
 		g_last_satellites = satellites;
@@ -334,6 +641,8 @@ bool poll_gnss(void)
 #else
 		g_last_lat = 0;
 		g_last_long = 0;
+		g_last_latitude = 0;
+		g_last_longitude = 0;
 		g_last_accuracy = 1;
 		g_last_altitude = 0;
 		g_last_satellites = 0;
@@ -347,27 +656,48 @@ bool poll_gnss(void)
 
 /**
  * @brief GNSS location aqcuisition
- * Called every 2.5 seconds by timer 1
+ * Called by the GNSS job, every GNSS_CHECK_INTERVAL with location_on,
+ * otherwise every GNSS_POLL_INTERVAL
+ * With location_on a solution is only checked when the module
+ * sent a new one, the packet is sent as soon as it is good enough.
  * Gives up after 1/2 of send frequency
  * or when location was aquired
  *
  */
 void gnss_handler(void *)
 {
+	// Steps of 2.5 seconds for the timeout and the progress display
+	uint16_t step = (millis() - gnss_start_time) / GNSS_POLL_INTERVAL;
+
+	if (g_custom_parameters.location_on)
+	{
+		// Take the solutions the module sent since the last check
+		gnss_transactions++;
+		my_gnss.checkUblox();
+		my_gnss.checkCallbacks();
+		if (!gnss_pvt_ready && (step < check_gnss_max_try))
+		{
+			return;
+		}
+	}
+
 	digitalWrite(LED_GREEN, HIGH);
 	bool finished_poll = false;
 	if (poll_gnss())
 	{
 		// Keep GNSS active if forced in setup ==> Leads to faster battery drainage!
-		if (!g_custom_parameters.location_on)
+		if (!g_custom_parameters.location_on && !has_sd)
 		{
-			// Power down the module
+			// Power down the module (shares the power rail with the SD card)
 			digitalWrite(WB_IO2, LOW);
+			gnss_warm_pending = true;
 		}
 		gnss_active = false;
 		delay(100);
-		MYLOG("GNSS", "Got location");
-		api.system.timer.stop(RAK_TIMER_3);
+		MYLOG("GNSS", "Got location after %ld ms", millis() - gnss_start_time);
+		// Keep the fix for the next power up, saved by the GNSS cache job after the uplink
+		gnss_cache_fix(&g_gnss_snapshot, millis() - gnss_start_time);
+		job_stop(JOB_GNSS);
 		if (has_oled && !g_settings_ui)
 		{
 			oled_clear();
@@ -396,6 +726,7 @@ void gnss_handler(void *)
 			else
 			{
 				tx_active = true;
+				MYLOG("GNSS", "Solution to send %ld ms", millis() - gnss_pvt_time);
 			}
 			// Increase sent packet number
 			packet_num++;
@@ -407,7 +738,7 @@ void gnss_handler(void *)
 	}
 	else
 	{
-		if (check_gnss_counter >= check_gnss_max_try)
+		if (step >= check_gnss_max_try)
 		{
 			// Keep GNSS active until we get a valid location!
 			delay(100);
@@ -415,7 +746,7 @@ void gnss_handler(void *)
 			tx_active = false;
 
 			MYLOG("GNSS", "Location timeout");
-			api.system.timer.stop(RAK_TIMER_3);
+			job_stop(JOB_GNSS);
 			// If no location found, FieldTester does not send data
 			if (has_oled && !g_settings_ui)
 			{
@@ -425,8 +756,10 @@ void gnss_handler(void *)
 			finished_poll = true;
 		}
 	}
-	if (has_oled && !finished_poll && !g_settings_ui)
+	// Update the progress once per step
+	if (has_oled && !finished_poll && !g_settings_ui && (step != check_gnss_counter))
 	{
+		check_gnss_counter = step;
 		oled_clear();
 		line_str[0] = 0x00;
 		if (g_custom_parameters.location_on)
@@ -452,6 +785,5 @@ void gnss_handler(void *)
 		oled_add_line(line_str);
 		oled_display();
 	}
-	check_gnss_counter++;
 	digitalWrite(LED_GREEN, LOW);
 }
@@ -0,0 +1,207 @@
+/**
+ * @file gnss_cache.cpp
+ * @author Bernd Giesecke (bernd@giesecke.tk)
+ * @brief Warm start data of the GNSS module.
+ * 		The last position and time are kept in flash, the navigation
+ * 		database of the module (UBX-MGA-DBD) on the SD card. Both are
+ * 		given back to the module after it was powered up.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include "app.h"
+#include <SD.h>
+#include <utilities.h>
+
+// The GNSS object
+extern SFE_UBLOX_GNSS my_gnss;
+
+// The settings are saved at flash offset 0, the warm start data must not overlap them
+static_assert(sizeof(custom_param_s) <= GNSS_CACHE_FLASH_OFFSET, "Settings overlap the GNSS warm start data in flash");
+
+/** Last position and time */
+gnss_cache_s gnss_cache;
+
+#if GNSS_DBD_SIZE > 0
+/** Buffer for the navigation database */
+uint8_t gnss_dbd[GNSS_DBD_SIZE];
+#endif
+
+/** Time the warm start data was saved (ms) */
+uint32_t gnss_cache_time = 0;
+/** Flag if the warm start data was saved since power up */
+bool gnss_cache_saved = false;
+/** Time the module was powered up (ms) */
+uint32_t gnss_power_time = 0;
+/** Flag if warm start data was given to the module */
+bool gnss_warm = false;
+
+/**
+ * @brief Read the last position and time from flash
+ *
+ * @return true valid data found
+ * @return false no data or CRC error
+ */
+bool load_gnss_cache(void)
+{
+	if (!api.system.flash.get(GNSS_CACHE_FLASH_OFFSET, (uint8_t *)&gnss_cache, sizeof(gnss_cache_s)))
+	{
+		return false;
+	}
+	if ((gnss_cache.magic != GNSS_CACHE_MAGIC) || (gnss_cache.crc != Crc32((uint8_t *)&gnss_cache, sizeof(gnss_cache_s) - sizeof(uint32_t))))
+	{
+		MYLOG("GNSS", "No warm start data in flash");
+		return false;
+	}
+	return true;
+}
+
+/**
+ * @brief Write the last position and time to flash
+ *
+ * @return true data written
+ * @return false flash write failed
+ */
+bool save_gnss_cache(void)
+{
+	gnss_cache.magic = GNSS_CACHE_MAGIC;
+	gnss_cache.crc = Crc32((uint8_t *)&gnss_cache, sizeof(gnss_cache_s) - sizeof(uint32_t));
+	if (!api.system.flash.set(GNSS_CACHE_FLASH_OFFSET, (uint8_t *)&gnss_cache, sizeof(gnss_cache_s)))
+	{
+		// Retry
+		return api.system.flash.set(GNSS_CACHE_FLASH_OFFSET, (uint8_t *)&gnss_cache, sizeof(gnss_cache_s));
+	}
+	return true;
+}
+
+/**
+ * @brief Give the last position, the time and the navigation
+ * 		database to the module. Called once after the module was
+ * 		powered up and configured, see gnss_warm_pending.
+ * 		The time is only sent with a RTC, it is the UTC of the last fix
+ * 		plus the RTC time passed since then, the time zone of the RTC
+ * 		does not matter.
+ *
+ */
+void gnss_warm_start(void)
+{
+	// Module is still starting up, poll_gnss() tries again on the first use
+	if (!my_gnss.isConnected())
+	{
+		MYLOG("GNSS", "Module not ready for warm start");
+		return;
+	}
+	gnss_warm_pending = false;
+	gnss_cache_saved = false;
+	gnss_warm = false;
+
+	if (load_gnss_cache())
+	{
+		if (has_rtc && (gnss_cache.rtc != 0) && (gnss_cache.utc != 0))
+		{
+			read_rak12002();
+			uint32_t rtc_now = log_make_time(g_date_time.year, g_date_time.month, g_date_time.date, g_date_time.hour, g_date_time.minute, g_date_time.second);
+			if (rtc_now >= gnss_cache.rtc)
+			{
+				date_time_s utc;
+				log_split_time(gnss_cache.utc + (rtc_now - gnss_cache.rtc), &utc);
+				my_gnss.setUTCTimeAssistance(utc.year, utc.month, utc.date, utc.hour, utc.minute, utc.second, 0, GNSS_WARM_TIME_ACC);
+				MYLOG("GNSS", "Time assistance %d.%02d.%02d %d:%02d:%02d", utc.year, utc.month, utc.date, utc.hour, utc.minute, utc.second);
+			}
+		}
+		// Altitude and accuracy in cm
+		my_gnss.setPositionAssistanceLLH(gnss_cache.latitude, gnss_cache.longitude, gnss_cache.altitude / 10, GNSS_WARM_POS_ACC);
+		MYLOG("GNSS", "Position assistance %.4f %.4f", gnss_cache.latitude / 10000000.0, gnss_cache.longitude / 10000000.0);
+		gnss_warm = true;
+	}
+
+#if GNSS_DBD_SIZE > 0
+	if (has_sd && mount_sd())
+	{
+		File file = SD.open(GNSS_DBD_NAME, FILE_READ);
+		if (file)
+		{
+			size_t size = file.read(gnss_dbd, GNSS_DBD_SIZE);
+			file.close();
+			if (size > 0)
+			{
+				size_t pushed = my_gnss.pushAssistNowData(gnss_dbd, size);
+				MYLOG("GNSS", "Navigation database %d of %d bytes pushed", pushed, size);
+				gnss_warm = true;
+			}
+		}
+	}
+#endif
+}
+
+/**
+ * @brief Keep the warm start data of an accepted fix and log the time
+ * 		to fix. The data is saved on the first fix after power up and
+ * 		then every GNSS_CACHE_INTERVAL by the GNSS cache job, so the
+ * 		uplink with the fix is not delayed.
+ *
+ * @param snapshot accepted solution
+ * @param ttf time to fix of this acquisition (ms)
+ */
+void gnss_cache_fix(gnss_snapshot_s *snapshot, uint32_t ttf)
+{
+	MYLOG("GNSS", "TTF %ld ms, %ld ms since power up, %s start", ttf, millis() - gnss_power_time, gnss_warm ? "warm" : "cold");
+
+	if (gnss_cache_saved && ((millis() - gnss_cache_time) < GNSS_CACHE_INTERVAL))
+	{
+		return;
+	}
+	gnss_cache_saved = true;
+	gnss_cache_time = millis();
+
+	gnss_cache.latitude = snapshot->latitude;
+	gnss_cache.longitude = snapshot->longitude;
+	gnss_cache.altitude = snapshot->altitude;
+	gnss_cache.utc = snapshot->utc;
+	gnss_cache.rtc = 0;
+	if (has_rtc)
+	{
+		read_rak12002();
+		gnss_cache.rtc = log_make_time(g_date_time.year, g_date_time.month, g_date_time.date, g_date_time.hour, g_date_time.minute, g_date_time.second);
+	}
+	job_start(JOB_GNSS_CACHE, 0);
+}
+
+/**
+ * @brief Save the warm start data, called by the GNSS cache job.
+ * 		Reading the navigation database blocks for up to 2 seconds, the
+ * 		save waits until the radio is idle.
+ *
+ */
+void save_gnss_warm_data(void)
+{
+	if (tx_active)
+	{
+		job_start(JOB_GNSS_CACHE, 1000);
+		return;
+	}
+
+	if (!save_gnss_cache())
+	{
+		MYLOG("GNSS", "Saving warm start data failed");
+	}
+
+#if GNSS_DBD_SIZE > 0
+	if (has_sd && mount_sd())
+	{
+		size_t size = my_gnss.readNavigationDatabase(gnss_dbd, GNSS_DBD_SIZE);
+		if (size > 0)
+		{
+			File file = SD.open(GNSS_DBD_NAME, FILE_UPDATE | O_TRUNC);
+			if (file)
+			{
+				file.write(gnss_dbd, size);
+				file.close();
+				MYLOG("GNSS", "Navigation database %d bytes saved", size);
+			}
+		}
+	}
+#endif
+}
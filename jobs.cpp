@@ -0,0 +1,326 @@
+/**
+ * @file jobs.cpp
+ * @author Bernd Giesecke (bernd@giesecke.tk)
+ * @brief Periodic and one-shot jobs of the application and the event
+ * 		queue that starts and stops them. All jobs run from loop() in
+ * 		mtmMain, one after the other, instead of in four RUI3 timers.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include "app.h"
+
+/** Job entry */
+struct job_s
+{
+	MillisTaskManager::TaskFunction_t function;
+	bool one_shot;
+	uint8_t priority;
+	const char *name;
+};
+
+void send_job(void);
+void display_job(void);
+void oled_saver_job(void);
+void gnss_job(void);
+void motion_job(void);
+void gnss_cache_job(void);
+
+/** Jobs, in the order of app_jobs_t */
+job_s jobs[JOB_NUM] = {
+	{send_job, false, 0, "send"},
+	{display_job, true, 0, "display"},
+	{oled_saver_job, true, 3, "oled_saver"},
+	{gnss_job, false, 1, "gnss"},
+	{motion_job, true, 1, "motion"},
+	{gnss_cache_job, true, 3, "gnss_cache"},
+};
+
+/** Event queue, written by callbacks and the application, read by loop() */
+app_event_s event_queue[EVENT_QUEUE_SIZE];
+/** Next free slot of the event queue */
+volatile uint8_t event_queue_head = 0;
+/** Oldest event of the event queue */
+volatile uint8_t event_queue_tail = 0;
+/** Number of events dropped because the queue was full */
+volatile uint32_t event_queue_dropped = 0;
+
+/** Radio event queue, written by the radio callbacks, read by the display job */
+radio_event_s radio_event_queue[RADIO_EVENT_QUEUE_SIZE];
+/** Next free slot of the radio event queue */
+volatile uint8_t radio_event_head = 0;
+/** Oldest event of the radio event queue */
+volatile uint8_t radio_event_tail = 0;
+/** Number of radio events dropped because the queue was full */
+volatile uint32_t radio_event_dropped = 0;
+
+/**
+ * @brief Send job, periodic with the send interval
+ *
+ */
+void send_job(void)
+{
+	send_packet(NULL);
+}
+
+/**
+ * @brief Display job, one-shot after a radio event.
+ * 		Handles all queued radio events, each one is shown and logged.
+ *
+ */
+void display_job(void)
+{
+	radio_event_s *event;
+	while ((event = peek_radio_event()) != NULL)
+	{
+		handle_display(event);
+		release_radio_event();
+	}
+}
+
+/**
+ * @brief Display saver job, one-shot after the display was switched on
+ *
+ */
+void oled_saver_job(void)
+{
+	oled_saver(NULL);
+}
+
+/**
+ * @brief GNSS job, periodic while a location is acquired
+ *
+ */
+void gnss_job(void)
+{
+	gnss_handler(NULL);
+}
+
+/**
+ * @brief Motion job, one-shot after an ACC interrupt
+ *
+ */
+void motion_job(void)
+{
+	handle_motion();
+}
+
+/**
+ * @brief GNSS cache job, one-shot after an accepted fix
+ *
+ */
+void gnss_cache_job(void)
+{
+	save_gnss_warm_data();
+}
+
+/**
+ * @brief Register all jobs in mtmMain, stopped
+ *
+ */
+void init_jobs(void)
+{
+	for (uint8_t job = 0; job < JOB_NUM; job++)
+	{
+		mtmMain.Register(jobs[job].function, 0, false, jobs[job].one_shot);
+		mtmMain.SetPriority(jobs[job].function, jobs[job].priority);
+	}
+}
+
+/**
+ * @brief Add an event to the event queue.
+ * 		Safe to call from callbacks and interrupt handlers, the
+ * 		producers are serialized with interrupts disabled.
+ *
+ * @param type event type, see app_event_type_t
+ * @param job job, see app_jobs_t
+ * @param time_ms period or delay of the job (ms)
+ * @return true event queued
+ * @return false queue full
+ */
+bool post_event(uint8_t type, uint8_t job, uint32_t time_ms)
+{
+	noInterrupts();
+	uint8_t head = event_queue_head;
+	uint8_t next = (head + 1) & (EVENT_QUEUE_SIZE - 1);
+	if (next == event_queue_tail)
+	{
+		event_queue_dropped++;
+		interrupts();
+		return false;
+	}
+	event_queue[head].type = type;
+	event_queue[head].job = job;
+	event_queue[head].time = time_ms;
+	// Publish the slot only after the event is complete
+	__sync_synchronize();
+	event_queue_head = next;
+	interrupts();
+	return true;
+}
+
+/**
+ * @brief Start a job, replaces api.system.timer.start().
+ * 		A periodic job runs every time_ms, a one-shot job once
+ * 		after time_ms. Starting a running job restarts it.
+ *
+ * @param job job, see app_jobs_t
+ * @param time_ms period or delay (ms)
+ * @return true event queued
+ * @return false queue full
+ */
+bool job_start(uint8_t job, uint32_t time_ms)
+{
+	return post_event(EVENT_JOB_START, job, time_ms);
+}
+
+/**
+ * @brief Stop a job, replaces api.system.timer.stop()
+ *
+ * @param job job, see app_jobs_t
+ * @return true event queued
+ * @return false queue full
+ */
+bool job_stop(uint8_t job)
+{
+	return post_event(EVENT_JOB_STOP, job, 0);
+}
+
+/**
+ * @brief Check for events that were not dispatched yet
+ *
+ * @return true events are waiting
+ * @return false queue is empty
+ */
+bool events_pending(void)
+{
+	return event_queue_tail != event_queue_head;
+}
+
+/**
+ * @brief Apply the queued events in the order they were posted.
+ * 		Called from loop() before the jobs run, consumer side of
+ * 		the event queue. Starts the display job if radio events are
+ * 		waiting and the job is stopped.
+ *
+ */
+void dispatch_events(void)
+{
+	while (event_queue_tail != event_queue_head)
+	{
+		uint8_t tail = event_queue_tail;
+		app_event_s event = event_queue[tail];
+		// Release the slot only after it was copied
+		__sync_synchronize();
+		event_queue_tail = (tail + 1) & (EVENT_QUEUE_SIZE - 1);
+
+		if (event.job >= JOB_NUM)
+		{
+			continue;
+		}
+		switch (event.type)
+		{
+		case EVENT_JOB_START:
+			mtmMain.Start(jobs[event.job].function, event.time, millis());
+			break;
+		case EVENT_JOB_STOP:
+			mtmMain.SetState(jobs[event.job].function, false);
+			break;
+		}
+	}
+
+	// Radio events wait for the display job, its start might have been lost in a full event queue
+	if (peek_radio_event() != NULL)
+	{
+		MillisTaskManager::Task_t *task = mtmMain.Find(jobs[JOB_DISPLAY].function);
+		if ((task != NULL) && !task->State)
+		{
+			mtmMain.Start(jobs[JOB_DISPLAY].function, 250, millis());
+		}
+	}
+}
+
+/**
+ * @brief Add a radio event to the radio event queue and start the
+ * 		display job. Safe to call from callbacks and interrupt handlers.
+ * 		Events that arrive before the display job ran are kept, the
+ * 		display job handles them in the order they arrived.
+ *
+ * @param event radio event, copied into the queue
+ * @return true event queued
+ * @return false queue full
+ */
+bool post_radio_event(radio_event_s *event)
+{
+	noInterrupts();
+	uint8_t head = radio_event_head;
+	uint8_t next = (head + 1) & (RADIO_EVENT_QUEUE_SIZE - 1);
+	if (next == radio_event_tail)
+	{
+		radio_event_dropped++;
+		interrupts();
+		return false;
+	}
+	radio_event_queue[head] = *event;
+	// Publish the slot only after the event is complete
+	__sync_synchronize();
+	radio_event_head = next;
+	interrupts();
+
+	job_start(JOB_DISPLAY, 250);
+	return true;
+}
+
+/**
+ * @brief Get the oldest event of the radio event queue.
+ * 		Consumer side, only called by the display job. The event stays
+ * 		in its slot until release_radio_event() is called, the
+ * 		producers cannot overwrite it while it is handled.
+ *
+ * @return radio_event_s* oldest event, NULL if the queue is empty
+ */
+radio_event_s *peek_radio_event(void)
+{
+	uint8_t tail = radio_event_tail;
+	if (tail == radio_event_head)
+	{
+		return NULL;
+	}
+	return &radio_event_queue[tail];
+}
+
+/**
+ * @brief Free the slot of the event returned by peek_radio_event()
+ *
+ */
+void release_radio_event(void)
+{
+	uint8_t tail = radio_event_tail;
+	if (tail == radio_event_head)
+	{
+		return;
+	}
+	// Release the slot only after the event was handled
+	__sync_synchronize();
+	radio_event_tail = (tail + 1) & (RADIO_EVENT_QUEUE_SIZE - 1);
+}
+
+/**
+ * @brief Get the name of a job
+ *
+ * @param func task function
+ * @return const char* name, NULL if func is not a job
+ */
+const char *job_name(MillisTaskManager::TaskFunction_t func)
+{
+	for (uint8_t job = 0; job < JOB_NUM; job++)
+	{
+		if (jobs[job].function == func)
+		{
+			return jobs[job].name;
+		}
+	}
+	return NULL;
+}
@@ -0,0 +1,126 @@
+"""
+Receiver for the bulk log dump of the Signal Meter (ATC+LOGS=b)
+
+The device sends every log file as
+	+FILE:<file>,<size>
+	+CHUNK:<file>,<offset>,<length>,<crc32>
+	<length> raw bytes
+	...
+	+DONE
+
+Chunks with a wrong CRC32 are requested again with ATC+LOGS=b,<file>,<offset>,<length>.
+If the stream stops, the dump is resumed with ATC+LOGS=b,<file>,<offset>.
+
+Usage: python log_dump.py <serial port> [output folder] [--start <file>[,<offset>]]
+Requires pyserial (pip install pyserial)
+"""
+import os
+import sys
+import zlib
+import serial
+
+MAX_RETRY = 5
+
+files = {}
+bad_chunks = []
+
+
+def file_path(out_dir, file_num):
+	return os.path.join(out_dir, '%04d-LOG.BIN' % file_num)
+
+
+def read_stream(port):
+	"""Read frames until +DONE. Returns True and the position after the last good chunk."""
+	last_pos = None
+	while True:
+		line = port.readline()
+		if not line:
+			# Timeout, stream stopped
+			return False, last_pos
+		line = line.decode('ascii', 'replace').strip()
+		if line.startswith('+FILE:'):
+			file_num, size = [int(val) for val in line[6:].split(',')]
+			if file_num not in files:
+				files[file_num] = bytearray(size)
+			elif len(files[file_num]) < size:
+				files[file_num].extend(bytes(size - len(files[file_num])))
+			print('File %04d, %d bytes' % (file_num, size))
+		elif line.startswith('+CHUNK:'):
+			values = line[7:].split(',')
+			file_num, offset, length = [int(val) for val in values[:3]]
+			crc = int(values[3], 16)
+			data = port.read(length)
+			if len(data) != length:
+				return False, last_pos
+			if zlib.crc32(data) == crc:
+				files[file_num][offset:offset + length] = data
+				last_pos = (file_num, offset + length)
+			else:
+				print('CRC error in file %04d at %d' % (file_num, offset))
+				bad_chunks.append((file_num, offset, length))
+		elif line.startswith('+DONE'):
+			return True, last_pos
+
+
+def request(port, command):
+	port.reset_input_buffer()
+	port.write((command + '\r\n').encode('ascii'))
+
+
+def main():
+	if len(sys.argv) < 2:
+		print(__doc__)
+		sys.exit(1)
+
+	args = [arg for arg in sys.argv[1:] if not arg.startswith('--')]
+	out_dir = args[1] if len(args) > 1 else '.'
+	start = None
+	if '--start' in sys.argv:
+		start = [int(val) for val in sys.argv[sys.argv.index('--start') + 1].split(',')]
+		if len(start) == 1:
+			start.append(0)
+		args.remove(sys.argv[sys.argv.index('--start') + 1])
+		# Keep the part of the file that was already received
+		if start[1] != 0 and os.path.exists(file_path(out_dir, start[0])):
+			with open(file_path(out_dir, start[0]), 'rb') as f:
+				files[start[0]] = bytearray(f.read()[:start[1]])
+
+	port = serial.Serial(args[0], 115200, timeout=5)
+
+	if start is None:
+		start = [0, 0]
+	request(port, 'ATC+LOGS=b,%d,%d' % (start[0], start[1]))
+
+	position = (start[0], start[1])
+	retry = 0
+	while True:
+		done, stopped = read_stream(port)
+		if done:
+			break
+		if stopped is None:
+			stopped = position
+		position = stopped
+		retry += 1
+		if retry > MAX_RETRY:
+			print('Stream stopped, restart with --start %d,%d' % stopped)
+			break
+		print('Stream stopped, resume file %04d at %d' % stopped)
+		request(port, 'ATC+LOGS=b,%d,%d' % stopped)
+
+	while bad_chunks and retry <= MAX_RETRY:
+		file_num, offset, length = bad_chunks.pop(0)
+		request(port, 'ATC+LOGS=b,%d,%d,%d' % (file_num, offset, length))
+		read_stream(port)
+		retry += 1
+
+	for file_num, data in sorted(files.items()):
+		with open(file_path(out_dir, file_num), 'wb') as f:
+			f.write(data)
+	if bad_chunks:
+		print('Failed chunks: ' + str(bad_chunks))
+	print('Saved %d files' % len(files))
+	port.close()
+
+
+if __name__ == '__main__':
+	main()
@@ -0,0 +1,396 @@
+/**
+ * @file log_format.cpp
+ * @author Bernd Giesecke (bernd@giesecke.tk)
+ * @brief Binary log record format and CSV rendering for the log dump
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include "app.h"
+#include <utilities.h>
+
+/** CSV header line for each column set */
+const char *csv_headers[] = {
+	"\"time\";\"Mode\";\"Gw\";\"Lat\";\"Lng\";\"RX RSSI\";\"RX SNR\";\"Demod\";\"TX DR\";\"Lost\"",
+	"\"time\";\"Mode\";\"Gw\";\"RX RSSI\";\"RX SNR\";\"Demod\";\"TX DR\";\"Lost\"",
+	"\"time\";\"Mode\";\"Gw\";\"Lat\";\"Lng\";\"min RSSI\";\"max RSSI\";\"RX RSSI\";\"RX SNR\";\"min Dist\";\"max Dist\";\"TX DR\";\"Lost\"",
+	"\"time\";\"Mode\";\"Gw\";\"Lat\";\"Lng\";\"max RSSI\";\"max SNR\";\"RX RSSI\";\"RX SNR\";\"min Dist\";\"max Dist\";\"TX DR\";\"PLR\"",
+	"\"time\";\"Mode\";\"Lat\";\"Lng\";\"RX RSSI\";\"RX SNR\"",
+	"\"time\";\"Mode\";\"RX RSSI\";\"RX SNR\""};
+
+/**
+ * @brief Get the column set of a log file
+ *
+ * @param test_mode test mode, see test_mode_num_t
+ * @param location_on location setting
+ * @return uint8_t column set, see log_columns_t
+ */
+uint8_t log_columns(uint8_t test_mode, bool location_on)
+{
+	switch (test_mode)
+	{
+	case MODE_LINKCHECK:
+		return location_on ? LOG_COL_LINKCHECK_LOC : LOG_COL_LINKCHECK;
+	case MODE_FIELDTESTER:
+		return LOG_COL_FIELDTESTER;
+	case MODE_FIELDTESTER_V2:
+		return LOG_COL_FIELDTESTER_V2;
+	default: // LoRa P2P
+		return location_on ? LOG_COL_P2P_LOC : LOG_COL_P2P;
+	}
+}
+
+/**
+ * @brief Convert a date to seconds since 1970-01-01
+ *
+ * @param year 4 digit year, 1970 or later
+ * @param month 1 to 12
+ * @param day 1 to 31
+ * @param hour 0 to 23
+ * @param minute 0 to 59
+ * @param second 0 to 59
+ * @return uint32_t seconds since 1970-01-01, 0 if the date is invalid
+ */
+uint32_t log_make_time(uint16_t year, uint8_t month, uint8_t day, uint8_t hour, uint8_t minute, uint8_t second)
+{
+	if ((year < 1970) || (month < 1) || (month > 12))
+	{
+		return 0;
+	}
+
+	// Days from civil date, with the year starting in March
+	int32_t y = year - (month <= 2 ? 1 : 0);
+	int32_t era = y / 400;
+	uint32_t yoe = y - era * 400;
+	uint32_t doy = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+	uint32_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+	uint32_t days = era * 146097 + doe - 719468;
+
+	return days * 86400 + hour * 3600 + minute * 60 + second;
+}
+
+/**
+ * @brief Convert seconds since 1970-01-01 to a date
+ *
+ * @param time seconds since 1970-01-01
+ * @param date_time structure for the date (weekday is not set)
+ */
+void log_split_time(uint32_t time, date_time_s *date_time)
+{
+	uint32_t secs = time % 86400;
+	uint32_t z = time / 86400 + 719468;
+
+	// Civil date from days, with the year starting in March
+	uint32_t era = z / 146097;
+	uint32_t doe = z - era * 146097;
+	uint32_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+	uint32_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+	uint32_t mp = (5 * doy + 2) / 153;
+	uint32_t month = mp < 10 ? mp + 3 : mp - 9;
+
+	date_time->year = yoe + era * 400 + (month <= 2 ? 1 : 0);
+	date_time->month = month;
+	date_time->date = doy - (153 * mp + 2) / 5 + 1;
+	date_time->hour = secs / 3600;
+	date_time->minute = (secs / 60) % 60;
+	date_time->second = secs % 60;
+}
+
+/**
+ * @brief Pack a result into a binary log record
+ *
+ * @param res result to log
+ * @param record packed log record
+ */
+void log_encode_record(volatile result_s *res, log_record_s *record)
+{
+	record->time = log_make_time(res->year, res->month, res->day, res->hour, res->min, res->sec);
+	record->lat = res->lat;
+	record->lng = res->lng;
+	record->lost = res->lost;
+	record->mode = res->mode;
+	record->gw = res->gw;
+	record->min_rssi = res->min_rssi;
+	record->max_rssi = res->max_rssi;
+	record->max_snr = res->max_snr;
+	record->rx_rssi = res->rx_rssi;
+	record->rx_snr = res->rx_snr;
+	record->tx_dr = res->tx_dr;
+	record->demod = res->demod;
+	// Distances are multiples of 250m (as received in the FieldTester downlink)
+	record->min_dst = res->min_dst / 250;
+	record->max_dst = res->max_dst / 250;
+	// Commit marker and CRC last, a torn write fails the check
+	record->commit = LOG_RECORD_COMMIT;
+	record->reserved[0] = 0;
+	record->reserved[1] = 0;
+	record->crc = Crc32((uint8_t *)record, offsetof(log_record_s, crc));
+}
+
+/**
+ * @brief Check if a log record was completely written
+ *
+ * @param record log record read from the SD card
+ * @return true commit marker and CRC are valid
+ * @return false unused space or torn record
+ */
+bool log_record_valid(log_record_s *record)
+{
+	return (record->commit == LOG_RECORD_COMMIT) && (record->crc == Crc32((uint8_t *)record, offsetof(log_record_s, crc)));
+}
+
+/**
+ * @brief Get the CSV header line of a column set
+ *
+ * @param columns column set, see log_columns_t
+ * @return const char* CSV header line (without line end)
+ */
+const char *log_csv_header(uint8_t columns)
+{
+	if (columns >= LOG_COL_INVALID)
+	{
+		return "";
+	}
+	return csv_headers[columns];
+}
+
+/** Two digit strings 00 to 99, formats two digits per table lookup */
+const char csv_digit_pairs[] =
+	"0001020304050607080910111213141516171819"
+	"2021222324252627282930313233343536373839"
+	"4041424344454647484950515253545556575859"
+	"6061626364656667686970717273747576777879"
+	"8081828384858687888990919293949596979899";
+
+/** Max length of a CSV line of any column set */
+#define CSV_LINE_MAX 128
+
+/**
+ * @brief Write two digits, like %02d for 0 to 99
+ *
+ * @param pos write position
+ * @param value 0 to 99
+ * @return char* position behind the digits
+ */
+char *csv_put_2(char *pos, uint8_t value)
+{
+	memcpy(pos, &csv_digit_pairs[value * 2], 2);
+	return pos + 2;
+}
+
+/**
+ * @brief Write an unsigned integer, like %u
+ *
+ * @param pos write position
+ * @param value value
+ * @return char* position behind the digits
+ */
+char *csv_put_uint(char *pos, uint32_t value)
+{
+	char digits[10];
+	char *end = &digits[10];
+	char *start = end;
+	while (value >= 100)
+	{
+		start -= 2;
+		memcpy(start, &csv_digit_pairs[(value % 100) * 2], 2);
+		value /= 100;
+	}
+	if (value >= 10)
+	{
+		start -= 2;
+		memcpy(start, &csv_digit_pairs[value * 2], 2);
+	}
+	else
+	{
+		*--start = '0' + value;
+	}
+	memcpy(pos, start, end - start);
+	return pos + (end - start);
+}
+
+/**
+ * @brief Write a signed integer, like %d
+ *
+ * @param pos write position
+ * @param value value
+ * @return char* position behind the digits
+ */
+char *csv_put_int(char *pos, int32_t value)
+{
+	if (value < 0)
+	{
+		*pos++ = '-';
+		return csv_put_uint(pos, (uint32_t)(-(int64_t)value));
+	}
+	return csv_put_uint(pos, value);
+}
+
+/**
+ * @brief Write a coordinate in 1/10000000 degree with 6 decimals.
+ * 		Same result as %.6f of the float degree value the firmware
+ * 		logged before the binary log (value / 10000000.0 as float).
+ * 		The float has 24 significant bits, times 10^6 it is exact in a
+ * 		double, llrint() then rounds like printf (half to even).
+ *
+ * @param pos write position
+ * @param value coordinate in 1/10000000 degree
+ * @return char* position behind the digits
+ */
+char *csv_put_coord(char *pos, int32_t value)
+{
+	float degree = value / 10000000.0;
+	if (degree < 0)
+	{
+		*pos++ = '-';
+		degree = -degree;
+	}
+	uint32_t micro = (uint32_t)llrint((double)degree * 1000000.0);
+	pos = csv_put_uint(pos, micro / 1000000);
+	*pos++ = '.';
+	uint32_t fraction = micro % 1000000;
+	pos = csv_put_2(pos, fraction / 10000);
+	pos = csv_put_2(pos, (fraction / 100) % 100);
+	return csv_put_2(pos, fraction % 100);
+}
+
+/**
+ * @brief Write a value in 1/10 with one decimal.
+ * 		Same result as %.1f of value / 10.0f
+ *
+ * @param pos write position
+ * @param value value in 1/10
+ * @return char* position behind the digits
+ */
+char *csv_put_tenth(char *pos, int16_t value)
+{
+	uint32_t abs_value = value;
+	if (value < 0)
+	{
+		*pos++ = '-';
+		abs_value = -(int32_t)value;
+	}
+	pos = csv_put_uint(pos, abs_value / 10);
+	*pos++ = '.';
+	*pos++ = '0' + (abs_value % 10);
+	return pos;
+}
+
+/**
+ * @brief Write a value followed by the separator
+ *
+ * @param pos write position
+ * @param value value
+ * @return char* position behind the separator
+ */
+char *csv_put_field(char *pos, int32_t value)
+{
+	pos = csv_put_int(pos, value);
+	*pos++ = ';';
+	return pos;
+}
+
+/**
+ * @brief Render a log record as CSV line.
+ * 		Table driven, the output is identical to the former snprintf
+ * 		formats, without the float printf.
+ *
+ * @param columns column set of the log file, see log_columns_t
+ * @param record log record
+ * @param line buffer for the CSV line (without line end)
+ * @param line_size size of the buffer
+ * @return size_t length of the CSV line
+ */
+size_t log_record_to_csv(uint8_t columns, log_record_s *record, char *line, size_t line_size)
+{
+	if (columns >= LOG_COL_INVALID)
+	{
+		line[0] = 0x00;
+		return 0;
+	}
+
+	date_time_s dt;
+	log_split_time(record->time, &dt);
+	int32_t min_dst = (int32_t)record->min_dst * 250;
+	int32_t max_dst = (int32_t)record->max_dst * 250;
+	bool with_location = (columns == LOG_COL_LINKCHECK_LOC) || (columns == LOG_COL_FIELDTESTER) || (columns == LOG_COL_FIELDTESTER_V2) || (columns == LOG_COL_P2P_LOC);
+
+	char csv[CSV_LINE_MAX];
+	char *pos = csv;
+
+	// Time as YYYY-MM-DD hh:mm:ss
+	pos = csv_put_2(pos, (dt.year / 100) % 100);
+	pos = csv_put_2(pos, dt.year % 100);
+	*pos++ = '-';
+	pos = csv_put_2(pos, dt.month);
+	*pos++ = '-';
+	pos = csv_put_2(pos, dt.date);
+	*pos++ = ' ';
+	pos = csv_put_2(pos, dt.hour);
+	*pos++ = ':';
+	pos = csv_put_2(pos, dt.minute);
+	*pos++ = ':';
+	pos = csv_put_2(pos, dt.second);
+	*pos++ = ';';
+
+	pos = csv_put_field(pos, record->mode);
+	if ((columns != LOG_COL_P2P_LOC) && (columns != LOG_COL_P2P))
+	{
+		pos = csv_put_field(pos, record->gw);
+	}
+	if (with_location)
+	{
+		pos = csv_put_coord(pos, record->lat);
+		*pos++ = ';';
+		pos = csv_put_coord(pos, record->lng);
+		*pos++ = ';';
+	}
+
+	switch (columns)
+	{
+	case LOG_COL_LINKCHECK_LOC:
+	case LOG_COL_LINKCHECK:
+		pos = csv_put_field(pos, record->rx_rssi);
+		pos = csv_put_field(pos, record->rx_snr);
+		pos = csv_put_field(pos, record->demod);
+		pos = csv_put_field(pos, record->tx_dr);
+		pos = csv_put_int(pos, record->lost);
+		break;
+	case LOG_COL_FIELDTESTER:
+		pos = csv_put_field(pos, record->min_rssi);
+		pos = csv_put_field(pos, record->max_rssi);
+		pos = csv_put_field(pos, record->rx_rssi);
+		pos = csv_put_field(pos, record->rx_snr);
+		pos = csv_put_field(pos, min_dst);
+		pos = csv_put_field(pos, max_dst);
+		pos = csv_put_field(pos, record->tx_dr);
+		pos = csv_put_int(pos, record->lost);
+		break;
+	case LOG_COL_FIELDTESTER_V2:
+		pos = csv_put_field(pos, record->max_rssi);
+		pos = csv_put_field(pos, record->max_snr);
+		pos = csv_put_field(pos, record->rx_rssi);
+		pos = csv_put_field(pos, record->rx_snr);
+		pos = csv_put_field(pos, min_dst);
+		pos = csv_put_field(pos, max_dst);
+		pos = csv_put_field(pos, record->tx_dr);
+		pos = csv_put_tenth(pos, record->lost);
+		break;
+	case LOG_COL_P2P_LOC:
+	case LOG_COL_P2P:
+		pos = csv_put_field(pos, record->rx_rssi);
+		pos = csv_put_int(pos, record->rx_snr);
+		break;
+	}
+
+	size_t len = pos - csv;
+	if (len >= line_size)
+	{
+		len = line_size - 1;
+	}
+	memcpy(line, csv, len);
+	line[len] = 0x00;
+	return len;
+}
@@ -0,0 +1,331 @@
+/**
+ * @file log_index.cpp
+ * @author Bernd Giesecke (bernd@giesecke.tk)
+ * @brief Persistent index of the log files on the SD card.
+ * 		Keeps the next free file number and per file row count and
+ * 		time span, so a new log file can be allocated without
+ * 		scanning the root directory.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include "app.h"
+#include <SD.h> //http://librarymanager/All#SD
+#include <utilities.h>
+
+/** Forward declarations */
+bool read_log_header(File &file, log_header_s *header);
+bool read_log_record(File &file, uint32_t row, log_record_s *record);
+
+/** Handle of the index file, open while the card is mounted */
+File index_file;
+
+/** Generation of the last valid header slot */
+uint32_t index_generation = 0;
+
+/** Next free log file number */
+uint16_t log_next_file = 0;
+
+/**
+ * @brief Calculate the CRC of a structure, excluding the CRC at its end
+ *
+ * @param data structure
+ * @param size size of the structure including the CRC
+ * @return uint32_t CRC
+ */
+uint32_t log_index_crc(void *data, uint16_t size)
+{
+	return Crc32((uint8_t *)data, size - sizeof(uint32_t));
+}
+
+/**
+ * @brief Position the index file, extend it with zeros if it is too short.
+ * 		Zeroed entries fail the CRC check and count as unknown.
+ *
+ * @param offset position in the file
+ * @return true file positioned
+ * @return false file could not be extended
+ */
+bool log_index_seek(uint32_t offset)
+{
+	uint32_t size = index_file.size();
+	if (size >= offset)
+	{
+		return index_file.seek(offset);
+	}
+	if (!index_file.seek(size))
+	{
+		return false;
+	}
+	uint8_t zeros[sizeof(log_index_entry_s)] = {0};
+	while (size < offset)
+	{
+		uint16_t chunk = min((uint32_t)sizeof(zeros), offset - size);
+		if (index_file.write(zeros, chunk) != chunk)
+		{
+			return false;
+		}
+		size += chunk;
+	}
+	return true;
+}
+
+/**
+ * @brief Open the index file, called after the SD card is mounted
+ *
+ * @return true index file is open
+ * @return false index file could not be opened
+ */
+bool open_log_index(void)
+{
+	if (index_file)
+	{
+		return true;
+	}
+	index_file = SD.open(LOG_INDEX_NAME, FILE_UPDATE);
+	if (!index_file)
+	{
+		MYLOG("IDX", "Can't open %s", LOG_INDEX_NAME);
+		return false;
+	}
+	return true;
+}
+
+/**
+ * @brief Close the index file, called before the SD card is unmounted
+ *
+ */
+void close_log_index(void)
+{
+	if (index_file)
+	{
+		index_file.close();
+	}
+}
+
+/**
+ * @brief Read the header slots of the index.
+ * 		The slot with the higher generation and a valid CRC wins.
+ *
+ * @return true valid header found, log_next_file is set
+ * @return false index is missing or corrupt
+ */
+bool read_log_index(void)
+{
+	if (!open_log_index())
+	{
+		return false;
+	}
+
+	bool found = false;
+	log_index_head_s head;
+	for (uint8_t slot = 0; slot < 2; slot++)
+	{
+		if (!index_file.seek(slot * SD_SECTOR_SIZE) || (index_file.read(&head, sizeof(log_index_head_s)) != sizeof(log_index_head_s)))
+		{
+			continue;
+		}
+		if ((head.magic != LOG_INDEX_MAGIC) || (head.crc != log_index_crc(&head, sizeof(log_index_head_s))))
+		{
+			MYLOG("IDX", "Slot %d invalid", slot);
+			continue;
+		}
+		if (!found || ((int32_t)(head.generation - index_generation) > 0))
+		{
+			index_generation = head.generation;
+			log_next_file = head.next_file;
+			found = true;
+		}
+	}
+	return found;
+}
+
+/**
+ * @brief Write the header of the index.
+ * 		The header goes to the slot not holding the current generation,
+ * 		if the write is torn the previous slot stays valid.
+ *
+ * @param next_file next free log file number
+ * @return true header written
+ * @return false write failed
+ */
+bool write_log_index(uint16_t next_file)
+{
+	if (!open_log_index())
+	{
+		return false;
+	}
+
+	log_index_head_s head;
+	head.magic = LOG_INDEX_MAGIC;
+	head.generation = index_generation + 1;
+	head.next_file = next_file;
+	head.reserved = 0;
+	head.crc = log_index_crc(&head, sizeof(log_index_head_s));
+
+	if (!log_index_seek((head.generation & 0x01) * SD_SECTOR_SIZE) || (index_file.write((uint8_t *)&head, sizeof(log_index_head_s)) != sizeof(log_index_head_s)))
+	{
+		MYLOG("IDX", "Header write failed");
+		return false;
+	}
+	index_file.flush();
+	index_generation = head.generation;
+	log_next_file = next_file;
+	return true;
+}
+
+/**
+ * @brief Write the entry of a log file to the index.
+ * 		Entries are sector aligned, a single write never spans two sectors.
+ *
+ * @param file_num log file number
+ * @param entry row count and time span, the CRC is set here
+ * @return true entry written
+ * @return false write failed
+ */
+bool write_log_index_entry(uint16_t file_num, log_index_entry_s *entry)
+{
+	if (!open_log_index())
+	{
+		return false;
+	}
+	entry->crc = log_index_crc(entry, sizeof(log_index_entry_s));
+	if (!log_index_seek(LOG_INDEX_ENTRIES + file_num * sizeof(log_index_entry_s)) || (index_file.write((uint8_t *)entry, sizeof(log_index_entry_s)) != sizeof(log_index_entry_s)))
+	{
+		MYLOG("IDX", "Entry write failed");
+		return false;
+	}
+	index_file.flush();
+	return true;
+}
+
+/**
+ * @brief Read the entry of a log file from the index
+ *
+ * @param file_num log file number
+ * @param entry filled with row count and time span
+ * @return true entry is valid
+ * @return false no entry or entry is corrupt
+ */
+bool read_log_index_entry(uint16_t file_num, log_index_entry_s *entry)
+{
+	if (!open_log_index())
+	{
+		return false;
+	}
+	uint32_t offset = LOG_INDEX_ENTRIES + file_num * sizeof(log_index_entry_s);
+	if ((offset + sizeof(log_index_entry_s)) > index_file.size())
+	{
+		return false;
+	}
+	if (!index_file.seek(offset) || (index_file.read(entry, sizeof(log_index_entry_s)) != sizeof(log_index_entry_s)))
+	{
+		return false;
+	}
+	return entry->crc == log_index_crc(entry, sizeof(log_index_entry_s));
+}
+
+/**
+ * @brief Rebuild the index from the log files in the root directory.
+ * 		Only used if the index is missing or corrupt.
+ *
+ * @return uint16_t next free log file number
+ */
+uint16_t rebuild_log_index(void)
+{
+	uint16_t next_file = 0;
+	File dir = SD.open("/", FILE_READ);
+	if (!dir)
+	{
+		MYLOG("IDX", "Can't open root");
+		return next_file;
+	}
+
+	while (true)
+	{
+		File file = dir.openNextFile();
+		if (!file)
+		{
+			// no more files
+			break;
+		}
+		char *entry_name = file.name();
+		if (file.isDirectory() || (strstr(entry_name, "-LOG.BIN") != entry_name + 4))
+		{
+			file.close();
+			continue;
+		}
+		bool valid_file = true;
+		for (int idx = 0; idx < 4; idx++)
+		{
+			if ((entry_name[idx] < '0') || (entry_name[idx] > '9'))
+			{
+				valid_file = false;
+			}
+		}
+		if (!valid_file)
+		{
+			MYLOG("IDX", "Not a log file %s", entry_name);
+			file.close();
+			continue;
+		}
+		uint16_t file_num = (entry_name[0] - '0') * 1000 + (entry_name[1] - '0') * 100 + (entry_name[2] - '0') * 10 + (entry_name[3] - '0');
+		MYLOG("IDX", "Found logfile %s", entry_name);
+		if (file_num >= next_file)
+		{
+			next_file = file_num + 1;
+		}
+
+		// Row count from the header plus valid records committed after its
+		// last update, time span from first and last record
+		log_index_entry_s entry = {0};
+		log_header_s header;
+		log_record_s record;
+		if (read_log_header(file, &header))
+		{
+			uint32_t max_rows = (file.size() - sizeof(log_header_s)) / sizeof(log_record_s);
+			entry.rows = header.rows;
+			while ((entry.rows < max_rows) && read_log_record(file, entry.rows, &record))
+			{
+				entry.rows++;
+			}
+			if (entry.rows != 0)
+			{
+				if (read_log_record(file, 0, &record))
+				{
+					entry.first_time = record.time;
+				}
+				if (read_log_record(file, entry.rows - 1, &record))
+				{
+					entry.last_time = record.time;
+				}
+			}
+			write_log_index_entry(file_num, &entry);
+		}
+		file.close();
+	}
+	dir.close();
+	return next_file;
+}
+
+/**
+ * @brief Get the number for a new log file.
+ * 		The number is taken from the index and reserved before the file
+ * 		is created. A crash in between leaves a gap, never a duplicate.
+ *
+ * @return uint16_t number of the new log file
+ */
+uint16_t alloc_log_file(void)
+{
+	if (!read_log_index())
+	{
+		MYLOG("IDX", "No valid index, scanning root");
+		log_next_file = rebuild_log_index();
+	}
+	uint16_t file_num = log_next_file;
+	write_log_index(file_num + 1);
+	MYLOG("IDX", "New log file %d", file_num);
+	return file_num;
+}
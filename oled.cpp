@@ -259,7 +259,7 @@ void oled_power(bool on_off)
 		// Restart display saver timer if enabled
 		if (g_custom_parameters.display_saver)
 		{
-			api.system.timer.start(RAK_TIMER_2, 60000, NULL);
+			job_start(JOB_OLED_SAVER, 60000);
 		}
 	}
 	else
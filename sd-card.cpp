@@ -10,10 +10,12 @@
  */
 #include "app.h"
 #include <SD.h> //http://librarymanager/All#SD
+#include <utilities.h>
 
 /** Forward declarations */
 void dir_sd(File dir);
 void dump_sd_file(const char *path);
+void drain_log_queue(void);
 
 /** Pointer to current log file */
 File log_file;
@@ -21,8 +23,392 @@ File log_file;
 /** Flag if write or file create failed */
 volatile bool sd_card_error = false;
 
-/** Number of lines written to file */
-volatile uint16_t lines_written = 0;
+/** Flag if SD card is powered and mounted */
+bool sd_mounted = false;
+
+/** Staging buffer for log rows, committed in sector sized chunks */
+uint8_t sd_buffer[SD_BUFFER_SIZE];
+/** Number of bytes in the staging buffer */
+uint16_t sd_buffer_len = 0;
+/** Number of rows not yet flushed to the card and the header */
+uint16_t sd_buffer_rows = 0;
+/** Time the oldest not yet flushed row was added */
+time_t sd_buffer_time = 0;
+/** Number of bytes committed to the current log file */
+uint32_t sd_file_pos = 0;
+/** Pre-allocated size of the current log file */
+uint32_t sd_file_alloc = 0;
+/** Number of rows written to the header of the current log file */
+uint32_t sd_header_rows = 0;
+/** Flag if the battery is low, checked once per send cycle */
+bool sd_low_bat = false;
+
+/** Queue of records from the callbacks to the writer task */
+volatile log_record_s log_queue[LOG_QUEUE_SIZE];
+/** Next free slot, only changed by the producer */
+volatile uint8_t log_queue_head = 0;
+/** Oldest queued record, only changed by the consumer */
+volatile uint8_t log_queue_tail = 0;
+/** Number of records lost because the queue was full */
+volatile uint32_t log_queue_dropped = 0;
+
+/** Number of the current log file */
+uint16_t log_file_num = 0;
+/** Index entry of the current log file */
+log_index_entry_s log_entry = {0};
+
+/**
+ * @brief Power up and mount the SD card if not yet done.
+ * 		The card stays mounted between log entries.
+ *
+ * @return true SD card is mounted
+ * @return false SD card could not be mounted
+ */
+bool mount_sd(void)
+{
+	if (sd_mounted)
+	{
+		return true;
+	}
+
+	digitalWrite(WB_IO2, HIGH);
+	delay(50);
+
+	if (!SD.begin(WB_SPI_CS))
+	{
+		MYLOG("SD", "SD begin failed");
+		return false;
+	}
+	sd_mounted = true;
+	open_log_index();
+	return true;
+}
+
+/**
+ * @brief Flush and close the log file and unmount the SD card
+ *
+ */
+void unmount_sd(void)
+{
+	close_sd_file();
+	close_log_index();
+	if (sd_mounted)
+	{
+		SD.end();
+	}
+	sd_mounted = false;
+}
+
+/**
+ * @brief Open the current log file for writing if it is not open yet.
+ * 		The file is pre-allocated, writing continues at sd_file_pos.
+ *
+ * @return true log file is open
+ * @return false log file could not be opened
+ */
+bool open_sd_file(void)
+{
+	if (log_file)
+	{
+		return true;
+	}
+	if (!mount_sd())
+	{
+		return false;
+	}
+	log_file = SD.open((const char *)file_name, FILE_UPDATE);
+	if (!log_file)
+	{
+		MYLOG("SD", "Can't open %s", file_name);
+		return false;
+	}
+	sd_file_alloc = log_file.size();
+	return log_file.seek(sd_file_pos);
+}
+
+/**
+ * @brief Read and check the header of a log file
+ *
+ * @param file opened log file
+ * @param header filled with the header, rows limited to the file size
+ * @return true valid log file
+ * @return false not a log file or unsupported version
+ */
+bool read_log_header(File &file, log_header_s *header)
+{
+	if (!file.seek(0) || (file.read(header, sizeof(log_header_s)) != sizeof(log_header_s)))
+	{
+		return false;
+	}
+	if ((header->magic != LOG_MAGIC) || (header->version != LOG_VERSION) || (header->record_size != sizeof(log_record_s)))
+	{
+		return false;
+	}
+	uint32_t max_rows = (file.size() - sizeof(log_header_s)) / sizeof(log_record_s);
+	if (header->rows > max_rows)
+	{
+		header->rows = max_rows;
+	}
+	return true;
+}
+
+/**
+ * @brief Size of the extent a log file is pre-allocated with.
+ * 		Sized from the rotation policy, so a file is filled without
+ * 		growing its cluster chain.
+ *
+ * @return uint32_t extent size in bytes, multiple of the sector size
+ */
+uint32_t log_extent_size(void)
+{
+	uint32_t rows = (g_custom_parameters.log_max_rows != 0) ? g_custom_parameters.log_max_rows : LOG_PREALLOC_ROWS;
+	uint32_t size = sizeof(log_header_s) + rows * sizeof(log_record_s);
+	if ((g_custom_parameters.log_max_kb != 0) && (size > (g_custom_parameters.log_max_kb * 1024UL)))
+	{
+		size = g_custom_parameters.log_max_kb * 1024UL;
+	}
+	return ((size + SD_SECTOR_SIZE - 1) / SD_SECTOR_SIZE) * SD_SECTOR_SIZE;
+}
+
+/**
+ * @brief Extend the pre-allocated part of the log file with zeros
+ *
+ * @param size new allocated size
+ * @return true file extended
+ * @return false write failed, card might be full
+ */
+bool extend_sd_file(uint32_t size)
+{
+	uint8_t zeros[SD_SECTOR_SIZE];
+	memset(zeros, 0, SD_SECTOR_SIZE);
+	if (!log_file.seek(sd_file_alloc))
+	{
+		return false;
+	}
+	while (sd_file_alloc < size)
+	{
+		uint16_t len = SD_SECTOR_SIZE - (sd_file_alloc % SD_SECTOR_SIZE);
+		if (log_file.write(zeros, len) != len)
+		{
+			return false;
+		}
+		sd_file_alloc += len;
+	}
+	MYLOG("SD", "Allocated %ld bytes", sd_file_alloc);
+	log_file.flush();
+	return log_file.seek(sd_file_pos);
+}
+
+/**
+ * @brief Write the number of committed rows to the header of the log file
+ *
+ */
+void update_log_header(void)
+{
+	uint32_t rows = (sd_file_pos - sizeof(log_header_s)) / sizeof(log_record_s);
+	log_file.seek(offsetof(log_header_s, rows));
+	log_file.write((uint8_t *)&rows, sizeof(uint32_t));
+	log_file.seek(sd_file_pos);
+	sd_header_rows = rows;
+}
+
+/**
+ * @brief Number of rows committed to the current log file
+ *
+ * @return uint32_t committed rows, 0 if no log file was created yet
+ */
+uint32_t committed_rows(void)
+{
+	if (sd_file_pos < sizeof(log_header_s))
+	{
+		return 0;
+	}
+	return (sd_file_pos - sizeof(log_header_s)) / sizeof(log_record_s);
+}
+
+/**
+ * @brief Commit the staging buffer to the log file.
+ * 		Without force only complete sectors are written, the partial
+ * 		tail stays in RAM. The whole buffer is written and the file is
+ * 		flushed if forced or if the row count or age limit is reached.
+ * 		A forced flush updates the header and the index entry whenever
+ * 		rows were committed since the last header update, even if the
+ * 		buffer is empty because the rows went out on a sector boundary.
+ *
+ * @param force true = write everything and flush the file
+ * @return true buffer committed (or nothing to do)
+ * @return false write to the card failed
+ */
+bool flush_sd_file(bool force)
+{
+	if (!force)
+	{
+		force = (sd_buffer_rows >= SD_FLUSH_ROWS) || ((sd_buffer_rows != 0) && ((millis() - sd_buffer_time) >= SD_FLUSH_AGE));
+	}
+
+	// Nothing buffered and the header is up to date
+	if ((sd_buffer_len == 0) && (!force || (committed_rows() == sd_header_rows)))
+	{
+		return true;
+	}
+
+	uint16_t to_write = sd_buffer_len;
+	if (!force)
+	{
+		// Write only up to the last sector boundary of the file
+		uint16_t to_boundary = SD_SECTOR_SIZE - (sd_file_pos % SD_SECTOR_SIZE);
+		if (sd_buffer_len < to_boundary)
+		{
+			return true;
+		}
+		to_write = to_boundary + ((sd_buffer_len - to_boundary) / SD_SECTOR_SIZE) * SD_SECTOR_SIZE;
+	}
+
+	if (!open_sd_file())
+	{
+		// Card removed or broken, drop the buffered rows
+		sd_buffer_len = 0;
+		sd_buffer_rows = 0;
+		return false;
+	}
+
+	// Rotation policy without size limit, allocate the next extent
+	if (((sd_file_pos + to_write) > sd_file_alloc) && !extend_sd_file(sd_file_alloc + log_extent_size()))
+	{
+		MYLOG("SD", "Can't extend %s", file_name);
+		sd_buffer_len = 0;
+		sd_buffer_rows = 0;
+		return false;
+	}
+
+	size_t written = log_file.write(sd_buffer, to_write);
+	if (written != to_write)
+	{
+		MYLOG("SD", "Written: %d expected %d", written, to_write);
+		// Error writing to file. Card might be full?
+		sd_buffer_len = 0;
+		sd_buffer_rows = 0;
+		return false;
+	}
+	sd_file_pos += written;
+	sd_buffer_len -= to_write;
+	memmove(sd_buffer, &sd_buffer[to_write], sd_buffer_len);
+
+	if (force)
+	{
+		if (committed_rows() != sd_header_rows)
+		{
+			update_log_header();
+			log_file.flush();
+			write_log_index_entry(log_file_num, &log_entry);
+		}
+		sd_buffer_rows = 0;
+	}
+	return true;
+}
+
+/**
+ * @brief Write all buffered rows and close the log file
+ *
+ */
+void close_log_file(void)
+{
+	flush_sd_file(true);
+	if (log_file)
+	{
+		log_file.close();
+	}
+}
+
+/**
+ * @brief Write all queued and buffered rows and close the log file.
+ * 		Used before reboot and log dump.
+ *
+ */
+void close_sd_file(void)
+{
+	drain_log_queue();
+	close_log_file();
+}
+
+/**
+ * @brief Read a record of a log file and check it
+ *
+ * @param file opened log file
+ * @param row record number
+ * @param record filled with the record
+ * @return true record is valid
+ * @return false read failed, unused space or torn record
+ */
+bool read_log_record(File &file, uint32_t row, log_record_s *record)
+{
+	if (!file.seek(sizeof(log_header_s) + row * sizeof(log_record_s)) || (file.read(record, sizeof(log_record_s)) != sizeof(log_record_s)))
+	{
+		return false;
+	}
+	return log_record_valid(record);
+}
+
+/**
+ * @brief Recover the newest log file after a power loss.
+ * 		The row count in the header is only updated on a forced flush.
+ * 		Records committed after the last update are added, torn records
+ * 		at the end are dropped and overwritten by the next rows.
+ *
+ */
+void recover_sd_file(void)
+{
+	if (!read_log_index() || (log_next_file == 0))
+	{
+		return;
+	}
+
+	char name[16];
+	sprintf(name, "%04d-LOG.BIN", log_next_file - 1);
+	File file = SD.open(name, FILE_UPDATE);
+	if (!file)
+	{
+		return;
+	}
+	log_header_s header;
+	log_record_s record;
+	if (!read_log_header(file, &header))
+	{
+		file.close();
+		return;
+	}
+
+	uint32_t max_rows = (file.size() - sizeof(log_header_s)) / sizeof(log_record_s);
+	uint32_t rows = header.rows;
+	while ((rows != 0) && !read_log_record(file, rows - 1, &record))
+	{
+		rows--;
+	}
+	while ((rows < max_rows) && read_log_record(file, rows, &record))
+	{
+		rows++;
+	}
+	if (rows != header.rows)
+	{
+		MYLOG("SD", "Recovered %s, %ld rows instead of %ld", name, rows, header.rows);
+		file.seek(offsetof(log_header_s, rows));
+		file.write((uint8_t *)&rows, sizeof(uint32_t));
+		file.flush();
+
+		log_index_entry_s entry = {0};
+		entry.rows = rows;
+		if ((rows != 0) && read_log_record(file, 0, &record))
+		{
+			entry.first_time = record.time;
+		}
+		if ((rows != 0) && read_log_record(file, rows - 1, &record))
+		{
+			entry.last_time = record.time;
+		}
+		write_log_index_entry(log_next_file - 1, &entry);
+	}
+	file.close();
+}
 
 /**
  * @brief Initialize SD card
@@ -32,9 +418,6 @@ volatile uint16_t lines_written = 0;
  */
 bool init_sd(void)
 {
-	digitalWrite(WB_IO2, HIGH);
-	delay(50);
-
 #if 0
 	Sd2Card card;
 	SdVolume volume;
@@ -83,7 +466,7 @@ bool init_sd(void)
 	MYLOG("SD", "Volume size (GB): %.2f", (float)volumesize / 1024 / 1024.0);
 #endif
 
-	if (!SD.begin(WB_SPI_CS))
+	if (!mount_sd())
 	{
 		MYLOG("SD", "SD begin failed.\nMake sure you've formatted the card and it is inserted");
 		return false;
@@ -112,7 +495,10 @@ bool init_sd(void)
 	}
 #endif
 
-	SD.end();
+	// Fix the row count of the newest log file after a power loss
+	recover_sd_file();
+
+	// Keep the card mounted, log rows are buffered and committed in sectors
 	return true;
 }
 
@@ -153,158 +539,451 @@ void dir_sd(File dir)
 #endif
 
 /**
- * @brief Send content of all files to the Serial port
+ * @brief Find the first row of a log file not older than a time.
+ * 		Rows are written in time order, so a binary search is used.
  *
+ * @param file opened log file
+ * @param rows number of rows in the file
+ * @param time requested time
+ * @return uint32_t row number, rows if all rows are older
  */
-void dump_all_sd_files(void)
+uint32_t find_log_row(File &file, uint32_t rows, uint32_t time)
 {
-	SD.begin(WB_SPI_CS);
-	uint16_t file_num = 0;
-	sprintf((char *)file_name, "%04d-log.csv", file_num);
-	while (true)
+	log_record_s record;
+	uint32_t low = 0;
+	uint32_t high = rows;
+	while (low < high)
 	{
-		if (SD.exists((const char *)file_name))
+		uint32_t mid = low + (high - low) / 2;
+		if (!file.seek(sizeof(log_header_s) + mid * sizeof(log_record_s)) || (file.read(&record, sizeof(log_record_s)) != sizeof(log_record_s)))
 		{
-			// MYLOG("SD", "Content of %s:", file_name);
-			Serial.println("=====================================================");
-			Serial.printf("%s\r\n", file_name);
-			log_file = SD.open((const char *)file_name, FILE_READ); // re-open the file for reading.
-			if (log_file)
-			{
-				while (log_file.available())
-				{
-					Serial.write(log_file.read()); // read from the file until there's nothing else in it.
-					delay(5);
-				}
-				log_file.close(); // close the file.
-				Serial.println("=====================================================");
-				Serial.flush();
-			}
-			else
-			{
-				MYLOG("SD", "Failed to open file for reading."); // if the file didn't open, print an error.
-			}
-
-			file_num++;
-			sprintf((char *)file_name, "%04d-log.csv", file_num);
-			MYLOG("SD", "Look for next file %s", file_name);
+			break;
+		}
+		if (record.time < time)
+		{
+			low = mid + 1;
 		}
 		else
 		{
-			break;
+			high = mid;
 		}
 	}
-
-	SD.end();
+	return low;
 }
 
 /**
- * @brief Send the content of a file to the Serial port
+ * @brief Render a binary log file as CSV to the Serial port
  *
- * @param path Path as string
+ * @param file opened log file
+ * @param first_row first row to print
+ * @param from_time print only rows from this time on
+ * @param to_time print only rows up to this time
  */
-void dump_sd_file(const char *path)
+void print_log_file(File &file, uint32_t first_row, uint32_t from_time, uint32_t to_time)
 {
-	digitalWrite(WB_IO2, HIGH);
-	delay(50);
-	MYLOG("SD", "Reading file: %s", path);
+	log_header_s header;
+	log_record_s record;
+	char line_entry[256];
 
-	SD.begin(WB_SPI_CS);
+	if ((file.read(&header, sizeof(log_header_s)) != sizeof(log_header_s)) || (header.magic != LOG_MAGIC))
+	{
+		Serial.println("Not a log file");
+		return;
+	}
+	if ((header.version != LOG_VERSION) || (header.record_size != sizeof(log_record_s)))
+	{
+		Serial.printf("Unsupported log version %d\r\n", header.version);
+		return;
+	}
 
-	log_file = SD.open(path, FILE_READ); // re-open the file for reading.
-	if (log_file)
+	// Only the committed rows, the rest of the file is pre-allocated
+	uint32_t rows = min(header.rows, (uint32_t)((file.size() - sizeof(log_header_s)) / sizeof(log_record_s)));
+	if (from_time != 0)
 	{
-		while (log_file.available())
+		uint32_t from_row = find_log_row(file, rows, from_time);
+		if (from_row > first_row)
 		{
-			Serial.write(log_file.read()); // read from the file until there's nothing else in it.
-			delay(5);
+			first_row = from_row;
 		}
-		log_file.close(); // close the file.
 	}
-	else
+	file.seek(sizeof(log_header_s) + first_row * sizeof(log_record_s));
+
+	Serial.println(log_csv_header(header.columns));
+	for (uint32_t row = first_row; row < rows; row++)
 	{
-		MYLOG("SD", "Failed to open file for reading."); // if the file didn't open, print an error.
+		if (file.read(&record, sizeof(log_record_s)) != sizeof(log_record_s))
+		{
+			break;
+		}
+		if (!log_record_valid(&record))
+		{
+			MYLOG("SD", "Skip damaged row %ld", row);
+			continue;
+		}
+		if (record.time > to_time)
+		{
+			break;
+		}
+		log_record_to_csv(header.columns, &record, line_entry, sizeof(line_entry));
+		Serial.println(line_entry);
+		// Wait until the row is sent, the USB buffer drops data if it overflows
+		Serial.flush();
 	}
-	SD.end();
 }
 
 /**
- * @brief Erase all files on the SD card
+ * @brief Send rows of a log file as CSV to the Serial port
  *
+ * @param file_num log file number
+ * @param first_row first row to print
+ * @param from_time print only rows from this time on
+ * @param to_time print only rows up to this time
+ * @return true file was printed
+ * @return false file not found
  */
-void clear_sd_file(void)
+bool print_sd_file(uint16_t file_num, uint32_t first_row, uint32_t from_time, uint32_t to_time)
 {
-	digitalWrite(WB_IO2, HIGH);
-	delay(50);
+	char name[16];
+	sprintf(name, "%04d-LOG.BIN", file_num);
+	File file = SD.open(name, FILE_READ);
+	if (!file)
+	{
+		MYLOG("SD", "Failed to open %s", name);
+		return false;
+	}
+	Serial.println("=====================================================");
+	Serial.printf("%s\r\n", name);
+	print_log_file(file, first_row, from_time, to_time);
+	file.close();
+	Serial.println("=====================================================");
+	Serial.flush();
+	return true;
+}
 
-	// SD.begin(WB_SPI_CS);
-	// uint16_t file_num = 0;
-	// sprintf((char *)file_name, "%04d-log.csv", file_num);
-	// while (true)
-	// {
-	// 	if (SD.exists((const char *)file_name))
-	// 	{
-	// 		MYLOG("SD", "Delete %s:", file_name);
-	// 		SD.remove((const char *)file_name);
-	// 		file_num++;
-	// 		sprintf((char *)file_name, "%04d-log.csv", file_num);
-	// 		MYLOG("SD", "Next file %s", file_name);
-	// 	}
-	// 	else
-	// 	{
-	// 		break;
-	// 	}
-	// }
+/**
+ * @brief Send content of all files to the Serial port
+ *
+ */
+void dump_all_sd_files(void)
+{
+	close_sd_file();
+	if (!mount_sd())
+	{
+		return;
+	}
+	// Files are numbered 0 .. log_next_file - 1, numbers can have gaps
+	for (uint16_t file_num = 0; file_num < log_next_file; file_num++)
+	{
+		print_sd_file(file_num, 0, 0, UINT32_MAX);
+	}
+	// The card stays mounted after a dump, like after the other dump commands
+}
 
-	SD.end();
+/**
+ * @brief List the log files with size, row count and time span
+ *
+ */
+void list_sd_files(void)
+{
+	close_sd_file();
+	if (!mount_sd())
+	{
+		return;
+	}
+	char name[16];
+	log_index_entry_s entry;
+	date_time_s first;
+	date_time_s last;
+	for (uint16_t file_num = 0; file_num < log_next_file; file_num++)
+	{
+		sprintf(name, "%04d-LOG.BIN", file_num);
+		File file = SD.open(name, FILE_READ);
+		if (!file)
+		{
+			continue;
+		}
+		log_header_s header;
+		if (!read_log_header(file, &header))
+		{
+			file.close();
+			continue;
+		}
+		file.close();
+		uint32_t size = sizeof(log_header_s) + header.rows * sizeof(log_record_s);
+		if (!read_log_index_entry(file_num, &entry))
+		{
+			Serial.printf("%s;%ld;%ld\r\n", name, size, header.rows);
+			continue;
+		}
+		log_split_time(entry.first_time, &first);
+		log_split_time(entry.last_time, &last);
+		Serial.printf("%s;%ld;%ld;%04d-%02d-%02d %02d:%02d:%02d;%04d-%02d-%02d %02d:%02d:%02d\r\n", name, size, entry.rows,
+					  first.year, first.month, first.date, first.hour, first.minute, first.second,
+					  last.year, last.month, last.date, last.hour, last.minute, last.second);
+	}
+}
 
-	SD.begin(WB_SPI_CS);
+/**
+ * @brief Send one log file as CSV to the Serial port
+ *
+ * @param file_num log file number
+ * @return true file was sent
+ * @return false file not found
+ */
+bool dump_sd_file_num(uint16_t file_num)
+{
+	close_sd_file();
+	if (!mount_sd())
+	{
+		return false;
+	}
+	return print_sd_file(file_num, 0, 0, UINT32_MAX);
+}
 
-	File dir = SD.open("/", FILE_READ);
-	if (dir)
+/**
+ * @brief Send all rows between two times as CSV to the Serial port.
+ * 		Files outside of the time span are skipped by their index entry
+ * 		without opening them, inside a file the first row is found by
+ * 		a binary search.
+ *
+ * @param from_time first time, seconds since 1970
+ * @param to_time last time, seconds since 1970
+ */
+void dump_sd_time_range(uint32_t from_time, uint32_t to_time)
+{
+	close_sd_file();
+	if (!mount_sd())
 	{
-		while (true)
+		return;
+	}
+	log_index_entry_s entry;
+	for (uint16_t file_num = 0; file_num < log_next_file; file_num++)
+	{
+		if (read_log_index_entry(file_num, &entry) && ((entry.rows == 0) || (entry.last_time < from_time) || (entry.first_time > to_time)))
 		{
-			log_file = dir.openNextFile();
-			if (!log_file)
-			{
-				// no more files
-				MYLOG("SD", "No more files");
-				break;
-			}
-			if (!log_file.isDirectory())
-			{
-				char *last_file_name = log_file.name();
-				SD.remove((const char *)last_file_name);
-			}
-			log_file.close();
+			continue;
 		}
-		dir.close();
+		print_sd_file(file_num, 0, from_time, to_time);
+	}
+}
+
+/**
+ * @brief Send the last rows of the log as CSV to the Serial port
+ *
+ * @param rows number of rows
+ */
+void dump_sd_tail(uint32_t rows)
+{
+	close_sd_file();
+	if (!mount_sd())
+	{
+		return;
+	}
+
+	// Go back from the newest file until enough rows are found
+	char name[16];
+	int32_t file_num = log_next_file - 1;
+	uint32_t first_row = 0;
+	for (; file_num >= 0; file_num--)
+	{
+		sprintf(name, "%04d-LOG.BIN", file_num);
+		File file = SD.open(name, FILE_READ);
+		if (!file)
+		{
+			continue;
+		}
+		log_header_s header;
+		uint32_t file_rows = read_log_header(file, &header) ? header.rows : 0;
+		file.close();
+		if (file_rows >= rows)
+		{
+			first_row = file_rows - rows;
+			break;
+		}
+		rows -= file_rows;
+	}
+	if (file_num < 0)
+	{
+		file_num = 0;
+	}
+
+	for (; file_num < log_next_file; file_num++)
+	{
+		if (print_sd_file(file_num, first_row, 0, UINT32_MAX))
+		{
+			first_row = 0;
+		}
+	}
+}
+
+/**
+ * @brief Send the content of a file to the Serial port
+ *
+ * @param path Path as string
+ */
+void dump_sd_file(const char *path)
+{
+	MYLOG("SD", "Reading file: %s", path);
+
+	close_sd_file();
+	if (!mount_sd())
+	{
+		return;
+	}
+
+	log_file = SD.open(path, FILE_READ); // re-open the file for reading.
+	if (log_file)
+	{
+		print_log_file(log_file, 0, 0, UINT32_MAX);
+		log_file.close(); // close the file.
 	}
 	else
 	{
-		MYLOG("SD", "Can't open root");
+		MYLOG("SD", "Failed to open file for reading."); // if the file didn't open, print an error.
 	}
-	SD.end();
 }
 
 /**
- * @brief Create a new file on the SD card.
- * 		Checks available files and generates a new file name
+ * @brief Stream a part of a log file as raw frames.
+ * 		Each frame is a line "+CHUNK:<file>,<offset>,<length>,<crc32>"
+ * 		followed by <length> raw bytes. Chunks are aligned to the sectors
+ * 		of the file, so they are read from the card in one access.
  *
- * @return true File created
- * @return false File could not be created
+ * @param file_num log file number
+ * @param offset start offset in the file
+ * @param length number of bytes, 0 = up to the end of the file
+ * @return true part of the file was sent
+ * @return false file not found or read error
  */
-bool create_sd_file(void)
+bool stream_sd_file(uint16_t file_num, uint32_t offset, uint32_t length)
 {
-	digitalWrite(WB_IO2, HIGH);
-	delay(50);
+	char name[16];
+	sprintf(name, "%04d-LOG.BIN", file_num);
+	File file = SD.open(name, FILE_READ);
+	if (!file)
+	{
+		MYLOG("SD", "Can't open %s", name);
+		return false;
+	}
+
+	// Send only the committed part of the pre-allocated file
+	log_header_s header;
+	uint32_t size = file.size();
+	if (read_log_header(file, &header))
+	{
+		size = sizeof(log_header_s) + header.rows * sizeof(log_record_s);
+	}
+	if (offset > size)
+	{
+		offset = size;
+	}
+	if ((length == 0) || (length > (size - offset)))
+	{
+		length = size - offset;
+	}
+	Serial.printf("+FILE:%d,%ld\r\n", file_num, size);
+
+	uint8_t chunk[SD_DUMP_CHUNK];
+	if (!file.seek(offset))
+	{
+		file.close();
+		return false;
+	}
+	while (length != 0)
+	{
+		uint16_t len = SD_DUMP_CHUNK - (offset % SD_DUMP_CHUNK);
+		if (len > length)
+		{
+			len = length;
+		}
+		if (file.read(chunk, len) != len)
+		{
+			MYLOG("SD", "Read failed at %ld", offset);
+			break;
+		}
+		Serial.printf("+CHUNK:%d,%ld,%d,%08lX\r\n", file_num, offset, len, Crc32(chunk, len));
+		Serial.write(chunk, len);
+		// Wait until the frame is sent, the USB buffer drops data if it overflows
+		Serial.flush();
+		offset += len;
+		length -= len;
+	}
+	file.close();
+	return length == 0;
+}
+
+/**
+ * @brief Stream log files as raw frames for the log_dump.py receiver.
+ * 		Logging continues after the dump, no reboot required.
+ *
+ * @param file_num first file to send, -1 = all files
+ * @param offset start offset in the first file
+ * @param length number of bytes of the first file, 0 = up to the end.
+ * 		If a length is given only this part of the first file is sent.
+ */
+void stream_sd_files(int32_t file_num, uint32_t offset, uint32_t length)
+{
+	close_sd_file();
+	if (!mount_sd())
+	{
+		return;
+	}
+
+	if (file_num >= 0)
+	{
+		stream_sd_file(file_num, offset, length);
+	}
+	if ((file_num < 0) || (length == 0))
+	{
+		char name[16];
+		for (uint16_t next_file = file_num + 1; next_file < log_next_file; next_file++)
+		{
+			sprintf(name, "%04d-LOG.BIN", next_file);
+			if (SD.exists(name))
+			{
+				stream_sd_file(next_file, 0, 0);
+			}
+		}
+	}
+	Serial.printf("+DONE\r\n");
+}
+
+/**
+ * @brief Erase all files on the SD card
+ *
+ */
+void clear_sd_file(void)
+{
+	close_sd_file();
+
+	// SD.begin(WB_SPI_CS);
+	// uint16_t file_num = 0;
+	// sprintf((char *)file_name, "%04d-log.csv", file_num);
+	// while (true)
+	// {
+	// 	if (SD.exists((const char *)file_name))
+	// 	{
+	// 		MYLOG("SD", "Delete %s:", file_name);
+	// 		SD.remove((const char *)file_name);
+	// 		file_num++;
+	// 		sprintf((char *)file_name, "%04d-log.csv", file_num);
+	// 		MYLOG("SD", "Next file %s", file_name);
+	// 	}
+	// 	else
+	// 	{
+	// 		break;
+	// 	}
+	// }
 
-	SD.begin(WB_SPI_CS);
+	if (!mount_sd())
+	{
+		return;
+	}
+	// The index is removed with the log files
+	close_log_index();
+	log_next_file = 0;
 
 	File dir = SD.open("/", FILE_READ);
-	uint16_t file_num = 0;
-	sprintf((char *)file_name, "%04d-log.csv", file_num);
 	if (dir)
 	{
 		while (true)
@@ -313,40 +992,13 @@ bool create_sd_file(void)
 			if (!log_file)
 			{
 				// no more files
-				MYLOG("SD", "New filename = %s", file_name);
+				MYLOG("SD", "No more files");
 				break;
 			}
 			if (!log_file.isDirectory())
 			{
 				char *last_file_name = log_file.name();
-				std::string file_string = last_file_name;
-				if (file_string.find("-LOG.CSV") != string::npos)
-				{
-					bool valid_file = true;
-					for (int idx = 0; idx < 4; idx++)
-					{
-						if ((last_file_name[idx] < '0') || (last_file_name[idx] > '9'))
-						{
-							valid_file = false;
-						}
-					}
-					if (valid_file)
-					{
-						MYLOG("SD", "Found logfile %s", last_file_name);
-						last_file_name[4] = 0x00;
-						file_num = atol(last_file_name);
-						sprintf((char *)file_name, "%04d-LOG.CSV", file_num + 1);
-						MYLOG("SD", "Next file is %s", file_name);
-					}
-					else
-					{
-						MYLOG("SD", "Not a log file %s", last_file_name);
-					}
-				}
-				else
-				{
-					MYLOG("SD", "Not a log file %s", last_file_name);
-				}
+				SD.remove((const char *)last_file_name);
 			}
 			log_file.close();
 		}
@@ -356,44 +1008,56 @@ bool create_sd_file(void)
 	{
 		MYLOG("SD", "Can't open root");
 	}
+	unmount_sd();
+}
+
+/**
+ * @brief Create a new file on the SD card.
+ * 		Checks available files and generates a new file name
+ *
+ * @return true File created
+ * @return false File could not be created
+ */
+bool create_sd_file(void)
+{
+	// Commit rows of the previous file before switching
+	close_log_file();
+	if (!mount_sd())
+	{
+		sd_card_error = true;
+		return false;
+	}
+
+	// Take the next number from the index, the root directory is only scanned if the index is lost
+	log_file_num = alloc_log_file();
+	sprintf((char *)file_name, "%04d-LOG.BIN", log_file_num);
+	MYLOG("SD", "New filename = %s", file_name);
+	memset(&log_entry, 0, sizeof(log_index_entry_s));
+	sd_buffer_rows = 0;
+	sd_header_rows = 0;
 
-	log_file = SD.open((const char *)file_name, FILE_WRITE);
+	log_file = SD.open((const char *)file_name, FILE_UPDATE | O_TRUNC);
 	if (log_file)
 	{
 		MYLOG("SD", "Writing Header to %s", file_name);
-		if (g_custom_parameters.test_mode == MODE_LINKCHECK)
+		log_header_s header;
+		header.magic = LOG_MAGIC;
+		header.version = LOG_VERSION;
+		header.test_mode = g_custom_parameters.test_mode;
+		header.columns = log_columns(g_custom_parameters.test_mode, g_custom_parameters.location_on);
+		header.record_size = sizeof(log_record_s);
+		header.rows = 0;
+		memset(header.reserved, 0, sizeof(header.reserved));
+		sd_file_pos = sizeof(log_header_s);
+		sd_file_alloc = sizeof(log_header_s);
+		if ((log_file.write((uint8_t *)&header, sizeof(log_header_s)) != sizeof(log_header_s)) || !extend_sd_file(log_extent_size()))
 		{
-			if (g_custom_parameters.location_on)
-			{
-				log_file.println("\"time\";\"Mode\";\"Gw\";\"Lat\";\"Lng\";\"RX RSSI\";\"RX SNR\";\"Demod\";\"TX DR\";\"Lost\"");
-			}
-			else
-			{
-				log_file.println("\"time\";\"Mode\";\"Gw\";\"RX RSSI\";\"RX SNR\";\"Demod\";\"TX DR\";\"Lost\"");
-			}
-		}
-		else if (g_custom_parameters.test_mode == MODE_FIELDTESTER)
-		{
-			log_file.println("\"time\";\"Mode\";\"Gw\";\"Lat\";\"Lng\";\"min RSSI\";\"max RSSI\";\"RX RSSI\";\"RX SNR\";\"min Dist\";\"max Dist\";\"TX DR\";\"Lost\"");
-		}
-		else if (g_custom_parameters.test_mode == MODE_FIELDTESTER_V2)
-		{
-			log_file.println("\"time\";\"Mode\";\"Gw\";\"Lat\";\"Lng\";\"max RSSI\";\"max SNR\";\"RX RSSI\";\"RX SNR\";\"min Dist\";\"max Dist\";\"TX DR\";\"PLR\"");
-		}
-		else // P2P mode
-		{
-			if (g_custom_parameters.location_on)
-			{
-				log_file.println("\"time\";\"Mode\";\"Lat\";\"Lng\";\"RX RSSI\";\"RX SNR\"");
-			}
-			else
-			{
-				log_file.println("\"time\";\"Mode\";\"RX RSSI\";\"RX SNR\"");
-			}
+			// Error writing to file. Card might be full?
+			log_file.close();
+			sd_card_error = true;
+			return false;
 		}
-		log_file.flush();
-		log_file.close();
-		SD.end();
+		// Keep the file open for the following rows
 		sd_card_error = false;
 		return true;
 	}
@@ -402,140 +1066,260 @@ bool create_sd_file(void)
 		// Error creating file. Card might be full?
 		sd_card_error = true;
 	}
-	SD.end();
 
 	return false;
 }
 
 /**
- * @brief Write to the current log file
+ * @brief Continue the last log file after a restart.
+ * 		Row count and time span are recovered from the file header and
+ * 		the first and last record.
+ * 		A new file is needed if the rotation policy requests it or if
+ * 		the test mode or location setting changed.
  *
+ * @return true last log file is open for appending
+ * @return false a new log file has to be created
  */
-void write_sd_entry(void)
+bool resume_sd_file(void)
 {
+	if ((g_custom_parameters.log_rotate & LOG_ROTATE_BOOT) || !mount_sd())
+	{
+		return false;
+	}
+	if (!read_log_index() || (log_next_file == 0))
+	{
+		return false;
+	}
 
-	digitalWrite(WB_IO2, HIGH);
-	delay(50);
-
-	SD.begin(WB_SPI_CS);
-
-	char line_entry[512];
-	if (!SD.exists((const char *)file_name))
+	uint16_t file_num = log_next_file - 1;
+	sprintf((char *)file_name, "%04d-LOG.BIN", file_num);
+	log_file = SD.open((const char *)file_name, FILE_UPDATE);
+	if (!log_file)
 	{
-		MYLOG("SD", "Can't find %s", file_name);
+		return false;
 	}
-	else
+
+	log_header_s header;
+	log_record_s record;
+	bool valid_file = read_log_header(log_file, &header);
+	// Mode or location change requires a new file, the column set is fixed in the header
+	valid_file = valid_file && (header.test_mode == g_custom_parameters.test_mode) && (header.columns == log_columns(g_custom_parameters.test_mode, g_custom_parameters.location_on));
+	if (!valid_file)
 	{
-		MYLOG("SD", "Found %s", file_name);
+		MYLOG("SD", "Can't continue %s", file_name);
+		log_file.close();
+		return false;
 	}
 
-	log_file = SD.open((const char *)file_name, FILE_WRITE);
-	if (log_file)
+	// Records behind the committed row count are overwritten
+	uint32_t size = sizeof(log_header_s) + header.rows * sizeof(log_record_s);
+	memset(&log_entry, 0, sizeof(log_index_entry_s));
+	log_entry.rows = header.rows;
+	if (log_entry.rows != 0)
 	{
-		sd_card_error = false;
-		size_t bytes_to_write = 0;
-		if (g_custom_parameters.test_mode == MODE_LINKCHECK)
-		{
-			if (g_custom_parameters.location_on)
-			{
-				// log_file.println("\"time\";\"Mode\";\"Gw\";\"Lat\";\"Lng\";\"RX RSSI\";\"RX SNR\";\"Demod\";\"TX DR\";\"Lost\"");
-				bytes_to_write = snprintf(line_entry, 511, "%04d-%02d-%02d %02d:%02d:%02d;%d;%d;%.6f;%.6f;%d;%d;%d;%d;%d",
-										  result.year, result.month, result.day, result.hour, result.min, result.sec,
-										  result.mode, result.gw,
-										  result.lat, result.lng,
-										  result.rx_rssi,
-										  result.rx_snr,
-										  result.demod, result.tx_dr, result.lost);
-			}
-			else
-			{
-				// log_file.println("\"time\";\"Mode\";\"Gw\";\"RX RSSI\";\"RX SNR\";\"Demod\";\"TX DR\";\"Lost\"");
-				bytes_to_write = snprintf(line_entry, 511, "%04d-%02d-%02d %02d:%02d:%02d;%d;%d;%d;%d;%d;%d;%d",
-										  result.year, result.month, result.day, result.hour, result.min, result.sec,
-										  result.mode, result.gw,
-										  result.rx_rssi,
-										  result.rx_snr,
-										  result.demod, result.tx_dr, result.lost);
-			}
-		}
-		else if (g_custom_parameters.test_mode == MODE_FIELDTESTER)
-		{
-			// log_file.println("\"time\";\"Mode\";\"Gw\";\"Lat\";\"Lng\";\"min RSSI\";\"max RSSI\";\"RX RSSI\";\"RX SNR\";\"min Dist\";\"max Dist\";\"TX DR\";\"Lost\"");
-			bytes_to_write = snprintf(line_entry, 511, "%04d-%02d-%02d %02d:%02d:%02d;%d;%d;%.6f;%.6f;%d;%d;%d;%d;%d;%d;%d;%d",
-									  result.year, result.month, result.day, result.hour, result.min, result.sec,
-									  result.mode, result.gw,
-									  result.lat, result.lng,
-									  result.min_rssi, result.max_rssi, result.rx_rssi,
-									  result.rx_snr,
-									  result.min_dst, result.max_dst, result.tx_dr, result.lost);
-		}
-		else if (g_custom_parameters.test_mode == MODE_FIELDTESTER_V2)
+		if (log_file.read(&record, sizeof(log_record_s)) == sizeof(log_record_s))
 		{
-			// log_file.println("\"time\";\"Mode\";\"Gw\";\"Lat\";\"Lng\";\"max RSSI\";\"max SNR\";\"RX RSSI\";\"RX SNR\";\"min Dist\";\"max Dist\";\"TX DR\";\"PLR\"");
-			bytes_to_write = snprintf(line_entry, 511, "%04d-%02d-%02d %02d:%02d:%02d;%d;%d;%.6f;%.6f;%d;%d;%d;%d;%d;%d;%d;%.1f",
-									  result.year, result.month, result.day, result.hour, result.min, result.sec,
-									  result.mode, result.gw,
-									  result.lat, result.lng,
-									  result.max_rssi, result.max_snr, result.rx_rssi,
-									  result.rx_snr,
-									  result.min_dst, result.max_dst, result.tx_dr, (float)result.lost / 10.0f);
+			log_entry.first_time = record.time;
 		}
-		else // LoRa P2P
+		if (log_file.seek(size - sizeof(log_record_s)) && (log_file.read(&record, sizeof(log_record_s)) == sizeof(log_record_s)))
 		{
-			if (g_custom_parameters.location_on)
-			{
-				// log_file.println("\"time\";\"Mode\";\"Lat\";\"Lng\";\"RX RSSI\";\"RX SNR\"");
-				bytes_to_write = snprintf(line_entry, 511, "%04d-%02d-%02d %02d:%02d:%02d;%d;%.6f;%.6f;%d;%d",
-										  result.year, result.month, result.day, result.hour, result.min, result.sec,
-										  result.mode,
-										  result.lat, result.lng,
-										  result.rx_rssi,
-										  result.rx_snr);
-			}
-			else
-			{
-				// log_file.println("\"time\";\"Mode\";\"RX RSSI\";\"RX SNR\"");
-				bytes_to_write = snprintf(line_entry, 511, "%04d-%02d-%02d %02d:%02d:%02d;%d;%d;%d",
-										  result.year, result.month, result.day, result.hour, result.min, result.sec,
-										  result.mode,
-										  result.rx_rssi,
-										  result.rx_snr);
-			}
+			log_entry.last_time = record.time;
 		}
+	}
+	log_file_num = file_num;
+	sd_file_pos = size;
+	sd_file_alloc = log_file.size();
+	sd_buffer_rows = 0;
+	sd_header_rows = header.rows;
+	log_file.seek(sd_file_pos);
 
-		MYLOG("SD", "Writing:\r\n%s", line_entry);
-		size_t written = log_file.println(line_entry);
-		if (written != bytes_to_write + 2) // Including /r/n
-		{
-			MYLOG("SD", "Written: %d expected %d", written, bytes_to_write);
-			// Error writing to file. Card might be full?
-			sd_card_error = true;
-		}
-		else
-		{
-			sd_card_error = false;
-		}
-		log_file.flush();
+	if (((g_custom_parameters.log_max_rows != 0) && (log_entry.rows >= g_custom_parameters.log_max_rows)) || ((g_custom_parameters.log_max_kb != 0) && (size >= (g_custom_parameters.log_max_kb * 1024UL))))
+	{
+		MYLOG("SD", "%s is full", file_name);
 		log_file.close();
+		return false;
+	}
 
-		lines_written++;
+	MYLOG("SD", "Continue %s with %ld rows", file_name, log_entry.rows);
+	sd_card_error = false;
+	return true;
+}
+
+/**
+ * @brief Check the rotation policy before a record is added
+ *
+ * @param record next record
+ * @return true start a new log file for this record
+ * @return false record goes into the current log file
+ */
+bool log_rotation_due(log_record_s *record)
+{
+	if (log_entry.rows == 0)
+	{
+		return false;
 	}
-	else
+	if ((g_custom_parameters.log_max_rows != 0) && (log_entry.rows >= g_custom_parameters.log_max_rows))
 	{
-		// Error writing to file. Card might be full?
-		sd_card_error = true;
-		MYLOG("SD", "Error writing to %s", file_name);
+		MYLOG("SD", "Rotate, %ld rows", log_entry.rows);
+		return true;
+	}
+	if ((g_custom_parameters.log_max_kb != 0) && ((sd_file_pos + sd_buffer_len + sizeof(log_record_s)) > (g_custom_parameters.log_max_kb * 1024UL)))
+	{
+		MYLOG("SD", "Rotate, %ld bytes", sd_file_pos + sd_buffer_len);
+		return true;
+	}
+	if ((g_custom_parameters.log_max_minutes != 0) && ((record->time - log_entry.first_time) >= (g_custom_parameters.log_max_minutes * 60UL)))
+	{
+		MYLOG("SD", "Rotate, file time span reached");
+		return true;
 	}
+	if ((g_custom_parameters.log_rotate & LOG_ROTATE_DAY) && ((record->time / 86400) != (log_entry.last_time / 86400)))
+	{
+		MYLOG("SD", "Rotate, new day");
+		return true;
+	}
+	return false;
+}
 
-	SD.end();
+/**
+ * @brief Add a record to the current log file.
+ * 		The record is added to the staging buffer, the buffer is
+ * 		committed to the card in sectors by flush_sd_file().
+ * 		Runs only in the writer context, see sd_writer_task().
+ *
+ * @param record binary log record
+ */
+void write_sd_record(log_record_s *record)
+{
+	if (log_rotation_due(record))
+	{
+		// create_sd_file() sets sd_card_error
+		create_sd_file();
+	}
+
+	// Make room in the staging buffer
+	if ((sd_buffer_len + sizeof(log_record_s)) > SD_BUFFER_SIZE)
+	{
+		flush_sd_file(true);
+	}
+	if (sd_buffer_rows == 0)
+	{
+		sd_buffer_time = millis();
+	}
+	memcpy(&sd_buffer[sd_buffer_len], record, sizeof(log_record_s));
+	sd_buffer_len += sizeof(log_record_s);
+	sd_buffer_rows++;
 
-	if (lines_written == 300)
+	if (log_entry.rows == 0)
 	{
-		sd_card_error = create_sd_file();
-		lines_written = 0;
+		log_entry.first_time = record->time;
 	}
+	log_entry.last_time = record->time;
+	log_entry.rows++;
+
+	// On low battery commit every row, a brown-out would lose the buffered rows
+	sd_card_error = !flush_sd_file(sd_low_bat);
+}
+
+/**
+ * @brief Check the battery level for the flush policy.
+ * 		Called once per send cycle, not for every row.
+ *
+ */
+void check_sd_battery(void)
+{
+	sd_low_bat = (NRF_POWER->USBREGSTATUS != 3) && (api.system.bat.get() < SD_FLUSH_LOW_BAT);
+}
+
+/**
+ * @brief Write all queued records to the log file.
+ * 		Consumer side of the record queue.
+ *
+ */
+void drain_log_queue(void)
+{
+	while (log_queue_tail != log_queue_head)
+	{
+		uint8_t tail = log_queue_tail;
+		log_record_s record;
+		memcpy(&record, (const void *)&log_queue[tail], sizeof(log_record_s));
+		// Release the slot only after the record is copied
+		__sync_synchronize();
+		log_queue_tail = (tail + 1) & (LOG_QUEUE_SIZE - 1);
+		write_sd_record(&record);
+	}
+}
+
+/**
+ * @brief Check if the writer task has work to do
+ *
+ * @return true records are queued or rows are not yet flushed or not yet in the header
+ * @return false nothing to write
+ */
+bool log_writer_pending(void)
+{
+	return (log_queue_tail != log_queue_head) || (sd_buffer_len != 0) || (sd_buffer_rows != 0);
+}
+
+/**
+ * @brief Writer task, registered in mtmMain.
+ * 		Writes the queued records while the radio is idle and commits
+ * 		buffered rows that reached their age limit.
+ * 		The task only runs again when there is something to do, the
+ * 		tickless loop sleeps in between.
+ *
+ */
+void sd_writer_task(void)
+{
+	if (!has_sd || tx_active)
+	{
+		// Try again shortly, the queue is drained after the transmission
+		mtmMain.SetIntervalTime(sd_writer_task, SD_WRITER_RETRY);
+		return;
+	}
+	drain_log_queue();
+	flush_sd_file(false);
+
+	// Nothing left to write, sleep until write_sd_entry() notifies the task again
+	if (!log_writer_pending())
+	{
+		mtmMain.SetState(sd_writer_task, false);
+		return;
+	}
+	// Only rows waiting for their age limit are left, wake up when they are due.
+	// A new row notifies the task earlier.
+	uint32_t age = millis() - sd_buffer_time;
+	mtmMain.SetIntervalTime(sd_writer_task, age < SD_FLUSH_AGE ? SD_FLUSH_AGE - age : SD_WRITER_RETRY);
+}
+
+/**
+ * @brief Add an entry to the log.
+ * 		The result is packed into a binary record and queued, the SD
+ * 		card is written later by sd_writer_task(). This keeps slow SD
+ * 		card access out of the radio and display callbacks.
+ * 		Producer side of the record queue, the callbacks must not
+ * 		call it from more than one context.
+ *
+ */
+void write_sd_entry(void)
+{
+	uint8_t head = log_queue_head;
+	uint8_t next = (head + 1) & (LOG_QUEUE_SIZE - 1);
+	if (next == log_queue_tail)
+	{
+		log_queue_dropped++;
+		MYLOG("SD", "Log queue full, dropped %ld", log_queue_dropped);
+		return;
+	}
+	log_encode_record(&result, (log_record_s *)&log_queue[head]);
+	MYLOG("SD", "Queued record, time %ld", log_queue[head].time);
+	// Publish the slot only after the record is complete
+	__sync_synchronize();
+	log_queue_head = next;
+	// Wake up the writer task
+	mtmMain.Notify(mtmMain.Find(sd_writer_task));
 
 	ready_to_dump = true;
 
 	return;
-}
\ No newline at end of file
+}
@@ -0,0 +1,208 @@
+/**
+ * @file fw_test.h
+ * @author Bernd Giesecke (bernd@giesecke.tk)
+ * @brief Board and main loop of the firmware tests (test_fw_*).
+ * 		The firmware runs against the stand-ins in stubs/, fw_power_on()
+ * 		puts the modules on the board, setup() and fw_run() run it like
+ * 		the RUI3 core does. The firmware keeps its state in globals, so
+ * 		a test boots it once per process, fw_fresh() runs a part of a
+ * 		test in a new process, like after a reboot.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#ifndef _FW_TEST_H_
+#define _FW_TEST_H_
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "app.h"
+#include "host_test.h"
+#include <SD.h>
+#include <nRF_SSD1306Wire.h>
+#include <Melopero_RV3028.h>
+
+void setup(void);
+void loop(void);
+/** Flags of the .ino that app.h does not declare */
+extern bool has_gnss;
+extern volatile int32_t packet_lost;
+/** Rows dropped because the record queue was full, sd-card.cpp */
+extern volatile uint32_t log_queue_dropped;
+
+/** I2C address of the OLED */
+#define FW_OLED_ADDRESS 0x3C
+/** I2C address of the LIS3DH */
+#define FW_ACC_ADDRESS 0x18
+
+/** Modules on the board */
+struct fw_board_s
+{
+	bool oled;
+	bool rtc;
+	bool gnss;
+	bool acc;
+	bool sd;
+};
+
+/** Board with all modules */
+static const fw_board_s fw_full_board = {true, true, true, true, true};
+
+/**
+ * @brief Power on the board, all stand-ins start from their reset
+ * 		state. Settings can be changed and saved before setup().
+ *
+ * @param board modules on the board
+ * @param sd_dir host directory of the SD card, emptied
+ */
+static inline void fw_power_on(const fw_board_s &board, const char *sd_dir)
+{
+	host_api_reset();
+	Wire.reset();
+	Wire.present[FW_OLED_ADDRESS] = board.oled;
+	Wire.present[HOST_RTC_ADDRESS] = board.rtc;
+	Wire.present[HOST_GNSS_ADDRESS] = board.gnss;
+	Wire.present[FW_ACC_ADDRESS] = board.acc;
+	host_sd_reset(sd_dir);
+	host_sd.present = board.sd;
+	memset(&host_gnss, 0, sizeof(host_gnss));
+	memset(&host_oled, 0, sizeof(host_oled));
+	// On battery, setup() does not wait for AT+BOOT
+	NRF_POWER->USBREGSTATUS = 0;
+}
+
+/**
+ * @brief Run the main loop like the RUI3 core does
+ *
+ * @param ms time to run (ms)
+ */
+static inline void fw_run(uint32_t ms)
+{
+	uint32_t end = millis() + ms;
+	while ((int32_t)(millis() - end) < 0)
+	{
+		uint32_t now = millis();
+		loop();
+		host_radio_poll();
+		// The core needs some time for each loop
+		if (millis() == now)
+		{
+			host_advance(100);
+		}
+	}
+}
+
+/**
+ * @brief Measurement of a log row in FieldTester V2 mode, the values
+ * 		change with the row number
+ *
+ * @param row row number
+ * @param interval time between two rows (ms)
+ * @param res filled with the measurement
+ */
+static inline void fw_make_row(uint32_t row, uint32_t interval, volatile result_s *res)
+{
+	uint32_t time = HOST_UTC_START + row * (interval / 1000);
+	date_time_s date_time;
+	log_split_time(time, &date_time);
+	res->year = date_time.year;
+	res->month = date_time.month;
+	res->day = date_time.date;
+	res->hour = date_time.hour;
+	res->min = date_time.minute;
+	res->sec = date_time.second;
+	res->mode = MODE_FIELDTESTER_V2;
+	res->gw = 1 + row % 4;
+	res->lat = 144215360 + row * 100;
+	res->lng = 1210068190 - row * 100;
+	res->max_rssi = -60 - row % 50;
+	res->max_snr = 7;
+	res->rx_rssi = -90;
+	res->rx_snr = 6;
+	res->min_dst = 2;
+	res->max_dst = 8;
+	res->lost = row % 10;
+	res->tx_dr = 3;
+}
+
+/**
+ * @brief Read a host file
+ *
+ * @param path host path
+ * @param content filled with the content of the file
+ * @return true file was read
+ * @return false file not found
+ */
+static inline bool fw_read_file(const char *path, std::string &content)
+{
+	content.clear();
+	FILE *file = fopen(path, "rb");
+	if (file == NULL)
+	{
+		return false;
+	}
+	char buffer[4096];
+	size_t size;
+	while ((size = fread(buffer, 1, sizeof(buffer), file)) != 0)
+	{
+		content.append(buffer, size);
+	}
+	fclose(file);
+	return true;
+}
+
+/**
+ * @brief Create a host directory or remove all files in it
+ *
+ * @param path host path
+ */
+static inline void fw_clear_dir(const char *path)
+{
+	mkdir(path, 0755);
+	DIR *dir = opendir(path);
+	if (dir == NULL)
+	{
+		return;
+	}
+	struct dirent *entry;
+	while ((entry = readdir(dir)) != NULL)
+	{
+		if (entry->d_name[0] != '.')
+		{
+			unlink((std::string(path) + "/" + entry->d_name).c_str());
+		}
+	}
+	closedir(dir);
+}
+
+/**
+ * @brief Run a part of a test in a new process, the firmware starts
+ * 		from its reset state and the SD card directory is kept
+ *
+ * @param part test part, its failed checks are added to the test
+ */
+static inline void fw_fresh(void (*part)(void))
+{
+	fflush(stdout);
+	pid_t pid = fork();
+	if (pid == 0)
+	{
+		// Only the failed checks of this part
+		host_test_failed = 0;
+		part();
+		fflush(stdout);
+		_exit(host_test_failed > 0 ? 1 : 0);
+	}
+	int status = 0;
+	waitpid(pid, &status, 0);
+	if (!WIFEXITED(status) || (WEXITSTATUS(status) != 0))
+	{
+		fprintf(stderr, "fw_fresh: part failed\n");
+		host_test_failed++;
+	}
+}
+
+#endif // _FW_TEST_H_
@@ -0,0 +1,107 @@
+/**
+ * @file host_test.h
+ * @author Bernd Giesecke (bernd@giesecke.tk)
+ * @brief Checks and random numbers of the host tests
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#ifndef _HOST_TEST_H_
+#define _HOST_TEST_H_
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+
+/** Number of failed checks */
+static int host_test_failed = 0;
+
+/** Count and report a failed check, the test continues */
+#define CHECK(cond)                                                            \
+	do                                                                         \
+	{                                                                          \
+		if (!(cond))                                                           \
+		{                                                                      \
+			fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+			host_test_failed++;                                                \
+		}                                                                      \
+	} while (0)
+
+/** State of the random generator, fixed seed for repeatable runs */
+static uint64_t host_test_seed = 0x9E3779B97F4A7C15ULL;
+
+/**
+ * @brief Random number, xorshift64*
+ *
+ * @return uint32_t random number
+ */
+static inline uint32_t host_random(void)
+{
+	host_test_seed ^= host_test_seed >> 12;
+	host_test_seed ^= host_test_seed << 25;
+	host_test_seed ^= host_test_seed >> 27;
+	return (uint32_t)((host_test_seed * 0x2545F4914F6CDD1DULL) >> 32);
+}
+
+/**
+ * @brief Random number in a range
+ *
+ * @param low smallest value
+ * @param high largest value
+ * @return int32_t random number
+ */
+static inline int32_t host_random_range(int32_t low, int32_t high)
+{
+	return (int32_t)((uint32_t)low + host_random() % ((uint32_t)high - (uint32_t)low + 1));
+}
+
+/**
+ * @brief Number of iterations of the random tests
+ *
+ * @param argc argument count of main()
+ * @param argv arguments of main(), the first one is the number of iterations
+ * @param iterations default number of iterations
+ * @return uint32_t number of iterations
+ */
+static inline uint32_t host_test_iterations(int argc, char **argv, uint32_t iterations)
+{
+	if (argc > 1)
+	{
+		iterations = strtoul(argv[1], NULL, 10);
+	}
+	return iterations;
+}
+
+/**
+ * @brief Wall clock time for the benchmarks, the Arduino clock of the
+ * 		stubs is virtual
+ *
+ * @return uint64_t monotonic time (us)
+ */
+static inline uint64_t host_time_us(void)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+/**
+ * @brief Print the result of a test
+ *
+ * @param name test name
+ * @return int exit code of the test
+ */
+static inline int host_test_result(const char *name)
+{
+	if (host_test_failed != 0)
+	{
+		printf("%s: %d checks failed\n", name, host_test_failed);
+		return 1;
+	}
+	printf("%s: passed\n", name);
+	return 0;
+}
+
+#endif // _HOST_TEST_H_
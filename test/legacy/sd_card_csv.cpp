@@ -0,0 +1,220 @@
+/**
+ * @file sd_card_csv.cpp
+ * @author Bernd Giesecke (bernd@giesecke.tk)
+ * @brief The former CSV logger of sd-card.cpp, reference of the SD
+ * 		card tests. Taken unchanged except for the names, the result
+ * 		given as parameter and the coordinates, which are now
+ * 		deg * 1e7 integers.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include "sd_card_csv.h"
+#include <SD.h>
+#include <string>
+
+using namespace std;
+
+/** Name of current log file */
+char legacy_file_name[] = "0000-log.csv";
+
+/** Rows written to the current log file */
+static uint16_t lines_written = 0;
+
+/**
+ * @brief Create a new file on the SD card.
+ * 		Checks available files and generates a new file name
+ *
+ * @return true File created
+ * @return false File could not be created
+ */
+bool legacy_create_sd_file(void)
+{
+	digitalWrite(WB_IO2, HIGH);
+	delay(50);
+
+	SD.begin(WB_SPI_CS);
+
+	File log_file;
+	File dir = SD.open("/", FILE_READ);
+	uint16_t file_num = 0;
+	sprintf(legacy_file_name, "%04d-log.csv", file_num);
+	if (dir)
+	{
+		while (true)
+		{
+			log_file = dir.openNextFile();
+			if (!log_file)
+			{
+				// no more files
+				break;
+			}
+			if (!log_file.isDirectory())
+			{
+				char *last_file_name = log_file.name();
+				std::string file_string = last_file_name;
+				if (file_string.find("-LOG.CSV") != string::npos)
+				{
+					bool valid_file = true;
+					for (int idx = 0; idx < 4; idx++)
+					{
+						if ((last_file_name[idx] < '0') || (last_file_name[idx] > '9'))
+						{
+							valid_file = false;
+						}
+					}
+					if (valid_file)
+					{
+						last_file_name[4] = 0x00;
+						file_num = atol(last_file_name);
+						sprintf(legacy_file_name, "%04d-LOG.CSV", file_num + 1);
+					}
+				}
+			}
+			log_file.close();
+		}
+		dir.close();
+	}
+
+	log_file = SD.open(legacy_file_name, FILE_WRITE);
+	if (log_file)
+	{
+		if (g_custom_parameters.test_mode == MODE_LINKCHECK)
+		{
+			if (g_custom_parameters.location_on)
+			{
+				log_file.println("\"time\";\"Mode\";\"Gw\";\"Lat\";\"Lng\";\"RX RSSI\";\"RX SNR\";\"Demod\";\"TX DR\";\"Lost\"");
+			}
+			else
+			{
+				log_file.println("\"time\";\"Mode\";\"Gw\";\"RX RSSI\";\"RX SNR\";\"Demod\";\"TX DR\";\"Lost\"");
+			}
+		}
+		else if (g_custom_parameters.test_mode == MODE_FIELDTESTER)
+		{
+			log_file.println("\"time\";\"Mode\";\"Gw\";\"Lat\";\"Lng\";\"min RSSI\";\"max RSSI\";\"RX RSSI\";\"RX SNR\";\"min Dist\";\"max Dist\";\"TX DR\";\"Lost\"");
+		}
+		else if (g_custom_parameters.test_mode == MODE_FIELDTESTER_V2)
+		{
+			log_file.println("\"time\";\"Mode\";\"Gw\";\"Lat\";\"Lng\";\"max RSSI\";\"max SNR\";\"RX RSSI\";\"RX SNR\";\"min Dist\";\"max Dist\";\"TX DR\";\"PLR\"");
+		}
+		else // P2P mode
+		{
+			if (g_custom_parameters.location_on)
+			{
+				log_file.println("\"time\";\"Mode\";\"Lat\";\"Lng\";\"RX RSSI\";\"RX SNR\"");
+			}
+			else
+			{
+				log_file.println("\"time\";\"Mode\";\"RX RSSI\";\"RX SNR\"");
+			}
+		}
+		log_file.flush();
+		log_file.close();
+		SD.end();
+		lines_written = 0;
+		return true;
+	}
+	SD.end();
+
+	return false;
+}
+
+/**
+ * @brief Write to the current log file
+ *
+ * @param result measurement of the row
+ */
+void legacy_write_sd_entry(result_s *result)
+{
+	digitalWrite(WB_IO2, HIGH);
+	delay(50);
+
+	SD.begin(WB_SPI_CS);
+
+	char line_entry[512];
+	SD.exists(legacy_file_name);
+
+	File log_file = SD.open(legacy_file_name, FILE_WRITE);
+	if (log_file)
+	{
+		if (g_custom_parameters.test_mode == MODE_LINKCHECK)
+		{
+			if (g_custom_parameters.location_on)
+			{
+				snprintf(line_entry, 511, "%04d-%02d-%02d %02d:%02d:%02d;%d;%d;%.6f;%.6f;%d;%d;%d;%d;%d",
+						 result->year, result->month, result->day, result->hour, result->min, result->sec,
+						 result->mode, result->gw,
+						 result->lat / 10000000.0, result->lng / 10000000.0,
+						 result->rx_rssi,
+						 result->rx_snr,
+						 result->demod, result->tx_dr, result->lost);
+			}
+			else
+			{
+				snprintf(line_entry, 511, "%04d-%02d-%02d %02d:%02d:%02d;%d;%d;%d;%d;%d;%d;%d",
+						 result->year, result->month, result->day, result->hour, result->min, result->sec,
+						 result->mode, result->gw,
+						 result->rx_rssi,
+						 result->rx_snr,
+						 result->demod, result->tx_dr, result->lost);
+			}
+		}
+		else if (g_custom_parameters.test_mode == MODE_FIELDTESTER)
+		{
+			snprintf(line_entry, 511, "%04d-%02d-%02d %02d:%02d:%02d;%d;%d;%.6f;%.6f;%d;%d;%d;%d;%d;%d;%d;%d",
+					 result->year, result->month, result->day, result->hour, result->min, result->sec,
+					 result->mode, result->gw,
+					 result->lat / 10000000.0, result->lng / 10000000.0,
+					 result->min_rssi, result->max_rssi, result->rx_rssi,
+					 result->rx_snr,
+					 result->min_dst, result->max_dst, result->tx_dr, result->lost);
+		}
+		else if (g_custom_parameters.test_mode == MODE_FIELDTESTER_V2)
+		{
+			snprintf(line_entry, 511, "%04d-%02d-%02d %02d:%02d:%02d;%d;%d;%.6f;%.6f;%d;%d;%d;%d;%d;%d;%d;%.1f",
+					 result->year, result->month, result->day, result->hour, result->min, result->sec,
+					 result->mode, result->gw,
+					 result->lat / 10000000.0, result->lng / 10000000.0,
+					 result->max_rssi, result->max_snr, result->rx_rssi,
+					 result->rx_snr,
+					 result->min_dst, result->max_dst, result->tx_dr, (float)result->lost / 10.0f);
+		}
+		else // LoRa P2P
+		{
+			if (g_custom_parameters.location_on)
+			{
+				snprintf(line_entry, 511, "%04d-%02d-%02d %02d:%02d:%02d;%d;%.6f;%.6f;%d;%d",
+						 result->year, result->month, result->day, result->hour, result->min, result->sec,
+						 result->mode,
+						 result->lat / 10000000.0, result->lng / 10000000.0,
+						 result->rx_rssi,
+						 result->rx_snr);
+			}
+			else
+			{
+				snprintf(line_entry, 511, "%04d-%02d-%02d %02d:%02d:%02d;%d;%d;%d",
+						 result->year, result->month, result->day, result->hour, result->min, result->sec,
+						 result->mode,
+						 result->rx_rssi,
+						 result->rx_snr);
+			}
+		}
+
+		log_file.println(line_entry);
+		log_file.flush();
+		log_file.close();
+
+		lines_written++;
+	}
+
+	SD.end();
+
+	if (lines_written == 300)
+	{
+		legacy_create_sd_file();
+		lines_written = 0;
+	}
+}
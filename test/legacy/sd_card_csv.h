@@ -0,0 +1,25 @@
+/**
+ * @file sd_card_csv.h
+ * @author Bernd Giesecke (bernd@giesecke.tk)
+ * @brief The former CSV logger of sd-card.cpp, one open, append and
+ * 		close cycle with power up and mount of the card per row, the
+ * 		next file is found by a scan of the root directory.
+ * 		Reference of the SD card tests, built against the SD card
+ * 		stand-in.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#ifndef _SD_CARD_CSV_H_
+#define _SD_CARD_CSV_H_
+#include "app.h"
+
+/** Name of the current CSV log file */
+extern char legacy_file_name[];
+
+bool legacy_create_sd_file(void);
+void legacy_write_sd_entry(result_s *result);
+
+#endif // _SD_CARD_CSV_H_
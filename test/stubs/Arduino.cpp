@@ -0,0 +1,192 @@
+/**
+ * @file Arduino.cpp
+ * @author Bernd Giesecke (bernd@giesecke.tk)
+ * @brief Virtual clock, GPIO, interrupts and Serial of the host build
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include <Arduino.h>
+#include <stdarg.h>
+
+/** Virtual clock (us) */
+uint64_t host_clock_us = 0;
+/** Number of noInterrupts() calls without interrupts() */
+int host_irq_disabled = 0;
+/** Level of the GPIOs */
+static uint8_t host_pins[64];
+/** Interrupt handlers of the GPIOs */
+static void (*host_isr[64])(void);
+/** Interrupt mode of the GPIOs */
+static uint8_t host_isr_mode[64];
+
+NRF_GPIO_Type host_nrf_p0;
+NRF_GPIO_Type host_nrf_p1;
+NRF_POWER_Type host_nrf_power;
+
+HostSerial Serial;
+HostSerial Serial6;
+
+/**
+ * @brief Move the virtual clock forward
+ *
+ * @param us time to add (us)
+ */
+void host_advance(uint32_t us)
+{
+	host_clock_us += us;
+}
+
+uint32_t millis(void)
+{
+	return (uint32_t)(host_clock_us / 1000);
+}
+
+uint32_t micros(void)
+{
+	return (uint32_t)host_clock_us;
+}
+
+void delay(uint32_t ms)
+{
+	host_advance(ms * 1000);
+}
+
+void noInterrupts(void)
+{
+	host_irq_disabled++;
+}
+
+void interrupts(void)
+{
+	host_irq_disabled--;
+}
+
+void pinMode(uint32_t, uint32_t)
+{
+}
+
+void digitalWrite(uint32_t pin, uint32_t value)
+{
+	host_pins[pin & 0x3F] = value;
+	// Outputs are read back from the port registers like gnss_power_on() does
+	NRF_GPIO_Type *port = (pin < 32) ? NRF_P0 : NRF_P1;
+	if (value)
+	{
+		port->OUT |= 1UL << (pin & 0x1F);
+	}
+	else
+	{
+		port->OUT &= ~(1UL << (pin & 0x1F));
+	}
+}
+
+int digitalRead(uint32_t pin)
+{
+	return host_pins[pin & 0x3F];
+}
+
+void attachInterrupt(uint32_t pin, void (*handler)(void), uint32_t mode)
+{
+	host_isr[pin & 0x3F] = handler;
+	host_isr_mode[pin & 0x3F] = mode;
+}
+
+void detachInterrupt(uint32_t pin)
+{
+	host_isr[pin & 0x3F] = NULL;
+}
+
+/**
+ * @brief Drive an input from outside, calls the interrupt handler on a
+ * 		matching edge like the GPIOTE does
+ *
+ * @param pin GPIO
+ * @param value new level
+ */
+void host_set_pin(uint32_t pin, uint32_t value)
+{
+	uint8_t old_value = host_pins[pin & 0x3F];
+	host_pins[pin & 0x3F] = value;
+	void (*handler)(void) = host_isr[pin & 0x3F];
+	if ((handler == NULL) || (old_value == value))
+	{
+		return;
+	}
+	uint8_t mode = host_isr_mode[pin & 0x3F];
+	if ((mode == CHANGE) || ((mode == RISING) && value) || ((mode == FALLING) && !value))
+	{
+		handler();
+	}
+}
+
+/**
+ * @brief vsnprintf() with the int sizes of the nRF52840, long is 32 bit
+ * 		there, so "%ld" is printed as "%d"
+ *
+ * @param text buffer for the text
+ * @param size size of the buffer
+ * @param format format of the firmware
+ * @param args arguments
+ * @return int length of the text
+ */
+int host_vsnprintf(char *text, size_t size, const char *format, va_list args)
+{
+	char host_format[256];
+	size_t len = 0;
+	bool conversion = false;
+	for (const char *src = format; (*src != 0) && (len < sizeof(host_format) - 1); src++)
+	{
+		if (conversion && (*src == 'l') && (src[1] != 'l') && (src[-1] != 'l'))
+		{
+			continue;
+		}
+		if (*src == '%')
+		{
+			conversion = !conversion;
+		}
+		else if (conversion && isalpha(*src) && (*src != 'l') && (*src != 'h'))
+		{
+			conversion = false;
+		}
+		host_format[len++] = *src;
+	}
+	host_format[len] = 0;
+	return vsnprintf(text, size, host_format, args);
+}
+
+int HostSerial::printf(const char *format, ...)
+{
+	char text[512];
+	va_list args;
+	va_start(args, format);
+	int len = host_vsnprintf(text, sizeof(text), format, args);
+	va_end(args);
+	if (len < 0)
+	{
+		return len;
+	}
+	return write((const uint8_t *)text, min((size_t)len, sizeof(text) - 1));
+}
+
+size_t HostSerial::print(const char *text)
+{
+	return write((const uint8_t *)text, strlen(text));
+}
+
+size_t HostSerial::println(const char *line)
+{
+	return print(line) + print("\r\n");
+}
+
+size_t HostSerial::write(const uint8_t *buffer, size_t size)
+{
+	if (capture != NULL)
+	{
+		capture->append((const char *)buffer, size);
+		return size;
+	}
+	return fwrite(buffer, 1, size, stdout);
+}
@@ -0,0 +1,109 @@
+/**
+ * @file Arduino.h
+ * @author Bernd Giesecke (bernd@giesecke.tk)
+ * @brief Stand-in for the RUI3 Arduino core on the host.
+ * 		The clock is virtual, it only moves with host_advance(), delay()
+ * 		and api.system.sleep.cpu(). The RUI3 API and Wire are included
+ * 		like the RUI3 core does, they are only linked into the firmware
+ * 		tests (test_fw_*).
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#ifndef _HOST_ARDUINO_H_
+#define _HOST_ARDUINO_H_
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+#include <time.h>
+#include <string>
+#include <algorithm>
+
+typedef uint8_t byte;
+/** Arduino String, only what the firmware uses */
+class String : public std::string
+{
+public:
+	String(void) {}
+	String(const char *text) : std::string(text) {}
+	String(const std::string &text) : std::string(text) {}
+	void toUpperCase(void)
+	{
+		for (size_t idx = 0; idx < length(); idx++)
+		{
+			at(idx) = toupper(at(idx));
+		}
+	}
+};
+
+using std::max;
+using std::min;
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+#define CHANGE 2
+#define FALLING 3
+#define RISING 4
+
+#define WB_IO1 17
+#define WB_IO2 34
+#define WB_IO5 9
+#define WB_SPI_CS 26
+#define LED_GREEN 35
+#define LED_BLUE 36
+#define PIN_WIRE_SDA 13
+#define PIN_WIRE_SCL 14
+
+/** Virtual clock (us) */
+extern uint64_t host_clock_us;
+/** Number of noInterrupts() calls without interrupts() */
+extern int host_irq_disabled;
+
+void host_advance(uint32_t us);
+uint32_t millis(void);
+uint32_t micros(void);
+void delay(uint32_t ms);
+void noInterrupts(void);
+void interrupts(void);
+void pinMode(uint32_t pin, uint32_t mode);
+void digitalWrite(uint32_t pin, uint32_t value);
+int digitalRead(uint32_t pin);
+void attachInterrupt(uint32_t pin, void (*handler)(void), uint32_t mode);
+void detachInterrupt(uint32_t pin);
+
+void host_set_pin(uint32_t pin, uint32_t value);
+int host_vsnprintf(char *text, size_t size, const char *format, va_list args);
+
+/** Serial port, printed to stdout or collected in capture */
+class HostSerial
+{
+public:
+	/** Output is appended here instead of stdout if set */
+	String *capture = NULL;
+
+	void begin(uint32_t) {}
+	int available(void) { return 1; }
+	int printf(const char *format, ...) __attribute__((format(printf, 2, 3)));
+	size_t print(const char *text);
+	size_t println(const char *line);
+	size_t write(const uint8_t *buffer, size_t size);
+	void flush(void) {}
+};
+extern HostSerial Serial;
+extern HostSerial Serial6;
+
+#include <nrf.h>
+#include <Wire.h>
+#include <rui3_api.h>
+
+#endif // _HOST_ARDUINO_H_
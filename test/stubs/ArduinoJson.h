@@ -0,0 +1,10 @@
+/**
+ * @file ArduinoJson.h
+ * @author Bernd Giesecke (bernd@giesecke.tk)
+ * @brief Stand-in for ArduinoJson on the host, not used by the pure modules
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
@@ -0,0 +1,44 @@
+/**
+ * @file CayenneLPP.h
+ * @author Bernd Giesecke (bernd@giesecke.tk)
+ * @brief Stand-in for the CayenneLPP library on the host, the packet
+ * 		buffer that WisCayenne fills
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#ifndef _HOST_CAYENNELPP_H_
+#define _HOST_CAYENNELPP_H_
+#include <Arduino.h>
+
+#define LPP_ERROR_OK 0
+#define LPP_ERROR_OVERFLOW 1
+
+class CayenneLPP
+{
+public:
+	CayenneLPP(uint8_t size) : _maxsize(size)
+	{
+		_buffer = (uint8_t *)malloc(size);
+		reset();
+	}
+	~CayenneLPP(void) { free(_buffer); }
+	void reset(void)
+	{
+		_cursor = 0;
+		_error = LPP_ERROR_OK;
+	}
+	uint8_t getSize(void) { return _cursor; }
+	uint8_t *getBuffer(void) { return _buffer; }
+	uint8_t getError(void) { return _error; }
+
+protected:
+	uint8_t *_buffer;
+	uint8_t _maxsize;
+	uint8_t _cursor;
+	uint8_t _error;
+};
+
+#endif // _HOST_CAYENNELPP_H_
@@ -0,0 +1,14 @@
+/**
+ * @file Melopero_RV3028.cpp
+ * @author Bernd Giesecke (bernd@giesecke.tk)
+ * @brief RTC time of the host build
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include <Melopero_RV3028.h>
+
+/** UNIX time of the RTC at millis() == 0 */
+uint32_t host_rtc_base = HOST_UTC_START;
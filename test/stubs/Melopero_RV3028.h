@@ -0,0 +1,75 @@
+/**
+ * @file Melopero_RV3028.h
+ * @author Bernd Giesecke (bernd@giesecke.tk)
+ * @brief Stand-in for the RV3028 RTC library on the host.
+ * 		The RTC runs on the virtual clock, host_rtc_base is the UNIX
+ * 		time at millis() == 0.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#ifndef _HOST_RV3028_H_
+#define _HOST_RV3028_H_
+#include <Arduino.h>
+
+/** I2C address of the RTC */
+#define HOST_RTC_ADDRESS 0x52
+
+/** UNIX time of the RTC at millis() == 0 */
+extern uint32_t host_rtc_base;
+
+class Melopero_RV3028
+{
+public:
+	void initI2C(TwoWire &bus) { wire = &bus; }
+	void useEEPROM(bool) {}
+	void writeToRegister(uint8_t, uint8_t) { transfer(); }
+	void set24HourMode(void) { transfer(); }
+	uint32_t getUnixTime(void)
+	{
+		transfer();
+		return host_rtc_base + millis() / 1000;
+	}
+	uint16_t getYear(void) { return now().tm_year + 1900; }
+	uint8_t getMonth(void) { return now().tm_mon + 1; }
+	uint8_t getWeekday(void) { return now().tm_wday; }
+	uint8_t getDate(void) { return now().tm_mday; }
+	uint8_t getHour(void) { return now().tm_hour; }
+	uint8_t getMinute(void) { return now().tm_min; }
+	uint8_t getSecond(void) { return now().tm_sec; }
+	void setTime(uint16_t year, uint8_t month, uint8_t weekday, uint8_t date, uint8_t hour, uint8_t minute, uint8_t second)
+	{
+		struct tm time = {0};
+		time.tm_year = year - 1900;
+		time.tm_mon = month - 1;
+		time.tm_mday = date;
+		time.tm_hour = hour;
+		time.tm_min = minute;
+		time.tm_sec = second;
+		transfer();
+		host_rtc_base = timegm(&time) - millis() / 1000;
+	}
+
+private:
+	TwoWire *wire = NULL;
+
+	void transfer(void)
+	{
+		if (wire != NULL)
+		{
+			wire->transfer(HOST_RTC_ADDRESS);
+		}
+	}
+
+	struct tm now(void)
+	{
+		time_t seconds = getUnixTime();
+		struct tm time;
+		gmtime_r(&seconds, &time);
+		return time;
+	}
+};
+
+#endif // _HOST_RV3028_H_
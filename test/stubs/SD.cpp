@@ -0,0 +1,385 @@
+/**
+ * @file SD.cpp
+ * @author Bernd Giesecke (bernd@giesecke.tk)
+ * @brief SD card of the host build, a directory with counted sector
+ * 		writes, write latency and power cut
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include <SD.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+host_sd_s host_sd;
+SDClass SD;
+
+/** Open file or directory */
+struct host_file_s
+{
+	FILE *file;						 // Host file, NULL for a directory
+	std::string path;				 // Host path
+	char name[64];					 // Name without path
+	uint8_t mode;					 // Open mode
+	uint32_t pos;					 // Read/write position
+	uint32_t size;					 // File size
+	int64_t cache_sector;			 // Sector in the cache, -1 = none
+	bool cache_dirty;				 // Cache has to be written
+	bool dir_dirty;					 // Directory entry has to be written
+	bool fat_dirty;					 // FAT has to be written
+	std::vector<std::string> entries; // Directory entries, sorted
+	size_t next_entry;				 // Next entry for openNextFile()
+
+	~host_file_s()
+	{
+		if (file != NULL)
+		{
+			fclose(file);
+		}
+	}
+};
+
+/**
+ * @brief Start with an empty card in a directory
+ *
+ * @param root host directory, created if it does not exist
+ */
+void host_sd_reset(const char *root)
+{
+	host_sd.root = root;
+	host_sd.present = true;
+	host_sd.mounted = false;
+	host_sd.dead = false;
+	host_sd.sector_us = 0;
+	host_sd.cut_after = -1;
+	memset(&host_sd.stats, 0, sizeof(host_sd.stats));
+	mkdir(root, 0755);
+	host_sd_clear();
+}
+
+/**
+ * @brief Remove all files of the card
+ *
+ */
+void host_sd_clear(void)
+{
+	DIR *dir = opendir(host_sd.root.c_str());
+	if (dir == NULL)
+	{
+		return;
+	}
+	struct dirent *entry;
+	while ((entry = readdir(dir)) != NULL)
+	{
+		if (entry->d_name[0] != '.')
+		{
+			unlink((host_sd.root + "/" + entry->d_name).c_str());
+		}
+	}
+	closedir(dir);
+}
+
+/**
+ * @brief Host path of a card path. The card has 8.3 names, they are
+ * 		stored and listed in upper case, whatever case the path uses.
+ *
+ * @param path path on the card
+ * @return std::string host path
+ */
+static std::string host_path(const char *path)
+{
+	while (*path == '/')
+	{
+		path++;
+	}
+	std::string name = path;
+	std::transform(name.begin(), name.end(), name.begin(), ::toupper);
+	return name.empty() ? host_sd.root : host_sd.root + "/" + name;
+}
+
+/**
+ * @brief One sector write to the card
+ *
+ * @param counter data, directory or FAT counter
+ */
+static void sector_write(uint32_t *counter)
+{
+	(*counter)++;
+	host_advance(host_sd.sector_us);
+}
+
+/**
+ * @brief Write the cached sector if it was changed
+ *
+ * @param state open file
+ */
+static void write_cache(host_file_s *state)
+{
+	if (state->cache_dirty)
+	{
+		sector_write(&host_sd.stats.data_sectors);
+		state->cache_dirty = false;
+	}
+}
+
+File::operator bool(void) const
+{
+	return state && !host_sd.dead;
+}
+
+int File::read(void *buffer, size_t size)
+{
+	if (!*this || (state->file == NULL))
+	{
+		return -1;
+	}
+	host_sd.stats.reads++;
+	fseek(state->file, state->pos, SEEK_SET);
+	size_t len = fread(buffer, 1, size, state->file);
+	state->pos += len;
+	host_sd.stats.read_bytes += len;
+	return len;
+}
+
+size_t File::write(const uint8_t *buffer, size_t size)
+{
+	if (!*this || (state->file == NULL) || !(state->mode & O_WRITE))
+	{
+		return 0;
+	}
+	host_sd.stats.writes++;
+	host_sd.stats.write_bytes += size;
+	if (state->mode & O_APPEND)
+	{
+		state->pos = state->size;
+	}
+
+	// Power cut within this write, only the first bytes reach the card
+	size_t len = size;
+	if ((host_sd.cut_after >= 0) && ((int64_t)len > host_sd.cut_after))
+	{
+		len = host_sd.cut_after;
+	}
+	fseek(state->file, state->pos, SEEK_SET);
+	fwrite(buffer, 1, len, state->file);
+	fflush(state->file);
+	if (host_sd.cut_after >= 0)
+	{
+		host_sd.cut_after -= len;
+		if (len < size)
+		{
+			host_sd.dead = true;
+			return len;
+		}
+	}
+
+	// Full sectors are written directly, partial ones through the cache
+	uint32_t pos = state->pos;
+	size_t left = len;
+	while (left > 0)
+	{
+		uint32_t sector = pos / HOST_SD_SECTOR_SIZE;
+		uint32_t offset = pos % HOST_SD_SECTOR_SIZE;
+		uint32_t chunk = min(left, (size_t)(HOST_SD_SECTOR_SIZE - offset));
+		if (chunk == HOST_SD_SECTOR_SIZE)
+		{
+			if (state->cache_sector == sector)
+			{
+				state->cache_dirty = false;
+			}
+			sector_write(&host_sd.stats.data_sectors);
+		}
+		else
+		{
+			if (state->cache_sector != sector)
+			{
+				write_cache(state.get());
+				state->cache_sector = sector;
+			}
+			state->cache_dirty = true;
+		}
+		pos += chunk;
+		left -= chunk;
+	}
+
+	// Growing the file allocates clusters in the FAT
+	const uint32_t cluster = HOST_SD_CLUSTER_SECTORS * HOST_SD_SECTOR_SIZE;
+	if (pos > state->size)
+	{
+		if (((pos + cluster - 1) / cluster) > ((state->size + cluster - 1) / cluster))
+		{
+			state->fat_dirty = true;
+		}
+		state->size = pos;
+	}
+	state->pos = pos;
+	// SdFat updates the modification time with each write
+	state->dir_dirty = true;
+	return len;
+}
+
+bool File::seek(uint32_t position)
+{
+	if (!*this || (state->file == NULL) || (position > state->size))
+	{
+		return false;
+	}
+	host_sd.stats.seeks++;
+	state->pos = position;
+	return true;
+}
+
+uint32_t File::position(void)
+{
+	return state ? state->pos : 0;
+}
+
+uint32_t File::size(void)
+{
+	return state ? state->size : 0;
+}
+
+void File::flush(void)
+{
+	if (!*this || (state->file == NULL))
+	{
+		return;
+	}
+	host_sd.stats.flushes++;
+	write_cache(state.get());
+	if (state->fat_dirty)
+	{
+		sector_write(&host_sd.stats.fat_sectors);
+		state->fat_dirty = false;
+	}
+	if (state->dir_dirty)
+	{
+		sector_write(&host_sd.stats.dir_sectors);
+		state->dir_dirty = false;
+	}
+}
+
+void File::close(void)
+{
+	if (!state)
+	{
+		return;
+	}
+	flush();
+	state.reset();
+}
+
+char *File::name(void)
+{
+	return state ? state->name : NULL;
+}
+
+bool File::isDirectory(void)
+{
+	return state && (state->file == NULL);
+}
+
+File File::openNextFile(void)
+{
+	if (!*this || (state->file != NULL) || (state->next_entry >= state->entries.size()))
+	{
+		return File();
+	}
+	std::string entry = state->entries[state->next_entry++];
+	return SD.open(entry.c_str(), FILE_READ);
+}
+
+bool SDClass::begin(uint32_t)
+{
+	host_sd.mounted = host_sd.present && !host_sd.dead;
+	return host_sd.mounted;
+}
+
+void SDClass::end(void)
+{
+	host_sd.mounted = false;
+}
+
+File SDClass::open(const char *path, uint8_t mode)
+{
+	if (!host_sd.mounted || host_sd.dead)
+	{
+		return File();
+	}
+	std::shared_ptr<host_file_s> state(new host_file_s());
+	state->path = host_path(path);
+	const char *name = strrchr(path, '/');
+	snprintf(state->name, sizeof(state->name), "%s", name == NULL ? path : name + 1);
+	for (char *pos = state->name; *pos != 0; pos++)
+	{
+		*pos = toupper(*pos);
+	}
+	state->mode = mode;
+	state->cache_sector = -1;
+
+	struct stat info;
+	bool exists = stat(state->path.c_str(), &info) == 0;
+	if (exists && S_ISDIR(info.st_mode))
+	{
+		DIR *dir = opendir(state->path.c_str());
+		struct dirent *entry;
+		while ((dir != NULL) && ((entry = readdir(dir)) != NULL))
+		{
+			if (entry->d_name[0] != '.')
+			{
+				state->entries.push_back(entry->d_name);
+			}
+		}
+		if (dir != NULL)
+		{
+			closedir(dir);
+		}
+		std::sort(state->entries.begin(), state->entries.end());
+		host_sd.stats.opens++;
+		return File(state);
+	}
+
+	if (!(mode & O_WRITE))
+	{
+		state->file = exists ? fopen(state->path.c_str(), "rb") : NULL;
+	}
+	else if (exists && !(mode & O_TRUNC))
+	{
+		state->file = fopen(state->path.c_str(), "r+b");
+	}
+	else if (mode & O_CREAT)
+	{
+		state->file = fopen(state->path.c_str(), "w+b");
+		// New directory entry, or the cluster chain of the truncated file is freed
+		sector_write(exists ? &host_sd.stats.fat_sectors : &host_sd.stats.dir_sectors);
+		exists = false;
+	}
+	if (state->file == NULL)
+	{
+		return File();
+	}
+	state->size = exists ? info.st_size : 0;
+	host_sd.stats.opens++;
+	return File(state);
+}
+
+bool SDClass::exists(const char *path)
+{
+	struct stat info;
+	return host_sd.mounted && !host_sd.dead && (stat(host_path(path).c_str(), &info) == 0);
+}
+
+bool SDClass::remove(const char *path)
+{
+	if (!host_sd.mounted || host_sd.dead || (unlink(host_path(path).c_str()) != 0))
+	{
+		return false;
+	}
+	sector_write(&host_sd.stats.dir_sectors);
+	sector_write(&host_sd.stats.fat_sectors);
+	return true;
+}
@@ -0,0 +1,107 @@
+/**
+ * @file SD.h
+ * @author Bernd Giesecke (bernd@giesecke.tk)
+ * @brief Stand-in for the SD card library on the host.
+ * 		Files live in the directory host_sd.root, with upper case
+ * 		names like the 8.3 names of the card. The card is modelled
+ * 		like SdFat uses it: partial sectors go through a one sector
+ * 		cache, full sectors are written directly, the directory entry
+ * 		and the FAT are written on flush() and close(). Each sector
+ * 		write to the card is counted and takes host_sd.sector_us on the
+ * 		virtual clock. host_sd.cut_after cuts the power after that many
+ * 		more bytes reached the card, the card is dead until the test
+ * 		clears host_sd.dead.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#ifndef _HOST_SD_H_
+#define _HOST_SD_H_
+#include <Arduino.h>
+#include <memory>
+
+#define O_READ 0x01
+#define O_WRITE 0x02
+#define O_RDWR (O_READ | O_WRITE)
+#define O_APPEND 0x04
+#define O_CREAT 0x10
+#define O_TRUNC 0x40
+
+#define FILE_READ O_READ
+#define FILE_WRITE (O_RDWR | O_CREAT | O_APPEND)
+
+/** Sector size of the card */
+#define HOST_SD_SECTOR_SIZE 512
+/** Sectors per cluster of the card */
+#define HOST_SD_CLUSTER_SECTORS 64
+
+/** Access counters of the card */
+struct host_sd_stats_s
+{
+	uint32_t opens;		   // Opened files and directories
+	uint32_t writes;	   // write() calls
+	uint64_t write_bytes;  // Bytes passed to write()
+	uint32_t reads;		   // read() calls
+	uint64_t read_bytes;   // Bytes returned by read()
+	uint32_t seeks;		   // seek() calls
+	uint32_t flushes;	   // flush() calls
+	uint32_t data_sectors; // Data sector writes to the card
+	uint32_t dir_sectors;  // Directory sector writes to the card
+	uint32_t fat_sectors;  // FAT sector writes to the card
+};
+
+/** State of the card */
+struct host_sd_s
+{
+	std::string root;		// Host directory with the files
+	bool present;			// Card inserted
+	bool mounted;			// SD.begin() succeeded
+	bool dead;				// Power was cut, all accesses fail
+	uint32_t sector_us;		// Time of a sector write (us)
+	int64_t cut_after;		// Cut the power after this many bytes, -1 = never
+	host_sd_stats_s stats;
+};
+extern host_sd_s host_sd;
+
+void host_sd_reset(const char *root);
+void host_sd_clear(void);
+
+struct host_file_s;
+
+class File
+{
+public:
+	File(void) {}
+	File(std::shared_ptr<host_file_s> state) : state(state) {}
+	operator bool(void) const;
+	int read(void *buffer, size_t size);
+	size_t write(const uint8_t *buffer, size_t size);
+	size_t print(const char *text) { return write((const uint8_t *)text, strlen(text)); }
+	size_t println(const char *text) { return print(text) + print("\r\n"); }
+	bool seek(uint32_t position);
+	uint32_t position(void);
+	uint32_t size(void);
+	void flush(void);
+	void close(void);
+	char *name(void);
+	bool isDirectory(void);
+	File openNextFile(void);
+
+private:
+	std::shared_ptr<host_file_s> state;
+};
+
+class SDClass
+{
+public:
+	bool begin(uint32_t cs);
+	void end(void);
+	File open(const char *path, uint8_t mode = FILE_READ);
+	bool exists(const char *path);
+	bool remove(const char *path);
+};
+extern SDClass SD;
+
+#endif // _HOST_SD_H_
@@ -0,0 +1,104 @@
+/**
+ * @file SparkFunLIS3DH.h
+ * @author Bernd Giesecke (bernd@giesecke.tk)
+ * @brief Stand-in for the LIS3DH library on the host.
+ * 		The registers are a plain array, the acceleration is set by the
+ * 		test. Reading INT1_SRC clears the latched interrupt like the
+ * 		sensor does.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#ifndef _HOST_LIS3DH_H_
+#define _HOST_LIS3DH_H_
+#include <Arduino.h>
+
+#define I2C_MODE 0
+#define SPI_MODE 1
+
+#define LIS3DH_CTRL_REG1 0x20
+#define LIS3DH_CTRL_REG2 0x21
+#define LIS3DH_CTRL_REG3 0x22
+#define LIS3DH_CTRL_REG5 0x24
+#define LIS3DH_CTRL_REG6 0x25
+#define LIS3DH_INT1_CFG 0x30
+#define LIS3DH_INT1_SRC 0x31
+#define LIS3DH_INT1_THS 0x32
+#define LIS3DH_INT1_DURATION 0x33
+
+typedef enum
+{
+	IMU_SUCCESS = 0,
+	IMU_HW_ERROR,
+	IMU_NOT_SUPPORTED,
+	IMU_GENERIC_ERROR,
+	IMU_OUT_OF_BOUNDS,
+	IMU_ALL_ONES_WARNING
+} status_t;
+
+struct SensorSettings
+{
+	uint8_t adcEnabled;
+	uint8_t tempEnabled;
+	uint16_t accelSampleRate;
+	uint8_t accelRange;
+	uint8_t xAccelEnabled;
+	uint8_t yAccelEnabled;
+	uint8_t zAccelEnabled;
+};
+
+class LIS3DH
+{
+public:
+	SensorSettings settings;
+	/** Register file of the sensor */
+	uint8_t registers[0x40];
+	/** Acceleration (g) */
+	float accel[3];
+
+	LIS3DH(uint8_t mode, uint8_t address) : address(address)
+	{
+		memset(registers, 0, sizeof(registers));
+		memset(accel, 0, sizeof(accel));
+		accel[2] = 1.0;
+	}
+	status_t begin(void) { return Wire.transfer(address) ? IMU_SUCCESS : IMU_HW_ERROR; }
+	status_t readRegister(uint8_t *output, uint8_t offset)
+	{
+		if (!Wire.transfer(address))
+		{
+			return IMU_HW_ERROR;
+		}
+		*output = registers[offset & 0x3F];
+		if (offset == LIS3DH_INT1_SRC)
+		{
+			registers[LIS3DH_INT1_SRC] = 0;
+		}
+		return IMU_SUCCESS;
+	}
+	status_t writeRegister(uint8_t offset, uint8_t value)
+	{
+		if (!Wire.transfer(address))
+		{
+			return IMU_HW_ERROR;
+		}
+		registers[offset & 0x3F] = value;
+		return IMU_SUCCESS;
+	}
+	float readFloatAccelX(void) { return read_axis(0); }
+	float readFloatAccelY(void) { return read_axis(1); }
+	float readFloatAccelZ(void) { return read_axis(2); }
+
+private:
+	uint8_t address;
+
+	float read_axis(uint8_t axis)
+	{
+		Wire.transfer(address);
+		return accel[axis];
+	}
+};
+
+#endif // _HOST_LIS3DH_H_
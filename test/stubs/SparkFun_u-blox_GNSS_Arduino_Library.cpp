@@ -0,0 +1,360 @@
+/**
+ * @file SparkFun_u-blox_GNSS_Arduino_Library.cpp
+ * @author Bernd Giesecke (bernd@giesecke.tk)
+ * @brief GNSS module of the host build, replays solutions
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include <SparkFun_u-blox_GNSS_Arduino_Library.h>
+
+host_gnss_s host_gnss;
+
+/**
+ * @brief One I2C transaction, the module answers while it is powered
+ *
+ * @return true module answered
+ */
+bool SFE_UBLOX_GNSS::transfer(void)
+{
+	return Wire.transfer(HOST_GNSS_ADDRESS) && digitalRead(WB_IO2);
+}
+
+/**
+ * @brief Read a message from the module, one I2C transaction per chunk
+ *
+ * @param bytes size of the message
+ * @return true module answered
+ */
+bool SFE_UBLOX_GNSS::read(uint16_t bytes)
+{
+	for (uint16_t chunk = 0; chunk < bytes; chunk += HOST_GNSS_I2C_CHUNK)
+	{
+		if (!transfer())
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * @brief Current solution of the replay
+ *
+ * @return int32_t index in host_gnss.epochs, -1 before the first one
+ */
+int32_t SFE_UBLOX_GNSS::epoch(void)
+{
+	int32_t idx = -1;
+	while (((uint32_t)(idx + 1) < host_gnss.num_epochs) && (host_gnss.epochs[idx + 1].time <= millis()))
+	{
+		idx++;
+	}
+	return idx;
+}
+
+bool SFE_UBLOX_GNSS::begin(void)
+{
+	return isConnected();
+}
+
+bool SFE_UBLOX_GNSS::isConnected(void)
+{
+	return transfer();
+}
+
+size_t SFE_UBLOX_GNSS::pushAssistNowData(const uint8_t *, size_t size)
+{
+	if (!transfer())
+	{
+		return 0;
+	}
+	host_gnss.assist_bytes += size;
+	return size;
+}
+
+size_t SFE_UBLOX_GNSS::readNavigationDatabase(uint8_t *buffer, size_t max_size)
+{
+	if (!transfer())
+	{
+		return 0;
+	}
+	// A small database, the content does not matter
+	size_t size = min(max_size, (size_t)512);
+	memset(buffer, 0xB5, size);
+	return size;
+}
+
+bool SFE_UBLOX_GNSS::getPVT(void)
+{
+	if (auto_pvt)
+	{
+		// The library does not poll a message that is sent automatically
+		if (auto_implicit)
+		{
+			checkUblox();
+		}
+		return false;
+	}
+	host_gnss.polls++;
+	// Poll request, bytes available, message
+	if (!transfer() || !transfer() || !read(HOST_UBX_NAV_PVT_SIZE))
+	{
+		return false;
+	}
+	int32_t idx = epoch();
+	if (idx < 0)
+	{
+		return false;
+	}
+	pvt_packet.data = host_gnss.epochs[idx].pvt;
+	packetUBXNAVPVT = &pvt_packet;
+	pvt_queried = QUERIED_ALL;
+	return true;
+}
+
+bool SFE_UBLOX_GNSS::getDOP(void)
+{
+	host_gnss.polls++;
+	if (!transfer() || !transfer() || !read(HOST_UBX_NAV_DOP_SIZE))
+	{
+		return false;
+	}
+	int32_t idx = epoch();
+	if (idx < 0)
+	{
+		return false;
+	}
+	memset(&dop_packet, 0, sizeof(dop_packet));
+	dop_packet.data.iTOW = host_gnss.epochs[idx].pvt.iTOW;
+	dop_packet.data.hDOP = host_gnss.epochs[idx].hdop;
+	dop_packet.data.pDOP = host_gnss.epochs[idx].pvt.pDOP;
+	packetUBXNAVDOP = &dop_packet;
+	dop_queried = true;
+	return true;
+}
+
+/**
+ * @brief Get a NAV-PVT value with the staleness rule of the library:
+ * 		poll only if the value was read since the last solution
+ *
+ * @param value see host_pvt_queried_t
+ */
+void SFE_UBLOX_GNSS::query_pvt(uint8_t value)
+{
+	if ((pvt_queried & value) == 0)
+	{
+		getPVT();
+	}
+	pvt_queried &= ~value;
+}
+
+int32_t SFE_UBLOX_GNSS::getLatitude(void)
+{
+	query_pvt(QUERIED_LAT);
+	return pvt_packet.data.lat;
+}
+
+int32_t SFE_UBLOX_GNSS::getLongitude(void)
+{
+	query_pvt(QUERIED_LON);
+	return pvt_packet.data.lon;
+}
+
+int32_t SFE_UBLOX_GNSS::getAltitude(void)
+{
+	query_pvt(QUERIED_HEIGHT);
+	return pvt_packet.data.height;
+}
+
+uint8_t SFE_UBLOX_GNSS::getSIV(void)
+{
+	query_pvt(QUERIED_SIV);
+	return pvt_packet.data.numSV;
+}
+
+uint8_t SFE_UBLOX_GNSS::getFixType(void)
+{
+	query_pvt(QUERIED_FIX_TYPE);
+	return pvt_packet.data.fixType;
+}
+
+bool SFE_UBLOX_GNSS::getGnssFixOk(void)
+{
+	query_pvt(QUERIED_FIX_OK);
+	return pvt_packet.data.flags.bits.gnssFixOK;
+}
+
+uint16_t SFE_UBLOX_GNSS::getHorizontalDOP(void)
+{
+	if (!dop_queried)
+	{
+		getDOP();
+	}
+	dop_queried = false;
+	return dop_packet.data.hDOP;
+}
+
+void SFE_UBLOX_GNSS::checkUblox(void)
+{
+	host_gnss.checks++;
+	if (!auto_pvt || !transfer())
+	{
+		return;
+	}
+	int32_t idx = epoch();
+	if ((idx < 0) || (idx == auto_epoch) || !read(HOST_UBX_NAV_PVT_SIZE))
+	{
+		return;
+	}
+	auto_epoch = idx;
+	pvt_packet.data = host_gnss.epochs[idx].pvt;
+	packetUBXNAVPVT = &pvt_packet;
+	pvt_queried = QUERIED_ALL;
+	callback_pending = true;
+}
+
+void SFE_UBLOX_GNSS::checkCallbacks(void)
+{
+	if (callback_pending && (pvt_callback != NULL))
+	{
+		host_gnss.callbacks++;
+		pvt_callback(&pvt_packet.data);
+	}
+	callback_pending = false;
+}
+
+/**
+ * @brief Little endian value of a UBX payload
+ *
+ * @param payload message payload
+ * @param offset offset of the value
+ * @param size size of the value (bytes)
+ * @return uint32_t value
+ */
+static uint32_t ubx_extract(const uint8_t *payload, uint8_t offset, uint8_t size)
+{
+	uint32_t value = 0;
+	for (uint8_t idx = 0; idx < size; idx++)
+	{
+		value |= (uint32_t)payload[offset + idx] << (8 * idx);
+	}
+	return value;
+}
+
+/**
+ * @brief Fill the epochs of the replay from a UBX byte stream, like a
+ * 		log of the I2C output of the module. NAV-PVT starts an epoch,
+ * 		NAV-DOP with the same iTOW adds its HDOP, the module sends it
+ * 		before or after the NAV-PVT of its solution. Other messages and
+ * 		bytes between messages are skipped, messages with a wrong
+ * 		checksum are dropped. The fields are extracted at their
+ * 		offsets in the u-blox interface description, like the library
+ * 		does.
+ *
+ * @param stream UBX bytes
+ * @param size number of bytes
+ * @param start millis() of the first solution, the others follow by their iTOW
+ * @param epochs filled with the solutions
+ * @param max_epochs size of epochs
+ * @param errors set to the number of dropped messages, can be NULL
+ * @return uint32_t number of epochs
+ */
+uint32_t host_gnss_load_ubx(const uint8_t *stream, size_t size, uint32_t start, host_gnss_epoch_s *epochs, uint32_t max_epochs, uint32_t *errors)
+{
+	uint32_t num = 0;
+	uint32_t dropped = 0;
+	uint32_t first_itow = 0;
+	// NAV-DOP that came before its NAV-PVT
+	uint32_t dop_itow = 0xFFFFFFFF;
+	uint16_t dop_hdop = 0;
+	size_t pos = 0;
+	while (pos + 8 <= size)
+	{
+		if ((stream[pos] != 0xB5) || (stream[pos + 1] != 0x62))
+		{
+			pos++;
+			continue;
+		}
+		uint8_t msg_class = stream[pos + 2];
+		uint8_t msg_id = stream[pos + 3];
+		uint16_t length = stream[pos + 4] | (stream[pos + 5] << 8);
+		if (pos + 8 + length > size)
+		{
+			break;
+		}
+		// 8 bit Fletcher checksum over class, id, length and payload
+		uint8_t ck_a = 0;
+		uint8_t ck_b = 0;
+		for (size_t idx = pos + 2; idx < pos + 6 + length; idx++)
+		{
+			ck_a += stream[idx];
+			ck_b += ck_a;
+		}
+		if ((ck_a != stream[pos + 6 + length]) || (ck_b != stream[pos + 7 + length]))
+		{
+			// Look for the next sync in the broken message
+			dropped++;
+			pos += 2;
+			continue;
+		}
+		const uint8_t *payload = &stream[pos + 6];
+		pos += 8 + length;
+
+		if ((msg_class == 0x01) && (msg_id == 0x07) && (length == 92) && (num < max_epochs))
+		{
+			uint32_t itow = ubx_extract(payload, 0, 4);
+			if (num == 0)
+			{
+				first_itow = itow;
+			}
+			host_gnss_epoch_s *epoch = &epochs[num++];
+			memset(epoch, 0, sizeof(host_gnss_epoch_s));
+			epoch->time = start + (itow - first_itow);
+			UBX_NAV_PVT_data_t *pvt = &epoch->pvt;
+			pvt->iTOW = itow;
+			pvt->year = ubx_extract(payload, 4, 2);
+			pvt->month = payload[6];
+			pvt->day = payload[7];
+			pvt->hour = payload[8];
+			pvt->min = payload[9];
+			pvt->sec = payload[10];
+			pvt->valid.all = payload[11];
+			pvt->tAcc = ubx_extract(payload, 12, 4);
+			pvt->nano = (int32_t)ubx_extract(payload, 16, 4);
+			pvt->fixType = payload[20];
+			pvt->flags.all = payload[21];
+			pvt->flags2 = payload[22];
+			pvt->numSV = payload[23];
+			pvt->lon = (int32_t)ubx_extract(payload, 24, 4);
+			pvt->lat = (int32_t)ubx_extract(payload, 28, 4);
+			pvt->height = (int32_t)ubx_extract(payload, 32, 4);
+			pvt->hMSL = (int32_t)ubx_extract(payload, 36, 4);
+			pvt->hAcc = ubx_extract(payload, 40, 4);
+			pvt->vAcc = ubx_extract(payload, 44, 4);
+			pvt->gSpeed = (int32_t)ubx_extract(payload, 60, 4);
+			pvt->headMot = (int32_t)ubx_extract(payload, 64, 4);
+			pvt->pDOP = ubx_extract(payload, 76, 2);
+			if (dop_itow == itow)
+			{
+				epoch->hdop = dop_hdop;
+			}
+		}
+		else if ((msg_class == 0x01) && (msg_id == 0x04) && (length == 18))
+		{
+			dop_itow = ubx_extract(payload, 0, 4);
+			dop_hdop = ubx_extract(payload, 12, 2);
+			if ((num > 0) && (epochs[num - 1].pvt.iTOW == dop_itow))
+			{
+				epochs[num - 1].hdop = dop_hdop;
+			}
+		}
+	}
+	if (errors != NULL)
+	{
+		*errors = dropped;
+	}
+	return num;
+}
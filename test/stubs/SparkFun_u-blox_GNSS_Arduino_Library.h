@@ -0,0 +1,214 @@
+/**
+ * @file SparkFun_u-blox_GNSS_Arduino_Library.h
+ * @author Bernd Giesecke (bernd@giesecke.tk)
+ * @brief Stand-in for the u-blox GNSS library on the host.
+ * 		The module replays the epochs in host_gnss.epochs, an epoch is
+ * 		the solution from its time (millis()) on. The epochs can be
+ * 		filled from a UBX byte stream with host_gnss_load_ubx(). The
+ * 		module answers while WB_IO2 powers it. The I2C transactions are
+ * 		counted on Wire like the library does them: a poll writes the
+ * 		request, reads the number of bytes available and then the
+ * 		message in chunks of HOST_GNSS_I2C_CHUNK bytes, a check of the
+ * 		auto PVT reads the number of bytes and the message only if a
+ * 		new one is there. The getters poll only if their value was
+ * 		already read since the last solution, like the library does.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#ifndef _HOST_UBLOX_H_
+#define _HOST_UBLOX_H_
+#include <Arduino.h>
+
+/** I2C address of the module */
+#define HOST_GNSS_ADDRESS 0x42
+/** Bytes read from the module in one I2C transaction */
+#define HOST_GNSS_I2C_CHUNK 32
+/** UBX message sizes with sync, class, id, length and checksum */
+#define HOST_UBX_NAV_PVT_SIZE (8 + 92)
+#define HOST_UBX_NAV_DOP_SIZE (8 + 18)
+
+#define COM_TYPE_UBX 0x01
+
+typedef enum
+{
+	SFE_UBLOX_GNSS_ID_GPS = 0,
+	SFE_UBLOX_GNSS_ID_SBAS,
+	SFE_UBLOX_GNSS_ID_GALILEO,
+	SFE_UBLOX_GNSS_ID_BEIDOU,
+	SFE_UBLOX_GNSS_ID_IMES,
+	SFE_UBLOX_GNSS_ID_QZSS,
+	SFE_UBLOX_GNSS_ID_GLONASS
+} sfe_ublox_gnss_ids_e;
+
+/** NAV-PVT payload */
+typedef struct
+{
+	uint32_t iTOW;
+	uint16_t year;
+	uint8_t month;
+	uint8_t day;
+	uint8_t hour;
+	uint8_t min;
+	uint8_t sec;
+	union
+	{
+		uint8_t all;
+		struct
+		{
+			uint8_t validDate : 1;
+			uint8_t validTime : 1;
+			uint8_t fullyResolved : 1;
+			uint8_t validMag : 1;
+		} bits;
+	} valid;
+	uint32_t tAcc;
+	int32_t nano;
+	uint8_t fixType;
+	union
+	{
+		uint8_t all;
+		struct
+		{
+			uint8_t gnssFixOK : 1;
+			uint8_t diffSoln : 1;
+			uint8_t psmState : 3;
+			uint8_t headVehValid : 1;
+			uint8_t carrSoln : 2;
+		} bits;
+	} flags;
+	uint8_t flags2;
+	uint8_t numSV;
+	int32_t lon;
+	int32_t lat;
+	int32_t height;
+	int32_t hMSL;
+	uint32_t hAcc;
+	uint32_t vAcc;
+	int32_t velN;
+	int32_t velE;
+	int32_t velD;
+	int32_t gSpeed;
+	int32_t headMot;
+	uint32_t sAcc;
+	uint32_t headAcc;
+	uint16_t pDOP;
+} UBX_NAV_PVT_data_t;
+
+typedef struct
+{
+	UBX_NAV_PVT_data_t data;
+} UBX_NAV_PVT_t;
+
+/** NAV-DOP payload */
+typedef struct
+{
+	uint32_t iTOW;
+	uint16_t gDOP;
+	uint16_t pDOP;
+	uint16_t tDOP;
+	uint16_t vDOP;
+	uint16_t hDOP;
+	uint16_t nDOP;
+	uint16_t eDOP;
+} UBX_NAV_DOP_data_t;
+
+typedef struct
+{
+	UBX_NAV_DOP_data_t data;
+} UBX_NAV_DOP_t;
+
+/** One solution of the replay */
+struct host_gnss_epoch_s
+{
+	uint32_t time; // millis() from which on the module has this solution
+	UBX_NAV_PVT_data_t pvt;
+	uint16_t hdop; // Horizontal DOP * 100
+};
+
+/** Replay and counters of the module */
+struct host_gnss_s
+{
+	const host_gnss_epoch_s *epochs; // Solutions, sorted by time
+	uint32_t num_epochs;			 // Number of solutions
+	uint32_t polls;					 // NAV-PVT and NAV-DOP polls
+	uint32_t checks;				 // Checks of the auto PVT
+	uint32_t callbacks;				 // Auto PVT callbacks
+	uint32_t assist_bytes;			 // AssistNow bytes pushed
+};
+extern host_gnss_s host_gnss;
+
+uint32_t host_gnss_load_ubx(const uint8_t *stream, size_t size, uint32_t start, host_gnss_epoch_s *epochs, uint32_t max_epochs, uint32_t *errors);
+
+class SFE_UBLOX_GNSS
+{
+public:
+	UBX_NAV_PVT_t *packetUBXNAVPVT = NULL;
+	UBX_NAV_DOP_t *packetUBXNAVDOP = NULL;
+
+	bool begin(void);
+	bool isConnected(void);
+	bool setI2COutput(uint8_t) { return transfer(); }
+	bool enableGNSS(bool, sfe_ublox_gnss_ids_e) { return transfer(); }
+	bool setNavigationFrequency(uint8_t) { return transfer(); }
+	bool setMeasurementRate(uint16_t) { return transfer(); }
+	bool saveConfiguration(void) { return transfer(); }
+	bool powerOff(uint32_t) { return transfer(); }
+	bool setAutoPVT(bool enable, bool implicitUpdate)
+	{
+		auto_pvt = enable;
+		auto_implicit = implicitUpdate;
+		return transfer();
+	}
+	bool setAutoPVTcallbackPtr(void (*callback)(UBX_NAV_PVT_data_t *))
+	{
+		pvt_callback = callback;
+		return true;
+	}
+	bool setUTCTimeAssistance(uint16_t, uint8_t, uint8_t, uint8_t, uint8_t, uint8_t, uint32_t = 0, uint16_t = 0, uint32_t = 0) { return transfer(); }
+	bool setPositionAssistanceLLH(int32_t, int32_t, int32_t, uint32_t) { return transfer(); }
+	size_t pushAssistNowData(const uint8_t *, size_t size);
+	size_t readNavigationDatabase(uint8_t *buffer, size_t max_size);
+	bool getPVT(void);
+	bool getDOP(void);
+	int32_t getLatitude(void);
+	int32_t getLongitude(void);
+	int32_t getAltitude(void);
+	uint16_t getHorizontalDOP(void);
+	uint8_t getSIV(void);
+	uint8_t getFixType(void);
+	bool getGnssFixOk(void);
+	void checkUblox(void);
+	void checkCallbacks(void);
+
+private:
+	/** Values of the last solution not read by a getter yet, see host_pvt_queried_t */
+	enum host_pvt_queried_t
+	{
+		QUERIED_LAT = 0x01,
+		QUERIED_LON = 0x02,
+		QUERIED_HEIGHT = 0x04,
+		QUERIED_SIV = 0x08,
+		QUERIED_FIX_TYPE = 0x10,
+		QUERIED_FIX_OK = 0x20,
+		QUERIED_ALL = 0x3F
+	};
+	bool auto_pvt = false;
+	bool auto_implicit = false;
+	bool callback_pending = false;
+	int32_t auto_epoch = -1;
+	uint8_t pvt_queried = 0;
+	bool dop_queried = false;
+	void (*pvt_callback)(UBX_NAV_PVT_data_t *) = NULL;
+	UBX_NAV_PVT_t pvt_packet;
+	UBX_NAV_DOP_t dop_packet;
+
+	bool transfer(void);
+	bool read(uint16_t bytes);
+	int32_t epoch(void);
+	void query_pvt(uint8_t value);
+};
+
+#endif // _HOST_UBLOX_H_
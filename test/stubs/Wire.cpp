@@ -0,0 +1,13 @@
+/**
+ * @file Wire.cpp
+ * @author Bernd Giesecke (bernd@giesecke.tk)
+ * @brief I2C bus of the host build
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include <Wire.h>
+
+TwoWire Wire;
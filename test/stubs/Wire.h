@@ -0,0 +1,57 @@
+/**
+ * @file Wire.h
+ * @author Bernd Giesecke (bernd@giesecke.tk)
+ * @brief Stand-in for the I2C bus on the host.
+ * 		The device stand-ins call transfer() for each bus transaction,
+ * 		a device answers if it is marked present.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#ifndef _HOST_WIRE_H_
+#define _HOST_WIRE_H_
+#include <stdint.h>
+#include <string.h>
+
+class TwoWire
+{
+public:
+	/** Devices on the bus, by 7 bit address */
+	bool present[128];
+	/** Transactions per device */
+	uint32_t transactions[128];
+
+	TwoWire(void) { reset(); }
+	void begin(void) {}
+	void beginTransmission(uint8_t address) { tx_address = address & 0x7F; }
+	uint8_t endTransmission(void) { return transfer(tx_address) ? 0 : 2; }
+
+	/**
+	 * @brief One transaction with a device
+	 *
+	 * @param address 7 bit address
+	 * @return true device acknowledged
+	 * @return false no device at the address
+	 */
+	bool transfer(uint8_t address)
+	{
+		transactions[address & 0x7F]++;
+		return present[address & 0x7F];
+	}
+
+	/** Remove all devices and clear the counters */
+	void reset(void)
+	{
+		memset(present, 0, sizeof(present));
+		memset(transactions, 0, sizeof(transactions));
+		tx_address = 0;
+	}
+
+private:
+	uint8_t tx_address;
+};
+extern TwoWire Wire;
+
+#endif // _HOST_WIRE_H_
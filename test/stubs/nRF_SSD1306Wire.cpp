@@ -0,0 +1,91 @@
+/**
+ * @file nRF_SSD1306Wire.cpp
+ * @author Bernd Giesecke (bernd@giesecke.tk)
+ * @brief OLED framebuffer of the host build
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include <nRF_SSD1306Wire.h>
+
+host_oled_s host_oled;
+
+void SSD1306Wire::clear(void)
+{
+	memset(buffer, 0, sizeof(buffer));
+	memset(text, 0, sizeof(text));
+}
+
+void SSD1306Wire::setPixel(int16_t x, int16_t y)
+{
+	if ((x < 0) || (x >= HOST_OLED_WIDTH) || (y < 0) || (y >= HOST_OLED_HEIGHT))
+	{
+		return;
+	}
+	uint8_t *byte = &buffer[x + (y / 8) * HOST_OLED_WIDTH];
+	uint8_t bit = 1 << (y & 7);
+	switch (color)
+	{
+	case WHITE:
+		*byte |= bit;
+		break;
+	case BLACK:
+		*byte &= ~bit;
+		break;
+	case INVERSE:
+		*byte ^= bit;
+		break;
+	}
+}
+
+void SSD1306Wire::fillRect(int16_t x, int16_t y, int16_t width, int16_t height)
+{
+	for (int16_t row = y; row < y + height; row++)
+	{
+		for (int16_t col = x; col < x + width; col++)
+		{
+			setPixel(col, row);
+		}
+	}
+	// Clearing a text area removes its text
+	if (color == BLACK)
+	{
+		for (int16_t line = max(0, y / 10); line < min(HOST_OLED_LINES, (y + height + 9) / 10); line++)
+		{
+			text[line][0] = 0;
+		}
+	}
+}
+
+void SSD1306Wire::drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1)
+{
+	int16_t steps = max(abs(x1 - x0), abs(y1 - y0));
+	for (int16_t step = 0; step <= steps; step++)
+	{
+		setPixel(x0 + (steps == 0 ? 0 : (x1 - x0) * step / steps), y0 + (steps == 0 ? 0 : (y1 - y0) * step / steps));
+	}
+}
+
+void SSD1306Wire::drawString(int16_t x, int16_t y, const char *new_text)
+{
+	int16_t line = y / 10;
+	if ((line < 0) || (line >= HOST_OLED_LINES))
+	{
+		return;
+	}
+	size_t len = strlen(text[line]);
+	snprintf(&text[line][len], sizeof(text[line]) - len, "%s%s", len == 0 ? "" : " ", new_text);
+}
+
+void SSD1306Wire::display(void)
+{
+	if (!wire->transfer(address))
+	{
+		return;
+	}
+	host_oled.frames++;
+	memcpy(host_oled.pixels, buffer, sizeof(buffer));
+	memcpy(host_oled.text, text, sizeof(text));
+}
@@ -0,0 +1,85 @@
+/**
+ * @file nRF_SSD1306Wire.h
+ * @author Bernd Giesecke (bernd@giesecke.tk)
+ * @brief Stand-in for the SSD1306 OLED library on the host.
+ * 		Rectangles and lines go into a 128 x 64 framebuffer, text is
+ * 		kept as strings by line (10 pixel rows), every font character is
+ * 		6 pixel wide. display() copies the frame to host_oled.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#ifndef _HOST_SSD1306_H_
+#define _HOST_SSD1306_H_
+#include <Arduino.h>
+
+#define ArialMT_Plain_10 NULL
+#define GEOMETRY_128_64 0
+
+typedef enum
+{
+	BLACK = 0,
+	WHITE = 1,
+	INVERSE = 2
+} OLEDDISPLAY_COLOR;
+
+typedef enum
+{
+	TEXT_ALIGN_LEFT = 0,
+	TEXT_ALIGN_RIGHT = 1,
+	TEXT_ALIGN_CENTER = 2
+} OLEDDISPLAY_TEXT_ALIGNMENT;
+
+/** Width of the display in pixel */
+#define HOST_OLED_WIDTH 128
+/** Height of the display in pixel */
+#define HOST_OLED_HEIGHT 64
+/** Text lines of the display */
+#define HOST_OLED_LINES (HOST_OLED_HEIGHT / 10)
+
+/** Content of the display after the last display() */
+struct host_oled_s
+{
+	bool on;									   // Display switched on
+	uint32_t frames;							   // display() calls
+	uint8_t pixels[HOST_OLED_WIDTH * HOST_OLED_HEIGHT / 8]; // Framebuffer, one bit per pixel
+	char text[HOST_OLED_LINES][64];				   // Text by line, strings in one line are joined
+};
+extern host_oled_s host_oled;
+
+class SSD1306Wire
+{
+public:
+	SSD1306Wire(uint8_t address, int sda, int scl, int geometry, TwoWire *wire)
+		: address(address), wire(wire) {}
+	void setI2cAutoInit(bool) {}
+	bool init(void) { return wire->transfer(address); }
+	void displayOn(void) { host_oled.on = true; }
+	void displayOff(void) { host_oled.on = false; }
+	void clear(void);
+	void setBrightness(uint8_t) {}
+	void setContrast(uint8_t, uint8_t = 241, uint8_t = 64) {}
+	void flipScreenVertically(void) {}
+	void setFont(const uint8_t *) {}
+	void setColor(OLEDDISPLAY_COLOR new_color) { color = new_color; }
+	void setTextAlignment(OLEDDISPLAY_TEXT_ALIGNMENT) {}
+	void fillRect(int16_t x, int16_t y, int16_t width, int16_t height);
+	void drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1);
+	void drawString(int16_t x, int16_t y, const char *text);
+	void drawString(int16_t x, int16_t y, const String &text) { drawString(x, y, text.c_str()); }
+	uint16_t getStringWidth(const char *text, uint16_t length) { return length * 6; }
+	void display(void);
+
+private:
+	uint8_t address;
+	TwoWire *wire;
+	OLEDDISPLAY_COLOR color = WHITE;
+	uint8_t buffer[HOST_OLED_WIDTH * HOST_OLED_HEIGHT / 8];
+	char text[HOST_OLED_LINES][64];
+
+	void setPixel(int16_t x, int16_t y);
+};
+
+#endif // _HOST_SSD1306_H_
@@ -0,0 +1,36 @@
+/**
+ * @file nrf.h
+ * @author Bernd Giesecke (bernd@giesecke.tk)
+ * @brief Stand-in for the nRF52840 registers used by the firmware,
+ * 		plain variables on the host
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#ifndef _HOST_NRF_H_
+#define _HOST_NRF_H_
+#include <stdint.h>
+
+/** GPIO port, only the output register */
+typedef struct
+{
+	volatile uint32_t OUT;
+} NRF_GPIO_Type;
+
+/** POWER peripheral, only the USB regulator status */
+typedef struct
+{
+	volatile uint32_t USBREGSTATUS; // 3 = on USB power
+} NRF_POWER_Type;
+
+extern NRF_GPIO_Type host_nrf_p0;
+extern NRF_GPIO_Type host_nrf_p1;
+extern NRF_POWER_Type host_nrf_power;
+
+#define NRF_P0 (&host_nrf_p0)
+#define NRF_P1 (&host_nrf_p1)
+#define NRF_POWER (&host_nrf_power)
+
+#endif // _HOST_NRF_H_
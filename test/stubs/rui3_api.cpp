@@ -0,0 +1,555 @@
+/**
+ * @file rui3_api.cpp
+ * @author Bernd Giesecke (bernd@giesecke.tk)
+ * @brief RUI3 API of the host build, settings, flash, AT commands,
+ * 		system time and the simulated radio
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include <Arduino.h>
+#include <udrv_dfu.h>
+
+HostApi api;
+uint8_t host_flash[HOST_FLASH_SIZE];
+host_radio_s host_radio;
+
+/** Network work mode, 0 = LoRa P2P, 1 = LoRaWAN */
+static uint8_t host_nwm = 1;
+/** System time at millis() == 0 (s) */
+static uint32_t host_systime_base = 0;
+
+static void (*recv_cb)(SERVICE_LORA_RECEIVE_T *data);
+static void (*send_cb)(int32_t status);
+static void (*join_cb)(int32_t status);
+static void (*linkcheck_cb)(SERVICE_LORA_LINKCHECK_T *data);
+static void (*timereq_cb)(int32_t status);
+static void (*p2p_recv_cb)(rui_lora_p2p_recv_t data);
+static void (*p2p_send_cb)(void);
+
+/** Radio events waiting for their time */
+enum host_event_t
+{
+	EV_JOIN,
+	EV_RECV,
+	EV_SEND,
+	EV_LINKCHECK,
+	EV_TIMEREQ,
+	EV_P2P_SEND
+};
+
+struct host_event_s
+{
+	uint64_t due;  // Virtual time of the callback (us)
+	uint8_t type;  // host_event_t
+	int32_t status; // Status of send and join callbacks
+	SERVICE_LORA_RECEIVE_T rx;
+	uint8_t buffer[256];
+};
+
+/** Maximum number of pending radio events */
+#define HOST_MAX_EVENTS 16
+static host_event_s host_events[HOST_MAX_EVENTS];
+static uint8_t host_num_events = 0;
+
+/** Registered AT commands */
+struct host_at_s
+{
+	char name[16];
+	PF_handler handler;
+	unsigned int perm;
+};
+#define HOST_MAX_AT 32
+static host_at_s host_at[HOST_MAX_AT];
+static uint8_t host_num_at = 0;
+
+/**
+ * @brief Queue a radio callback
+ *
+ * @param type host_event_t
+ * @param delay_ms time until the callback (ms)
+ * @return host_event_s* queued event, NULL if the queue is full
+ */
+static host_event_s *add_event(uint8_t type, uint32_t delay_ms)
+{
+	if (host_num_events == HOST_MAX_EVENTS)
+	{
+		return NULL;
+	}
+	host_event_s *event = &host_events[host_num_events++];
+	memset(event, 0, sizeof(host_event_s));
+	event->type = type;
+	event->due = host_clock_us + (uint64_t)delay_ms * 1000;
+	return event;
+}
+
+/**
+ * @brief Reset the API, the radio and the flash to the state after
+ * 		power on, called by the firmware tests before setup()
+ *
+ */
+void host_api_reset(void)
+{
+	api = HostApi();
+	memset(host_flash, 0xFF, sizeof(host_flash));
+	memset(&host_radio, 0, sizeof(host_radio));
+	host_radio.joined = true;
+	host_radio.join_time = 5000;
+	host_radio.airtime = 1500;
+	host_radio.rssi = -80;
+	host_radio.snr = 8;
+	host_radio.gateways = 1;
+	host_radio.battery = 4.0;
+	host_radio.utc = HOST_UTC_START;
+	host_nwm = 1;
+	host_systime_base = 0;
+	recv_cb = NULL;
+	send_cb = NULL;
+	join_cb = NULL;
+	linkcheck_cb = NULL;
+	timereq_cb = NULL;
+	p2p_recv_cb = NULL;
+	p2p_send_cb = NULL;
+	host_num_events = 0;
+	host_num_at = 0;
+}
+
+/**
+ * @brief Time of the next radio callback
+ *
+ * @return uint32_t millis() of the next callback, 0xFFFFFFFF if none
+ */
+uint32_t host_radio_next(void)
+{
+	uint64_t next = UINT64_MAX;
+	for (uint8_t idx = 0; idx < host_num_events; idx++)
+	{
+		next = min(next, host_events[idx].due);
+	}
+	return next == UINT64_MAX ? 0xFFFFFFFF : (uint32_t)(next / 1000);
+}
+
+/**
+ * @brief Deliver the radio callbacks that are due, in the order they
+ * 		were queued
+ *
+ * @return uint32_t number of callbacks
+ */
+uint32_t host_radio_poll(void)
+{
+	uint32_t delivered = 0;
+	uint8_t idx = 0;
+	while (idx < host_num_events)
+	{
+		if (host_events[idx].due > host_clock_us)
+		{
+			idx++;
+			continue;
+		}
+		host_event_s event = host_events[idx];
+		memmove(&host_events[idx], &host_events[idx + 1], (host_num_events - idx - 1) * sizeof(host_event_s));
+		host_num_events--;
+		delivered++;
+		switch (event.type)
+		{
+		case EV_JOIN:
+			host_radio.joined = event.status == 0;
+			if (join_cb != NULL)
+			{
+				join_cb(event.status);
+			}
+			break;
+		case EV_RECV:
+			if (recv_cb != NULL)
+			{
+				event.rx.Buffer = event.buffer;
+				recv_cb(&event.rx);
+			}
+			break;
+		case EV_SEND:
+			if (send_cb != NULL)
+			{
+				send_cb(event.status);
+			}
+			break;
+		case EV_LINKCHECK:
+			if (linkcheck_cb != NULL)
+			{
+				SERVICE_LORA_LINKCHECK_T answer = {0};
+				answer.State = event.status;
+				answer.DemodMargin = 20;
+				answer.NbGateways = host_radio.gateways;
+				answer.Rssi = host_radio.rssi;
+				answer.Snr = host_radio.snr;
+				linkcheck_cb(&answer);
+			}
+			break;
+		case EV_TIMEREQ:
+			if (event.status == 0)
+			{
+				// The network sends GPS time, 18 leap seconds ahead of UTC
+				host_systime_base = host_radio.utc + 18;
+			}
+			if (timereq_cb != NULL)
+			{
+				timereq_cb(event.status);
+			}
+			break;
+		case EV_P2P_SEND:
+			if (p2p_send_cb != NULL)
+			{
+				p2p_send_cb();
+			}
+			break;
+		}
+		// A callback may have queued new events
+		idx = 0;
+	}
+	return delivered;
+}
+
+/**
+ * @brief Receive a LoRa P2P packet, the callback is called at once like
+ * 		from the radio interrupt
+ *
+ * @param payload packet
+ * @param length size of the packet
+ * @param rssi RSSI of the packet
+ * @param snr SNR of the packet
+ */
+void host_radio_p2p_rx(uint8_t *payload, uint16_t length, int16_t rssi, int8_t snr)
+{
+	if (!host_radio.rx_on || (host_nwm != 0) || (p2p_recv_cb == NULL))
+	{
+		return;
+	}
+	rui_lora_p2p_recv_t data = {payload, length, rssi, snr};
+	p2p_recv_cb(data);
+}
+
+/**
+ * @brief Run an AT command like the RUI3 AT parser does for
+ * 		registered commands, parameters are separated by ':' or ','
+ *
+ * @param line command, e.g. "ATC+LOGS=n,50" or "ATC+SENDINT?"
+ * @return int result of the handler, AT_COMMAND_NOT_FOUND if it is not registered
+ */
+int host_at_command(const char *line)
+{
+	if (strncmp(line, "ATC+", 4) != 0)
+	{
+		return AT_COMMAND_NOT_FOUND;
+	}
+	char cmd[128];
+	snprintf(cmd, sizeof(cmd), "%s", line);
+	char *args = strpbrk(cmd, "=?");
+	char query[] = "?";
+	stParam param = {0};
+	bool write = false;
+	if (args != NULL)
+	{
+		if (*args == '?')
+		{
+			param.argc = 1;
+			param.argv[0] = query;
+		}
+		else
+		{
+			write = true;
+			char *arg = args + 1;
+			while ((arg != NULL) && (param.argc < AT_MAX_ARGV))
+			{
+				param.argv[param.argc++] = arg;
+				arg = strpbrk(arg, ":,");
+				if (arg != NULL)
+				{
+					*arg++ = 0;
+				}
+			}
+		}
+		*args = 0;
+	}
+	for (uint8_t idx = 0; idx < host_num_at; idx++)
+	{
+		if (strcmp(&cmd[4], host_at[idx].name) == 0)
+		{
+			if (!(host_at[idx].perm & (write ? RAK_ATCMD_PERM_WRITE : RAK_ATCMD_PERM_READ)))
+			{
+				return AT_PARAM_ERROR;
+			}
+			int result = host_at[idx].handler(SERIAL_USB0, cmd, &param);
+			Serial.printf("%s\r\n", result == AT_OK ? "OK" : "AT_ERROR");
+			return result;
+		}
+	}
+	return AT_COMMAND_NOT_FOUND;
+}
+
+int atcmd_printf(const char *format, ...)
+{
+	char text[256];
+	va_list args;
+	va_start(args, format);
+	int len = host_vsnprintf(text, sizeof(text), format, args);
+	va_end(args);
+	Serial.print(text);
+	return len;
+}
+
+/**
+ * @brief Convert an AT parameter from hex ASCII to bytes
+ *
+ * @param p_str hex string
+ * @param len length of the string
+ * @param p_hex buffer for the bytes
+ * @return int 0 if the string is valid hex with an even length
+ */
+int at_check_hex_param(char *p_str, uint32_t len, uint8_t *p_hex)
+{
+	if ((len == 0) || (len % 2) != 0)
+	{
+		return -1;
+	}
+	for (uint32_t idx = 0; idx < len; idx += 2)
+	{
+		if (!isxdigit(p_str[idx]) || !isxdigit(p_str[idx + 1]))
+		{
+			return -1;
+		}
+		char byte[3] = {p_str[idx], p_str[idx + 1], 0};
+		p_hex[idx / 2] = strtoul(byte, NULL, 16);
+	}
+	return 0;
+}
+
+SysTime_t SysTimeGet(void)
+{
+	SysTime_t sys_time;
+	sys_time.Seconds = host_systime_base + millis() / 1000;
+	sys_time.SubSeconds = millis() % 1000;
+	return sys_time;
+}
+
+void SysTimeSet(SysTime_t sys_time)
+{
+	host_systime_base = sys_time.Seconds - millis() / 1000;
+}
+
+void SysTimeLocalTime(const uint32_t timestamp, struct tm *local_time)
+{
+	time_t seconds = timestamp;
+	gmtime_r(&seconds, local_time);
+}
+
+bool HostKey::get(uint8_t *buf, uint32_t len)
+{
+	memcpy(buf, value, min(len, (uint32_t)sizeof(value)));
+	return true;
+}
+
+uint32_t HostNwm::get(void)
+{
+	return host_nwm;
+}
+
+bool HostNwm::set(void)
+{
+	host_nwm = mode;
+	return true;
+}
+
+bool HostLoRaWAN::njs_t::get(void)
+{
+	return host_radio.joined;
+}
+
+bool HostLoRaWAN::join(uint8_t join_start, uint8_t, uint8_t, uint8_t)
+{
+	if ((host_nwm != 1) || (join_start == 0))
+	{
+		return false;
+	}
+	host_radio.joins++;
+	host_event_s *event = add_event(EV_JOIN, host_radio.join_time);
+	return event != NULL;
+}
+
+bool HostLoRaWAN::send(uint8_t length, uint8_t *payload, uint8_t fport, bool, uint8_t)
+{
+	if ((host_nwm != 1) || !host_radio.joined)
+	{
+		return false;
+	}
+	host_radio.uplinks++;
+	host_radio.last_port = fport;
+	host_radio.last_length = length;
+	memcpy(host_radio.last_payload, payload, length);
+
+	// RX windows first, then the TX done callback
+	SERVICE_LORA_RECEIVE_T rx = {0};
+	if ((host_radio.downlink != NULL) && host_radio.downlink(fport, payload, length, &rx))
+	{
+		host_event_s *event = add_event(EV_RECV, host_radio.airtime);
+		if (event != NULL)
+		{
+			event->rx = rx;
+			memcpy(event->buffer, rx.Buffer, min(rx.BufferSize, (uint16_t)sizeof(event->buffer)));
+		}
+	}
+	if (linkcheck.value != 0)
+	{
+		add_event(EV_LINKCHECK, host_radio.airtime);
+		if (linkcheck.value == 1)
+		{
+			linkcheck.value = 0;
+		}
+	}
+	if (timereq.value != 0)
+	{
+		add_event(EV_TIMEREQ, host_radio.airtime);
+		timereq.value = 0;
+	}
+	host_event_s *event = add_event(EV_SEND, host_radio.airtime);
+	if (event == NULL)
+	{
+		return false;
+	}
+	event->status = host_radio.status;
+	return true;
+}
+
+bool HostLoRaWAN::registerRecvCallback(void (*callback)(SERVICE_LORA_RECEIVE_T *data))
+{
+	recv_cb = callback;
+	return true;
+}
+
+bool HostLoRaWAN::registerSendCallback(void (*callback)(int32_t status))
+{
+	send_cb = callback;
+	return true;
+}
+
+bool HostLoRaWAN::registerJoinCallback(void (*callback)(int32_t status))
+{
+	join_cb = callback;
+	return true;
+}
+
+bool HostLoRaWAN::registerLinkCheckCallback(void (*callback)(SERVICE_LORA_LINKCHECK_T *data))
+{
+	linkcheck_cb = callback;
+	return true;
+}
+
+bool HostLoRaWAN::registerTimereqCallback(void (*callback)(int32_t status))
+{
+	timereq_cb = callback;
+	return true;
+}
+
+bool HostLoRa::precv(uint32_t timeout)
+{
+	host_radio.rx_on = timeout != 0;
+	return host_nwm == 0;
+}
+
+bool HostLoRa::psend(uint8_t length, uint8_t *payload, bool)
+{
+	if (host_nwm != 0)
+	{
+		return false;
+	}
+	host_radio.p2p_sends++;
+	host_radio.last_length = length;
+	memcpy(host_radio.last_payload, payload, length);
+	return add_event(EV_P2P_SEND, host_radio.airtime) != NULL;
+}
+
+bool HostLoRa::registerPRecvCallback(void (*callback)(rui_lora_p2p_recv_t data))
+{
+	p2p_recv_cb = callback;
+	return true;
+}
+
+bool HostLoRa::registerPSendCallback(void (*callback)(void))
+{
+	p2p_send_cb = callback;
+	return true;
+}
+
+bool HostSystem::atMode_t::add(char *cmd, char *, char *, PF_handler handler, unsigned int perm)
+{
+	if (host_num_at == HOST_MAX_AT)
+	{
+		return false;
+	}
+	snprintf(host_at[host_num_at].name, sizeof(host_at[host_num_at].name), "%s", cmd);
+	host_at[host_num_at].handler = handler;
+	host_at[host_num_at].perm = perm;
+	host_num_at++;
+	return true;
+}
+
+float HostSystem::bat_t::get(void)
+{
+	return host_radio.battery;
+}
+
+bool HostSystem::flash_t::get(uint32_t offset, uint8_t *buf, uint32_t len)
+{
+	if ((offset + len) > HOST_FLASH_SIZE)
+	{
+		return false;
+	}
+	memcpy(buf, &host_flash[offset], len);
+	return true;
+}
+
+bool HostSystem::flash_t::set(uint32_t offset, uint8_t *buf, uint32_t len)
+{
+	if ((offset + len) > HOST_FLASH_SIZE)
+	{
+		return false;
+	}
+	memcpy(&host_flash[offset], buf, len);
+	return true;
+}
+
+/**
+ * @brief Sleep until the time is up or a radio callback is due, the
+ * 		radio interrupt wakes up the device
+ *
+ * @param ms sleep time (ms)
+ * @return true always
+ */
+bool HostSystem::sleep_t::cpu(uint32_t ms)
+{
+	uint64_t wake = host_clock_us + (uint64_t)ms * 1000;
+	for (uint8_t idx = 0; idx < host_num_events; idx++)
+	{
+		wake = min(wake, max(host_events[idx].due, host_clock_us));
+	}
+	uint64_t slept_us = wake - host_clock_us;
+	host_radio.sleeps++;
+	host_radio.sleep_us += slept_us;
+	host_clock_us = wake;
+	if (host_radio.on_sleep != NULL)
+	{
+		host_radio.on_sleep(ms, slept_us);
+	}
+	host_radio_poll();
+	return true;
+}
+
+void HostSystem::reboot(void)
+{
+	host_radio.reboots++;
+}
+
+void udrv_enter_dfu(void)
+{
+	host_radio.reboots++;
+}
@@ -0,0 +1,321 @@
+/**
+ * @file rui3_api.h
+ * @author Bernd Giesecke (bernd@giesecke.tk)
+ * @brief Stand-in for the RUI3 API on the host.
+ * 		The api object keeps the settings in variables, the flash is a
+ * 		RAM array and the radio is simulated: uplinks are recorded and
+ * 		their callbacks come after host_radio.airtime, a downlink can be
+ * 		added by host_radio.downlink. Callbacks are delivered by
+ * 		api.system.sleep.cpu() and host_radio_poll(), like the radio
+ * 		interrupt wakes up the device.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#ifndef _HOST_RUI3_API_H_
+#define _HOST_RUI3_API_H_
+#include <stdint.h>
+#include <time.h>
+#include <string>
+
+// AT command results
+#define AT_OK 0
+#define AT_ERROR 1
+#define AT_PARAM_ERROR 2
+#define AT_BUSY_ERROR 3
+#define AT_TEST_PARAM_OVERFLOW 4
+#define AT_NO_NETWORK_JOINED 5
+#define AT_RX_ERROR 6
+#define AT_MODE_NO_SUPPORT 7
+#define AT_COMMAND_NOT_FOUND 8
+
+#define RAK_ATCMD_PERM_READ 0x01
+#define RAK_ATCMD_PERM_WRITE 0x02
+
+/** Maximum number of AT command parameters */
+#define AT_MAX_ARGV 8
+
+typedef enum
+{
+	SERIAL_USB0 = 0,
+	SERIAL_UART0,
+	SERIAL_UART1,
+	SERIAL_UART2
+} SERIAL_PORT;
+
+/** Parameters of an AT command, separated by ':' or ',' */
+typedef struct
+{
+	uint32_t argc;
+	char *argv[AT_MAX_ARGV];
+} stParam;
+
+typedef int (*PF_handler)(SERIAL_PORT port, char *cmd, stParam *param);
+
+int atcmd_printf(const char *format, ...) __attribute__((format(printf, 1, 2)));
+int at_check_hex_param(char *p_str, uint32_t len, uint8_t *p_hex);
+
+typedef enum
+{
+	RAK_LORAMAC_STATUS_OK = 0,
+	RAK_LORAMAC_STATUS_ERROR,
+	RAK_LORAMAC_STATUS_TX_TIMEOUT,
+	RAK_LORAMAC_STATUS_RX1_TIMEOUT,
+	RAK_LORAMAC_STATUS_RX2_TIMEOUT,
+	RAK_LORAMAC_STATUS_RX1_ERROR,
+	RAK_LORAMAC_STATUS_RX2_ERROR,
+	RAK_LORAMAC_STATUS_JOIN_FAIL,
+	RAK_LORAMAC_STATUS_DOWNLINK_REPEATED,
+	RAK_LORAMAC_STATUS_TX_DR_PAYLOAD_SIZE_ERROR,
+	RAK_LORAMAC_STATUS_DOWNLINK_TOO_MANY_FRAMES_LOSS,
+	RAK_LORAMAC_STATUS_ADDRESS_FAIL,
+	RAK_LORAMAC_STATUS_MIC_FAIL,
+	RAK_LORAMAC_STATUS_MULTICAST_FAIL,
+	RAK_LORAMAC_STATUS_BEACON_LOCKED,
+	RAK_LORAMAC_STATUS_BEACON_LOST,
+	RAK_LORAMAC_STATUS_BEACON_NOT_FOUND
+} RAK_LORAMAC_STATUS;
+
+/** LoRaWAN downlink */
+typedef struct
+{
+	uint8_t Port;
+	uint8_t RxDatarate;
+	uint8_t *Buffer;
+	uint16_t BufferSize;
+	int16_t Rssi;
+	int8_t Snr;
+	uint32_t DownLinkCounter;
+} SERVICE_LORA_RECEIVE_T;
+
+/** LoRaWAN LinkCheck answer */
+typedef struct
+{
+	uint8_t State;
+	uint8_t DemodMargin;
+	uint8_t NbGateways;
+	int16_t Rssi;
+	int8_t Snr;
+} SERVICE_LORA_LINKCHECK_T;
+
+/** LoRa P2P packet */
+typedef struct
+{
+	uint8_t *Buffer;
+	uint16_t BufferSize;
+	int16_t Rssi;
+	int8_t Snr;
+} rui_lora_p2p_recv_t;
+
+typedef struct
+{
+	uint32_t Seconds;
+	int16_t SubSeconds;
+} SysTime_t;
+
+SysTime_t SysTimeGet(void);
+void SysTimeSet(SysTime_t sys_time);
+void SysTimeLocalTime(const uint32_t timestamp, struct tm *local_time);
+
+/** Get/set of one setting */
+template <typename T>
+class HostParam
+{
+public:
+	T value;
+	HostParam(T init = 0) : value(init) {}
+	T get(void) { return value; }
+	bool set(T new_value)
+	{
+		value = new_value;
+		return true;
+	}
+};
+
+/** Key or address, get() copies it */
+class HostKey
+{
+public:
+	uint8_t value[16] = {0};
+	bool get(uint8_t *buf, uint32_t len);
+};
+
+/** Network work mode, shared by api.lora and api.lorawan */
+class HostNwm
+{
+public:
+	HostNwm(uint8_t mode) : mode(mode) {}
+	uint32_t get(void);
+	bool set(void);
+
+private:
+	uint8_t mode;
+};
+
+class HostLoRaWAN
+{
+public:
+	HostParam<uint8_t> dr = HostParam<uint8_t>(3);
+	HostParam<uint8_t> band = HostParam<uint8_t>(4);
+	HostParam<uint8_t> txp;
+	HostParam<bool> adr;
+	HostParam<bool> cfm;
+	HostParam<uint8_t> linkcheck;
+	HostParam<uint8_t> timereq;
+	HostParam<bool> njm = HostParam<bool>(true);
+	HostNwm nwm = HostNwm(1);
+	HostKey deui, appeui, appkey, appskey, nwkskey, daddr;
+
+	class njs_t
+	{
+	public:
+		bool get(void);
+	} njs;
+
+	bool join(uint8_t join_start, uint8_t auto_join, uint8_t period, uint8_t attempts);
+	bool send(uint8_t length, uint8_t *payload, uint8_t fport, bool confirm = false, uint8_t retry = 0);
+	bool registerRecvCallback(void (*callback)(SERVICE_LORA_RECEIVE_T *data));
+	bool registerSendCallback(void (*callback)(int32_t status));
+	bool registerJoinCallback(void (*callback)(int32_t status));
+	bool registerLinkCheckCallback(void (*callback)(SERVICE_LORA_LINKCHECK_T *data));
+	bool registerTimereqCallback(void (*callback)(int32_t status));
+};
+
+class HostLoRa
+{
+public:
+	HostParam<uint32_t> pfreq = HostParam<uint32_t>(916000000);
+	HostParam<uint8_t> psf = HostParam<uint8_t>(7);
+	// Bandwidth code like the RUI3 P2P settings, 0 = 125 kHz
+	HostParam<uint16_t> pbw;
+	HostParam<uint8_t> pcr;
+	HostParam<uint8_t> ptp = HostParam<uint8_t>(22);
+	HostParam<uint16_t> ppl = HostParam<uint16_t>(8);
+	HostParam<uint32_t> pbr = HostParam<uint32_t>(50000);
+	HostParam<uint32_t> pfdev = HostParam<uint32_t>(25000);
+	HostNwm nwm = HostNwm(0);
+
+	bool precv(uint32_t timeout);
+	bool psend(uint8_t length, uint8_t *payload, bool cad = false);
+	bool registerPRecvCallback(void (*callback)(rui_lora_p2p_recv_t data));
+	bool registerPSendCallback(void (*callback)(void));
+};
+
+class HostSystem
+{
+public:
+	class atMode_t
+	{
+	public:
+		bool add(char *cmd, char *usage, char *title, PF_handler handler, unsigned int perm = RAK_ATCMD_PERM_WRITE | RAK_ATCMD_PERM_READ);
+	} atMode;
+
+	class bat_t
+	{
+	public:
+		float get(void);
+	} bat;
+
+	class flash_t
+	{
+	public:
+		bool get(uint32_t offset, uint8_t *buf, uint32_t len);
+		bool set(uint32_t offset, uint8_t *buf, uint32_t len);
+	} flash;
+
+	class hwModel_t
+	{
+	public:
+		std::string get(void) { return model; }
+		bool set(std::string new_model)
+		{
+			model = new_model;
+			return true;
+		}
+
+	private:
+		std::string model;
+	} hwModel;
+
+	class firmwareVersion_t
+	{
+	public:
+		bool set(std::string version)
+		{
+			ver = version;
+			return true;
+		}
+		std::string ver;
+	} firmwareVersion;
+
+	class firmwareVer_t
+	{
+	public:
+		std::string get(void) { return "RUI_4.2.0_RAK4631"; }
+	} firmwareVer;
+
+	class sleep_t
+	{
+	public:
+		bool cpu(uint32_t ms);
+	} sleep;
+
+	HostParam<uint8_t> lpm;
+
+	void reboot(void);
+};
+
+class HostApi
+{
+public:
+	HostSystem system;
+	HostLoRaWAN lorawan;
+	HostLoRa lora;
+};
+extern HostApi api;
+
+/** UTC of the first power on, 2026-10-16 08:00:00 */
+#define HOST_UTC_START 1792137600
+
+/** Size of the user flash */
+#define HOST_FLASH_SIZE 4096
+extern uint8_t host_flash[HOST_FLASH_SIZE];
+
+/** State of the simulated radio and system */
+struct host_radio_s
+{
+	bool joined;		// Network joined
+	uint32_t join_time; // Time from join() to the join callback (ms)
+	uint32_t airtime;	// Time from send()/psend() to the send callback (ms)
+	int32_t status;		// Status of the next send callbacks
+	int16_t rssi;		// RSSI of received packets
+	int8_t snr;			// SNR of received packets
+	uint8_t gateways;	// Gateways in the LinkCheck answer
+	/** Called for each LoRaWAN uplink, fills a downlink and returns true */
+	bool (*downlink)(uint8_t fport, uint8_t *payload, uint8_t length, SERVICE_LORA_RECEIVE_T *rx);
+	bool rx_on;				   // P2P receive enabled
+	uint32_t uplinks;		   // LoRaWAN uplinks
+	uint32_t p2p_sends;		   // P2P packets sent
+	uint32_t joins;			   // Join requests
+	uint32_t reboots;		   // api.system.reboot() calls
+	uint32_t sleeps;		   // api.system.sleep.cpu() calls
+	uint64_t sleep_us;		   // Time in api.system.sleep.cpu()
+	/** Called after each api.system.sleep.cpu() with the requested and the slept time */
+	void (*on_sleep)(uint32_t ms, uint64_t slept_us);
+	uint8_t last_port;		   // fPort of the last uplink
+	uint8_t last_length;	   // Size of the last uplink
+	uint8_t last_payload[256]; // Last uplink or P2P packet
+	float battery;			   // Battery voltage (V)
+	uint32_t utc;			   // UTC at millis() == 0 (s), the network time of a time request
+};
+extern host_radio_s host_radio;
+
+void host_api_reset(void);
+uint32_t host_radio_poll(void);
+uint32_t host_radio_next(void);
+void host_radio_p2p_rx(uint8_t *payload, uint16_t length, int16_t rssi, int8_t snr);
+int host_at_command(const char *line);
+
+#endif // _HOST_RUI3_API_H_
@@ -0,0 +1,17 @@
+/**
+ * @file udrv_dfu.h
+ * @author Bernd Giesecke (bernd@giesecke.tk)
+ * @brief Stand-in for the RUI3 DFU driver on the host, entering the
+ * 		bootloader is only counted
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#ifndef _HOST_UDRV_DFU_H_
+#define _HOST_UDRV_DFU_H_
+
+void udrv_enter_dfu(void);
+
+#endif // _HOST_UDRV_DFU_H_
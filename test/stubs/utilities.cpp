@@ -0,0 +1,25 @@
+/**
+ * @file utilities.cpp
+ * @author Bernd Giesecke (bernd@giesecke.tk)
+ * @brief CRC32 of the host build, same polynomial as zlib and log_dump.py
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include <utilities.h>
+
+uint32_t Crc32(uint8_t *buffer, uint16_t length)
+{
+	uint32_t crc = 0xFFFFFFFF;
+	for (uint16_t idx = 0; idx < length; idx++)
+	{
+		crc ^= buffer[idx];
+		for (uint8_t bit = 0; bit < 8; bit++)
+		{
+			crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+		}
+	}
+	return ~crc;
+}
@@ -0,0 +1,17 @@
+/**
+ * @file utilities.h
+ * @author Bernd Giesecke (bernd@giesecke.tk)
+ * @brief Stand-in for the RUI3 utilities on the host
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#ifndef _HOST_UTILITIES_H_
+#define _HOST_UTILITIES_H_
+#include <stdint.h>
+
+uint32_t Crc32(uint8_t *buffer, uint16_t length);
+
+#endif // _HOST_UTILITIES_H_
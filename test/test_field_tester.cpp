@@ -0,0 +1,144 @@
+/**
+ * @file test_field_tester.cpp
+ * @author Bernd Giesecke (bernd@giesecke.tk)
+ * @brief Random test of the FieldTester downlink parser.
+ * 		Random payloads of random size, including short and NULL
+ * 		buffers, are parsed and compared with a reference decoding
+ * 		of "FieldTester V2 Packet format.txt".
+ * 		Call with the number of payloads as argument, default is 1000000.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include <string.h>
+#include "app.h"
+#include "host_test.h"
+
+/**
+ * @brief Reference decoding of a downlink of valid size
+ *
+ * @param buffer downlink payload
+ * @param v2 true for FieldTester V2 format
+ * @param dl decoded downlink
+ */
+void reference_dl(const uint8_t *buffer, bool v2, field_tester_dl_s *dl)
+{
+	memset(dl, 0, sizeof(field_tester_dl_s));
+	if (v2)
+	{
+		dl->version = 2;
+		dl->plr = buffer[0] * 256 + buffer[1];
+		dl->max_rssi = buffer[2] - 200;
+		dl->min_distance = buffer[3] * 250;
+		dl->max_distance = buffer[4] * 250;
+		dl->gateways = buffer[5] / 16;
+		dl->seq_id = (buffer[5] % 16) * 256 + buffer[6];
+		dl->max_snr = buffer[7] - 200;
+		memcpy(dl->gw_eui, &buffer[8], 3);
+	}
+	else
+	{
+		dl->version = 1;
+		dl->seq_id = buffer[0];
+		dl->min_rssi = buffer[1] - 200;
+		dl->max_rssi = buffer[2] - 200;
+		dl->min_distance = buffer[3] * 250;
+		dl->max_distance = buffer[4] * 250;
+		dl->gateways = buffer[5];
+	}
+}
+
+/**
+ * @brief Random payloads against the reference decoding
+ *
+ * @param iterations number of payloads
+ */
+void test_random_dl(uint32_t iterations)
+{
+	uint8_t buffer[256];
+	field_tester_dl_s dl;
+	field_tester_dl_s expected;
+	uint32_t rejected = 0;
+
+	for (uint32_t count = 0; (count < iterations) && (host_test_failed == 0); count++)
+	{
+		bool v2 = host_random() & 1;
+		uint16_t size;
+		if ((host_random() % 8) == 0)
+		{
+			size = host_random() % (sizeof(buffer) + 1);
+		}
+		else
+		{
+			size = host_random() % (FT_V2_DL_SIZE + 3);
+		}
+		for (uint16_t idx = 0; idx < size; idx++)
+		{
+			buffer[idx] = host_random();
+		}
+		const uint8_t *payload = ((host_random() % 64) == 0) ? NULL : buffer;
+
+		memset(&dl, 0xA5, sizeof(dl));
+		uint32_t invalid = field_tester_dl_invalid;
+		bool valid = parse_field_tester_dl(payload, size, v2, &dl);
+
+		if ((payload == NULL) || (size < (v2 ? FT_V2_DL_SIZE : FT_V1_DL_SIZE)))
+		{
+			// Rejected, dl is not changed
+			CHECK(!valid);
+			CHECK(field_tester_dl_invalid == invalid + 1);
+			memset(&expected, 0xA5, sizeof(expected));
+			CHECK(memcmp(&dl, &expected, sizeof(dl)) == 0);
+			rejected++;
+			continue;
+		}
+
+		CHECK(valid);
+		CHECK(field_tester_dl_invalid == invalid);
+		reference_dl(buffer, v2, &expected);
+		CHECK(memcmp(&dl, &expected, sizeof(dl)) == 0);
+
+		// The distances survive the log record
+		volatile result_s res;
+		log_record_s record;
+		res.min_dst = dl.min_distance;
+		res.max_dst = dl.max_distance;
+		log_encode_record(&res, &record);
+		CHECK(record.min_dst == buffer[3]);
+		CHECK(record.max_dst == buffer[4]);
+	}
+	printf("%u downlinks, %u rejected\n", iterations, rejected);
+}
+
+/**
+ * @brief The largest distance of the downlink is logged as a positive number
+ *
+ */
+void test_max_distance(void)
+{
+	uint8_t payload[FT_V2_DL_SIZE] = {0x00, 0x00, 100, 255, 255, 0x10, 0x01, 200, 0x01, 0x02, 0x03};
+	field_tester_dl_s dl;
+	CHECK(parse_field_tester_dl(payload, sizeof(payload), true, &dl));
+	CHECK(dl.min_distance == 63750);
+	CHECK(dl.max_distance == 63750);
+
+	volatile result_s res;
+	res.mode = MODE_FIELDTESTER_V2;
+	res.min_dst = dl.min_distance;
+	res.max_dst = dl.max_distance;
+	log_record_s record;
+	log_encode_record(&res, &record);
+
+	char line[256];
+	log_record_to_csv(log_columns(MODE_FIELDTESTER_V2, true), &record, line, sizeof(line));
+	CHECK(strstr(line, ";63750;63750;") != NULL);
+}
+
+int main(int argc, char **argv)
+{
+	test_max_distance();
+	test_random_dl(host_test_iterations(argc, argv, 1000000));
+	return host_test_result("field_tester");
+}
@@ -0,0 +1,194 @@
+/**
+ * @file test_fw_drive.cpp
+ * @author Bernd Giesecke (bernd@giesecke.tk)
+ * @brief End to end test of the whole firmware on the host.
+ * 		A device in FieldTester V2 mode with location on drives for an
+ * 		hour: the GNSS module replays a fix that moves every minute,
+ * 		the network answers each uplink with a FieldTester V2
+ * 		downlink. The uplinks, the OLED, the rows on the SD card and
+ * 		the CSV sent for ATC+LOGS=n are checked against the replay.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include "fw_test.h"
+
+/** Send interval of the test (ms) */
+#define DRIVE_INTERVAL 60000
+/** Duration of the drive (ms) */
+#define DRIVE_TIME 3600000
+/** Number of GNSS epochs, one per second */
+#define DRIVE_EPOCHS (DRIVE_TIME / 1000 + 1)
+/** Position of the first epoch (deg * 1e7) */
+#define DRIVE_LAT 144215360
+#define DRIVE_LNG 1210068190
+/** Movement per second (deg * 1e7) */
+#define DRIVE_STEP 100
+
+static host_gnss_epoch_s drive_epochs[DRIVE_EPOCHS];
+
+/** Downlinks sent by the network */
+static uint32_t downlinks = 0;
+
+/**
+ * @brief Network answer to a FieldTester V2 uplink, the max RSSI of the
+ * 		downlink counts the uplinks
+ *
+ * @param fport fPort of the uplink
+ * @param payload uplink
+ * @param length size of the uplink
+ * @param rx downlink to fill
+ * @return true downlink is sent
+ */
+bool ft_v2_network(uint8_t fport, uint8_t *payload, uint8_t length, SERVICE_LORA_RECEIVE_T *rx)
+{
+	static uint8_t downlink[FT_V2_DL_SIZE];
+	if ((fport != 1) || (length == 0))
+	{
+		return false;
+	}
+	downlinks++;
+	memset(downlink, 0, sizeof(downlink));
+	downlink[1] = 5;							 // PLR 0.5%
+	downlink[2] = 200 - 60 - (downlinks % 40);	 // Max RSSI
+	downlink[3] = 2;							 // Min distance 500 m
+	downlink[4] = 8;							 // Max distance 2000 m
+	downlink[5] = 0x30 | ((downlinks >> 8) & 0x0F); // 3 gateways
+	downlink[6] = downlinks & 0xFF;
+	downlink[7] = 200 + 7; // Max SNR
+	rx->Port = 2;
+	rx->RxDatarate = 3;
+	rx->Buffer = downlink;
+	rx->BufferSize = sizeof(downlink);
+	rx->Rssi = -90;
+	rx->Snr = 6;
+	return true;
+}
+
+/**
+ * @brief GNSS replay: no fix for the first 20 seconds, then a 3D fix
+ * 		that moves every second
+ *
+ */
+void make_drive_epochs(void)
+{
+	memset(drive_epochs, 0, sizeof(drive_epochs));
+	for (uint32_t idx = 0; idx < DRIVE_EPOCHS; idx++)
+	{
+		host_gnss_epoch_s *epoch = &drive_epochs[idx];
+		epoch->time = idx * 1000;
+		epoch->pvt.iTOW = idx * 1000;
+		if (idx < 20)
+		{
+			continue;
+		}
+		epoch->pvt.fixType = 3;
+		epoch->pvt.flags.bits.gnssFixOK = 1;
+		epoch->pvt.numSV = 9;
+		epoch->pvt.lat = DRIVE_LAT + idx * DRIVE_STEP;
+		epoch->pvt.lon = DRIVE_LNG - idx * DRIVE_STEP;
+		epoch->pvt.height = 35000;
+		epoch->pvt.hAcc = 3000;
+		epoch->pvt.pDOP = 120;
+		epoch->hdop = 90;
+	}
+	host_gnss.epochs = drive_epochs;
+	host_gnss.num_epochs = DRIVE_EPOCHS;
+}
+
+/**
+ * @brief Number of lines of a text starting with a prefix
+ *
+ * @param text text
+ * @param prefix start of the line
+ * @return uint32_t number of lines
+ */
+uint32_t count_lines(const std::string &text, const char *prefix)
+{
+	uint32_t lines = 0;
+	size_t pos = 0;
+	while (pos < text.size())
+	{
+		size_t end = text.find('\n', pos);
+		if (end == std::string::npos)
+		{
+			end = text.size();
+		}
+		if (text.compare(pos, strlen(prefix), prefix) == 0)
+		{
+			lines++;
+		}
+		pos = end + 1;
+	}
+	return lines;
+}
+
+int main(int argc, char **argv)
+{
+	fw_power_on(fw_full_board, "build/sd_drive");
+	make_drive_epochs();
+	host_radio.downlink = ft_v2_network;
+
+	// Settings as saved with ATC+MODE=3 and ATC+SENDINT=60
+	g_custom_parameters.test_mode = MODE_FIELDTESTER_V2;
+	g_custom_parameters.send_interval = DRIVE_INTERVAL;
+	g_custom_parameters.location_on = true;
+	g_custom_parameters.gnss_policy = GNSS_POLICY_HACC;
+	g_custom_parameters.log_max_rows = 300;
+	CHECK(save_at_setting());
+
+	setup();
+	CHECK(has_oled && has_rtc && has_gnss && has_sd);
+	CHECK(strstr(host_oled.text[0], "RAK Signal Meter") != NULL);
+
+	fw_run(DRIVE_TIME);
+
+	// One uplink per interval, each with its downlink, the first needs the fix
+	uint32_t uplinks = DRIVE_TIME / DRIVE_INTERVAL;
+	CHECK(host_radio.uplinks >= uplinks - 1);
+	CHECK(host_radio.uplinks <= uplinks);
+	CHECK(downlinks == host_radio.uplinks);
+	CHECK(host_radio.last_port == 1);
+	CHECK(radio_event_dropped == 0);
+	CHECK(event_queue_dropped == 0);
+	CHECK(gnss_last_fix.fixes >= host_radio.uplinks);
+
+	// The location of the last uplink is from the replay
+	int32_t lat_steps = (g_last_latitude - DRIVE_LAT) / DRIVE_STEP;
+	CHECK(lat_steps >= 20);
+	CHECK(lat_steps < (int32_t)DRIVE_EPOCHS);
+	CHECK(g_last_longitude == DRIVE_LNG - lat_steps * DRIVE_STEP);
+
+	// The display shows the last downlink
+	CHECK(host_oled.frames > 0);
+	CHECK(strstr(host_oled.text[0], "RAK FieldTest V2") != NULL);
+	bool gateways_shown = false;
+	for (uint8_t line = 0; line < 6; line++)
+	{
+		gateways_shown |= strstr(host_oled.text[line], "GW(s): 3") != NULL;
+	}
+	CHECK(gateways_shown);
+
+	// Every downlink is a row of the log, sent as CSV for ATC+LOGS=n
+	String csv;
+	Serial.capture = &csv;
+	CHECK(host_at_command("ATC+LOGS=n,1000") == AT_OK);
+	Serial.capture = NULL;
+	CHECK(count_lines(csv, "20") == downlinks);
+	CHECK(csv.find("OK") != std::string::npos);
+	char location[32];
+	snprintf(location, sizeof(location), "%.6f", g_last_latitude / 10000000.0);
+	CHECK(csv.find(location) != std::string::npos);
+
+	// Logging goes on after the dump
+	uint32_t before = host_radio.uplinks;
+	fw_run(5 * DRIVE_INTERVAL);
+	CHECK(host_radio.uplinks >= before + 4);
+
+	printf("uplinks %u, rows %u, data sectors %u, dir sectors %u, fat sectors %u, sleep %.1f%%\n",
+		   host_radio.uplinks, count_lines(csv, "20"), host_sd.stats.data_sectors, host_sd.stats.dir_sectors,
+		   host_sd.stats.fat_sectors, 100.0 * host_radio.sleep_us / host_clock_us);
+	return host_test_result("fw_drive");
+}
@@ -0,0 +1,423 @@
+/**
+ * @file test_fw_gnss_policy.cpp
+ * @author Bernd Giesecke (bernd@giesecke.tk)
+ * @brief Offline evaluation of the fix acceptance policies. The same
+ * 		acquisitions are replayed through the GNSS stand-in for each
+ * 		policy, the firmware runs them in FieldTester V2 mode with
+ * 		location like on the field. Between the acquisitions the module
+ * 		has no fix, each uplink starts an acquisition and the
+ * 		acquisition starts at the first solution of the replay.
+ * 		Reported per policy are the time to accept and the error of the
+ * 		accepted position.
+ * 		Recorded acquisitions are given as UBX files (u-center logs,
+ * 		one acquisition per file, from the power up of the module),
+ * 		the reference position of a file is its solution with
+ * 		the smallest horizontal accuracy estimate. Without files, or
+ * 		with a number as argument, generated acquisitions with known
+ * 		position are replayed: cold and warm starts, different
+ * 		convergence and some with a poor sky view.
+ * 		Call with the number of generated acquisitions or with UBX
+ * 		files as arguments, default is 40 generated acquisitions.
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include "fw_test.h"
+#include <math.h>
+#include <sys/mman.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+/** Send interval, the acquisition takes at most half of it (ms) */
+#define POLICY_INTERVAL 120000
+/** Length of a generated acquisition (s) */
+#define POLICY_TRACE_TIME 70
+/** Largest number of acquisitions and of solutions per acquisition */
+#define POLICY_MAX_TRACES 500
+#define POLICY_MAX_EPOCHS 600
+/** Position of the generated acquisitions (deg * 1e7) */
+#define POLICY_LAT 144215360
+#define POLICY_LON 1210068190
+/** Distance of 1e-7 deg latitude (mm) */
+#define POLICY_MM_PER_UNIT 11.132
+
+/** Policy settings of a run */
+struct policy_run_s
+{
+	const char *name;
+	uint8_t policy;
+	uint16_t hacc_max; // m
+	uint8_t deadline;  // %
+};
+static const policy_run_s policy_runs[] = {
+	{"legacy", GNSS_POLICY_LEGACY, 50, 75},
+	{"hacc 50 m", GNSS_POLICY_HACC, 50, 75},
+	{"hacc 10 m", GNSS_POLICY_HACC, 10, 75},
+	{"settled", GNSS_POLICY_SETTLED, 50, 75},
+};
+#define POLICY_RUNS (sizeof(policy_runs) / sizeof(policy_runs[0]))
+
+/** Acquisition to replay, solution times from the power up of the module */
+struct policy_trace_s
+{
+	std::string name;
+	std::vector<host_gnss_epoch_s> epochs;
+	int32_t lat; // Reference position (deg * 1e7)
+	int32_t lon;
+	bool clear_sky; // Generated with a 3D fix before the deadline
+};
+static std::vector<policy_trace_s> traces;
+
+/** Outcome of one acquisition */
+struct policy_result_s
+{
+	bool accepted;
+	bool deadline; // Accepted by the deadline
+	bool in_trace; // Accepted position is a solution of the acquisition
+	uint32_t ttf;  // Time to accept (ms)
+	uint32_t h_acc;
+	double error_m;
+};
+
+/** Outcomes of all runs, shared with the runs */
+struct policy_results_s
+{
+	policy_result_s result[POLICY_RUNS][POLICY_MAX_TRACES];
+	uint32_t done[POLICY_RUNS];
+};
+static policy_results_s *results = NULL;
+
+/** Run of the current process */
+static uint8_t policy_run = 0;
+/** Replay of the current acquisition */
+static host_gnss_epoch_s policy_epochs[POLICY_MAX_EPOCHS];
+/** Solutions without fix between two acquisitions */
+#define POLICY_IDLE_EPOCHS (2 * POLICY_INTERVAL / 1000)
+static host_gnss_epoch_s policy_idle[POLICY_IDLE_EPOCHS];
+
+/**
+ * @brief Solutions without fix from now on until the next acquisition
+ *
+ */
+void policy_no_fix(void)
+{
+	memset(policy_idle, 0, sizeof(policy_idle));
+	for (uint32_t sec = 0; sec < POLICY_IDLE_EPOCHS; sec++)
+	{
+		policy_idle[sec].time = millis() + sec * 1000;
+		policy_idle[sec].pvt.iTOW = policy_idle[sec].time;
+		policy_idle[sec].pvt.hAcc = 4294967295UL;
+		policy_idle[sec].pvt.pDOP = 9999;
+		policy_idle[sec].hdop = 9999;
+	}
+	host_gnss.epochs = policy_idle;
+	host_gnss.num_epochs = POLICY_IDLE_EPOCHS;
+}
+
+/**
+ * @brief Generate an acquisition. The error of the position shrinks
+ * 		from the first fix on towards a floor, the horizontal accuracy
+ * 		estimate follows it with a factor, satellites are added until
+ * 		the sky is used up.
+ *
+ * @param idx number of the acquisition
+ * @param trace filled with the acquisition
+ */
+void policy_make_trace(uint32_t idx, policy_trace_s *trace)
+{
+	bool warm = host_random_range(0, 9) < 3;
+	bool poor_sky = host_random_range(0, 9) == 0;
+	uint32_t first_fix = warm ? host_random_range(3, 8) : host_random_range(12, 40);
+	uint32_t sky = poor_sky ? host_random_range(5, 7) : host_random_range(8, 14);
+	double error_start = host_random_range(30, 150);
+	double error_floor = poor_sky ? host_random_range(20, 60) : host_random_range(1, 4);
+	double tau = host_random_range(5, 25);
+	double estimate = host_random_range(60, 150) / 100.0;
+	double angle = host_random_range(0, 359) * M_PI / 180.0;
+
+	char name[32];
+	snprintf(name, sizeof(name), "#%u %s%s", idx, warm ? "warm" : "cold", poor_sky ? " poor sky" : "");
+	trace->name = name;
+	trace->lat = POLICY_LAT + host_random_range(-5000, 5000);
+	trace->lon = POLICY_LON + host_random_range(-5000, 5000);
+	trace->clear_sky = !poor_sky;
+	trace->epochs.clear();
+
+	uint8_t satellites = 0;
+	for (uint32_t sec = 0; sec <= POLICY_TRACE_TIME; sec++)
+	{
+		host_gnss_epoch_s epoch;
+		memset(&epoch, 0, sizeof(epoch));
+		epoch.time = sec * 1000;
+		epoch.pvt.iTOW = sec * 1000;
+		if ((satellites < sky) && (host_random_range(0, 2) == 0 || (sec >= first_fix && satellites < 4)))
+		{
+			satellites++;
+		}
+		epoch.pvt.numSV = satellites;
+		epoch.pvt.hAcc = 4294967295UL;
+		epoch.pvt.pDOP = 9999;
+		epoch.hdop = 9999;
+		if (sec >= first_fix)
+		{
+			double error = error_start * exp(-(double)(sec - first_fix) / tau) + error_floor;
+			error *= host_random_range(80, 120) / 100.0;
+			angle += host_random_range(-20, 20) * M_PI / 180.0;
+			epoch.pvt.fixType = sec < first_fix + 3 ? 2 : 3;
+			epoch.pvt.flags.bits.gnssFixOK = epoch.pvt.fixType == 3;
+			epoch.pvt.lat = trace->lat + (int32_t)(error * 1000.0 * cos(angle) / POLICY_MM_PER_UNIT);
+			epoch.pvt.lon = trace->lon + (int32_t)(error * 1000.0 * sin(angle) / POLICY_MM_PER_UNIT / cos(trace->lat / 1e7 * M_PI / 180.0));
+			epoch.pvt.height = 35000 + (int32_t)(error * 1500.0 * sin(angle));
+			epoch.pvt.hAcc = (uint32_t)(error * 1000.0 * estimate);
+			epoch.pvt.pDOP = 100 + 1500 / max(satellites, (uint8_t)1);
+			epoch.hdop = 80 + 1000 / max(satellites, (uint8_t)1);
+		}
+		trace->epochs.push_back(epoch);
+	}
+}
+
+/**
+ * @brief Load a recorded acquisition
+ *
+ * @param file_name UBX file
+ * @param trace filled with the acquisition
+ * @return true file holds at least one 3D fix
+ */
+bool policy_load_trace(const char *file_name, policy_trace_s *trace)
+{
+	std::string content;
+	if (!fw_read_file(file_name, content))
+	{
+		fprintf(stderr, "cannot read %s\n", file_name);
+		return false;
+	}
+	uint32_t errors = 0;
+	uint32_t count = host_gnss_load_ubx((const uint8_t *)content.data(), content.size(), 0, policy_epochs, POLICY_MAX_EPOCHS, &errors);
+	trace->name = file_name;
+	trace->clear_sky = false;
+	trace->epochs.assign(policy_epochs, policy_epochs + count);
+	uint32_t best = 0xFFFFFFFF;
+	for (uint32_t idx = 0; idx < count; idx++)
+	{
+		if (policy_epochs[idx].pvt.flags.bits.gnssFixOK && (policy_epochs[idx].pvt.fixType >= 3) && (policy_epochs[idx].pvt.hAcc < best))
+		{
+			best = policy_epochs[idx].pvt.hAcc;
+			trace->lat = policy_epochs[idx].pvt.lat;
+			trace->lon = policy_epochs[idx].pvt.lon;
+		}
+	}
+	printf("%s: %u solutions, %u broken messages\n", file_name, count, errors);
+	return best != 0xFFFFFFFF;
+}
+
+/**
+ * @brief Distance between two positions, flat earth
+ *
+ * @return double distance (m)
+ */
+double policy_distance(int32_t lat1, int32_t lon1, int32_t lat2, int32_t lon2)
+{
+	double north = (double)(lat1 - lat2) * POLICY_MM_PER_UNIT;
+	double east = (double)(lon1 - lon2) * POLICY_MM_PER_UNIT * cos(lat2 / 1e7 * M_PI / 180.0);
+	return sqrt(north * north + east * east) / 1000.0;
+}
+
+/**
+ * @brief Replay all acquisitions with one policy, runs in its own process
+ *
+ */
+void policy_replay(void)
+{
+	const policy_run_s *run = &policy_runs[policy_run];
+	fw_power_on(fw_full_board, "build/sd_policy");
+	g_custom_parameters.test_mode = MODE_FIELDTESTER_V2;
+	g_custom_parameters.send_interval = POLICY_INTERVAL;
+	g_custom_parameters.location_on = true;
+	g_custom_parameters.gnss_policy = run->policy;
+	g_custom_parameters.gnss_hacc_max = run->hacc_max;
+	g_custom_parameters.gnss_deadline = run->deadline;
+	CHECK(save_at_setting());
+	setup();
+	CHECK(has_gnss);
+
+	for (uint32_t idx = 0; idx < traces.size(); idx++)
+	{
+		// Wait for the send job to start the acquisition
+		policy_no_fix();
+		uint32_t wait = 0;
+		while (!gnss_active && (wait < 2 * POLICY_INTERVAL))
+		{
+			fw_run(100);
+			wait += 100;
+		}
+		CHECK(gnss_active);
+
+		// The module has the solutions of the acquisition from its start on
+		policy_trace_s *trace = &traces[idx];
+		uint32_t count = min((uint32_t)trace->epochs.size(), (uint32_t)POLICY_MAX_EPOCHS);
+		for (uint32_t epoch = 0; epoch < count; epoch++)
+		{
+			policy_epochs[epoch] = trace->epochs[epoch];
+			policy_epochs[epoch].time += gnss_start_time;
+		}
+		host_gnss.epochs = policy_epochs;
+		host_gnss.num_epochs = count;
+
+		uint32_t fixes = gnss_last_fix.fixes;
+		uint32_t start = gnss_start_time;
+		while (gnss_active)
+		{
+			fw_run(100);
+		}
+		CHECK(millis() - start <= POLICY_INTERVAL / 2 + GNSS_POLL_INTERVAL);
+
+		policy_result_s *result = &results->result[policy_run][idx];
+		result->accepted = gnss_last_fix.fixes != fixes;
+		if (result->accepted)
+		{
+			result->deadline = strcmp(gnss_last_fix.reason, "deadline") == 0;
+			result->ttf = gnss_last_fix.ttf;
+			result->h_acc = gnss_last_fix.h_acc;
+			result->error_m = policy_distance(g_last_latitude, g_last_longitude, trace->lat, trace->lon);
+			for (uint32_t epoch = 0; epoch < count; epoch++)
+			{
+				if ((policy_epochs[epoch].pvt.lat == g_last_latitude) && (policy_epochs[epoch].pvt.lon == g_last_longitude) &&
+					(policy_epochs[epoch].pvt.hAcc == result->h_acc))
+				{
+					result->in_trace = true;
+				}
+			}
+		}
+		results->done[policy_run]++;
+	}
+}
+
+/**
+ * @brief Percentile of a list of values
+ *
+ * @param values values, sorted in place
+ * @param percent percentile
+ * @return double value, 0 for an empty list
+ */
+double policy_percentile(std::vector<double> &values, uint8_t percent)
+{
+	if (values.empty())
+	{
+		return 0.0;
+	}
+	std::sort(values.begin(), values.end());
+	return values[(values.size() - 1) * percent / 100];
+}
+
+int main(int argc, char **argv)
+{
+	uint32_t generated = 40;
+	bool files = false;
+	for (int arg = 1; arg < argc; arg++)
+	{
+		if ((argv[arg][0] >= '0') && (argv[arg][0] <= '9'))
+		{
+			generated = min((uint32_t)strtoul(argv[arg], NULL, 10), (uint32_t)POLICY_MAX_TRACES);
+			continue;
+		}
+		policy_trace_s trace;
+		CHECK(policy_load_trace(argv[arg], &trace));
+		traces.push_back(trace);
+		files = true;
+	}
+	for (uint32_t idx = 0; !files && (idx < generated); idx++)
+	{
+		policy_trace_s trace;
+		policy_make_trace(idx, &trace);
+		traces.push_back(trace);
+	}
+	CHECK(!traces.empty() && (traces.size() <= POLICY_MAX_TRACES));
+
+	results = (policy_results_s *)mmap(NULL, sizeof(policy_results_s), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	CHECK(results != MAP_FAILED);
+	memset(results, 0, sizeof(policy_results_s));
+	for (policy_run = 0; policy_run < POLICY_RUNS; policy_run++)
+	{
+		fw_fresh(policy_replay);
+		CHECK(results->done[policy_run] == traces.size());
+	}
+
+	printf("%u acquisitions, acquisition time %d s, deadline %d%%\n", (uint32_t)traces.size(), POLICY_INTERVAL / 2000,
+		   policy_runs[0].deadline);
+	printf("  %-10s %8s %8s %8s %10s %10s %10s %10s %10s\n", "policy", "accepted", "deadline", "timeout", "ttf med s",
+		   "ttf p90 s", "err med m", "err p90 m", "err max m");
+	for (uint8_t run = 0; run < POLICY_RUNS; run++)
+	{
+		const policy_run_s *settings = &policy_runs[run];
+		std::vector<double> ttf;
+		std::vector<double> error;
+		uint32_t deadline = 0;
+		uint32_t timeout = 0;
+		for (uint32_t idx = 0; idx < traces.size(); idx++)
+		{
+			policy_result_s *result = &results->result[run][idx];
+			if (!result->accepted)
+			{
+				timeout++;
+				continue;
+			}
+			ttf.push_back(result->ttf / 1000.0);
+			error.push_back(result->error_m);
+			deadline += result->deadline ? 1 : 0;
+
+			// The accepted position is one solution of the acquisition, with its own accuracy estimate
+			CHECK(result->in_trace);
+			CHECK(result->ttf <= POLICY_INTERVAL / 2 + GNSS_POLL_INTERVAL);
+			if (settings->policy == GNSS_POLICY_LEGACY)
+			{
+				CHECK(!result->deadline);
+			}
+			else if (result->deadline)
+			{
+				CHECK(result->ttf >= POLICY_INTERVAL / 2 / 100 * settings->deadline);
+			}
+			else if (settings->policy == GNSS_POLICY_HACC)
+			{
+				CHECK(result->h_acc <= (uint32_t)settings->hacc_max * 1000);
+			}
+		}
+		// With a 3D fix before the deadline only the legacy policy can give up
+		for (uint32_t idx = 0; idx < traces.size(); idx++)
+		{
+			if ((settings->policy != GNSS_POLICY_LEGACY) && traces[idx].clear_sky)
+			{
+				CHECK(results->result[run][idx].accepted);
+			}
+		}
+		std::vector<double> error_max = error;
+		printf("  %-10s %8u %8u %8u %10.1f %10.1f %10.1f %10.1f %10.1f\n", settings->name, (uint32_t)ttf.size(), deadline, timeout,
+			   policy_percentile(ttf, 50), policy_percentile(ttf, 90), policy_percentile(error, 50), policy_percentile(error, 90),
+			   policy_percentile(error_max, 100));
+	}
+
+	// Each recorded acquisition, time to accept (s) and error (m) per policy
+	if (files)
+	{
+		for (uint32_t idx = 0; idx < traces.size(); idx++)
+		{
+			printf("  %-30s", traces[idx].name.c_str());
+			for (uint8_t run = 0; run < POLICY_RUNS; run++)
+			{
+				policy_result_s *result = &results->result[run][idx];
+				if (result->accepted)
+				{
+					printf(" %s %5.1f s %6.1f m", policy_runs[run].name, result->ttf / 1000.0, result->error_m);
+				}
+				else
+				{
+					printf(" %s timeout", policy_runs[run].name);
+				}
+			}
+			printf("\n");
+		}
+	}
+	return host_test_result("fw_gnss_policy");
+}
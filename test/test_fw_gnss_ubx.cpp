@@ -0,0 +1,438 @@
+/**
+ * @file test_fw_gnss_ubx.cpp
+ * @author Bernd Giesecke (bernd@giesecke.tk)
+ * @brief Replay of a UBX byte stream through the I2C bus stand-in.
+ * 		The stream is a cold start of two minutes as the module sends
+ * 		it: NAV-DOP and NAV-PVT of each solution, NAV-STATUS, NMEA text
+ * 		in between and one NAV-PVT with a broken checksum. The GNSS
+ * 		stand-in takes the solutions from the stream, each one is read
+ * 		with the getters the firmware used before (getLatitude() ...
+ * 		getGnssFixOk()), with the snapshot of gnss_read_pvt() and
+ * 		gnss_read_dop() in polled mode and with auto PVT. All reads
+ * 		must give the values of the solution in the stream, the I2C
+ * 		transactions of each read are counted and printed.
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include "fw_test.h"
+#include <sys/mman.h>
+#include <vector>
+
+/** Solutions in the stream, one per second */
+#define UBX_SOLUTIONS 120
+/** Solution with a broken NAV-PVT checksum */
+#define UBX_BROKEN 40
+/** GPS time of week of the first solution (ms) */
+#define UBX_ITOW0 460800000
+/** First solution with a 2D and with a 3D fix */
+#define UBX_FIX_2D 15
+#define UBX_FIX_3D 25
+
+/** GNSS module of gnss.cpp */
+extern SFE_UBLOX_GNSS my_gnss;
+
+/** Solution of the stream */
+struct ubx_solution_s
+{
+	uint32_t itow;
+	uint8_t fix_type;
+	bool fix_ok;
+	uint8_t satellites;
+	int32_t lat;
+	int32_t lon;
+	int32_t height;
+	uint32_t h_acc;
+	uint16_t pdop;
+	uint16_t hdop;
+};
+
+/** Values and I2C transactions of one read */
+struct ubx_read_s
+{
+	bool read;
+	int32_t lat;
+	int32_t lon;
+	int32_t height;
+	uint16_t hdop;
+	uint8_t satellites;
+	uint8_t fix_type;
+	bool fix_ok;
+	uint32_t pvt_i2c;  // NAV-PVT, all values for the getters
+	uint32_t dop_i2c;  // NAV-DOP
+	uint32_t idle_i2c; // Auto PVT check without a new solution
+};
+
+/** Reads of all parts, shared with the parts */
+struct ubx_results_s
+{
+	uint32_t epochs;
+	uint32_t errors;
+	uint32_t itow[UBX_SOLUTIONS];
+	ubx_read_s getters[UBX_SOLUTIONS];
+	ubx_read_s snapshot[UBX_SOLUTIONS];
+	ubx_read_s auto_pvt[UBX_SOLUTIONS];
+};
+static ubx_results_s *results = NULL;
+
+static std::vector<uint8_t> ubx_stream;
+static host_gnss_epoch_s ubx_epochs[UBX_SOLUTIONS];
+
+/**
+ * @brief Solution of the cold start: no fix, then a 2D fix and a 3D
+ * 		fix that gets better and moves
+ *
+ * @param idx second of the stream
+ * @param solution filled with the solution
+ */
+void ubx_make_solution(uint32_t idx, ubx_solution_s *solution)
+{
+	memset(solution, 0, sizeof(ubx_solution_s));
+	solution->itow = UBX_ITOW0 + idx * 1000;
+	solution->satellites = idx < UBX_FIX_2D ? idx / 3 : min(4 + idx / 8, (uint32_t)14);
+	solution->h_acc = 4294967295UL;
+	solution->pdop = 9999;
+	solution->hdop = 9999;
+	if (idx < UBX_FIX_2D)
+	{
+		return;
+	}
+	solution->fix_type = idx < UBX_FIX_3D ? 2 : 3;
+	solution->fix_ok = idx >= UBX_FIX_3D;
+	solution->lat = 144215360 + idx * 37;
+	solution->lon = 1210068190 - idx * 23;
+	solution->height = 35000 + idx * 10;
+	solution->h_acc = max(50000 - idx * 500, (uint32_t)2500);
+	solution->pdop = max(400 - idx * 3, (uint32_t)110);
+	solution->hdop = max(300 - idx * 2, (uint32_t)80);
+}
+
+/**
+ * @brief Store a little endian value in a payload
+ *
+ * @param payload message payload
+ * @param offset offset of the value
+ * @param size size of the value (bytes)
+ * @param value value
+ */
+void ubx_put(uint8_t *payload, uint8_t offset, uint8_t size, uint32_t value)
+{
+	for (uint8_t idx = 0; idx < size; idx++)
+	{
+		payload[offset + idx] = (value >> (8 * idx)) & 0xFF;
+	}
+}
+
+/**
+ * @brief Add a UBX message to the stream
+ *
+ * @param msg_class message class
+ * @param msg_id message id
+ * @param payload payload
+ * @param length size of the payload
+ * @return size_t offset of the message in the stream
+ */
+size_t ubx_add(uint8_t msg_class, uint8_t msg_id, const uint8_t *payload, uint16_t length)
+{
+	size_t start = ubx_stream.size();
+	uint8_t header[] = {0xB5, 0x62, msg_class, msg_id, (uint8_t)(length & 0xFF), (uint8_t)(length >> 8)};
+	ubx_stream.insert(ubx_stream.end(), header, header + sizeof(header));
+	ubx_stream.insert(ubx_stream.end(), payload, payload + length);
+	uint8_t ck_a = 0;
+	uint8_t ck_b = 0;
+	for (size_t idx = start + 2; idx < ubx_stream.size(); idx++)
+	{
+		ck_a += ubx_stream[idx];
+		ck_b += ck_a;
+	}
+	ubx_stream.push_back(ck_a);
+	ubx_stream.push_back(ck_b);
+	return start;
+}
+
+/**
+ * @brief Build the stream, the fields are placed at their offsets in
+ * 		the u-blox interface description
+ *
+ */
+void ubx_make_stream(void)
+{
+	ubx_stream.clear();
+	for (uint32_t idx = 0; idx < UBX_SOLUTIONS; idx++)
+	{
+		ubx_solution_s solution;
+		ubx_make_solution(idx, &solution);
+
+		// NAV-DOP before NAV-PVT, the module sends by message id
+		uint8_t dop[18] = {0};
+		ubx_put(dop, 0, 4, solution.itow);
+		ubx_put(dop, 6, 2, solution.pdop);
+		ubx_put(dop, 12, 2, solution.hdop);
+		ubx_add(0x01, 0x04, dop, sizeof(dop));
+
+		uint8_t pvt[92] = {0};
+		ubx_put(pvt, 0, 4, solution.itow);
+		ubx_put(pvt, 4, 2, 2026);
+		pvt[6] = 10;
+		pvt[7] = 16;
+		pvt[8] = 8;
+		pvt[9] = idx / 60;
+		pvt[10] = idx % 60;
+		pvt[11] = idx >= UBX_FIX_2D ? 0x07 : 0x00;
+		pvt[20] = solution.fix_type;
+		pvt[21] = solution.fix_ok ? 0x01 : 0x00;
+		pvt[23] = solution.satellites;
+		ubx_put(pvt, 24, 4, solution.lon);
+		ubx_put(pvt, 28, 4, solution.lat);
+		ubx_put(pvt, 32, 4, solution.height);
+		ubx_put(pvt, 36, 4, solution.height - 47000);
+		ubx_put(pvt, 40, 4, solution.h_acc);
+		ubx_put(pvt, 44, 4, solution.h_acc * 2);
+		ubx_put(pvt, 76, 2, solution.pdop);
+		size_t start = ubx_add(0x01, 0x07, pvt, sizeof(pvt));
+		if (idx == UBX_BROKEN)
+		{
+			// Bit error in the latitude
+			ubx_stream[start + 6 + 28] ^= 0x10;
+		}
+
+		// NAV-STATUS and NMEA text are skipped
+		uint8_t status[16] = {0};
+		ubx_put(status, 0, 4, solution.itow);
+		status[4] = solution.fix_type;
+		ubx_add(0x01, 0x03, status, sizeof(status));
+		const char *nmea = "$GNGGA,080000.00,1425.29216,N,12100.40914,E,1,09,0.90,35.0,M,-47.0,M,,*6B\r\n";
+		ubx_stream.insert(ubx_stream.end(), nmea, nmea + strlen(nmea));
+	}
+}
+
+/**
+ * @brief Boot with the GNSS module and load the stream, the first
+ * 		solution comes one second after the boot
+ *
+ * @param location_on auto PVT (true) or polled solutions (false)
+ */
+void ubx_boot(bool location_on)
+{
+	fw_power_on(fw_full_board, "build/sd_ubx");
+	g_custom_parameters.test_mode = MODE_FIELDTESTER_V2;
+	g_custom_parameters.send_interval = 0;
+	g_custom_parameters.location_on = location_on;
+	CHECK(save_at_setting());
+	setup();
+	CHECK(has_gnss);
+
+	results->epochs = host_gnss_load_ubx(ubx_stream.data(), ubx_stream.size(), millis() + 1000, ubx_epochs, UBX_SOLUTIONS, &results->errors);
+	host_gnss.epochs = ubx_epochs;
+	host_gnss.num_epochs = results->epochs;
+	for (uint32_t epoch = 0; epoch < results->epochs; epoch++)
+	{
+		results->itow[epoch] = ubx_epochs[epoch].pvt.iTOW;
+	}
+}
+
+/**
+ * @brief Move the clock to a time after the start of a solution
+ *
+ * @param epoch solution
+ * @param after time after its start (ms)
+ */
+void ubx_wait(uint32_t epoch, uint32_t after)
+{
+	uint32_t time = ubx_epochs[epoch].time + after;
+	host_advance((time - millis()) * 1000);
+}
+
+/**
+ * @brief I2C transactions with the GNSS module since boot
+ *
+ * @return uint32_t transactions
+ */
+uint32_t ubx_i2c(void)
+{
+	return Wire.transactions[HOST_GNSS_ADDRESS];
+}
+
+/**
+ * @brief Read each solution with the getters, in the order of the
+ * 		former poll_gnss(), runs in its own process
+ *
+ */
+void ubx_getters(void)
+{
+	ubx_boot(false);
+	for (uint32_t epoch = 0; epoch < results->epochs; epoch++)
+	{
+		ubx_wait(epoch, 300);
+		ubx_read_s *read = &results->getters[epoch];
+		uint32_t start = ubx_i2c();
+		read->lat = my_gnss.getLatitude();
+		read->lon = my_gnss.getLongitude();
+		read->height = my_gnss.getAltitude();
+		uint32_t dop_start = ubx_i2c();
+		read->hdop = my_gnss.getHorizontalDOP();
+		read->dop_i2c = ubx_i2c() - dop_start;
+		read->satellites = my_gnss.getSIV();
+		read->fix_type = my_gnss.getFixType();
+		read->fix_ok = my_gnss.getGnssFixOk();
+		read->pvt_i2c = ubx_i2c() - start - read->dop_i2c;
+		read->read = true;
+	}
+}
+
+/**
+ * @brief Read each solution into a snapshot, polled, runs in its own process
+ *
+ */
+void ubx_snapshot(void)
+{
+	ubx_boot(false);
+	for (uint32_t epoch = 0; epoch < results->epochs; epoch++)
+	{
+		ubx_wait(epoch, 300);
+		ubx_read_s *read = &results->snapshot[epoch];
+		gnss_snapshot_s snapshot;
+		memset(&snapshot, 0, sizeof(snapshot));
+		uint32_t start = ubx_i2c();
+		read->read = gnss_read_pvt(&snapshot);
+		read->pvt_i2c = ubx_i2c() - start;
+		start = ubx_i2c();
+		CHECK(gnss_read_dop(&snapshot));
+		read->dop_i2c = ubx_i2c() - start;
+		CHECK(snapshot.transactions == 2);
+		read->lat = snapshot.latitude;
+		read->lon = snapshot.longitude;
+		read->height = snapshot.altitude;
+		read->hdop = snapshot.hdop;
+		read->satellites = snapshot.satellites;
+		read->fix_type = snapshot.fix_type;
+		read->fix_ok = snapshot.fix_ok;
+	}
+}
+
+/**
+ * @brief Read each solution into a snapshot with auto PVT, once after
+ * 		it arrived and once more without a new one, runs in its own
+ * 		process
+ *
+ */
+void ubx_auto_pvt(void)
+{
+	ubx_boot(true);
+	for (uint32_t epoch = 0; epoch < results->epochs; epoch++)
+	{
+		ubx_wait(epoch, 100);
+		ubx_read_s *read = &results->auto_pvt[epoch];
+		gnss_snapshot_s snapshot;
+		memset(&snapshot, 0, sizeof(snapshot));
+		uint32_t start = ubx_i2c();
+		read->read = gnss_read_pvt(&snapshot);
+		read->pvt_i2c = ubx_i2c() - start;
+		read->lat = snapshot.latitude;
+		read->lon = snapshot.longitude;
+		read->height = snapshot.altitude;
+		read->satellites = snapshot.satellites;
+		read->fix_type = snapshot.fix_type;
+		read->fix_ok = snapshot.fix_ok;
+
+		ubx_wait(epoch, 600);
+		start = ubx_i2c();
+		CHECK(gnss_read_pvt(&snapshot));
+		read->idle_i2c = ubx_i2c() - start;
+		CHECK(snapshot.itow == results->itow[epoch]);
+	}
+}
+
+/**
+ * @brief Compare a read with the solution in the stream
+ *
+ * @param name reader
+ * @param epoch solution
+ * @param read values read
+ * @param hdop compare the HDOP
+ */
+void ubx_compare(const char *name, uint32_t epoch, ubx_read_s *read, bool hdop)
+{
+	ubx_solution_s solution;
+	ubx_make_solution((results->itow[epoch] - UBX_ITOW0) / 1000, &solution);
+	bool equal = read->read && (read->lat == solution.lat) && (read->lon == solution.lon) && (read->height == solution.height) &&
+				 (read->satellites == solution.satellites) && (read->fix_type == solution.fix_type) && (read->fix_ok == solution.fix_ok) &&
+				 (!hdop || (read->hdop == solution.hdop));
+	if (!equal)
+	{
+		fprintf(stderr, "%s: solution %u: lat %d lon %d height %d sv %u fix %u ok %d hdop %u\n", name,
+				(results->itow[epoch] - UBX_ITOW0) / 1000, read->lat, read->lon, read->height, read->satellites,
+				read->fix_type, read->fix_ok, read->hdop);
+		CHECK(equal);
+	}
+}
+
+/**
+ * @brief Print the mean I2C transactions of a reader
+ *
+ * @param name reader
+ * @param reads reads of all solutions
+ * @param dop with the NAV-DOP
+ */
+void ubx_print(const char *name, ubx_read_s *reads, bool dop)
+{
+	uint64_t pvt = 0;
+	uint64_t dop_i2c = 0;
+	for (uint32_t epoch = 0; epoch < results->epochs; epoch++)
+	{
+		pvt += reads[epoch].pvt_i2c;
+		dop_i2c += dop ? reads[epoch].dop_i2c : 0;
+	}
+	printf("  %-28s %8.2f %8.2f %8.2f\n", name, (double)pvt / results->epochs, (double)dop_i2c / results->epochs,
+		   (double)(pvt + dop_i2c) / results->epochs);
+}
+
+int main(int argc, char **argv)
+{
+	results = (ubx_results_s *)mmap(NULL, sizeof(ubx_results_s), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	CHECK(results != MAP_FAILED);
+	memset(results, 0, sizeof(ubx_results_s));
+	ubx_make_stream();
+
+	fw_fresh(ubx_getters);
+	fw_fresh(ubx_snapshot);
+	fw_fresh(ubx_auto_pvt);
+
+	// The broken NAV-PVT is dropped, all others are replayed
+	CHECK(results->epochs == UBX_SOLUTIONS - 1);
+	CHECK(results->errors == 1);
+
+	// Polled NAV-PVT: request, bytes available, message in 32 byte chunks
+	uint32_t pvt_i2c = 2 + (HOST_UBX_NAV_PVT_SIZE + HOST_GNSS_I2C_CHUNK - 1) / HOST_GNSS_I2C_CHUNK;
+	uint32_t dop_i2c = 2 + (HOST_UBX_NAV_DOP_SIZE + HOST_GNSS_I2C_CHUNK - 1) / HOST_GNSS_I2C_CHUNK;
+	for (uint32_t epoch = 0; epoch < results->epochs; epoch++)
+	{
+		ubx_compare("getters", epoch, &results->getters[epoch], true);
+		ubx_compare("snapshot", epoch, &results->snapshot[epoch], true);
+		ubx_compare("auto PVT", epoch, &results->auto_pvt[epoch], false);
+
+		CHECK(results->snapshot[epoch].pvt_i2c == pvt_i2c);
+		CHECK(results->snapshot[epoch].dop_i2c == dop_i2c);
+		CHECK(results->snapshot[epoch].pvt_i2c + results->snapshot[epoch].dop_i2c <=
+			  results->getters[epoch].pvt_i2c + results->getters[epoch].dop_i2c);
+		CHECK(results->auto_pvt[epoch].pvt_i2c == pvt_i2c - 1);
+		CHECK(results->auto_pvt[epoch].idle_i2c == 1);
+	}
+
+	printf("%u solutions from %u UBX bytes, %u dropped message\n", results->epochs, (uint32_t)ubx_stream.size(), results->errors);
+	printf("I2C transactions per solution      NAV-PVT  NAV-DOP    total\n");
+	ubx_print("getters (7 values)", results->getters, true);
+	ubx_print("snapshot", results->snapshot, true);
+	ubx_print("snapshot, policy w/o HDOP", results->snapshot, false);
+	ubx_print("auto PVT, new solution", results->auto_pvt, false);
+	uint64_t idle = 0;
+	for (uint32_t epoch = 0; epoch < results->epochs; epoch++)
+	{
+		idle += results->auto_pvt[epoch].idle_i2c;
+	}
+	printf("  %-28s %8.2f %8.2f %8.2f\n", "auto PVT, no new solution", (double)idle / results->epochs, 0.0,
+		   (double)idle / results->epochs);
+	return host_test_result("fw_gnss_ubx");
+}
@@ -0,0 +1,317 @@
+/**
+ * @file test_fw_jobs.cpp
+ * @author Bernd Giesecke (bernd@giesecke.tk)
+ * @brief A day of events replayed on the virtual clock. The firmware
+ * 		runs for 24 hours in FieldTester V2 mode with location, a
+ * 		script presses the button, sends AT commands and switches the
+ * 		network off and on. All send, display, display saver and GNSS
+ * 		work runs as jobs in mtmMain, started and stopped through the
+ * 		event queue. Checked are the uplinks of each send interval,
+ * 		that every downlink is shown and logged once, the display
+ * 		saver, and that no event is dropped. The runs, run times and
+ * 		start delays of the jobs on the virtual clock are printed.
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include "fw_test.h"
+#include <vector>
+
+/** Duration of the replay (s) */
+#define DAY_TIME 86400
+/** GNSS epochs, one per second */
+#define DAY_EPOCHS (DAY_TIME + 1)
+/** Longest pause of the uplinks beyond the send interval, the settings UI is open for 30 s (ms) */
+#define DAY_SLACK 35000
+
+/** Actions of the script */
+enum day_action_t
+{
+	DAY_NETWORK_OFF = 0, // No more downlinks
+	DAY_NETWORK_ON,		 // Downlinks again
+	DAY_CLICKS,			 // Click the button
+	DAY_LONG_PRESS,		 // Hold the button for 4 s
+	DAY_AT,				 // AT command
+	DAY_DISPLAY,		 // Check if the display is on
+};
+
+/** Event of the script */
+struct day_event_s
+{
+	uint32_t time;		 // Time from power on (s)
+	uint8_t action;		 // See day_action_t
+	uint8_t value;		 // Clicks, display state
+	const char *command; // AT command
+};
+
+/** The day, sorted by time */
+static const day_event_s day_events[] = {
+	{2 * 3600, DAY_NETWORK_OFF, 0, NULL},
+	{3 * 3600, DAY_NETWORK_ON, 0, NULL},
+	{3 * 3600 + 1810, DAY_CLICKS, 3, NULL}, // Manual uplink
+	{5 * 3600, DAY_AT, 0, "ATC+SENDINT=120"},
+	{8 * 3600, DAY_CLICKS, 2, NULL},	  // Open the settings UI
+	{8 * 3600 + 30, DAY_CLICKS, 1, NULL}, // Close it without changes
+	{10 * 3600, DAY_DISPLAY, 0, NULL},	  // Display saver switched off after the UI
+	{10 * 3600, DAY_LONG_PRESS, 0, NULL}, // Display on
+	{10 * 3600 + 30, DAY_DISPLAY, 1, NULL},
+	{10 * 3600 + 90, DAY_DISPLAY, 0, NULL}, // Display saver
+	{10 * 3600 + 600, DAY_LONG_PRESS, 0, NULL},
+	{10 * 3600 + 620, DAY_LONG_PRESS, 0, NULL}, // Display off before the saver
+	{10 * 3600 + 630, DAY_DISPLAY, 0, NULL},
+	{12 * 3600, DAY_AT, 0, "ATC+SENDINT=60"},
+	{16 * 3600, DAY_AT, 0, "ATC+LOGS=n,5"},
+	{20 * 3600, DAY_CLICKS, 3, NULL}, // Manual uplink
+};
+#define DAY_EVENTS (sizeof(day_events) / sizeof(day_events[0]))
+
+/** Send intervals of the day */
+struct day_phase_s
+{
+	uint32_t start;	   // Time from power on (s)
+	uint32_t end;	   // Time from power on (s)
+	uint32_t interval; // Send interval (ms)
+	uint8_t manual;	   // Manual uplinks
+};
+static const day_phase_s day_phases[] = {
+	{0, 5 * 3600, 60000, 1},
+	{5 * 3600, 12 * 3600, 120000, 0},
+	{12 * 3600, DAY_TIME, 60000, 1},
+};
+#define DAY_PHASES (sizeof(day_phases) / sizeof(day_phases[0]))
+
+static host_gnss_epoch_s day_epochs[DAY_EPOCHS];
+
+/** Network answers the uplinks */
+static bool network_on = true;
+/** Time of each uplink (ms) */
+static std::vector<uint32_t> uplink_times;
+/** Downlinks sent by the network */
+static uint32_t downlinks = 0;
+
+/**
+ * @brief Network, records the uplinks and answers them with a
+ * 		FieldTester V2 downlink while it is on
+ *
+ * @param fport fPort of the uplink
+ * @param payload uplink
+ * @param length size of the uplink
+ * @param rx downlink to fill
+ * @return true downlink is sent
+ */
+bool day_network(uint8_t fport, uint8_t *payload, uint8_t length, SERVICE_LORA_RECEIVE_T *rx)
+{
+	static uint8_t downlink[FT_V2_DL_SIZE];
+	if ((fport != 1) || (length == 0))
+	{
+		return false;
+	}
+	uplink_times.push_back(millis());
+	if (!network_on)
+	{
+		return false;
+	}
+	downlinks++;
+	memset(downlink, 0, sizeof(downlink));
+	downlink[1] = 5;
+	downlink[2] = 200 - 60 - (downlinks % 40);
+	downlink[3] = 2;
+	downlink[4] = 8;
+	downlink[5] = 0x20 | ((downlinks >> 8) & 0x0F);
+	downlink[6] = downlinks & 0xFF;
+	downlink[7] = 200 + 7;
+	rx->Port = 2;
+	rx->RxDatarate = 3;
+	rx->Buffer = downlink;
+	rx->BufferSize = sizeof(downlink);
+	rx->Rssi = -90;
+	rx->Snr = 6;
+	return true;
+}
+
+/**
+ * @brief GNSS replay, a 3D fix that moves every second
+ *
+ */
+void make_day_epochs(void)
+{
+	memset(day_epochs, 0, sizeof(day_epochs));
+	for (uint32_t idx = 0; idx < DAY_EPOCHS; idx++)
+	{
+		host_gnss_epoch_s *epoch = &day_epochs[idx];
+		epoch->time = idx * 1000;
+		epoch->pvt.iTOW = idx * 1000;
+		epoch->pvt.fixType = 3;
+		epoch->pvt.flags.bits.gnssFixOK = 1;
+		epoch->pvt.numSV = 9;
+		epoch->pvt.lat = 144215360 + (idx % 3600) * 10;
+		epoch->pvt.lon = 1210068190 - (idx % 3600) * 10;
+		epoch->pvt.hAcc = 3000;
+		epoch->pvt.pDOP = 120;
+		epoch->hdop = 90;
+	}
+	host_gnss.epochs = day_epochs;
+	host_gnss.num_epochs = DAY_EPOCHS;
+}
+
+/**
+ * @brief Click the button, each click is 150 ms down and 150 ms up
+ *
+ * @param clicks number of clicks
+ */
+void day_clicks(uint8_t clicks)
+{
+	for (uint8_t click = 0; click < clicks; click++)
+	{
+		host_set_pin(BUTTON_INT_PIN, LOW);
+		fw_run(150);
+		host_set_pin(BUTTON_INT_PIN, HIGH);
+		fw_run(150);
+	}
+}
+
+/**
+ * @brief Number of log rows, sent as CSV for ATC+LOGS=n
+ *
+ * @return uint32_t number of rows
+ */
+uint32_t day_log_rows(void)
+{
+	String csv;
+	Serial.capture = &csv;
+	CHECK(host_at_command("ATC+LOGS=n,5000") == AT_OK);
+	Serial.capture = NULL;
+	uint32_t rows = 0;
+	for (size_t pos = csv.find("\n2026-"); pos != std::string::npos; pos = csv.find("\n2026-", pos + 1))
+	{
+		rows++;
+	}
+	return rows;
+}
+
+int main(int argc, char **argv)
+{
+	fw_power_on(fw_full_board, "build/sd_jobs");
+	make_day_epochs();
+	host_radio.downlink = day_network;
+	host_set_pin(BUTTON_INT_PIN, HIGH);
+
+	g_custom_parameters.test_mode = MODE_FIELDTESTER_V2;
+	g_custom_parameters.send_interval = day_phases[0].interval;
+	g_custom_parameters.location_on = true;
+	g_custom_parameters.display_saver = true;
+	g_custom_parameters.log_max_rows = 300;
+	CHECK(save_at_setting());
+	setup();
+	CHECK(has_oled && has_rtc && has_gnss && has_sd);
+
+	for (uint8_t idx = 0; idx < DAY_EVENTS; idx++)
+	{
+		const day_event_s *event = &day_events[idx];
+		fw_run(event->time * 1000 - millis());
+		switch (event->action)
+		{
+		case DAY_NETWORK_OFF:
+			network_on = false;
+			break;
+		case DAY_NETWORK_ON:
+			network_on = true;
+			break;
+		case DAY_CLICKS:
+		{
+			size_t uplinks = uplink_times.size();
+			day_clicks(event->value);
+			if (event->value == 3)
+			{
+				// Manual uplink
+				fw_run(5000);
+				CHECK(uplink_times.size() == uplinks + 1);
+			}
+			break;
+		}
+		case DAY_LONG_PRESS:
+			host_set_pin(BUTTON_INT_PIN, LOW);
+			fw_run(4000);
+			host_set_pin(BUTTON_INT_PIN, HIGH);
+			fw_run(500);
+			break;
+		case DAY_AT:
+		{
+			String answer;
+			Serial.capture = &answer;
+			CHECK(host_at_command(event->command) == AT_OK);
+			Serial.capture = NULL;
+			break;
+		}
+		case DAY_DISPLAY:
+			if (host_oled.on != (event->value != 0))
+			{
+				fprintf(stderr, "display at %u s is %s\n", event->time, host_oled.on ? "on" : "off");
+				CHECK(host_oled.on == (event->value != 0));
+			}
+			break;
+		}
+	}
+	fw_run(DAY_TIME * 1000 - millis());
+	close_sd_file();
+
+	// Uplinks of each send interval, no pause longer than the interval and the settings UI
+	printf("Uplinks in %d h\n", DAY_TIME / 3600);
+	printf("  %6s %6s %9s %8s %8s %12s\n", "from h", "to h", "interval", "uplinks", "expected", "max gap (s)");
+	for (uint8_t phase = 0; phase < DAY_PHASES; phase++)
+	{
+		const day_phase_s *range = &day_phases[phase];
+		uint32_t uplinks = 0;
+		uint32_t max_gap = 0;
+		uint32_t prev = 0;
+		for (size_t idx = 0; idx < uplink_times.size(); idx++)
+		{
+			uint32_t time = uplink_times[idx];
+			if ((time < range->start * 1000) || (time >= range->end * 1000))
+			{
+				continue;
+			}
+			if (uplinks != 0)
+			{
+				max_gap = max(max_gap, time - prev);
+			}
+			prev = time;
+			uplinks++;
+		}
+		uint32_t expected = (range->end - range->start) * 1000 / range->interval + range->manual;
+		printf("  %6u %6u %9u %8u %8u %12.1f\n", range->start / 3600, range->end / 3600, range->interval / 1000, uplinks,
+			   expected, max_gap / 1000.0);
+		CHECK(uplinks + 2 >= expected);
+		CHECK(uplinks <= expected + 1);
+		CHECK(max_gap <= range->interval + DAY_SLACK);
+	}
+
+	// Every downlink was shown and logged once, nothing was dropped
+	uint32_t rows = day_log_rows();
+	CHECK(rows == downlinks);
+	CHECK(downlinks < uplink_times.size());
+	CHECK(peek_radio_event() == NULL);
+	CHECK(event_queue_dropped == 0);
+	CHECK(radio_event_dropped == 0);
+	CHECK(log_queue_dropped == 0);
+	CHECK(host_radio.sleep_us * 10 > host_clock_us * 9);
+
+	printf("Jobs and tasks\n");
+	printf("  %-14s %8s %13s %13s %14s\n", "job", "runs", "max cost (ms)", "avg cost (ms)", "max delay (ms)");
+	for (uint16_t idx = 0; idx < mtmMain.GetCount(); idx++)
+	{
+		MillisTaskManager::Task_t *task = mtmMain.GetTask(idx);
+		const char *name = job_name(task->Function);
+		if (name == NULL)
+		{
+			name = task->Function == sd_writer_task ? "sd_writer" : "button";
+		}
+		printf("  %-14s %8u %13.1f %13.1f %14u\n", name, task->Stats.Runs, task->Stats.CostMax / 1000.0,
+			   task->Stats.Runs != 0 ? task->Stats.CostSum / 1000.0 / task->Stats.Runs : 0.0, task->Stats.ErrorMax);
+	}
+	printf("uplinks %u, downlinks %u, rows %u, sleep %.1f%%\n", (uint32_t)uplink_times.size(), downlinks, rows,
+		   100.0 * host_radio.sleep_us / host_clock_us);
+	return host_test_result("fw_jobs");
+}
@@ -0,0 +1,317 @@
+/**
+ * @file test_fw_motion.cpp
+ * @author Bernd Giesecke (bernd@giesecke.tk)
+ * @brief Motion gate. The decision of motion_skip_send() is checked
+ * 		for each condition alone. Then the firmware runs with the gate
+ * 		on in FieldTester V2 mode with location: uplinks are skipped
+ * 		while the device does not move, an interrupt of the LIS3DH
+ * 		sends at once and starts the send interval again, the latched
+ * 		interrupt is cleared, manual uplinks are never skipped and do
+ * 		not open the gate for the next ones, and with the gate switched
+ * 		off over ATC+MOTION every uplink is sent again. LinkCheck, P2P
+ * 		and FieldTester without location must send every interval with
+ * 		the gate on.
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include "fw_test.h"
+#include <vector>
+
+/** Send interval (ms) */
+#define MOTION_INTERVAL 60000
+/** Time between the send job and the uplink, the fix is there at once (ms) */
+#define MOTION_SEND_TIME 3000
+/** GNSS epochs, one per second */
+#define MOTION_EPOCHS 1801
+
+/** Motion gate state of acc.cpp */
+extern LIS3DH acc_sensor;
+extern volatile bool motion_since_send;
+extern bool send_skipped;
+
+/** Conditions of motion_skip_send() */
+struct motion_case_s
+{
+	const char *name;
+	uint8_t mode;
+	bool gate;
+	bool acc;
+	bool location_on;
+	bool forced;
+	bool sweep;
+	bool acquisition;
+	bool motion;
+	bool last_location;
+	bool skip;		   // Expected result
+	bool motion_after; // Expected motion flag after the check
+};
+
+/** Each condition alone, the first case skips */
+static const motion_case_s motion_cases[] = {
+	{"no motion", MODE_FIELDTESTER_V2, true, true, true, false, false, false, false, true, true, false},
+	{"no motion FieldTester", MODE_FIELDTESTER, true, true, true, false, false, false, false, true, true, false},
+	{"motion", MODE_FIELDTESTER_V2, true, true, true, false, false, false, true, true, false, false},
+	{"no location yet", MODE_FIELDTESTER_V2, true, true, true, false, false, false, false, false, false, false},
+	{"gate off", MODE_FIELDTESTER_V2, false, true, true, false, false, false, false, true, false, false},
+	{"gate off, motion", MODE_FIELDTESTER_V2, false, true, true, false, false, false, true, true, false, true},
+	{"no ACC", MODE_FIELDTESTER_V2, true, false, true, false, false, false, false, true, false, false},
+	{"location off", MODE_FIELDTESTER_V2, true, true, false, false, false, false, false, true, false, false},
+	{"manual uplink", MODE_FIELDTESTER_V2, true, true, true, true, false, false, false, true, false, false},
+	{"DR sweep", MODE_FIELDTESTER_V2, true, true, true, false, true, false, false, true, false, false},
+	{"acquisition", MODE_FIELDTESTER_V2, true, true, true, false, false, true, false, true, false, false},
+	{"LinkCheck", MODE_LINKCHECK, true, true, true, false, false, false, false, true, false, false},
+	{"P2P", MODE_P2P, true, true, true, false, false, false, false, true, false, false},
+};
+#define MOTION_CASES (sizeof(motion_cases) / sizeof(motion_cases[0]))
+
+static host_gnss_epoch_s motion_epochs[MOTION_EPOCHS];
+
+/** Time of each FieldTester uplink (ms) */
+static std::vector<uint32_t> uplink_times;
+
+/** Test mode and location of the mode run */
+static uint8_t motion_mode = MODE_LINKCHECK;
+static bool motion_location = true;
+
+/**
+ * @brief Network, records the FieldTester uplinks, no downlinks
+ *
+ * @param fport fPort of the uplink
+ * @param payload uplink
+ * @param length size of the uplink
+ * @param rx downlink to fill
+ * @return false no downlink
+ */
+bool motion_network(uint8_t fport, uint8_t *payload, uint8_t length, SERVICE_LORA_RECEIVE_T *rx)
+{
+	if ((fport == 1) && (length != 0))
+	{
+		uplink_times.push_back(millis());
+	}
+	return false;
+}
+
+/**
+ * @brief Boot with the motion gate on and a 3D fix from the start
+ *
+ * @param mode test mode
+ * @param location_on location on or off
+ */
+void motion_boot(uint8_t mode, bool location_on)
+{
+	fw_power_on(fw_full_board, "build/sd_motion");
+	memset(motion_epochs, 0, sizeof(motion_epochs));
+	for (uint32_t idx = 0; idx < MOTION_EPOCHS; idx++)
+	{
+		host_gnss_epoch_s *epoch = &motion_epochs[idx];
+		epoch->time = idx * 1000;
+		epoch->pvt.iTOW = idx * 1000;
+		epoch->pvt.fixType = 3;
+		epoch->pvt.flags.bits.gnssFixOK = 1;
+		epoch->pvt.numSV = 9;
+		epoch->pvt.lat = 144215360;
+		epoch->pvt.lon = 1210068190;
+		epoch->pvt.hAcc = 3000;
+		epoch->pvt.pDOP = 120;
+		epoch->hdop = 90;
+	}
+	host_gnss.epochs = motion_epochs;
+	host_gnss.num_epochs = MOTION_EPOCHS;
+	host_radio.downlink = motion_network;
+	host_set_pin(BUTTON_INT_PIN, HIGH);
+	host_set_pin(ACC_INT_PIN, LOW);
+	uplink_times.clear();
+
+	g_custom_parameters.test_mode = mode;
+	g_custom_parameters.send_interval = MOTION_INTERVAL;
+	g_custom_parameters.location_on = location_on;
+	g_custom_parameters.motion_gate = true;
+	CHECK(save_at_setting());
+	setup();
+	CHECK(has_acc);
+}
+
+/**
+ * @brief The device moves, the LIS3DH latches Z high and raises its
+ * 		interrupt pin
+ *
+ */
+void motion_move(void)
+{
+	acc_sensor.registers[LIS3DH_INT1_SRC] = 0x60;
+	host_set_pin(ACC_INT_PIN, HIGH);
+	fw_run(100);
+	host_set_pin(ACC_INT_PIN, LOW);
+}
+
+/**
+ * @brief Click the button three times for a manual uplink
+ *
+ */
+void motion_manual_uplink(void)
+{
+	for (uint8_t click = 0; click < 3; click++)
+	{
+		host_set_pin(BUTTON_INT_PIN, LOW);
+		fw_run(150);
+		host_set_pin(BUTTON_INT_PIN, HIGH);
+		fw_run(150);
+	}
+}
+
+/**
+ * @brief Each condition of motion_skip_send() alone, runs in its own process
+ *
+ */
+void motion_decision(void)
+{
+	motion_boot(MODE_FIELDTESTER_V2, true);
+	fw_run(10000);
+	CHECK(!gnss_active);
+
+	for (uint8_t idx = 0; idx < MOTION_CASES; idx++)
+	{
+		const motion_case_s *test = &motion_cases[idx];
+		g_custom_parameters.test_mode = test->mode;
+		g_custom_parameters.motion_gate = test->gate;
+		g_custom_parameters.location_on = test->location_on;
+		has_acc = test->acc;
+		forced_tx = test->forced;
+		dr_sweep_active = test->sweep;
+		gnss_active = test->acquisition;
+		motion_since_send = test->motion;
+		g_last_lat = test->last_location ? 14.421536 : 0.0;
+		g_last_long = test->last_location ? 121.006819 : 0.0;
+		send_skipped = false;
+
+		bool skip = motion_skip_send();
+		if ((skip != test->skip) || (send_skipped != test->skip) || (motion_since_send != test->motion_after))
+		{
+			fprintf(stderr, "%s: skip %d, skipped flag %d, motion %d\n", test->name, skip, send_skipped, motion_since_send);
+		}
+		CHECK(skip == test->skip);
+		CHECK(send_skipped == test->skip);
+		CHECK(motion_since_send == test->motion_after);
+	}
+	forced_tx = false;
+	dr_sweep_active = false;
+	gnss_active = false;
+}
+
+/**
+ * @brief Uplinks with the motion gate on and after it was switched off,
+ * 		runs in its own process
+ *
+ */
+void motion_gate(void)
+{
+	motion_boot(MODE_FIELDTESTER_V2, true);
+
+	// The first uplink is sent, there is no location before it
+	fw_run(MOTION_INTERVAL + MOTION_SEND_TIME);
+	CHECK(!uplink_times.empty());
+	CHECK((g_last_lat != 0) && (g_last_long != 0));
+	size_t uplinks = uplink_times.size();
+
+	// No motion, no uplinks
+	fw_run(5 * MOTION_INTERVAL);
+	CHECK(uplink_times.size() == uplinks);
+	CHECK(send_skipped);
+	printf("  %-36s %8u\n", "skipped, 5 intervals", (uint32_t)(uplink_times.size() - uplinks));
+
+	// Motion sends at once and clears the interrupt
+	uint32_t moved = millis();
+	motion_move();
+	fw_run(MOTION_SEND_TIME);
+	CHECK(uplink_times.size() == uplinks + 1);
+	CHECK(acc_sensor.registers[LIS3DH_INT1_SRC] == 0);
+	CHECK(!send_skipped);
+	printf("  %-36s %8u\n", "motion, sent at once", (uint32_t)(uplink_times.size() - uplinks));
+	uplinks = uplink_times.size();
+
+	// Motion while nothing was skipped only flags it for the next uplink
+	fw_run(MOTION_INTERVAL / 2);
+	motion_move();
+	fw_run(MOTION_SEND_TIME);
+	CHECK(uplink_times.size() == uplinks);
+	CHECK(acc_sensor.registers[LIS3DH_INT1_SRC] == 0);
+
+	// The send interval started again with the uplink on motion
+	fw_run(moved + MOTION_INTERVAL + MOTION_SEND_TIME - millis());
+	CHECK(uplink_times.size() == uplinks + 1);
+	CHECK(uplink_times.back() >= moved + MOTION_INTERVAL);
+	CHECK(uplink_times.back() < moved + MOTION_INTERVAL + MOTION_SEND_TIME);
+	printf("  %-36s %8u\n", "moved in interval, sent on time", (uint32_t)(uplink_times.size() - uplinks));
+	uplinks = uplink_times.size();
+
+	// No motion, skipped again, but a manual uplink is sent
+	fw_run(2 * MOTION_INTERVAL);
+	CHECK(uplink_times.size() == uplinks);
+	CHECK(send_skipped);
+	motion_manual_uplink();
+	fw_run(5000);
+	CHECK(uplink_times.size() == uplinks + 1);
+	CHECK(!forced_tx);
+	printf("  %-36s %8u\n", "no motion, manual uplink", (uint32_t)(uplink_times.size() - uplinks));
+	uplinks = uplink_times.size();
+
+	// The manual uplink does not open the gate for the next ones
+	fw_run(2 * MOTION_INTERVAL);
+	CHECK(uplink_times.size() == uplinks);
+	CHECK(send_skipped);
+
+	// Gate off, every interval is sent without motion
+	String answer;
+	Serial.capture = &answer;
+	CHECK(host_at_command("ATC+MOTION=0") == AT_OK);
+	Serial.capture = NULL;
+	CHECK(!has_acc);
+	fw_run(3 * MOTION_INTERVAL + MOTION_SEND_TIME);
+	CHECK(uplink_times.size() >= uplinks + 3);
+	CHECK(uplink_times.size() <= uplinks + 4);
+	printf("  %-36s %8u\n", "gate off, 3 intervals", (uint32_t)(uplink_times.size() - uplinks));
+
+	CHECK(event_queue_dropped == 0);
+}
+
+/**
+ * @brief Uplinks with the gate on in the modes it does not gate,
+ * 		runs in its own process
+ *
+ */
+void motion_modes(void)
+{
+	motion_boot(motion_mode, motion_location);
+	fw_run(MOTION_INTERVAL + MOTION_SEND_TIME);
+	uint32_t uplinks = host_radio.uplinks;
+	uint32_t p2p_sends = host_radio.p2p_sends;
+
+	fw_run(5 * MOTION_INTERVAL);
+	uint32_t sent = motion_mode == MODE_P2P ? host_radio.p2p_sends - p2p_sends : host_radio.uplinks - uplinks;
+	CHECK(sent >= 5);
+	CHECK(!send_skipped);
+	const char *names[] = {"LinkCheck", "P2P", "FieldTester", "FieldTester V2"};
+	char name[48];
+	snprintf(name, sizeof(name), "%s%s, 5 intervals", names[motion_mode], motion_location ? "" : " indoor");
+	printf("  %-36s %8u\n", name, sent);
+}
+
+int main(int argc, char **argv)
+{
+	fw_fresh(motion_decision);
+	printf("Uplinks with the motion gate on\n");
+	printf("  %-36s %8s\n", "phase", "uplinks");
+	fw_fresh(motion_gate);
+
+	const uint8_t modes[] = {MODE_LINKCHECK, MODE_P2P, MODE_FIELDTESTER_V2};
+	for (uint8_t run = 0; run < sizeof(modes); run++)
+	{
+		motion_mode = modes[run];
+		motion_location = motion_mode != MODE_FIELDTESTER_V2;
+		fw_fresh(motion_modes);
+	}
+	return host_test_result("fw_motion");
+}
@@ -0,0 +1,218 @@
+/**
+ * @file test_fw_radio.cpp
+ * @author Bernd Giesecke (bernd@giesecke.tk)
+ * @brief Bursts of radio callbacks. The callbacks are called back to
+ * 		back like from the radio interrupt, part of a burst before and
+ * 		part after the display job ran, in LoRa P2P mode with received
+ * 		packets and in LinkCheck mode with send done, send failed and
+ * 		LinkCheck answers. Each event that is logged carries a tag in
+ * 		the lost packet counter. The log must hold the tag of every
+ * 		event that was queued, once and in order, and every event that
+ * 		did not fit into the radio event queue must be counted in
+ * 		radio_event_dropped.
+ * 		Call with the number of bursts per mode as argument, default is 200.
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include "fw_test.h"
+#include <vector>
+
+/** Longest burst */
+#define BURST_MAX (RADIO_EVENT_QUEUE_SIZE + 4)
+/** Highest log file number read */
+#define BURST_MAX_FILES 20
+
+/** Radio callbacks of the .ino */
+void send_cb_lpw(int32_t status);
+void linkcheck_cb_lpw(SERVICE_LORA_LINKCHECK_T *data);
+void recv_cb_p2p(rui_lora_p2p_recv_t data);
+/** tx_active of the .ino */
+extern volatile bool tx_active;
+
+/** Callbacks of a burst */
+enum burst_callback_t
+{
+	BURST_P2P_RX = 0,	 // Received P2P packet, logged
+	BURST_TX_DONE,		 // LoRaWAN send done, not logged
+	BURST_TX_FAILED,	 // LoRaWAN send failed, logged
+	BURST_LINKCHECK,	 // LinkCheck answer, logged
+};
+
+/** Number of bursts per mode */
+static uint32_t bursts = 200;
+
+/**
+ * @brief Call a radio callback like the radio interrupt does
+ *
+ * @param callback see burst_callback_t
+ * @param tag lost packet counter of the event
+ */
+void burst_callback(uint8_t callback, int32_t tag)
+{
+	switch (callback)
+	{
+	case BURST_P2P_RX:
+	{
+		uint8_t packet[] = {0x01, 0x02, 0x03, 0x04};
+		packet_lost = tag;
+		rui_lora_p2p_recv_t data = {packet, sizeof(packet), -70, 9};
+		recv_cb_p2p(data);
+		break;
+	}
+	case BURST_TX_DONE:
+		tx_active = true;
+		send_cb_lpw(0);
+		break;
+	case BURST_TX_FAILED:
+		// The callback counts the failed packet
+		packet_lost = tag - 1;
+		send_cb_lpw(-1);
+		break;
+	case BURST_LINKCHECK:
+	{
+		packet_lost = tag;
+		SERVICE_LORA_LINKCHECK_T answer = {0};
+		answer.State = 0;
+		answer.DemodMargin = 20;
+		answer.NbGateways = 2;
+		answer.Rssi = -80;
+		answer.Snr = 5;
+		linkcheck_cb_lpw(&answer);
+		break;
+	}
+	}
+}
+
+/**
+ * @brief Lost packet counters of all log rows, in file order
+ *
+ * @param tags filled with the counters
+ */
+void burst_log_tags(std::vector<int32_t> &tags)
+{
+	tags.clear();
+	for (uint16_t file_num = 0; file_num < BURST_MAX_FILES; file_num++)
+	{
+		char name[16];
+		snprintf(name, sizeof(name), "%04d-LOG.BIN", file_num);
+		std::string content;
+		if (!fw_read_file((host_sd.root + "/" + name).c_str(), content) || (content.size() < sizeof(log_header_s)))
+		{
+			continue;
+		}
+		log_header_s header;
+		memcpy(&header, content.data(), sizeof(log_header_s));
+		CHECK(header.magic == LOG_MAGIC);
+		CHECK(sizeof(log_header_s) + header.rows * sizeof(log_record_s) <= content.size());
+		for (uint32_t row = 0; (row < header.rows) && (sizeof(log_header_s) + (row + 1) * sizeof(log_record_s) <= content.size()); row++)
+		{
+			log_record_s record;
+			memcpy(&record, content.data() + sizeof(log_header_s) + row * sizeof(log_record_s), sizeof(log_record_s));
+			CHECK(log_record_valid(&record));
+			tags.push_back(record.lost);
+		}
+	}
+}
+
+/**
+ * @brief Fire the bursts in one test mode, runs in its own process
+ *
+ * @param mode test mode, MODE_P2P or MODE_LINKCHECK
+ */
+void burst_run(uint8_t mode)
+{
+	fw_power_on(fw_full_board, "build/sd_radio");
+	g_custom_parameters.test_mode = mode;
+	g_custom_parameters.send_interval = 0;
+	g_custom_parameters.location_on = false;
+	CHECK(save_at_setting());
+	setup();
+	CHECK(has_sd);
+	// Join and the first display updates
+	fw_run(30000);
+	CHECK(peek_radio_event() == NULL);
+
+	std::vector<int32_t> expected;
+	uint32_t fired = 0;
+	uint32_t queued = 0;
+	uint32_t dropped = radio_event_dropped;
+	uint32_t longest = 0;
+	int32_t tag = 1;
+	for (uint32_t burst = 0; burst < bursts; burst++)
+	{
+		uint32_t size = host_random_range(1, BURST_MAX);
+		// Part of the burst arrives after the display job started
+		uint32_t split = host_random_range(0, size);
+		uint32_t pause = host_random_range(0, 400);
+		longest = max(longest, size);
+		for (uint32_t idx = 0; idx < size; idx++)
+		{
+			if (idx == split)
+			{
+				fw_run(pause);
+			}
+			uint8_t callback = BURST_P2P_RX;
+			if (mode == MODE_LINKCHECK)
+			{
+				callback = host_random_range(BURST_TX_DONE, BURST_LINKCHECK);
+			}
+			uint32_t before = radio_event_dropped;
+			burst_callback(callback, tag);
+			fired++;
+			if (radio_event_dropped == before)
+			{
+				queued++;
+				if (callback != BURST_TX_DONE)
+				{
+					expected.push_back(tag);
+				}
+			}
+			tag++;
+		}
+		fw_run(host_random_range(300, 2000));
+		CHECK(peek_radio_event() == NULL);
+	}
+	close_sd_file();
+
+	// Every queued event is logged once and in order, the others are counted
+	std::vector<int32_t> tags;
+	burst_log_tags(tags);
+	CHECK(tags == expected);
+	CHECK(queued + (radio_event_dropped - dropped) == fired);
+	CHECK(event_queue_dropped == 0);
+	CHECK(log_queue_dropped == 0);
+
+	printf("  %-10s %8u %8u %8u %8u %8u\n", mode == MODE_P2P ? "P2P" : "LinkCheck", bursts, fired, queued,
+		   radio_event_dropped - dropped, (uint32_t)tags.size());
+}
+
+/**
+ * @brief Bursts of received P2P packets
+ *
+ */
+void burst_p2p(void)
+{
+	burst_run(MODE_P2P);
+}
+
+/**
+ * @brief Bursts of send done, send failed and LinkCheck answers
+ *
+ */
+void burst_linkcheck(void)
+{
+	burst_run(MODE_LINKCHECK);
+}
+
+int main(int argc, char **argv)
+{
+	bursts = host_test_iterations(argc, argv, bursts);
+	printf("Radio event bursts of up to %d callbacks, queue of %d events\n", BURST_MAX, RADIO_EVENT_QUEUE_SIZE);
+	printf("  %-10s %8s %8s %8s %8s %8s\n", "mode", "bursts", "events", "queued", "dropped", "rows");
+	fw_fresh(burst_p2p);
+	fw_fresh(burst_linkcheck);
+	return host_test_result("fw_radio");
+}
@@ -0,0 +1,202 @@
+/**
+ * @file test_fw_sd_alloc.cpp
+ * @author Bernd Giesecke (bernd@giesecke.tk)
+ * @brief Allocation of the next log file on a card with ALLOC_FILES
+ * 		log files. The firmware takes the number from the index, the
+ * 		root directory is only scanned if the index is missing or
+ * 		corrupt. The former CSV logger scanned the root directory for
+ * 		every new file. The files are created directly in the directory
+ * 		of the SD card stand-in, the card accesses and the host time of
+ * 		one allocation are compared.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include "fw_test.h"
+#include "legacy/sd_card_csv.h"
+
+/** Log files on the card, the 4 digit names allow 10000, the last one is allocated by the test */
+#define ALLOC_FILES 9999
+/** Allocations through the index, the time is averaged */
+#define ALLOC_ROUNDS 100
+
+bool read_log_index(void);
+void close_log_index(void);
+
+/** Card accesses of one allocation */
+struct alloc_cost_s
+{
+	uint32_t opens;		 // Opened files and directories
+	uint32_t reads;		 // read() calls
+	uint64_t read_bytes; // Bytes read
+	double time_us;		 // Host time
+};
+
+/**
+ * @brief Start a measurement
+ *
+ * @return uint64_t host time of the start
+ */
+uint64_t alloc_start(void)
+{
+	memset(&host_sd.stats, 0, sizeof(host_sd.stats));
+	return host_time_us();
+}
+
+/**
+ * @brief End a measurement
+ *
+ * @param start host time of the start
+ * @param rounds allocations since the start
+ * @param cost filled with the accesses per allocation
+ */
+void alloc_end(uint64_t start, uint32_t rounds, alloc_cost_s *cost)
+{
+	cost->time_us = (double)(host_time_us() - start) / rounds;
+	cost->opens = host_sd.stats.opens / rounds;
+	cost->reads = host_sd.stats.reads / rounds;
+	cost->read_bytes = host_sd.stats.read_bytes / rounds;
+}
+
+/**
+ * @brief Put a file directly into the directory of the card
+ *
+ * @param name file name
+ * @param data content
+ * @param size size of the content
+ */
+void put_card_file(const char *name, const void *data, size_t size)
+{
+	std::string path = host_sd.root + "/" + name;
+	FILE *file = fopen(path.c_str(), "wb");
+	CHECK(file != NULL);
+	if (file != NULL)
+	{
+		CHECK(fwrite(data, 1, size, file) == size);
+		fclose(file);
+	}
+}
+
+/**
+ * @brief Allocation of the former CSV logger, a scan of the root
+ * 		directory for the highest NNNN-LOG.CSV
+ *
+ * @param cost filled with the accesses of one allocation
+ */
+void alloc_legacy(alloc_cost_s *cost)
+{
+	fw_power_on(fw_full_board, "build/sd_alloc_csv");
+	g_custom_parameters.test_mode = MODE_FIELDTESTER_V2;
+	char name[16];
+	const char *header = "\"time\";\"Mode\";\"Gw\"\r\n";
+	for (uint16_t file_num = 0; file_num < ALLOC_FILES; file_num++)
+	{
+		snprintf(name, sizeof(name), "%04d-LOG.CSV", file_num);
+		put_card_file(name, header, strlen(header));
+	}
+
+	uint64_t start = alloc_start();
+	CHECK(legacy_create_sd_file());
+	alloc_end(start, 1, cost);
+	snprintf(name, sizeof(name), "%04d-LOG.CSV", ALLOC_FILES);
+	CHECK(strcmp(legacy_file_name, name) == 0);
+}
+
+/**
+ * @brief Allocation of the firmware, first without an index, which
+ * 		rebuilds it from a scan, then through the index, then with a
+ * 		corrupt index
+ *
+ * @param scan filled with the accesses of an allocation with a scan
+ * @param index filled with the accesses of an allocation through the index
+ */
+void alloc_firmware(alloc_cost_s *scan, alloc_cost_s *index)
+{
+	fw_power_on(fw_full_board, "build/sd_alloc_bin");
+	char name[16];
+	struct __attribute__((packed))
+	{
+		log_header_s header;
+		log_record_s record;
+	} log_file;
+	memset(&log_file, 0, sizeof(log_file));
+	log_file.header.magic = LOG_MAGIC;
+	log_file.header.version = LOG_VERSION;
+	log_file.header.test_mode = MODE_FIELDTESTER_V2;
+	log_file.header.columns = log_columns(MODE_FIELDTESTER_V2, true);
+	log_file.header.record_size = sizeof(log_record_s);
+	log_file.header.rows = 1;
+	for (uint16_t file_num = 0; file_num < ALLOC_FILES; file_num++)
+	{
+		result_s res = result_s();
+		res.year = 2026;
+		res.month = 10;
+		res.day = 16;
+		res.mode = MODE_FIELDTESTER_V2;
+		res.min = file_num % 60;
+		log_encode_record(&res, &log_file.record);
+		snprintf(name, sizeof(name), "%04d-LOG.BIN", file_num);
+		put_card_file(name, &log_file, sizeof(log_file));
+	}
+	CHECK(mount_sd());
+
+	// No index, it is rebuilt from the files
+	uint64_t start = alloc_start();
+	CHECK(alloc_log_file() == ALLOC_FILES);
+	alloc_end(start, 1, scan);
+	log_index_entry_s entry;
+	CHECK(read_log_index_entry(ALLOC_FILES - 1, &entry));
+	CHECK(entry.rows == 1);
+
+	start = alloc_start();
+	for (uint16_t round = 0; round < ALLOC_ROUNDS; round++)
+	{
+		CHECK(alloc_log_file() == ALLOC_FILES + 1 + round);
+	}
+	alloc_end(start, ALLOC_ROUNDS, index);
+
+	// A corrupt index is rebuilt, the number of the last file + 1 is taken again
+	close_log_index();
+	uint8_t zeros[LOG_INDEX_ENTRIES] = {0};
+	put_card_file(LOG_INDEX_NAME, zeros, sizeof(zeros));
+	CHECK(!read_log_index());
+	CHECK(alloc_log_file() == ALLOC_FILES);
+}
+
+/**
+ * @brief Print a line of the comparison
+ *
+ * @param name counter
+ * @param legacy value of the former logger
+ * @param scan value of the firmware without index
+ * @param index value of the firmware with index
+ */
+void print_cost(const char *name, double legacy, double scan, double index)
+{
+	printf("  %-16s %12.1f %12.1f %12.1f\n", name, legacy, scan, index);
+}
+
+int main(int argc, char **argv)
+{
+	alloc_cost_s legacy;
+	alloc_cost_s scan;
+	alloc_cost_s index;
+	alloc_legacy(&legacy);
+	alloc_firmware(&scan, &index);
+
+	printf("Next log file with %d files    CSV scan   index lost        index\n", ALLOC_FILES);
+	print_cost("opens", legacy.opens, scan.opens, index.opens);
+	print_cost("reads", legacy.reads, scan.reads, index.reads);
+	print_cost("read bytes", legacy.read_bytes, scan.read_bytes, index.read_bytes);
+	print_cost("host time (us)", legacy.time_us, scan.time_us, index.time_us);
+
+	// The index does not open any file, the scans open every file
+	CHECK(index.opens == 0);
+	CHECK(index.reads <= 2);
+	CHECK(legacy.opens >= ALLOC_FILES);
+	CHECK(scan.opens >= ALLOC_FILES);
+	CHECK(index.time_us * 100 < legacy.time_us);
+	return host_test_result("fw_sd_alloc");
+}
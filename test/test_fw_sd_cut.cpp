@@ -0,0 +1,180 @@
+/**
+ * @file test_fw_sd_cut.cpp
+ * @author Bernd Giesecke (bernd@giesecke.tk)
+ * @brief Power cuts while logging. The firmware logs rows until the
+ * 		SD card stand-in cuts the power after a random number of bytes,
+ * 		then boots again, init_sd() recovers the log and logging goes
+ * 		on. The log on the card must hold the rows in order, each once,
+ * 		without garbage, at least all rows that were written to the card
+ * 		before the cut, and the rows logged after the reboot.
+ * 		Both boots run in their own process, see fw_fresh().
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include "fw_test.h"
+#include <sys/mman.h>
+#include <vector>
+
+/** Rows logged before the cut */
+#define CUT_ROWS 250
+/** Rows per log file */
+#define CUT_FILE_ROWS 100
+/** Rows logged after the reboot, numbered from CUT_NEW_ROW */
+#define CUT_NEW_ROWS 10
+#define CUT_NEW_ROW 10000
+/** Time between two rows (ms) */
+#define CUT_INTERVAL 5000
+/** Highest log file number checked */
+#define CUT_MAX_FILES 20
+
+/** Record queue and staging buffer of sd-card.cpp */
+extern volatile uint8_t log_queue_head;
+extern volatile uint8_t log_queue_tail;
+extern uint16_t sd_buffer_len;
+
+/** Result of the run before the cut, shared with the parent and the reboot */
+struct cut_run_s
+{
+	uint32_t queued;	  // Rows queued before the cut
+	uint32_t durable;	  // Rows written to the card before the cut
+	uint64_t write_bytes; // Bytes passed to the card in a run without cut
+};
+static cut_run_s *cut_run = NULL;
+
+/** Bytes until the power is cut, -1 = no cut */
+static int64_t cut_offset = -1;
+
+/** Number of power cuts, the reboot was checked */
+static uint32_t cuts = 0;
+/** Rows lost by the cuts, they were not yet written to the card */
+static uint64_t lost_rows = 0;
+
+/**
+ * @brief Log rows until the power is cut, runs in its own process
+ *
+ */
+void cut_write(void)
+{
+	setup();
+	CHECK(has_sd);
+	memset(&host_sd.stats, 0, sizeof(host_sd.stats));
+	host_sd.cut_after = cut_offset;
+	cut_run->queued = 0;
+	cut_run->durable = 0;
+	for (uint32_t row = 0; row < CUT_ROWS; row++)
+	{
+		fw_make_row(row, CUT_INTERVAL, &result);
+		write_sd_entry();
+		cut_run->queued++;
+		fw_run(CUT_INTERVAL);
+		if (host_sd.dead)
+		{
+			return;
+		}
+		// Rows still in the queue or the staging buffer are not on the card
+		uint8_t in_queue = (log_queue_head - log_queue_tail) & (LOG_QUEUE_SIZE - 1);
+		cut_run->durable = cut_run->queued - in_queue - sd_buffer_len / sizeof(log_record_s);
+	}
+	// The cut can still hit the last flush
+	close_sd_file();
+	if (!host_sd.dead)
+	{
+		cut_run->durable = cut_run->queued;
+	}
+	cut_run->write_bytes = host_sd.stats.write_bytes;
+}
+
+/**
+ * @brief Boot after the cut, log more rows and check the log on the
+ * 		card, runs in its own process
+ *
+ */
+void cut_recover(void)
+{
+	setup();
+	CHECK(has_sd);
+	for (uint32_t row = 0; row < CUT_NEW_ROWS; row++)
+	{
+		fw_make_row(CUT_NEW_ROW + row, CUT_INTERVAL, &result);
+		write_sd_entry();
+		fw_run(CUT_INTERVAL);
+	}
+	close_sd_file();
+
+	// Rows of all files in file order, identified by their latitude
+	std::vector<uint32_t> rows;
+	for (uint16_t file_num = 0; file_num < CUT_MAX_FILES; file_num++)
+	{
+		char name[16];
+		snprintf(name, sizeof(name), "%04d-LOG.BIN", file_num);
+		std::string content;
+		log_header_s header;
+		if (!fw_read_file((host_sd.root + "/" + name).c_str(), content) || (content.size() < sizeof(log_header_s)))
+		{
+			continue;
+		}
+		memcpy(&header, content.data(), sizeof(log_header_s));
+		if (header.magic != LOG_MAGIC)
+		{
+			// Torn header of a file created just before the cut
+			continue;
+		}
+		CHECK(sizeof(log_header_s) + header.rows * sizeof(log_record_s) <= content.size());
+		for (uint32_t row = 0; (row < header.rows) && (sizeof(log_header_s) + (row + 1) * sizeof(log_record_s) <= content.size()); row++)
+		{
+			log_record_s record;
+			memcpy(&record, content.data() + sizeof(log_header_s) + row * sizeof(log_record_s), sizeof(log_record_s));
+			CHECK(log_record_valid(&record));
+			rows.push_back((record.lat - 144215360) / 100);
+		}
+	}
+
+	// The rows before the cut in order, at least the ones on the card, then the new rows
+	CHECK(rows.size() >= cut_run->durable + CUT_NEW_ROWS);
+	CHECK(rows.size() <= cut_run->queued + CUT_NEW_ROWS);
+	uint32_t old_rows = rows.size() - CUT_NEW_ROWS;
+	for (uint32_t idx = 0; idx < rows.size(); idx++)
+	{
+		uint32_t expected = idx < old_rows ? idx : CUT_NEW_ROW + idx - old_rows;
+		if (rows[idx] != expected)
+		{
+			fprintf(stderr, "cut at %lld: row %u is %u, expected %u\n", (long long)cut_offset, idx, rows[idx], expected);
+			CHECK(rows[idx] == expected);
+			break;
+		}
+	}
+}
+
+int main(int argc, char **argv)
+{
+	uint32_t iterations = host_test_iterations(argc, argv, 100);
+	cut_run = (cut_run_s *)mmap(NULL, sizeof(cut_run_s), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	CHECK(cut_run != MAP_FAILED);
+
+	fw_power_on(fw_full_board, "build/sd_cut");
+	g_custom_parameters.test_mode = MODE_FIELDTESTER_V2;
+	g_custom_parameters.send_interval = 0;
+	g_custom_parameters.log_max_rows = CUT_FILE_ROWS;
+	CHECK(save_at_setting());
+
+	// Bytes written to the card by a run without cut
+	fw_fresh(cut_write);
+	uint64_t write_bytes = cut_run->write_bytes;
+	CHECK(write_bytes > CUT_ROWS * sizeof(log_record_s));
+
+	for (uint32_t iteration = 0; iteration < iterations; iteration++)
+	{
+		host_sd_clear();
+		cut_offset = host_random_range(0, write_bytes - 1);
+		fw_fresh(cut_write);
+		fw_fresh(cut_recover);
+		cuts++;
+		lost_rows += cut_run->queued - cut_run->durable;
+	}
+	printf("%u power cuts within %llu bytes, %.1f rows per cut not yet on the card\n", cuts,
+		   (unsigned long long)write_bytes, (double)lost_rows / cuts);
+	return host_test_result("fw_sd_cut");
+}
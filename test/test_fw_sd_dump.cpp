@@ -0,0 +1,259 @@
+/**
+ * @file test_fw_sd_dump.cpp
+ * @author Bernd Giesecke (bernd@giesecke.tk)
+ * @brief Loopback test of the bulk log dump. log_dump.py runs on a
+ * 		pseudo terminal, the test plays the device: every ATC+LOGS
+ * 		command of the receiver is run by the firmware and its output is
+ * 		sent back. One chunk is corrupted on the way, the receiver has
+ * 		to request it again. A second run resumes a file in the middle.
+ * 		The received files must match the committed part of the log
+ * 		files on the SD card stand-in. Skipped if pyserial is missing.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include "fw_test.h"
+#include <fcntl.h>
+#include <poll.h>
+#include <algorithm>
+
+/** Rows of the log, 100 rows per file */
+#define DUMP_ROWS 250
+#define DUMP_FILE_ROWS 100
+/** Time between two rows (ms) */
+#define DUMP_INTERVAL 30000
+/** Folder of the received files */
+#define DUMP_OUT "build/sd_dump_out"
+/** Longest time of a receiver run (us, host time) */
+#define DUMP_TIMEOUT 60000000ULL
+
+/** Commands sent by the receiver */
+static uint32_t dump_requests = 0;
+/** Chunks re-requested by the receiver */
+static uint32_t dump_chunk_requests = 0;
+/** Bytes sent to the receiver */
+static uint64_t dump_bytes = 0;
+
+/**
+ * @brief Corrupt the first data byte of the first chunk of a file
+ *
+ * @param output output of the firmware
+ * @param file_num file number
+ */
+void corrupt_chunk(String &output, uint16_t file_num)
+{
+	char frame[16];
+	snprintf(frame, sizeof(frame), "+CHUNK:%d,", file_num);
+	size_t pos = output.find(frame);
+	CHECK(pos != std::string::npos);
+	if (pos != std::string::npos)
+	{
+		pos = output.find("\r\n", pos) + 2;
+		output[pos] ^= 0xFF;
+	}
+}
+
+/**
+ * @brief Write all bytes to the pseudo terminal
+ *
+ * @param master master side of the pseudo terminal
+ * @param output bytes to write
+ */
+void write_all(int master, const String &output)
+{
+	size_t sent = 0;
+	while (sent < output.size())
+	{
+		ssize_t written = write(master, output.data() + sent, output.size() - sent);
+		if (written <= 0)
+		{
+			CHECK(errno == EINTR || errno == EAGAIN);
+			continue;
+		}
+		sent += written;
+	}
+	dump_bytes += sent;
+}
+
+/**
+ * @brief Run log_dump.py against the firmware
+ *
+ * @param start --start argument, NULL to dump all files
+ * @param corrupt_file a chunk of this file is corrupted in the first answer, -1 = none
+ */
+void run_receiver(const char *start, int32_t corrupt_file)
+{
+	int master = posix_openpt(O_RDWR | O_NOCTTY);
+	CHECK(master >= 0);
+	CHECK(grantpt(master) == 0);
+	CHECK(unlockpt(master) == 0);
+	const char *slave_name = ptsname(master);
+	// Keep the slave open, reads of the master fail while no slave is open
+	int slave = open(slave_name, O_RDWR | O_NOCTTY);
+	CHECK(slave >= 0);
+
+	fflush(stdout);
+	pid_t pid = fork();
+	if (pid == 0)
+	{
+		close(master);
+		int quiet = open("/dev/null", O_WRONLY);
+		dup2(quiet, STDOUT_FILENO);
+		if (start != NULL)
+		{
+			execlp("python3", "python3", "../log_dump.py", slave_name, DUMP_OUT, "--start", start, (char *)NULL);
+		}
+		else
+		{
+			execlp("python3", "python3", "../log_dump.py", slave_name, DUMP_OUT, (char *)NULL);
+		}
+		_exit(127);
+	}
+
+	std::string line;
+	int status = 0;
+	uint64_t timeout = host_time_us() + DUMP_TIMEOUT;
+	while (waitpid(pid, &status, WNOHANG) != pid)
+	{
+		if (host_time_us() > timeout)
+		{
+			fprintf(stderr, "fw_sd_dump: receiver timed out\n");
+			kill(pid, SIGKILL);
+			waitpid(pid, &status, 0);
+			host_test_failed++;
+			break;
+		}
+		pollfd poll_master = {master, POLLIN, 0};
+		if (poll(&poll_master, 1, 100) <= 0)
+		{
+			continue;
+		}
+		char buffer[256];
+		ssize_t received = read(master, buffer, sizeof(buffer));
+		for (ssize_t idx = 0; idx < received; idx++)
+		{
+			if ((buffer[idx] != '\r') && (buffer[idx] != '\n'))
+			{
+				line += buffer[idx];
+				continue;
+			}
+			if (line.compare(0, 4, "ATC+") != 0)
+			{
+				line.clear();
+				continue;
+			}
+			// A request with a length re-requests a chunk
+			dump_requests++;
+			if (std::count(line.begin(), line.end(), ',') == 3)
+			{
+				dump_chunk_requests++;
+			}
+			String output;
+			Serial.capture = &output;
+			host_at_command(line.c_str());
+			Serial.capture = NULL;
+			if (corrupt_file >= 0)
+			{
+				corrupt_chunk(output, corrupt_file);
+				corrupt_file = -1;
+			}
+			write_all(master, output);
+			line.clear();
+		}
+	}
+	CHECK(WIFEXITED(status) && (WEXITSTATUS(status) == 0));
+	close(slave);
+	close(master);
+}
+
+/**
+ * @brief Compare a received file with the committed part of the log file
+ *
+ * @param file_num file number
+ * @return uint32_t rows of the file
+ */
+uint32_t compare_file(uint16_t file_num)
+{
+	char name[16];
+	snprintf(name, sizeof(name), "%04d-LOG.BIN", file_num);
+	std::string card;
+	std::string received;
+	CHECK(fw_read_file((host_sd.root + "/" + name).c_str(), card));
+	CHECK(fw_read_file((std::string(DUMP_OUT) + "/" + name).c_str(), received));
+	if (card.size() < sizeof(log_header_s))
+	{
+		return 0;
+	}
+	log_header_s header;
+	memcpy(&header, card.data(), sizeof(log_header_s));
+	card.resize(sizeof(log_header_s) + header.rows * sizeof(log_record_s));
+	CHECK(received == card);
+	return header.rows;
+}
+
+int main(int argc, char **argv)
+{
+	if (system("python3 -c 'import serial' 2>/dev/null") != 0)
+	{
+		printf("fw_sd_dump: skipped, python3 with pyserial is needed\n");
+		return 0;
+	}
+
+	fw_power_on(fw_full_board, "build/sd_dump");
+	g_custom_parameters.test_mode = MODE_FIELDTESTER_V2;
+	g_custom_parameters.send_interval = 0;
+	g_custom_parameters.log_max_rows = DUMP_FILE_ROWS;
+	CHECK(save_at_setting());
+	setup();
+	CHECK(has_sd);
+	for (uint32_t row = 0; row < DUMP_ROWS; row++)
+	{
+		fw_make_row(row, DUMP_INTERVAL, &result);
+		write_sd_entry();
+		fw_run(DUMP_INTERVAL);
+	}
+	uint16_t files = (DUMP_ROWS + DUMP_FILE_ROWS - 1) / DUMP_FILE_ROWS;
+	fw_clear_dir(DUMP_OUT);
+
+	// All files, a corrupt chunk of the second file is requested again
+	run_receiver(NULL, 1);
+	CHECK(dump_chunk_requests == 1);
+	uint32_t rows = 0;
+	for (uint16_t file_num = 0; file_num < files; file_num++)
+	{
+		rows += compare_file(file_num);
+	}
+	CHECK(rows == DUMP_ROWS);
+	printf("%d files, %u rows, %u requests, %llu bytes sent\n", files, rows, dump_requests, (unsigned long long)dump_bytes);
+
+	// Resume the last file behind its header
+	char name[32];
+	snprintf(name, sizeof(name), "%s/%04d-LOG.BIN", DUMP_OUT, files - 1);
+	CHECK(truncate(name, sizeof(log_header_s)) == 0);
+	char start[16];
+	snprintf(start, sizeof(start), "%d,%d", files - 1, (int)sizeof(log_header_s));
+	uint32_t requests = dump_requests;
+	run_receiver(start, -1);
+	CHECK(dump_requests == requests + 1);
+	rows = 0;
+	for (uint16_t file_num = 0; file_num < files; file_num++)
+	{
+		rows += compare_file(file_num);
+	}
+	CHECK(rows == DUMP_ROWS);
+
+	// Logging goes on after the dump
+	fw_make_row(DUMP_ROWS, DUMP_INTERVAL, &result);
+	write_sd_entry();
+	fw_run(DUMP_INTERVAL);
+	close_sd_file();
+	snprintf(name, sizeof(name), "%04d-LOG.BIN", files - 1);
+	std::string card;
+	CHECK(fw_read_file((host_sd.root + "/" + name).c_str(), card));
+	log_header_s header;
+	memcpy(&header, card.data(), sizeof(log_header_s));
+	CHECK(header.rows == (uint32_t)(DUMP_ROWS - (files - 1) * DUMP_FILE_ROWS + 1));
+	return host_test_result("fw_sd_dump");
+}
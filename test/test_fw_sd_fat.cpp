@@ -0,0 +1,100 @@
+/**
+ * @file test_fw_sd_fat.cpp
+ * @author Bernd Giesecke (bernd@giesecke.tk)
+ * @brief FAT and directory sector writes per 1000 log rows. The former
+ * 		CSV logger appended to the file with every row, which grew the
+ * 		cluster chain and rewrote the directory entry. The firmware
+ * 		creates each log file with an extent sized from the rotation
+ * 		policy and writes into it, the FAT is only written when a file
+ * 		is created. Measured on the SD card stand-in, which writes the
+ * 		FAT when a file grows into a new cluster and the directory
+ * 		entry on every flush after a write.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include "fw_test.h"
+#include "legacy/sd_card_csv.h"
+
+/** Logged rows */
+#define FAT_ROWS 1000
+/** Time between two rows (ms) */
+#define FAT_INTERVAL 30000
+
+/** Rows per file of the firmware runs, 0 = no row limit */
+static const uint16_t fat_max_rows[] = {300, 0};
+/** Row limit of the current run */
+static uint16_t max_rows = 0;
+
+/**
+ * @brief Print the sector writes of a run
+ *
+ * @param name logger
+ */
+void print_sectors(const char *name)
+{
+	printf("  %-22s %10u %10u %10u\n", name, host_sd.stats.data_sectors, host_sd.stats.dir_sectors, host_sd.stats.fat_sectors);
+}
+
+/**
+ * @brief Log the rows with the firmware, runs in its own process
+ *
+ */
+void fat_firmware(void)
+{
+	fw_power_on(fw_full_board, "build/sd_fat");
+	g_custom_parameters.test_mode = MODE_FIELDTESTER_V2;
+	g_custom_parameters.send_interval = 0;
+	g_custom_parameters.log_max_rows = max_rows;
+	CHECK(save_at_setting());
+	setup();
+	CHECK(has_sd);
+	fw_run(1000);
+	memset(&host_sd.stats, 0, sizeof(host_sd.stats));
+	for (uint32_t row = 0; row < FAT_ROWS; row++)
+	{
+		fw_make_row(row, FAT_INTERVAL, &result);
+		write_sd_entry();
+		fw_run(FAT_INTERVAL);
+	}
+	close_sd_file();
+
+	char name[32];
+	snprintf(name, sizeof(name), "buffered, %d rows/file", max_rows);
+	print_sectors(max_rows != 0 ? name : "buffered, no row limit");
+
+	// FAT only for a new file, the directory entry only with a flush of the buffer
+	uint32_t files = (max_rows != 0) ? (FAT_ROWS + max_rows - 1) / max_rows : 1;
+	CHECK(host_sd.stats.fat_sectors <= files);
+	CHECK(host_sd.stats.dir_sectors * 4 < FAT_ROWS);
+}
+
+int main(int argc, char **argv)
+{
+	printf("Sector writes per %d rows              data        dir        FAT\n", FAT_ROWS);
+
+	// Former CSV logger, new file every 300 rows
+	fw_power_on(fw_full_board, "build/sd_fat");
+	g_custom_parameters.test_mode = MODE_FIELDTESTER_V2;
+	CHECK(legacy_create_sd_file());
+	memset(&host_sd.stats, 0, sizeof(host_sd.stats));
+	result_s res;
+	for (uint32_t row = 0; row < FAT_ROWS; row++)
+	{
+		fw_make_row(row, FAT_INTERVAL, &res);
+		legacy_write_sd_entry(&res);
+	}
+	print_sectors("CSV, 300 rows/file");
+	CHECK(host_sd.stats.dir_sectors >= FAT_ROWS);
+	uint32_t legacy_fat = host_sd.stats.fat_sectors;
+
+	for (uint8_t run = 0; run < sizeof(fat_max_rows) / sizeof(fat_max_rows[0]); run++)
+	{
+		max_rows = fat_max_rows[run];
+		fw_fresh(fat_firmware);
+	}
+	CHECK(legacy_fat >= FAT_ROWS / 300);
+	return host_test_result("fw_sd_fat");
+}
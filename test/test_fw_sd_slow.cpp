@@ -0,0 +1,145 @@
+/**
+ * @file test_fw_sd_slow.cpp
+ * @author Bernd Giesecke (bernd@giesecke.tk)
+ * @brief Log rows on cards of increasing sector write time. The former
+ * 		CSV logger wrote the card in the callback, its time in the
+ * 		callback grows with the card. The firmware only queues the row
+ * 		in the callback, the writer task catches up in the main loop.
+ * 		No row may be lost and the time in the callback stays zero on
+ * 		every card. A burst of rows fills the queue, rows that do not
+ * 		fit are counted in log_queue_dropped.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include "fw_test.h"
+#include "legacy/sd_card_csv.h"
+
+/** Rows per card */
+#define SLOW_ROWS 300
+/** Time between two rows, shortest send interval (ms) */
+#define SLOW_INTERVAL 10000
+
+/** Sector write times of the cards (us) */
+static const uint32_t slow_sector_us[] = {500, 20000, 100000, 250000};
+
+/** Sector write time of the current card (us) */
+static uint32_t sector_us = 0;
+
+/** Time in the callback */
+struct slow_cost_s
+{
+	uint64_t callback_us;  // All rows
+	uint64_t max_callback; // Longest for one row
+};
+
+/**
+ * @brief Time a callback
+ *
+ * @param cost updated with the time of the callback
+ * @param start virtual time before the callback
+ */
+void slow_callback(slow_cost_s *cost, uint64_t start)
+{
+	uint64_t callback = host_clock_us - start;
+	cost->callback_us += callback;
+	cost->max_callback = max(cost->max_callback, callback);
+}
+
+/**
+ * @brief Rows of the log, sent as CSV for ATC+LOGS=n
+ *
+ * @return uint32_t number of rows
+ */
+uint32_t slow_log_rows(void)
+{
+	String csv;
+	Serial.capture = &csv;
+	CHECK(host_at_command("ATC+LOGS=n,2000") == AT_OK);
+	Serial.capture = NULL;
+	uint32_t rows = 0;
+	for (size_t pos = csv.find("\n2026-"); pos != std::string::npos; pos = csv.find("\n2026-", pos + 1))
+	{
+		rows++;
+	}
+	return rows;
+}
+
+/**
+ * @brief Log the rows on one card with the former CSV logger and with
+ * 		the firmware, runs in its own process
+ *
+ */
+void slow_card(void)
+{
+	slow_cost_s legacy = {0};
+	slow_cost_s firmware = {0};
+	result_s res;
+
+	fw_power_on(fw_full_board, "build/sd_slow");
+	host_sd.sector_us = sector_us;
+	g_custom_parameters.test_mode = MODE_FIELDTESTER_V2;
+	CHECK(legacy_create_sd_file());
+	for (uint32_t row = 0; row < SLOW_ROWS; row++)
+	{
+		fw_make_row(row, SLOW_INTERVAL, &res);
+		uint64_t start = host_clock_us;
+		legacy_write_sd_entry(&res);
+		slow_callback(&legacy, start);
+		host_advance(SLOW_INTERVAL * 1000 - (host_clock_us - start));
+	}
+
+	fw_power_on(fw_full_board, "build/sd_slow");
+	host_sd.sector_us = sector_us;
+	g_custom_parameters.test_mode = MODE_FIELDTESTER_V2;
+	g_custom_parameters.send_interval = 0;
+	g_custom_parameters.display_saver = false;
+	CHECK(save_at_setting());
+	setup();
+	CHECK(has_sd);
+	uint64_t start = host_clock_us;
+	for (uint32_t row = 0; row < SLOW_ROWS; row++)
+	{
+		fw_make_row(row, SLOW_INTERVAL, &result);
+		start = host_clock_us;
+		write_sd_entry();
+		slow_callback(&firmware, start);
+		fw_run(SLOW_INTERVAL);
+	}
+
+	// A burst fills the queue, the rows behind it are dropped and counted
+	for (uint32_t row = 0; row < LOG_QUEUE_SIZE + 2; row++)
+	{
+		fw_make_row(SLOW_ROWS + row, SLOW_INTERVAL, &result);
+		write_sd_entry();
+	}
+	uint32_t dropped = log_queue_dropped;
+	fw_run(SLOW_INTERVAL);
+	close_sd_file();
+	uint32_t rows = slow_log_rows();
+
+	printf("  %8.1f %10.1f %10.1f %10.1f %10.1f %8u %8u\n", sector_us / 1000.0,
+		   legacy.callback_us / 1000.0 / SLOW_ROWS, legacy.max_callback / 1000.0,
+		   firmware.callback_us / 1000.0 / SLOW_ROWS, firmware.max_callback / 1000.0, rows, dropped);
+
+	// The callback does not wait for the card, on any card
+	CHECK(firmware.max_callback == 0);
+	CHECK(legacy.max_callback >= 50000 + sector_us);
+	// Every row fits into the queue except the end of the burst
+	CHECK(dropped == 3);
+	CHECK(rows + dropped == SLOW_ROWS + LOG_QUEUE_SIZE + 2);
+}
+
+int main(int argc, char **argv)
+{
+	printf("Callback time per row (ms), CSV and queued\n");
+	printf("  %8s %10s %10s %10s %10s %8s %8s\n", "sector", "CSV", "CSV max", "queued", "queued max", "rows", "dropped");
+	for (uint8_t card = 0; card < sizeof(slow_sector_us) / sizeof(slow_sector_us[0]); card++)
+	{
+		sector_us = slow_sector_us[card];
+		fw_fresh(slow_card);
+	}
+	return host_test_result("fw_sd_slow");
+}
@@ -0,0 +1,157 @@
+/**
+ * @file test_fw_sd_write.cpp
+ * @author Bernd Giesecke (bernd@giesecke.tk)
+ * @brief Card writes and time per log row, the former CSV logger with
+ * 		an open, append and close cycle per row against the buffered
+ * 		binary logger of the firmware. Both write the same rows, one
+ * 		per send interval, to a card that needs HOST_SD_SECTOR_US for
+ * 		a sector write. The card accesses of the firmware are done by
+ * 		the writer task, the callback only queues the row.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include "fw_test.h"
+#include "legacy/sd_card_csv.h"
+
+/** Number of rows */
+#define WRITE_ROWS 1000
+/** Time between two rows, one send interval (ms) */
+#define WRITE_INTERVAL 30000
+/** Time of a sector write of the card (us) */
+#define HOST_SD_SECTOR_US 2000
+
+/** Card accesses of a logger */
+struct write_cost_s
+{
+	uint32_t opens;		   // Opened files
+	uint32_t sectors;	   // Sector writes, data, directory and FAT
+	uint64_t card_us;	   // Time of the sector writes
+	uint64_t callback_us;  // Time spent in the callback for all rows
+	uint64_t max_callback; // Longest time in the callback for one row
+};
+
+/**
+ * @brief Card accesses since the last reset of the counters
+ *
+ * @param cost filled with the counters of the card
+ */
+void card_cost(write_cost_s *cost)
+{
+	cost->opens = host_sd.stats.opens;
+	cost->sectors = host_sd.stats.data_sectors + host_sd.stats.dir_sectors + host_sd.stats.fat_sectors;
+	cost->card_us = (uint64_t)cost->sectors * HOST_SD_SECTOR_US;
+}
+
+/**
+ * @brief Log the rows with the former CSV logger, the callback did
+ * 		all the card work
+ *
+ * @param cost filled with the card accesses
+ */
+void write_legacy(write_cost_s *cost)
+{
+	fw_power_on(fw_full_board, "build/sd_write");
+	host_sd.sector_us = HOST_SD_SECTOR_US;
+	g_custom_parameters.test_mode = MODE_FIELDTESTER_V2;
+	CHECK(legacy_create_sd_file());
+	memset(&host_sd.stats, 0, sizeof(host_sd.stats));
+	memset(cost, 0, sizeof(write_cost_s));
+
+	result_s res;
+	for (uint32_t row = 0; row < WRITE_ROWS; row++)
+	{
+		fw_make_row(row, WRITE_INTERVAL, &res);
+		uint64_t start = host_clock_us;
+		legacy_write_sd_entry(&res);
+		uint64_t callback = host_clock_us - start;
+		cost->callback_us += callback;
+		cost->max_callback = max(cost->max_callback, callback);
+		host_advance(WRITE_INTERVAL * 1000 - callback);
+	}
+	card_cost(cost);
+}
+
+/**
+ * @brief Log the rows with the firmware, the callback queues the row
+ * 		and the main loop runs until the next row
+ *
+ * @param cost filled with the card accesses
+ */
+void write_firmware(write_cost_s *cost)
+{
+	fw_power_on(fw_full_board, "build/sd_write");
+	host_sd.sector_us = HOST_SD_SECTOR_US;
+	// Only the rows of the test, no uplinks
+	g_custom_parameters.test_mode = MODE_FIELDTESTER_V2;
+	g_custom_parameters.send_interval = 0;
+	g_custom_parameters.display_saver = false;
+	CHECK(save_at_setting());
+	setup();
+	CHECK(has_sd);
+	fw_run(1000);
+	memset(&host_sd.stats, 0, sizeof(host_sd.stats));
+	memset(cost, 0, sizeof(write_cost_s));
+
+	for (uint32_t row = 0; row < WRITE_ROWS; row++)
+	{
+		fw_make_row(row, WRITE_INTERVAL, &result);
+		uint64_t start = host_clock_us;
+		write_sd_entry();
+		uint64_t callback = host_clock_us - start;
+		cost->callback_us += callback;
+		cost->max_callback = max(cost->max_callback, callback);
+		fw_run(WRITE_INTERVAL);
+	}
+	// Rows still in the staging buffer are written before a reboot or dump
+	close_sd_file();
+	card_cost(cost);
+
+	// All rows are on the card
+	String csv;
+	Serial.capture = &csv;
+	CHECK(host_at_command("ATC+LOGS=n,2000") == AT_OK);
+	Serial.capture = NULL;
+	uint32_t rows = 0;
+	for (size_t pos = csv.find("\n2026-"); pos != std::string::npos; pos = csv.find("\n2026-", pos + 1))
+	{
+		rows++;
+	}
+	CHECK(rows == WRITE_ROWS);
+}
+
+/**
+ * @brief Print a line of the comparison
+ *
+ * @param name counter
+ * @param legacy value of the former logger
+ * @param firmware value of the firmware
+ */
+void print_cost(const char *name, double legacy, double firmware)
+{
+	printf("  %-24s %10.3f %10.3f\n", name, legacy, firmware);
+}
+
+int main(int argc, char **argv)
+{
+	write_cost_s legacy;
+	write_cost_s firmware;
+	write_legacy(&legacy);
+	write_firmware(&firmware);
+
+	printf("Per row, %d rows, %d us per sector write   CSV   buffered\n", WRITE_ROWS, HOST_SD_SECTOR_US);
+	print_cost("file opens", (double)legacy.opens / WRITE_ROWS, (double)firmware.opens / WRITE_ROWS);
+	print_cost("sector writes", (double)legacy.sectors / WRITE_ROWS, (double)firmware.sectors / WRITE_ROWS);
+	print_cost("card time (ms)", legacy.card_us / 1000.0 / WRITE_ROWS, firmware.card_us / 1000.0 / WRITE_ROWS);
+	print_cost("callback time (ms)", legacy.callback_us / 1000.0 / WRITE_ROWS, firmware.callback_us / 1000.0 / WRITE_ROWS);
+	print_cost("max callback time (ms)", legacy.max_callback / 1000.0, firmware.max_callback / 1000.0);
+
+	// The callback does not touch the card
+	CHECK(firmware.callback_us == 0);
+	// Rows are committed in sectors, the header and the index only on a flush
+	CHECK(firmware.sectors * 3 < legacy.sectors);
+	CHECK(firmware.opens * 100 < legacy.opens);
+	return host_test_result("fw_sd_write");
+}
@@ -0,0 +1,159 @@
+/**
+ * @file test_fw_sleep.cpp
+ * @author Bernd Giesecke (bernd@giesecke.tk)
+ * @brief Sleep windows of the tickless loop. The firmware runs for an
+ * 		hour in LinkCheck, FieldTester V2 with GNSS and LoRa P2P mode,
+ * 		every api.system.sleep.cpu() is recorded. The windows are
+ * 		reported per mode as a histogram with the early wake ups by
+ * 		radio events and the windows cut by TICKLESS_MAX_SLEEP. After a
+ * 		full window a scheduler task must be due.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include "fw_test.h"
+
+/** Time of a run (ms) */
+#define SLEEP_TIME 3600000
+/** Send interval (ms) */
+#define SLEEP_INTERVAL 60000
+/** Time between two P2P packets (ms) */
+#define SLEEP_P2P_RX 10000
+/** GNSS epochs, one per second */
+#define SLEEP_EPOCHS (SLEEP_TIME / 1000 + 1)
+
+/** Upper limits of the histogram buckets (ms) */
+static const uint32_t sleep_buckets[] = {10, 100, 500, TICKLESS_MAX_SLEEP};
+#define SLEEP_BUCKETS (sizeof(sleep_buckets) / sizeof(sleep_buckets[0]))
+
+/** Recorded sleep windows of a run */
+struct sleep_record_s
+{
+	uint32_t windows;				  // api.system.sleep.cpu() calls
+	uint32_t bucket[SLEEP_BUCKETS];	  // Windows per length
+	uint32_t early;					  // Ended early by a radio event
+	uint32_t capped;				  // Requested TICKLESS_MAX_SLEEP, the task is due later
+	uint32_t missed;				  // Full window, but no task was due after it
+	uint64_t slept_us;				  // Time slept
+};
+static sleep_record_s sleep_record;
+
+static host_gnss_epoch_s sleep_epochs[SLEEP_EPOCHS];
+
+/** Test mode of the current run */
+static uint8_t sleep_mode = MODE_LINKCHECK;
+
+/**
+ * @brief Record a sleep window, called by the api.system.sleep.cpu() stand-in
+ *
+ * @param ms requested time (ms)
+ * @param slept_us slept time (us)
+ */
+void record_sleep(uint32_t ms, uint64_t slept_us)
+{
+	sleep_record.windows++;
+	sleep_record.slept_us += slept_us;
+	uint8_t bucket = 0;
+	while ((bucket < SLEEP_BUCKETS - 1) && (ms > sleep_buckets[bucket]))
+	{
+		bucket++;
+	}
+	sleep_record.bucket[bucket]++;
+	if (slept_us < (uint64_t)ms * 1000)
+	{
+		sleep_record.early++;
+	}
+	else if (ms == TICKLESS_MAX_SLEEP)
+	{
+		sleep_record.capped++;
+	}
+	else if (mtmMain.GetSleepTime(millis()) != 0)
+	{
+		// The window was computed from the next deadline, it must be due now
+		sleep_record.missed++;
+	}
+}
+
+/**
+ * @brief Run the firmware for an hour in one mode, runs in its own process
+ *
+ */
+void sleep_run(void)
+{
+	fw_power_on(fw_full_board, "build/sd_sleep");
+	memset(sleep_epochs, 0, sizeof(sleep_epochs));
+	for (uint32_t idx = 0; idx < SLEEP_EPOCHS; idx++)
+	{
+		host_gnss_epoch_s *epoch = &sleep_epochs[idx];
+		epoch->time = idx * 1000;
+		epoch->pvt.iTOW = idx * 1000;
+		epoch->pvt.fixType = 3;
+		epoch->pvt.flags.bits.gnssFixOK = 1;
+		epoch->pvt.numSV = 9;
+		epoch->pvt.lat = 144215360;
+		epoch->pvt.lon = 1210068190;
+		epoch->pvt.hAcc = 3000;
+		epoch->pvt.pDOP = 120;
+		epoch->hdop = 90;
+	}
+	host_gnss.epochs = sleep_epochs;
+	host_gnss.num_epochs = SLEEP_EPOCHS;
+
+	g_custom_parameters.test_mode = sleep_mode;
+	g_custom_parameters.send_interval = SLEEP_INTERVAL;
+	g_custom_parameters.location_on = sleep_mode == MODE_FIELDTESTER_V2;
+	CHECK(save_at_setting());
+	setup();
+
+	memset(&sleep_record, 0, sizeof(sleep_record));
+	host_radio.on_sleep = record_sleep;
+	uint64_t start = host_clock_us;
+	uint8_t packet[] = {0x01, 0x02, 0x03, 0x04};
+	for (uint32_t time = 0; time < SLEEP_TIME; time += SLEEP_P2P_RX)
+	{
+		fw_run(SLEEP_P2P_RX);
+		if (sleep_mode == MODE_P2P)
+		{
+			host_radio_p2p_rx(packet, sizeof(packet), -70, 9);
+		}
+	}
+	host_radio.on_sleep = NULL;
+	uint64_t run_us = host_clock_us - start;
+
+	const char *names[] = {"LinkCheck", "P2P", "FieldTester", "FieldTester V2"};
+	printf("  %-15s %7u", names[sleep_mode], sleep_record.windows);
+	for (uint8_t bucket = 0; bucket < SLEEP_BUCKETS; bucket++)
+	{
+		printf(" %7u", sleep_record.bucket[bucket]);
+	}
+	printf(" %7u %7u %7u %6.1f%%\n", sleep_record.early, sleep_record.capped, sleep_record.missed,
+		   100.0 * sleep_record.slept_us / run_us);
+
+	// Every full window ended on a deadline, the device sleeps most of the time
+	CHECK(sleep_record.windows > 0);
+	CHECK(sleep_record.missed == 0);
+	CHECK(sleep_record.slept_us * 10 > run_us * 9);
+	// No task polls, short windows are the exception
+	CHECK((sleep_record.bucket[0] + sleep_record.bucket[1]) * 10 < sleep_record.windows);
+}
+
+int main(int argc, char **argv)
+{
+	printf("Sleep windows in %d s, requested time (ms)\n", SLEEP_TIME / 1000);
+	printf("  %-15s %7s", "mode", "windows");
+	for (uint8_t bucket = 0; bucket < SLEEP_BUCKETS; bucket++)
+	{
+		printf("  <=%4u", sleep_buckets[bucket]);
+	}
+	printf(" %7s %7s %7s %7s\n", "early", "capped", "missed", "asleep");
+
+	const uint8_t modes[] = {MODE_LINKCHECK, MODE_FIELDTESTER_V2, MODE_P2P};
+	for (uint8_t run = 0; run < sizeof(modes); run++)
+	{
+		sleep_mode = modes[run];
+		fw_fresh(sleep_run);
+	}
+	return host_test_result("fw_sleep");
+}
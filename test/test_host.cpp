@@ -0,0 +1,86 @@
+/**
+ * @file test_host.cpp
+ * @author Bernd Giesecke (bernd@giesecke.tk)
+ * @brief Smoke test of the host build.
+ * 		Drives a FieldTester V2 downlink through the parser, the log
+ * 		record and the CSV renderer, like handle_display() and the log
+ * 		dump do on the device, and checks the virtual clock.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include "app.h"
+#include "host_test.h"
+
+/** Logged result, normally defined in the .ino */
+volatile result_s result;
+
+/**
+ * @brief The clock only moves with host_advance() and delay()
+ *
+ */
+void test_clock(void)
+{
+	uint32_t start_ms = millis();
+	uint32_t start_us = micros();
+	CHECK(millis() == start_ms);
+	host_advance(1500);
+	CHECK(micros() - start_us == 1500);
+	delay(250);
+	CHECK(millis() - start_ms == 251);
+}
+
+/**
+ * @brief Downlink to log line
+ *
+ */
+void test_downlink_to_csv(void)
+{
+	// PLR 2.5%, max RSSI -80, distance 500m..1km, 3 gateways, sequence 0x123, max SNR 7, gateway EUI 0xAABBCC
+	uint8_t payload[FT_V2_DL_SIZE] = {0x00, 0x19, 120, 2, 4, 0x31, 0x23, 207, 0xAA, 0xBB, 0xCC};
+	field_tester_dl_s dl;
+	CHECK(parse_field_tester_dl(payload, sizeof(payload), true, &dl));
+	CHECK(dl.seq_id == 0x123);
+	CHECK(dl.gateways == 3);
+
+	result.year = 2026;
+	result.month = 10;
+	result.day = 16;
+	result.hour = 8;
+	result.min = 5;
+	result.sec = 9;
+	result.mode = MODE_FIELDTESTER_V2;
+	result.gw = dl.gateways;
+	result.lat = 144215360;
+	result.lng = 1210068190;
+	result.max_rssi = dl.max_rssi;
+	result.max_snr = dl.max_snr;
+	result.rx_rssi = -90;
+	result.rx_snr = 5;
+	result.min_dst = dl.min_distance;
+	result.max_dst = dl.max_distance;
+	result.tx_dr = 3;
+	result.lost = dl.plr;
+
+	log_record_s record;
+	log_encode_record(&result, &record);
+	CHECK(log_record_valid(&record));
+
+	char line[256];
+	log_record_to_csv(log_columns(MODE_FIELDTESTER_V2, true), &record, line, sizeof(line));
+	// Same CSV as the former float coordinates, 121.006819 as float is 121.0068207
+	CHECK(strcmp(line, "2026-10-16 08:05:09;3;3;14.421536;121.006821;-80;7;-90;5;500;1000;3;2.5") == 0);
+
+	// A torn record is not valid
+	record.commit = 0;
+	CHECK(!log_record_valid(&record));
+}
+
+int main(int argc, char **argv)
+{
+	test_clock();
+	test_downlink_to_csv();
+	return host_test_result("host");
+}
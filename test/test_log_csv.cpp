@@ -0,0 +1,175 @@
+/**
+ * @file test_log_csv.cpp
+ * @author Bernd Giesecke (bernd@giesecke.tk)
+ * @brief Equivalence test of the table driven CSV renderer.
+ * 		Random records of all column sets are rendered with
+ * 		log_record_to_csv() and with the former snprintf formats, the
+ * 		lines must be identical.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include "app.h"
+#include "host_test.h"
+
+/**
+ * @brief The former snprintf renderer, as reference.
+ * 		The coordinates are formatted from the float values the former
+ * 		code had in result_s. The distances are int32_t, the int16_t of the former code
+ * 		overflowed above 32.7 km.
+ *
+ * @param columns column set of the log file, see log_columns_t
+ * @param record log record
+ * @param line buffer for the CSV line (without line end)
+ * @param line_size size of the buffer
+ * @return size_t length of the CSV line
+ */
+size_t ref_record_to_csv(uint8_t columns, log_record_s *record, char *line, size_t line_size)
+{
+	date_time_s dt;
+	log_split_time(record->time, &dt);
+	// The former code logged the float degree values of the GNSS position
+	float lat = record->lat / 10000000.0;
+	float lng = record->lng / 10000000.0;
+	int32_t min_dst = record->min_dst * 250;
+	int32_t max_dst = record->max_dst * 250;
+	int len = 0;
+
+	switch (columns)
+	{
+	case LOG_COL_LINKCHECK_LOC:
+		len = snprintf(line, line_size, "%04d-%02d-%02d %02d:%02d:%02d;%d;%d;%.6f;%.6f;%d;%d;%d;%d;%d",
+					   dt.year, dt.month, dt.date, dt.hour, dt.minute, dt.second,
+					   record->mode, record->gw,
+					   lat, lng,
+					   record->rx_rssi,
+					   record->rx_snr,
+					   record->demod, record->tx_dr, record->lost);
+		break;
+	case LOG_COL_LINKCHECK:
+		len = snprintf(line, line_size, "%04d-%02d-%02d %02d:%02d:%02d;%d;%d;%d;%d;%d;%d;%d",
+					   dt.year, dt.month, dt.date, dt.hour, dt.minute, dt.second,
+					   record->mode, record->gw,
+					   record->rx_rssi,
+					   record->rx_snr,
+					   record->demod, record->tx_dr, record->lost);
+		break;
+	case LOG_COL_FIELDTESTER:
+		len = snprintf(line, line_size, "%04d-%02d-%02d %02d:%02d:%02d;%d;%d;%.6f;%.6f;%d;%d;%d;%d;%d;%d;%d;%d",
+					   dt.year, dt.month, dt.date, dt.hour, dt.minute, dt.second,
+					   record->mode, record->gw,
+					   lat, lng,
+					   record->min_rssi, record->max_rssi, record->rx_rssi,
+					   record->rx_snr,
+					   min_dst, max_dst, record->tx_dr, record->lost);
+		break;
+	case LOG_COL_FIELDTESTER_V2:
+		len = snprintf(line, line_size, "%04d-%02d-%02d %02d:%02d:%02d;%d;%d;%.6f;%.6f;%d;%d;%d;%d;%d;%d;%d;%.1f",
+					   dt.year, dt.month, dt.date, dt.hour, dt.minute, dt.second,
+					   record->mode, record->gw,
+					   lat, lng,
+					   record->max_rssi, record->max_snr, record->rx_rssi,
+					   record->rx_snr,
+					   min_dst, max_dst, record->tx_dr, (float)record->lost / 10.0f);
+		break;
+	case LOG_COL_P2P_LOC:
+		len = snprintf(line, line_size, "%04d-%02d-%02d %02d:%02d:%02d;%d;%.6f;%.6f;%d;%d",
+					   dt.year, dt.month, dt.date, dt.hour, dt.minute, dt.second,
+					   record->mode,
+					   lat, lng,
+					   record->rx_rssi,
+					   record->rx_snr);
+		break;
+	case LOG_COL_P2P:
+		len = snprintf(line, line_size, "%04d-%02d-%02d %02d:%02d:%02d;%d;%d;%d",
+					   dt.year, dt.month, dt.date, dt.hour, dt.minute, dt.second,
+					   record->mode,
+					   record->rx_rssi,
+					   record->rx_snr);
+		break;
+	default:
+		line[0] = 0x00;
+		break;
+	}
+
+	if (len < 0)
+	{
+		return 0;
+	}
+	return (size_t)len >= line_size ? line_size - 1 : len;
+}
+
+/** Values at the limits of the record fields */
+const int32_t edge_values[] = {0, 1, -1, 5, -5, 9, 10, 99, 100, 127, -128, 255, 32767, -32768, 9999999, 10000000, -10000000, 2147483647, -2147483647 - 1};
+
+/**
+ * @brief Random field value, often at a limit
+ *
+ * @return int32_t value, truncated by the caller to the field size
+ */
+int32_t random_field(void)
+{
+	if ((host_random() % 4) == 0)
+	{
+		return edge_values[host_random() % (sizeof(edge_values) / sizeof(edge_values[0]))];
+	}
+	return (int32_t)host_random();
+}
+
+/**
+ * @brief Random log record
+ *
+ * @param record filled with random values
+ */
+void random_record(log_record_s *record)
+{
+	record->time = host_random();
+	record->lat = random_field();
+	record->lng = random_field();
+	record->lost = random_field();
+	record->mode = random_field();
+	record->gw = random_field();
+	record->min_rssi = random_field();
+	record->max_rssi = random_field();
+	record->max_snr = random_field();
+	record->rx_rssi = random_field();
+	record->rx_snr = random_field();
+	record->tx_dr = random_field();
+	record->demod = random_field();
+	record->min_dst = random_field();
+	record->max_dst = random_field();
+	record->commit = LOG_RECORD_COMMIT;
+}
+
+int main(int argc, char **argv)
+{
+	uint32_t iterations = host_test_iterations(argc, argv, 1000000);
+	uint32_t mismatches = 0;
+	char line[256];
+	char ref_line[256];
+
+	for (uint32_t count = 0; count < iterations; count++)
+	{
+		log_record_s record;
+		random_record(&record);
+		uint8_t columns = count % (LOG_COL_INVALID + 1);
+		// Mostly full lines, sometimes a buffer that truncates the line
+		size_t line_size = ((count % 16) == 0) ? host_random_range(1, 80) : sizeof(line);
+
+		size_t len = log_record_to_csv(columns, &record, line, line_size);
+		size_t ref_len = ref_record_to_csv(columns, &record, ref_line, line_size);
+		if ((len != ref_len) || (strcmp(line, ref_line) != 0))
+		{
+			if (mismatches < 10)
+			{
+				fprintf(stderr, "columns %d size %d\n  got      %s\n  expected %s\n", columns, (int)line_size, line, ref_line);
+			}
+			mismatches++;
+		}
+	}
+	CHECK(mismatches == 0);
+	printf("%u rows, %u mismatches\n", iterations, mismatches);
+	return host_test_result("log_csv");
+}
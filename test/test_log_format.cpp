@@ -0,0 +1,192 @@
+/**
+ * @file test_log_format.cpp
+ * @author Bernd Giesecke (bernd@giesecke.tk)
+ * @brief Round trip test and benchmark of the binary log record.
+ * 		Random results are packed with log_encode_record(), the record
+ * 		must give back every field. The benchmark compares the bytes
+ * 		per row and the time per row with the former snprintf rows.
+ * 		Call with the number of results as argument, default is 1000000.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include <string.h>
+#include "app.h"
+#include "host_test.h"
+
+/**
+ * @brief Random result as the callbacks fill it
+ *
+ * @param res filled with random values in the range of the fields
+ */
+void random_result(volatile result_s *res)
+{
+	res->year = host_random_range(1970, 2105);
+	res->month = host_random_range(1, 12);
+	res->day = host_random_range(1, 28);
+	res->hour = host_random_range(0, 23);
+	res->min = host_random_range(0, 59);
+	res->sec = host_random_range(0, 59);
+	// 2106-02-07 is the end of the 32 bit time
+	if (res->year == 2105)
+	{
+		res->month = 12;
+	}
+	res->mode = host_random_range(0, 3);
+	res->gw = host_random_range(0, 255);
+	res->lat = host_random_range(-900000000, 900000000);
+	res->lng = host_random_range(-1800000000, 1800000000);
+	res->min_rssi = host_random_range(-128, 127);
+	res->max_rssi = host_random_range(-128, 127);
+	res->max_snr = host_random_range(-128, 127);
+	res->rx_rssi = host_random_range(-128, 127);
+	res->rx_snr = host_random_range(-128, 127);
+	// Distances come in 250 m steps from the FieldTester downlink
+	res->min_dst = host_random_range(0, 255) * 250;
+	res->max_dst = host_random_range(0, 255) * 250;
+	res->demod = host_random_range(0, 255);
+	res->lost = host_random_range(-32768, 32767);
+	res->tx_dr = host_random_range(0, 15);
+}
+
+/**
+ * @brief Check that a record gives back all fields of the result
+ *
+ * @param res packed result
+ * @param record log record
+ * @return true all fields are equal
+ */
+bool record_matches(volatile result_s *res, log_record_s *record)
+{
+	date_time_s dt;
+	log_split_time(record->time, &dt);
+	return (dt.year == res->year) && (dt.month == res->month) && (dt.date == res->day) &&
+		   (dt.hour == res->hour) && (dt.minute == res->min) && (dt.second == res->sec) &&
+		   (record->lat == res->lat) && (record->lng == res->lng) &&
+		   (record->mode == res->mode) && (record->gw == res->gw) &&
+		   (record->min_rssi == res->min_rssi) && (record->max_rssi == res->max_rssi) &&
+		   (record->max_snr == res->max_snr) && (record->rx_rssi == res->rx_rssi) &&
+		   (record->rx_snr == res->rx_snr) && (record->tx_dr == res->tx_dr) &&
+		   (record->demod == res->demod) && (record->lost == res->lost) &&
+		   (record->min_dst * 250 == res->min_dst) && (record->max_dst * 250 == res->max_dst);
+}
+
+/**
+ * @brief Round trip of random results, and single bit errors must be
+ * 		found by the record CRC
+ *
+ * @param iterations number of results
+ */
+void test_round_trip(uint32_t iterations)
+{
+	uint32_t mismatches = 0;
+	uint32_t undetected = 0;
+	for (uint32_t count = 0; count < iterations; count++)
+	{
+		volatile result_s res;
+		log_record_s record;
+		random_result(&res);
+		log_encode_record(&res, &record);
+		if (!log_record_valid(&record) || !record_matches(&res, &record))
+		{
+			mismatches++;
+			continue;
+		}
+		uint32_t bit = host_random() % (sizeof(log_record_s) * 8);
+		((uint8_t *)&record)[bit / 8] ^= 1 << (bit % 8);
+		if (log_record_valid(&record))
+		{
+			undetected++;
+		}
+	}
+	CHECK(mismatches == 0);
+	CHECK(undetected == 0);
+}
+
+/**
+ * @brief Former row of the log, a CSV line of the float result
+ *
+ * @param res result to log
+ * @param line buffer for the line
+ * @param line_size size of the buffer
+ * @return size_t length of the line
+ */
+size_t former_row(volatile result_s *res, char *line, size_t line_size)
+{
+	// Former FieldTester V2 row, the longest one
+	return snprintf(line, line_size, "%04d-%02d-%02d %02d:%02d:%02d;%d;%d;%.6f;%.6f;%d;%d;%d;%d;%d;%d;%d;%.1f",
+					res->year, res->month, res->day, res->hour, res->min, res->sec,
+					res->mode, res->gw,
+					(float)(res->lat / 10000000.0), (float)(res->lng / 10000000.0),
+					res->max_rssi, res->max_snr, res->rx_rssi,
+					res->rx_snr,
+					res->min_dst, res->max_dst, res->tx_dr, (float)res->lost / 10.0f);
+}
+
+/**
+ * @brief Bytes and time per row of the binary record and the former
+ * 		CSV row, and the time to render a record as CSV on dump
+ *
+ * @param iterations number of rows
+ */
+void bench_rows(uint32_t iterations)
+{
+	// Results of a drive, close positions and typical signal values
+	const uint32_t num_results = 1024;
+	static result_s results[num_results];
+	for (uint32_t idx = 0; idx < num_results; idx++)
+	{
+		random_result(&results[idx]);
+		results[idx].year = 2026;
+		results[idx].lat = 144215360 + host_random_range(-50000, 50000);
+		results[idx].lng = 1210068190 + host_random_range(-50000, 50000);
+		results[idx].rx_rssi = host_random_range(-120, -40);
+		results[idx].rx_snr = host_random_range(-20, 12);
+		results[idx].lost = host_random_range(0, 1000);
+	}
+
+	char line[256];
+	log_record_s record;
+	uint64_t csv_bytes = 0;
+	uint32_t sink = 0;
+
+	uint64_t start = host_time_us();
+	for (uint32_t count = 0; count < iterations; count++)
+	{
+		// println() added "\r\n"
+		csv_bytes += former_row(&results[count % num_results], line, sizeof(line)) + 2;
+	}
+	uint64_t former_time = host_time_us() - start;
+
+	start = host_time_us();
+	for (uint32_t count = 0; count < iterations; count++)
+	{
+		log_encode_record(&results[count % num_results], &record);
+		sink += record.crc;
+	}
+	uint64_t encode_time = host_time_us() - start;
+
+	start = host_time_us();
+	for (uint32_t count = 0; count < iterations; count++)
+	{
+		log_encode_record(&results[count % num_results], &record);
+		sink += log_record_to_csv(LOG_COL_FIELDTESTER_V2, &record, line, sizeof(line));
+	}
+	uint64_t render_time = host_time_us() - start - encode_time;
+
+	printf("Former CSV row: %.1f bytes, %.0f ns per row\n", (double)csv_bytes / iterations, former_time * 1000.0 / iterations);
+	printf("Binary record:  %d bytes, %.0f ns per row (%.1fx smaller)\n", (int)sizeof(log_record_s), encode_time * 1000.0 / iterations,
+		   (double)csv_bytes / iterations / sizeof(log_record_s));
+	printf("CSV on dump:    %.0f ns per row (%u)\n", render_time * 1000.0 / iterations, sink & 1);
+	CHECK(sizeof(log_record_s) * 2 <= (double)csv_bytes / iterations);
+}
+
+int main(int argc, char **argv)
+{
+	uint32_t iterations = host_test_iterations(argc, argv, 1000000);
+	test_round_trip(iterations);
+	bench_rows(iterations);
+	return host_test_result("log_format");
+}
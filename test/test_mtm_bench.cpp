@@ -0,0 +1,171 @@
+/**
+ * @file test_mtm_bench.cpp
+ * @author Bernd Giesecke (bernd@giesecke.tk)
+ * @brief Benchmark of the heap scheduler against the former linked
+ * 		list version (legacy/MillisTaskManagerList).
+ * 		1 to 500 tasks with random periods run on the virtual clock,
+ * 		each task takes BENCH_TASK_US. Reported are the host time per
+ * 		Running() call and the start jitter of the tasks, the time a
+ * 		task started after its due time. Both schedulers must run the
+ * 		same number of tasks.
+ * 		Call with the simulated time (ms) as argument, default is 10000.
+ * 		The timings are only meaningful in make bench.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include "MillisTaskManager.h"
+#include "legacy/MillisTaskManagerList.h"
+#include "Arduino.h"
+#include "host_test.h"
+
+/** Largest number of tasks */
+#define BENCH_MAX_TASKS 500
+/** Run time of a task on the virtual clock (us) */
+#define BENCH_TASK_US 20
+
+/** Period of each task (ms) */
+static uint32_t bench_period[BENCH_MAX_TASKS];
+/** Tick of the last run of each task, 0xFFFFFFFF before the first run */
+static uint32_t bench_prev[BENCH_MAX_TASKS];
+/** Number of task executions */
+static uint32_t bench_runs;
+/** Number of executions with a start jitter */
+static uint32_t bench_starts;
+/** Sum of the start jitter (us) */
+static uint64_t bench_jitter_sum;
+/** Largest start jitter (us) */
+static uint32_t bench_jitter_max;
+
+/**
+ * @brief Benchmark task, the former scheduler finds tasks by their
+ *        function, so each task needs its own function
+ */
+template <int I>
+void bench_task(void)
+{
+	uint64_t now = host_clock_us;
+	if (bench_prev[I] != 0xFFFFFFFF)
+	{
+		uint64_t due = ((uint64_t)bench_prev[I] + bench_period[I]) * 1000;
+		uint32_t jitter = now > due ? (uint32_t)(now - due) : 0;
+		bench_starts++;
+		bench_jitter_sum += jitter;
+		if (jitter > bench_jitter_max)
+		{
+			bench_jitter_max = jitter;
+		}
+	}
+	bench_prev[I] = now / 1000;
+	bench_runs++;
+	host_advance(BENCH_TASK_US);
+}
+
+/**
+ * @brief Table of the benchmark task functions
+ */
+template <int N>
+struct BenchTasks
+{
+	static void Fill(MillisTaskManager::TaskFunction_t *table)
+	{
+		BenchTasks<N - 1>::Fill(table);
+		table[N - 1] = bench_task<N - 1>;
+	}
+};
+
+template <>
+struct BenchTasks<0>
+{
+	static void Fill(MillisTaskManager::TaskFunction_t *table) {}
+};
+
+/** Task functions */
+static MillisTaskManager::TaskFunction_t bench_functions[BENCH_MAX_TASKS];
+
+/** Result of one scheduler run */
+struct bench_result_s
+{
+	uint32_t runs;		 // Task executions
+	double call_ns;		 // Host time per Running call (ns)
+	double jitter_mean;	 // Mean start jitter (us)
+	uint32_t jitter_max; // Largest start jitter (us)
+};
+
+/**
+ * @brief Run a scheduler with the first tasks of the benchmark set
+ *
+ * @param mtm scheduler, MillisTaskManager or MillisTaskManagerList
+ * @param tasks number of tasks
+ * @param duration simulated time (ms)
+ * @param result measured values
+ */
+template <class Scheduler>
+void bench_run(Scheduler &mtm, uint16_t tasks, uint32_t duration, bench_result_s *result)
+{
+	host_clock_us = 0;
+	bench_runs = 0;
+	bench_starts = 0;
+	bench_jitter_sum = 0;
+	bench_jitter_max = 0;
+	for (uint16_t idx = 0; idx < tasks; idx++)
+	{
+		bench_prev[idx] = 0xFFFFFFFF;
+		mtm.Register(bench_functions[idx], bench_period[idx]);
+	}
+
+	// One call per ms, or right after the tasks if they took longer
+	uint32_t calls = 0;
+	uint64_t host_time = 0;
+	while (millis() < duration)
+	{
+		uint32_t tick = millis();
+		uint64_t start = host_time_us();
+		mtm.Running(tick);
+		host_time += host_time_us() - start;
+		calls++;
+		if (millis() == tick)
+		{
+			host_clock_us = (uint64_t)(tick + 1) * 1000;
+		}
+	}
+
+	result->runs = bench_runs;
+	result->call_ns = host_time * 1000.0 / calls;
+	result->jitter_mean = bench_starts == 0 ? 0 : (double)bench_jitter_sum / bench_starts;
+	result->jitter_max = bench_jitter_max;
+}
+
+int main(int argc, char **argv)
+{
+	uint32_t duration = host_test_iterations(argc, argv, 10000);
+	const uint16_t task_counts[] = {1, 2, 5, 10, 20, 50, 100, 200, 500};
+
+	BenchTasks<BENCH_MAX_TASKS>::Fill(bench_functions);
+	for (uint16_t idx = 0; idx < BENCH_MAX_TASKS; idx++)
+	{
+		bench_period[idx] = host_random_range(10, 1000);
+	}
+
+	printf("tasks   list ns/call  heap ns/call   list jitter us (mean/max)   heap jitter us (mean/max)\n");
+	for (uint8_t count = 0; count < sizeof(task_counts) / sizeof(task_counts[0]); count++)
+	{
+		bench_result_s list;
+		bench_result_s heap;
+		{
+			MillisTaskManagerList mtm;
+			bench_run(mtm, task_counts[count], duration, &list);
+		}
+		{
+			MillisTaskManager mtm;
+			bench_run(mtm, task_counts[count], duration, &heap);
+		}
+		printf("%5d %13.0f %13.0f %15.1f / %-10u %15.1f / %u\n", task_counts[count], list.call_ns, heap.call_ns,
+			   list.jitter_mean, list.jitter_max, heap.jitter_mean, heap.jitter_max);
+		CHECK(list.runs == heap.runs);
+		CHECK(list.runs != 0);
+	}
+	return host_test_result("mtm_bench");
+}
@@ -0,0 +1,218 @@
+/**
+ * @file test_mtm_notify.cpp
+ * @author Bernd Giesecke (bernd@giesecke.tk)
+ * @brief Tests of Notify of MillisTaskManager.
+ * 		A notified task runs on the next Running call regardless of its
+ * 		period, a disabled task is enabled and GetSleepTime does not
+ * 		let the main loop sleep over a pending notification.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include "MillisTaskManager.h"
+#include "Arduino.h"
+#include "host_test.h"
+
+MillisTaskPool<4> mtm;
+
+/** Executions of the test tasks */
+static uint32_t runs[3];
+/** Tick of the last execution of the test tasks */
+static uint32_t run_tick[3];
+/** Current tick of the test */
+static uint32_t tick = 0;
+/** Handle notified by task_2 while it runs */
+static MillisTaskManager::TaskHandle_t notify_handle = MTM_INVALID_HANDLE;
+
+void task_0(void)
+{
+	runs[0]++;
+	run_tick[0] = tick;
+}
+
+void task_1(void)
+{
+	runs[1]++;
+	run_tick[1] = tick;
+}
+
+void task_2(void)
+{
+	runs[2]++;
+	run_tick[2] = tick;
+	// Like an interrupt during Running
+	if (notify_handle != MTM_INVALID_HANDLE)
+	{
+		mtm.Notify(notify_handle);
+		notify_handle = MTM_INVALID_HANDLE;
+	}
+}
+
+/**
+ * @brief Call Running for every ms up to the given tick
+ *
+ * @param until last tick
+ */
+void run_until(uint32_t until)
+{
+	while (tick < until)
+	{
+		tick++;
+		mtm.Running(tick);
+	}
+}
+
+/**
+ * @brief A notified task runs on the next Running call, then with its period again
+ *
+ */
+void test_notify_periodic(void)
+{
+	MillisTaskManager::TaskHandle_t handle = mtm.Add(task_0, 1000);
+	mtm.Running(tick);
+	CHECK(runs[0] == 1);
+
+	run_until(100);
+	CHECK(runs[0] == 1);
+	CHECK(mtm.GetSleepTime(tick) == 900);
+
+	CHECK(mtm.Notify(handle));
+	CHECK(mtm.IsNotified());
+	CHECK(mtm.GetSleepTime(tick) == 0);
+	uint32_t deadline = 0;
+	CHECK(mtm.GetNextDeadline(&deadline));
+	CHECK(deadline == tick);
+
+	run_until(101);
+	CHECK(runs[0] == 2);
+	CHECK(run_tick[0] == 101);
+	CHECK(!mtm.IsNotified());
+	CHECK(mtm.GetSleepTime(tick) == 1000);
+
+	// The period restarts with the notified run
+	run_until(1100);
+	CHECK(runs[0] == 2);
+	run_until(1101);
+	CHECK(runs[0] == 3);
+
+	// Several notifications before Running run the task once
+	mtm.Notify(handle);
+	mtm.Notify(handle);
+	run_until(1105);
+	CHECK(runs[0] == 4);
+	CHECK(run_tick[0] == 1102);
+
+	CHECK(mtm.Remove(handle));
+}
+
+/**
+ * @brief Notify enables a disabled task, it stays enabled
+ *
+ */
+void test_notify_disabled(void)
+{
+	MillisTaskManager::TaskHandle_t handle = mtm.Add(task_1, 50, false);
+	run_until(tick + 200);
+	CHECK(runs[1] == 0);
+	CHECK(mtm.GetSleepTime(tick) == MTM_SLEEP_FOREVER);
+
+	mtm.Notify(handle);
+	CHECK(mtm.GetSleepTime(tick) == 0);
+	uint32_t notified = tick + 1;
+	run_until(notified);
+	CHECK(runs[1] == 1);
+	CHECK(run_tick[1] == notified);
+	CHECK(mtm.Get(handle)->State);
+
+	run_until(notified + 50);
+	CHECK(runs[1] == 2);
+
+	// Disabled for longer than its period, the notified run has no start jitter
+	mtm.SetState(handle, false);
+	run_until(tick + 1000);
+	mtm.Notify(handle);
+	run_until(tick + 1);
+	CHECK(runs[1] == 3);
+#if (MTM_USE_STATS == 1)
+	CHECK(mtm.Get(handle)->Stats.ErrorMax == 0);
+#endif
+
+	// A notified one-shot task is disabled again after its execution
+	mtm.Register(task_1, 50, false, true);
+	mtm.Notify(handle);
+	run_until(tick + 200);
+	CHECK(runs[1] == 4);
+	CHECK(!mtm.Get(handle)->State);
+
+	CHECK(mtm.Remove(handle));
+}
+
+/**
+ * @brief A notification from a task during Running is kept for the next call
+ *
+ */
+void test_notify_from_task(void)
+{
+	MillisTaskManager::TaskHandle_t handle_0 = mtm.Add(task_0, 1000);
+	mtm.Add(task_2, 1000);
+	run_until(tick + 1);
+	uint32_t runs_0 = runs[0];
+	uint32_t runs_2 = runs[2];
+
+	// task_2 notifies task_0 while Running scans, task_0 runs on the next call
+	notify_handle = handle_0;
+	mtm.Notify(mtm.Find(task_2));
+	run_until(tick + 1);
+	CHECK(runs[2] == runs_2 + 1);
+	CHECK(runs[0] == runs_0);
+	CHECK(mtm.IsNotified());
+	CHECK(mtm.GetSleepTime(tick) == 0);
+	run_until(tick + 1);
+	CHECK(runs[0] == runs_0 + 1);
+	CHECK(run_tick[0] == tick);
+
+	// A task can notify itself
+	notify_handle = mtm.GetHandle(mtm.Find(task_2));
+	mtm.Notify(notify_handle);
+	run_until(tick + 2);
+	CHECK(runs[2] == runs_2 + 3);
+
+	mtm.Logout(task_0);
+	mtm.Logout(task_2);
+}
+
+/**
+ * @brief Notify fails for invalid and removed tasks
+ *
+ */
+void test_notify_invalid(void)
+{
+	CHECK(!mtm.Notify(MTM_INVALID_HANDLE));
+	CHECK(!mtm.Notify((MillisTaskManager::Task_t *)NULL));
+
+	MillisTaskManager::TaskHandle_t handle = mtm.Add(task_1, 10);
+	CHECK(mtm.Remove(handle));
+	CHECK(!mtm.Notify(handle));
+	CHECK(!mtm.IsNotified());
+
+	// The notification of a task removed before Running is dropped
+	handle = mtm.Add(task_1, 10, false);
+	mtm.Notify(handle);
+	mtm.Remove(handle);
+	uint32_t runs_1 = runs[1];
+	run_until(tick + 20);
+	CHECK(runs[1] == runs_1);
+	CHECK(!mtm.IsNotified());
+	CHECK(mtm.GetCount() == 0);
+}
+
+int main(int argc, char **argv)
+{
+	test_notify_periodic();
+	test_notify_disabled();
+	test_notify_from_task();
+	test_notify_invalid();
+	return host_test_result("mtm_notify");
+}
@@ -0,0 +1,247 @@
+/**
+ * @file test_mtm_pool.cpp
+ * @author Bernd Giesecke (bernd@giesecke.tk)
+ * @brief Tests of the static task pool of MillisTaskManager.
+ * 		MillisTaskPool<N> must not allocate from the heap, a full pool
+ * 		rejects new tasks and a removed task's handle stays invalid
+ * 		when its slot is reused. The heap allocated pool has no limit,
+ * 		it grows without moving the registered tasks.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include <new>
+#include "MillisTaskManager.h"
+#include "Arduino.h"
+#include "host_test.h"
+
+/** Number of heap allocations through operator new */
+static uint32_t heap_allocations = 0;
+
+/* Not inlined, GCC warns about free() of a pointer from operator new otherwise */
+__attribute__((noinline)) void *operator new(size_t size)
+{
+	heap_allocations++;
+	void *ptr = malloc(size);
+	if (ptr == NULL)
+	{
+		throw std::bad_alloc();
+	}
+	return ptr;
+}
+
+__attribute__((noinline)) void *operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+__attribute__((noinline)) void operator delete(void *ptr) noexcept
+{
+	free(ptr);
+}
+
+__attribute__((noinline)) void operator delete[](void *ptr) noexcept
+{
+	free(ptr);
+}
+
+__attribute__((noinline)) void operator delete(void *ptr, size_t) noexcept
+{
+	free(ptr);
+}
+
+__attribute__((noinline)) void operator delete[](void *ptr, size_t) noexcept
+{
+	free(ptr);
+}
+
+/** Executions of the test tasks */
+static uint32_t runs[5];
+
+void task_0(void) { runs[0]++; }
+void task_1(void) { runs[1]++; }
+void task_2(void) { runs[2]++; }
+void task_3(void) { runs[3]++; }
+void task_4(void) { runs[4]++; }
+
+/**
+ * @brief A full pool rejects new tasks, a removed slot is reused with a new handle
+ *
+ */
+void test_pool(void)
+{
+	uint32_t allocations = heap_allocations;
+	MillisTaskPool<4> mtm;
+
+	MillisTaskManager::TaskHandle_t handles[4];
+	handles[0] = mtm.Add(task_0, 10);
+	handles[1] = mtm.Add(task_1, 20);
+	handles[2] = mtm.Add(task_2, 30);
+	handles[3] = mtm.Add(task_3, 40);
+	for (int idx = 0; idx < 4; idx++)
+	{
+		CHECK(handles[idx] != MTM_INVALID_HANDLE);
+	}
+	CHECK(mtm.GetCount() == 4);
+
+	// Pool is full
+	CHECK(mtm.Add(task_4, 50) == MTM_INVALID_HANDLE);
+	CHECK(mtm.Register(task_4, 50) == NULL);
+	CHECK(mtm.Add(NULL, 50) == MTM_INVALID_HANDLE);
+
+	// Register of a known function updates the task instead of taking a slot
+	CHECK(mtm.Register(task_1, 25) == mtm.Get(handles[1]));
+	CHECK(mtm.Get(handles[1])->Time == 25);
+
+	// Removed task, its handle is invalid, also after the slot is reused
+	CHECK(mtm.Remove(handles[2]));
+	CHECK(mtm.Get(handles[2]) == NULL);
+	CHECK(!mtm.Remove(handles[2]));
+	CHECK(!mtm.SetState(handles[2], true));
+	CHECK(!mtm.Notify(handles[2]));
+	CHECK(mtm.Find(task_2) == NULL);
+	CHECK(mtm.GetCount() == 3);
+
+	MillisTaskManager::TaskHandle_t reused = mtm.Add(task_4, 50);
+	CHECK(reused != MTM_INVALID_HANDLE);
+	CHECK((reused & 0xFFFF) == (handles[2] & 0xFFFF));
+	CHECK(reused != handles[2]);
+	CHECK(mtm.Get(handles[2]) == NULL);
+	CHECK(mtm.Get(reused)->Function == task_4);
+
+	// The other handles still work
+	CHECK(mtm.Get(handles[0])->Function == task_0);
+	CHECK(mtm.Get(handles[3])->Function == task_3);
+	CHECK(mtm.Logout(task_0));
+	CHECK(mtm.Get(handles[0]) == NULL);
+
+	// Invalid slot
+	CHECK(mtm.Get(0x0000FFFF) == NULL);
+	CHECK(mtm.Get(MTM_INVALID_HANDLE) == NULL);
+
+	CHECK(heap_allocations == allocations);
+}
+
+/**
+ * @brief Tasks of the pool run with their period
+ *
+ */
+void test_pool_running(void)
+{
+	uint32_t allocations = heap_allocations;
+	MillisTaskPool<2> mtm;
+	memset(runs, 0, sizeof(runs));
+
+	mtm.Add(task_0, 10);
+	mtm.Add(task_1, 25);
+	// First execution right away, then with the period
+	for (uint32_t tick = 0; tick <= 100; tick++)
+	{
+		mtm.Running(tick);
+	}
+	CHECK(runs[0] == 11);
+	CHECK(runs[1] == 5);
+
+	// Disabled task does not run
+	mtm.SetState(task_1, false);
+	for (uint32_t tick = 101; tick <= 200; tick++)
+	{
+		mtm.Running(tick);
+	}
+	CHECK(runs[0] == 21);
+	CHECK(runs[1] == 5);
+
+	CHECK(heap_allocations == allocations);
+}
+
+/**
+ * @brief The scheduler without a pool allocates its pool once
+ *
+ */
+void test_heap_pool(void)
+{
+	uint32_t allocations = heap_allocations;
+	MillisTaskManager *mtm = new MillisTaskManager();
+	uint32_t created = heap_allocations;
+	CHECK(created > allocations);
+
+	for (int idx = 0; idx < 100; idx++)
+	{
+		MillisTaskManager::TaskHandle_t handle = mtm->Add(task_0, 10);
+		mtm->Running(idx);
+		mtm->Remove(handle);
+	}
+	CHECK(heap_allocations == created);
+	delete mtm;
+}
+
+/** Number of tasks of the growing pool test, more than 8 bit slots */
+#define GROW_TASKS 500
+
+/**
+ * @brief The heap allocated pool grows beyond MTM_MAX_TASKS, task
+ *        addresses and handles stay valid
+ *
+ */
+void test_heap_grow(void)
+{
+	static MillisTaskManager::TaskHandle_t handles[GROW_TASKS];
+	static MillisTaskManager::Task_t *tasks[GROW_TASKS];
+	MillisTaskManager mtm;
+	memset(runs, 0, sizeof(runs));
+
+	uint32_t allocations = heap_allocations;
+	for (int idx = 0; idx < GROW_TASKS; idx++)
+	{
+		handles[idx] = mtm.Add(task_0, 10 + idx % 7);
+		CHECK(handles[idx] != MTM_INVALID_HANDLE);
+		tasks[idx] = mtm.Get(handles[idx]);
+	}
+	CHECK(mtm.GetCount() == GROW_TASKS);
+	// 16, 32, 64, 128, 256, 512 tasks, 4 allocations per step
+	CHECK(heap_allocations - allocations == 5 * 4);
+
+	for (int idx = 0; idx < GROW_TASKS; idx++)
+	{
+		CHECK(mtm.Get(handles[idx]) == tasks[idx]);
+	}
+	CHECK(mtm.Register(task_1, 5) != NULL);
+	CHECK(mtm.Find(task_1)->Time == 5);
+
+	// Remove and add again does not allocate
+	allocations = heap_allocations;
+	for (int idx = 0; idx < GROW_TASKS; idx += 2)
+	{
+		CHECK(mtm.Remove(handles[idx]));
+		CHECK(mtm.Get(handles[idx]) == NULL);
+		MillisTaskManager::TaskHandle_t handle = mtm.Add(task_2, 10);
+		CHECK((handle & 0xFFFF) == (handles[idx] & 0xFFFF));
+		CHECK(handle != handles[idx]);
+		handles[idx] = handle;
+	}
+	CHECK(heap_allocations == allocations);
+
+	// All tasks run once in the first Running call, then with their period
+	for (uint32_t tick = 0; tick <= 100; tick++)
+	{
+		mtm.Running(tick);
+	}
+	CHECK(runs[1] == 21);
+	// Periods up to 16 ms, every task ran at least 7 times
+	CHECK(runs[0] + runs[2] >= GROW_TASKS * 7);
+	for (int idx = 1; idx < GROW_TASKS; idx += 2)
+	{
+		CHECK(mtm.Get(handles[idx])->Function == task_0);
+	}
+}
+
+int main(int argc, char **argv)
+{
+	test_pool();
+	test_pool_running();
+	test_heap_pool();
+	test_heap_grow();
+	return host_test_result("mtm_pool");
+}
@@ -0,0 +1,597 @@
+/**
+ * @file test_mtm_priority.cpp
+ * @author Bernd Giesecke (bernd@giesecke.tk)
+ * @brief Tests of the priority classes, aging, CPU budget and
+ * 		PriorityEnable of MillisTaskManager and a random test that
+ * 		checks the scheduler against a model of its tasks.
+ * 		Call with the number of random operations as argument,
+ * 		default is 1000000.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include <string.h>
+#include "MillisTaskManager.h"
+#include "Arduino.h"
+#include "host_test.h"
+
+/** Scheduler of the running test */
+MillisTaskManager *mtm;
+
+/** Execution order of the test tasks */
+static char order[32];
+/** Run time of the test tasks (us) */
+static uint32_t task_cost = 0;
+
+/**
+ * @brief Add a task name to the execution order
+ *
+ * @param name task name
+ */
+void log_order(char name)
+{
+	size_t len = strlen(order);
+	if (len < sizeof(order) - 1)
+	{
+		order[len] = name;
+		order[len + 1] = 0;
+	}
+	host_advance(task_cost);
+}
+
+void task_a(void) { log_order('a'); }
+void task_b(void) { log_order('b'); }
+void task_c(void) { log_order('c'); }
+void task_d(void) { log_order('d'); }
+
+/**
+ * @brief Due tasks run by priority class, not by registration order
+ *
+ */
+void test_priority(void)
+{
+	MillisTaskPool<4> pool;
+	mtm = &pool;
+	order[0] = 0;
+
+	pool.Add(task_a, 100);
+	pool.Add(task_b, 100);
+	pool.Add(task_c, 100);
+	CHECK(pool.SetPriority(task_a, 2));
+	CHECK(pool.SetPriority(task_b, 0));
+	CHECK(pool.SetPriority(task_c, 1));
+	CHECK(!pool.SetPriority(task_c, MTM_PRIORITY_CLASSES));
+	CHECK(!pool.SetPriority(task_d, 1));
+
+	pool.Running(0);
+	CHECK(strcmp(order, "bca") == 0);
+	pool.Running(100);
+	CHECK(strcmp(order, "bcabca") == 0);
+}
+
+/**
+ * @brief A task of a lower class overtakes after it waited MTM_PRIORITY_AGING longer per class
+ *
+ */
+void test_aging(void)
+{
+	MillisTaskPool<4> pool;
+	mtm = &pool;
+	order[0] = 0;
+
+	pool.Register(task_a, 0, false, true);
+	pool.Register(task_b, 0, false, true);
+	pool.SetPriority(task_a, 1);
+	pool.SetPriority(task_b, 0);
+
+	// a is due 1500 ms before b, more than the aging of one class
+	pool.Start(task_a, 100, 0);
+	pool.Start(task_b, 1600, 0);
+	pool.Running(2000);
+	CHECK(strcmp(order, "ab") == 0);
+
+	// a is due 500 ms before b, b keeps its priority
+	order[0] = 0;
+	pool.Start(task_a, 100, 2000);
+	pool.Start(task_b, 600, 2000);
+	pool.Running(4000);
+	CHECK(strcmp(order, "ba") == 0);
+}
+
+/**
+ * @brief Tasks that do not fit into the CPU budget run first on the next call
+ *
+ */
+void test_budget(void)
+{
+	MillisTaskPool<4> pool;
+	mtm = &pool;
+	order[0] = 0;
+	task_cost = 600;
+
+	pool.Add(task_a, 100);
+	pool.Add(task_b, 100);
+	pool.Add(task_c, 100);
+	pool.Add(task_d, 100);
+	pool.SetPriority(task_a, 0);
+	pool.SetPriority(task_b, 1);
+	pool.SetPriority(task_c, 2);
+	pool.SetPriority(task_d, 3);
+	pool.SetBudget(1000);
+
+	// 600 us + 600 us exceed the budget after the second task
+	pool.Running(0);
+	CHECK(strcmp(order, "ab") == 0);
+	CHECK(pool.GetSleepTime(0) == 0);
+
+	// The tasks that did not fit run on the next call
+	pool.Running(1);
+	CHECK(strcmp(order, "abcd") == 0);
+	CHECK(pool.GetSleepTime(1) == 99);
+
+	// Leftovers keep their place in the ready heap, a and b of the higher classes are due meanwhile
+	pool.Running(100);
+	CHECK(strcmp(order, "abcdab") == 0);
+	pool.Running(101);
+	CHECK(strcmp(order, "abcdabcd") == 0);
+
+	// No limit
+	pool.SetBudget(0);
+	pool.Running(201);
+	CHECK(strcmp(order, "abcdabcdabcd") == 0);
+	task_cost = 0;
+}
+
+/**
+ * @brief PriorityEnable runs one task per Running call
+ *
+ */
+void test_priority_enable(void)
+{
+	MillisTaskPool<4> pool(true);
+	mtm = &pool;
+	order[0] = 0;
+
+	pool.Add(task_a, 100);
+	pool.Add(task_b, 100);
+	pool.Add(task_c, 100);
+	pool.SetPriority(task_a, 3);
+	pool.SetPriority(task_c, 1);
+
+	pool.Running(0);
+	CHECK(strcmp(order, "b") == 0);
+	CHECK(pool.GetSleepTime(0) == 0);
+	pool.Running(1);
+	pool.Running(2);
+	CHECK(strcmp(order, "bca") == 0);
+	CHECK(pool.GetSleepTime(2) == 98);
+	pool.Running(3);
+	CHECK(strcmp(order, "bca") == 0);
+}
+
+/** Number of functions of the random test, more than the pool size */
+#define FUZZ_TASKS 8
+/** Pool size of the random test */
+#define FUZZ_POOL 6
+/** Largest clock step between two Running calls (ms) */
+#define FUZZ_MAX_STEP 60
+/** Longest time a due task may wait for its execution (ms) */
+#define FUZZ_MAX_WAIT ((MTM_PRIORITY_CLASSES - 1) * MTM_PRIORITY_AGING + (FUZZ_TASKS + 4) * FUZZ_MAX_STEP)
+
+/** Model of a task of the random test */
+struct fuzz_task_s
+{
+	bool live;
+	MillisTaskManager::TaskHandle_t handle;
+	bool enabled;
+	bool first;
+	bool triggered;
+	bool notified;
+	bool one_shot;
+	uint32_t period;
+	uint32_t base;
+	uint32_t cost;
+	bool waiting;
+	uint32_t wait_start;
+	uint32_t pass;
+};
+
+static fuzz_task_s fuzz[FUZZ_TASKS];
+/** Tick of the current Running call */
+static uint32_t fuzz_tick;
+/** Number of the current Running call */
+static uint32_t fuzz_pass;
+/** A Notify was not taken by Running yet */
+static bool fuzz_notify_pending;
+/** Longest wait of a due task (ms) */
+static uint32_t fuzz_max_wait;
+/** Executions of the random test */
+static uint32_t fuzz_runs;
+
+template <int N>
+void fuzz_task(void);
+
+static MillisTaskManager::TaskFunction_t fuzz_functions[FUZZ_TASKS] = {
+	fuzz_task<0>, fuzz_task<1>, fuzz_task<2>, fuzz_task<3>,
+	fuzz_task<4>, fuzz_task<5>, fuzz_task<6>, fuzz_task<7>};
+
+/**
+ * @brief Random model task
+ *
+ * @param live true for a registered task, false for a free one
+ * @return int model index, -1 if there is none
+ */
+int fuzz_pick(bool live)
+{
+	int start = host_random() % FUZZ_TASKS;
+	for (int idx = 0; idx < FUZZ_TASKS; idx++)
+	{
+		int task = (start + idx) % FUZZ_TASKS;
+		if (fuzz[task].live == live)
+		{
+			return task;
+		}
+	}
+	return -1;
+}
+
+/**
+ * @brief Random task period, mostly short, some 0 and some long ones
+ *
+ * @return uint32_t period (ms)
+ */
+uint32_t fuzz_period(void)
+{
+	uint32_t kind = host_random() % 10;
+	if (kind < 3)
+	{
+		return 0;
+	}
+	if (kind == 3)
+	{
+		return host_random_range(1000, 10000);
+	}
+	return host_random_range(1, 300);
+}
+
+/**
+ * @brief Check if a model task is due at the current tick
+ *
+ * @param task model task
+ * @param tick current time (ms)
+ * @return true task is due
+ */
+bool fuzz_due(fuzz_task_s *task, uint32_t tick)
+{
+	return task->live && task->enabled && (task->first || task->triggered || ((tick - task->base) >= task->period));
+}
+
+/**
+ * @brief Notify a task and the model
+ *
+ * @param idx model index
+ */
+void fuzz_notify(int idx)
+{
+	CHECK(mtm->Notify(fuzz[idx].handle));
+	fuzz[idx].notified = true;
+	fuzz_notify_pending = true;
+}
+
+/**
+ * @brief Remove a task from the scheduler and the model
+ *
+ * @param idx model index
+ */
+void fuzz_remove(int idx)
+{
+	fuzz_task_s *task = &fuzz[idx];
+	if (host_random() & 1)
+	{
+		CHECK(mtm->Remove(task->handle));
+	}
+	else
+	{
+		CHECK(mtm->Logout(fuzz_functions[idx]));
+	}
+	CHECK(mtm->Get(task->handle) == NULL);
+	CHECK(!mtm->Notify(task->handle));
+	task->live = false;
+	task->notified = false;
+	task->waiting = false;
+}
+
+/**
+ * @brief Start a task in the scheduler and the model
+ *
+ * @param idx model index
+ * @param tick start time
+ */
+void fuzz_start(int idx, uint32_t tick)
+{
+	fuzz_task_s *task = &fuzz[idx];
+	uint32_t period = fuzz_period();
+	CHECK(mtm->Start(fuzz_functions[idx], period, tick));
+	task->enabled = true;
+	task->period = period;
+	task->base = tick;
+	task->first = false;
+	task->triggered = false;
+	task->waiting = false;
+}
+
+/**
+ * @brief Execution of a task of the random test, checks it against the model
+ *
+ * @param idx model index
+ */
+void fuzz_run(int idx)
+{
+	fuzz_task_s *task = &fuzz[idx];
+	fuzz_runs++;
+
+	CHECK(task->live);
+	CHECK(task->enabled);
+	// At most once per Running call and only when due
+	CHECK(task->pass != fuzz_pass);
+	CHECK(fuzz_due(task, fuzz_tick));
+
+	task->pass = fuzz_pass;
+	task->base = fuzz_tick;
+	task->first = false;
+	task->triggered = false;
+	task->waiting = false;
+	if (task->one_shot)
+	{
+		task->enabled = false;
+	}
+
+	host_advance(task->cost);
+
+	// Like an interrupt or the task itself changing the task list
+	uint32_t action = host_random() % 100;
+	if (action < 5)
+	{
+		int other = fuzz_pick(true);
+		fuzz_notify(other);
+	}
+	else if (action < 8)
+	{
+		fuzz_start(idx, fuzz_tick);
+	}
+	else if (action < 10)
+	{
+		fuzz_remove(idx);
+	}
+}
+
+template <int N>
+void fuzz_task(void)
+{
+	fuzz_run(N);
+}
+
+/**
+ * @brief Running call of the random test, checks the scheduler against the model
+ *
+ */
+void fuzz_running(void)
+{
+	host_advance(host_random_range(0, FUZZ_MAX_STEP) * 1000);
+	fuzz_tick = millis();
+
+	if (fuzz_notify_pending)
+	{
+		fuzz_notify_pending = false;
+		for (int idx = 0; idx < FUZZ_TASKS; idx++)
+		{
+			if (fuzz[idx].live && fuzz[idx].notified)
+			{
+				fuzz[idx].notified = false;
+				fuzz[idx].triggered = true;
+				fuzz[idx].enabled = true;
+			}
+		}
+	}
+
+	for (int idx = 0; idx < FUZZ_TASKS; idx++)
+	{
+		if (fuzz_due(&fuzz[idx], fuzz_tick) && !fuzz[idx].waiting)
+		{
+			fuzz[idx].waiting = true;
+			fuzz[idx].wait_start = fuzz_tick;
+		}
+	}
+
+	fuzz_pass++;
+	mtm->Running(fuzz_tick);
+
+	int live = 0;
+	uint32_t sleep = MTM_SLEEP_FOREVER;
+	for (int idx = 0; idx < FUZZ_TASKS; idx++)
+	{
+		fuzz_task_s *task = &fuzz[idx];
+		if (!task->live)
+		{
+			CHECK(mtm->Find(fuzz_functions[idx]) == NULL);
+			continue;
+		}
+		live++;
+
+		MillisTaskManager::Task_t *node = mtm->Get(task->handle);
+		CHECK(node != NULL);
+		if (node == NULL)
+		{
+			continue;
+		}
+		CHECK(node->Function == fuzz_functions[idx]);
+		CHECK(mtm->Find(fuzz_functions[idx]) == node);
+		CHECK(node->State == task->enabled);
+
+		// No starvation
+		if (task->waiting)
+		{
+			uint32_t wait = fuzz_tick - task->wait_start;
+			if (wait > fuzz_max_wait)
+			{
+				fuzz_max_wait = wait;
+			}
+			CHECK(wait <= FUZZ_MAX_WAIT);
+		}
+
+		if (task->enabled)
+		{
+			uint32_t left = 0;
+			if (!task->first && !task->triggered && ((fuzz_tick - task->base) < task->period))
+			{
+				left = task->period - (fuzz_tick - task->base);
+			}
+			if (left < sleep)
+			{
+				sleep = left;
+			}
+		}
+	}
+	CHECK(mtm->GetCount() == live);
+	if (fuzz_notify_pending)
+	{
+		sleep = 0;
+	}
+	CHECK(mtm->GetSleepTime(fuzz_tick) == sleep);
+}
+
+/**
+ * @brief Random operations on the scheduler, checked against the model
+ *
+ * @param priority_enable run one task per Running call
+ * @param iterations number of operations
+ */
+void test_fuzz(bool priority_enable, uint32_t iterations)
+{
+	MillisTaskPool<FUZZ_POOL> pool(priority_enable);
+	mtm = &pool;
+	memset(fuzz, 0, sizeof(fuzz));
+	fuzz_notify_pending = false;
+	fuzz_max_wait = 0;
+	fuzz_runs = 0;
+
+	for (uint32_t step = 0; (step < iterations) && (host_test_failed == 0); step++)
+	{
+		uint32_t op = host_random() % 100;
+		int idx;
+		if (op < 10)
+		{
+			// Add a task, a full pool rejects it
+			idx = fuzz_pick(false);
+			if (idx < 0)
+			{
+				continue;
+			}
+			fuzz_task_s *task = &fuzz[idx];
+			int live = pool.GetCount();
+			uint32_t period = fuzz_period();
+			bool state = (host_random() % 4) != 0;
+			bool one_shot = (host_random() % 8) == 0;
+			MillisTaskManager::Task_t *node = pool.Register(fuzz_functions[idx], period, state, one_shot);
+			if (live == FUZZ_POOL)
+			{
+				CHECK(node == NULL);
+				continue;
+			}
+			CHECK(node != NULL);
+			if (node == NULL)
+			{
+				continue;
+			}
+			memset(task, 0, sizeof(fuzz_task_s));
+			task->live = true;
+			task->handle = pool.GetHandle(node);
+			task->enabled = state;
+			task->first = true;
+			task->one_shot = one_shot;
+			task->period = period;
+			task->cost = (host_random() % 4) == 0 ? host_random_range(0, 3000) : host_random_range(0, 200);
+			task->pass = fuzz_pass;
+			CHECK(pool.SetPriority(task->handle, host_random() % MTM_PRIORITY_CLASSES));
+		}
+		else if (op < 15)
+		{
+			idx = fuzz_pick(true);
+			if (idx >= 0)
+			{
+				fuzz_remove(idx);
+			}
+		}
+		else if (op < 25)
+		{
+			idx = fuzz_pick(true);
+			if (idx >= 0)
+			{
+				bool state = host_random() & 1;
+				if (host_random() & 1)
+				{
+					CHECK(pool.SetState(fuzz[idx].handle, state));
+				}
+				else
+				{
+					CHECK(pool.SetState(fuzz_functions[idx], state));
+				}
+				fuzz[idx].enabled = state;
+				if (!state)
+				{
+					fuzz[idx].waiting = false;
+				}
+			}
+		}
+		else if (op < 30)
+		{
+			idx = fuzz_pick(true);
+			if (idx >= 0)
+			{
+				fuzz_start(idx, millis());
+			}
+		}
+		else if (op < 38)
+		{
+			idx = fuzz_pick(true);
+			if (idx >= 0)
+			{
+				fuzz_notify(idx);
+			}
+		}
+		else if (op < 42)
+		{
+			idx = fuzz_pick(true);
+			if (idx >= 0)
+			{
+				uint8_t priority = host_random() % (MTM_PRIORITY_CLASSES + 1);
+				CHECK(pool.SetPriority(fuzz_functions[idx], priority) == (priority < MTM_PRIORITY_CLASSES));
+			}
+		}
+		else if (op < 44)
+		{
+			pool.SetBudget((host_random() & 1) ? 0 : host_random_range(200, 3000));
+		}
+		else
+		{
+			fuzz_running();
+		}
+	}
+	printf("PriorityEnable %d: %u runs, longest wait of a due task %u ms, limit %u ms\n",
+		   priority_enable, fuzz_runs, fuzz_max_wait, (uint32_t)FUZZ_MAX_WAIT);
+}
+
+int main(int argc, char **argv)
+{
+	uint32_t iterations = host_test_iterations(argc, argv, 1000000);
+
+	test_priority();
+	test_aging();
+	test_budget();
+	test_priority_enable();
+	test_fuzz(false, iterations / 2);
+	test_fuzz(true, iterations / 2);
+	return host_test_result("mtm_priority");
+}
@@ -0,0 +1,140 @@
+/**
+ * @file test_mtm_stats.cpp
+ * @author Bernd Giesecke (bernd@giesecke.tk)
+ * @brief Overhead of the per task statistics (MTM_USE_STATS).
+ * 		MillisTaskManager.cpp is built a second time with
+ * 		MTM_USE_STATS 0 and the class renamed to MillisTaskManagerNoStats
+ * 		(see Makefile), so both builds run the same task set in one
+ * 		program. Reported are the host time per Running() call and the
+ * 		difference per executed task. Both must run the same tasks and
+ * 		the statistics must count every run.
+ * 		Call with the simulated time (ms) as argument, default is 10000.
+ * 		The timings are only meaningful in make bench.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+// Scheduler without statistics, renamed
+#define MTM_USE_STATS 0
+#define MillisTaskManager MillisTaskManagerNoStats
+#define MillisTaskPool MillisTaskPoolNoStats
+#include "MillisTaskManager.h"
+#undef MillisTaskManager
+#undef MillisTaskPool
+#undef MTM_USE_STATS
+#undef __MILLISTASKMANAGER_H
+// Scheduler with statistics, as built for the firmware
+#define MTM_USE_STATS 1
+#include "MillisTaskManager.h"
+#include "Arduino.h"
+#include "host_test.h"
+
+/** Largest number of tasks */
+#define STATS_MAX_TASKS 50
+/** Run time of a task on the virtual clock (us) */
+#define STATS_TASK_US 20
+
+/** Period of each task (ms) */
+static uint32_t stats_period[STATS_MAX_TASKS];
+/** Number of task executions */
+static uint32_t stats_runs;
+
+/**
+ * @brief Benchmark task
+ *
+ */
+void stats_task(void)
+{
+	stats_runs++;
+	host_advance(STATS_TASK_US);
+}
+
+/** Result of one scheduler run */
+struct stats_result_s
+{
+	uint32_t runs;	 // Task executions
+	uint32_t calls;	 // Running() calls
+	double call_ns;	 // Host time per Running() call (ns)
+	double total_ns; // Host time of all calls (ns)
+};
+
+/**
+ * @brief Run a scheduler with the first tasks of the benchmark set
+ *
+ * @param mtm scheduler, with or without statistics
+ * @param tasks number of tasks
+ * @param duration simulated time (ms)
+ * @param result measured values
+ */
+template <class Scheduler>
+void stats_run(Scheduler &mtm, uint16_t tasks, uint32_t duration, stats_result_s *result)
+{
+	host_clock_us = 0;
+	stats_runs = 0;
+	for (uint16_t idx = 0; idx < tasks; idx++)
+	{
+		mtm.Add(stats_task, stats_period[idx]);
+	}
+
+	// One call per ms, or right after the tasks if they took longer
+	uint32_t calls = 0;
+	uint64_t host_time = 0;
+	while (millis() < duration)
+	{
+		uint32_t tick = millis();
+		uint64_t start = host_time_us();
+		mtm.Running(tick);
+		host_time += host_time_us() - start;
+		calls++;
+		if (millis() == tick)
+		{
+			host_clock_us = (uint64_t)(tick + 1) * 1000;
+		}
+	}
+
+	result->runs = stats_runs;
+	result->calls = calls;
+	result->total_ns = host_time * 1000.0;
+	result->call_ns = result->total_ns / calls;
+}
+
+int main(int argc, char **argv)
+{
+	uint32_t duration = host_test_iterations(argc, argv, 10000);
+	const uint16_t task_counts[] = {1, 5, 10, 20, 50};
+
+	for (uint16_t idx = 0; idx < STATS_MAX_TASKS; idx++)
+	{
+		stats_period[idx] = host_random_range(10, 1000);
+	}
+
+	printf("tasks   task runs  no stats ns/call  stats ns/call  stats ns/task run\n");
+	for (uint8_t count = 0; count < sizeof(task_counts) / sizeof(task_counts[0]); count++)
+	{
+		stats_result_s plain;
+		stats_result_s stats;
+		{
+			MillisTaskManagerNoStats mtm;
+			stats_run(mtm, task_counts[count], duration, &plain);
+		}
+		uint32_t recorded = 0;
+		{
+			MillisTaskManager mtm;
+			stats_run(mtm, task_counts[count], duration, &stats);
+			for (uint16_t idx = 0; idx < mtm.GetCount(); idx++)
+			{
+				MillisTaskManager::Task_t *task = mtm.GetTask(idx);
+				recorded += task->Stats.Runs;
+			}
+		}
+		printf("%5d %11u %17.0f %14.0f %18.1f\n", task_counts[count], stats.runs, plain.call_ns, stats.call_ns,
+			   (stats.total_ns - plain.total_ns) / stats.runs);
+		CHECK(plain.runs == stats.runs);
+		CHECK(plain.calls == stats.calls);
+		CHECK(stats.runs != 0);
+		CHECK(recorded == stats.runs);
+	}
+	return host_test_result("mtm_stats");
+}